@@ -0,0 +1,51 @@
+#include "boilerMode.h"
+#include <strings.h>
+
+// Noms des modes dans la configuration, dans l'ordre des énumérations
+static const char *const BOILER_MODE_NAMES[] = {"auto", "on", "manual", "off"};
+static const char *const PERIOD_MODE_NAMES[] = {"off", "auto", "on"};
+
+// Recherche `name` (sans tenir compte de la casse) dans `names`, -1 si absent
+static int findModeName(const std::string &name, const char *const *names, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (strcasecmp(name.c_str(), names[i]) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool parseBoilerMode(const std::string &name, BoilerMode &mode)
+{
+    int index = findModeName(name, BOILER_MODE_NAMES, 4);
+    if (index < 0)
+    {
+        return false;
+    }
+    mode = (BoilerMode)index;
+    return true;
+}
+
+const char *boilerModeName(BoilerMode mode)
+{
+    return mode <= BOILER_OFF ? BOILER_MODE_NAMES[mode] : "auto";
+}
+
+bool parsePeriodMode(const std::string &name, PeriodMode &mode)
+{
+    int index = findModeName(name, PERIOD_MODE_NAMES, 3);
+    if (index < 0)
+    {
+        return false;
+    }
+    mode = (PeriodMode)index;
+    return true;
+}
+
+const char *periodModeName(PeriodMode mode)
+{
+    return mode <= PERIOD_ON ? PERIOD_MODE_NAMES[mode] : "off";
+}
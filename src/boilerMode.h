@@ -0,0 +1,46 @@
+#ifndef BOILER_MODE_H
+#define BOILER_MODE_H
+
+#include <stdint.h>
+#include <string>
+
+// Mode de fonctionnement du chauffe-eau choisi par l'utilisateur
+enum BoilerMode : uint8_t
+{
+    BOILER_AUTO,   // Routage du surplus pendant les périodes "auto"
+    BOILER_ON,     // Marche forcée
+    BOILER_MANUAL, // Puissance fixe (triacOpening)
+    BOILER_OFF     // Arrêt (hors périodes "on")
+};
+
+// Mode d'une période du planning
+enum PeriodMode : uint8_t
+{
+    PERIOD_OFF,  // Hors période : arrêt
+    PERIOD_AUTO, // Période "auto" : régulation sur le surplus
+    PERIOD_ON    // Période "on" : marche forcée (prioritaire sur "auto")
+};
+
+/**
+ * Conversions entre les modes et leur nom dans la configuration (NVS, API, MQTT).
+ * Les noms sont acceptés sans tenir compte de la casse ("Auto", "auto", ...).
+ * @return false si le nom n'est pas reconnu (`mode` n'est pas modifié).
+ */
+bool parseBoilerMode(const std::string &name, BoilerMode &mode);
+const char *boilerModeName(BoilerMode mode);
+bool parsePeriodMode(const std::string &name, PeriodMode &mode);
+const char *periodModeName(PeriodMode mode);
+
+// Structure pour une période de fonctionnement
+struct Period
+{
+    int start;
+    bool startSunrise; // La période commence au lever du soleil
+    bool startSunset;  // La période commence au coucher du soleil
+    int end;
+    bool endSunrise; // La période se termine au lever du soleil
+    bool endSunset;  // La période se termine au coucher du soleil
+    PeriodMode mode;
+};
+
+#endif // BOILER_MODE_H
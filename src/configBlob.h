@@ -0,0 +1,127 @@
+#ifndef CONFIG_BLOB_H
+#define CONFIG_BLOB_H
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+/**
+ * Sérialisation binaire compacte des sections de la configuration (blobs NVS).
+ * Entiers et flottants en petit-boutiste, chaînes préfixées par leur longueur (16 bits).
+ * Un champ absent en fin de section (section écrite par un schéma plus ancien) est lu avec sa
+ * valeur par défaut : ajouter un champ à la fin d'une section ne nécessite pas de migration.
+ */
+
+// CRC-32 (polynôme 0xEDB88320) du contenu d'une section
+inline uint32_t configCrc32(const uint8_t *data, size_t length)
+{
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < length; i++)
+    {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+class ConfigBlobWriter
+{
+public:
+    void putU8(uint8_t value) { data.push_back(value); }
+    void putBool(bool value) { putU8(value ? 1 : 0); }
+    void putI32(int32_t value) { put(&value, sizeof(value)); }
+    void putFloat(float value) { put(&value, sizeof(value)); }
+    void putString(const std::string &value)
+    {
+        uint16_t length = value.size() > 0xFFFF ? 0xFFFF : (uint16_t)value.size();
+        put(&length, sizeof(length));
+        put(value.data(), length);
+    }
+
+    const std::vector<uint8_t> &getData() const { return data; }
+
+private:
+    void put(const void *value, size_t size)
+    {
+        const uint8_t *bytes = static_cast<const uint8_t *>(value);
+        data.insert(data.end(), bytes, bytes + size);
+    }
+
+    std::vector<uint8_t> data;
+};
+
+class ConfigBlobReader
+{
+public:
+    ConfigBlobReader(const uint8_t *data, size_t length) : data(data), length(length), position(0), truncated(false) {}
+
+    uint8_t getU8(uint8_t defaultValue)
+    {
+        uint8_t value = defaultValue;
+        get(&value, sizeof(value));
+        return value;
+    }
+    bool getBool(bool defaultValue) { return getU8(defaultValue ? 1 : 0) != 0; }
+    int32_t getI32(int32_t defaultValue)
+    {
+        int32_t value = defaultValue;
+        get(&value, sizeof(value));
+        return value;
+    }
+    float getFloat(float defaultValue)
+    {
+        float value = defaultValue;
+        get(&value, sizeof(value));
+        return value;
+    }
+    std::string getString(const char *defaultValue)
+    {
+        uint16_t size = 0;
+        if (!get(&size, sizeof(size)))
+        {
+            return defaultValue;
+        }
+        if (position + size > length)
+        {
+            truncated = true;
+            position = length;
+            return defaultValue;
+        }
+        std::string value(reinterpret_cast<const char *>(data + position), size);
+        position += size;
+        return value;
+    }
+
+    // false si un champ était coupé (section incohérente)
+    bool isValid() const { return !truncated; }
+
+private:
+    // Lit `size` octets ; en fin de section la valeur par défaut est conservée
+    bool get(void *value, size_t size)
+    {
+        if (position == length)
+        {
+            return false;
+        }
+        if (position + size > length)
+        {
+            truncated = true;
+            position = length;
+            return false;
+        }
+        memcpy(value, data + position, size);
+        position += size;
+        return true;
+    }
+
+    const uint8_t *data;
+    size_t length;
+    size_t position;
+    bool truncated;
+};
+
+#endif // CONFIG_BLOB_H
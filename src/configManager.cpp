@@ -1,66 +1,388 @@
 #include "configManager.h"
 #include <Arduino.h>
 #include "solarManager.h"
+#include "solarEphemeris.h"
+#include "configBlob.h"
 #include <time.h>
+
+extern SolarEphemeris solarEphemeris;
 // Constructeur
 ConfigManager::ConfigManager()
 {
+    memset(sectionCrc, 0, sizeof(sectionCrc));
 }
 
-// Sauvegarde la configuration dans la mémoire flash
-bool ConfigManager::saveConfig(const Config &config)
+// Version du format des sections (à incrémenter si un champ change de type ou de place)
+static const uint8_t CONFIG_SCHEMA_VERSION = 1;
+// En-tête d'une section : version du schéma, réservé, longueur (16 bits), CRC-32 du contenu
+static const size_t SECTION_HEADER_SIZE = 8;
+// Taille maximum d'une section (une vingtaine de périodes)
+static const size_t SECTION_MAX_SIZE = 1024;
+// Clé NVS de chaque section
+static const char *const SECTION_KEYS[SECTION_COUNT] = {"c.wifi", "c.mqtt", "c.meter", "c.boiler", "c.solar", "c.reg"};
+
+// Clés de l'ancien format (une clé par champ), hors clés des périodes "b.p.<n>.*"
+static const char *const LEGACY_KEYS[] = {"w.ssid", "w.pass", "m.serv", "m.port", "m.user", "m.pass", "m.topic",
+                                          "sh.ip", "sh.chan", "sh.period", "sh.model", "mt.src", "tic.std", "tic.rx",
+                                          "mb.trans", "mb.dev", "mb.addr", "mb.host", "mb.port", "mb.baud", "mb.rx",
+                                          "mb.tx", "mb.de", "mb.period", "mq.topic", "mq.key", "so.lat", "so.lon",
+                                          "so.tz", "r.set", "r.kp", "r.ki", "r.kd", "r.rate", "b.mode", "b.temp",
+                                          "b.triac", "b.power", "b.output", "b.p.size"};
+static const char *const LEGACY_PERIOD_SUFFIXES[] = {".s", ".e", ".sr", ".ss", ".er", ".es", ".m"};
+
+// Bits des ancrages d'une période au lever / coucher du soleil
+static const uint8_t PERIOD_START_SUNRISE = 0x01;
+static const uint8_t PERIOD_START_SUNSET = 0x02;
+static const uint8_t PERIOD_END_SUNRISE = 0x04;
+static const uint8_t PERIOD_END_SUNSET = 0x08;
+
+static void serializeSection(ConfigSection section, const Config &config, ConfigBlobWriter &writer)
 {
-    Serial.println("[-] Ecriture de la mémoire flash ...");
-    _preferences.begin("config", false);
+    switch (section)
+    {
+    case SECTION_WIFI:
+        writer.putString(config.wifi.ssid);
+        writer.putString(config.wifi.password);
+        break;
+
+    case SECTION_MQTT:
+        writer.putString(config.mqtt.server);
+        writer.putI32(config.mqtt.port);
+        writer.putString(config.mqtt.username);
+        writer.putString(config.mqtt.password);
+        writer.putString(config.mqtt.topic);
+        break;
+
+    case SECTION_METER:
+        writer.putString(config.shellyEm.ip);
+        writer.putString(config.shellyEm.channel);
+        writer.putI32(config.shellyEm.pollPeriod);
+        writer.putString(config.shellyEm.model);
+        writer.putString(config.meter.source);
+        writer.putBool(config.meter.linky.standard);
+        writer.putI32(config.meter.linky.rxPin);
+        writer.putString(config.meter.modbus.transport);
+        writer.putString(config.meter.modbus.device);
+        writer.putI32(config.meter.modbus.address);
+        writer.putString(config.meter.modbus.host);
+        writer.putI32(config.meter.modbus.port);
+        writer.putI32(config.meter.modbus.baudRate);
+        writer.putI32(config.meter.modbus.rxPin);
+        writer.putI32(config.meter.modbus.txPin);
+        writer.putI32(config.meter.modbus.dePin);
+        writer.putI32(config.meter.modbus.pollPeriod);
+        writer.putString(config.meter.mqtt.topic);
+        writer.putString(config.meter.mqtt.key);
+        break;
+
+    case SECTION_BOILER:
+        writer.putU8(config.boiler.mode);
+        writer.putI32(config.boiler.temperature);
+        writer.putI32(config.boiler.triacOpening);
+        writer.putI32(config.boiler.heaterPower);
+        writer.putString(config.boiler.outputMode);
+        writer.putU8(config.boiler.periods.size());
+        for (const Period &p : config.boiler.periods)
+        {
+            writer.putI32(p.start);
+            writer.putI32(p.end);
+            writer.putU8(p.mode);
+            writer.putU8((p.startSunrise ? PERIOD_START_SUNRISE : 0) | (p.startSunset ? PERIOD_START_SUNSET : 0) |
+                         (p.endSunrise ? PERIOD_END_SUNRISE : 0) | (p.endSunset ? PERIOD_END_SUNSET : 0));
+        }
+        writer.putU8(config.boiler.sensorResolution);
+        writer.putI32(config.boiler.sensorInterval);
+        break;
+
+    case SECTION_SOLAR:
+        writer.putFloat(config.solar.latitude);
+        writer.putFloat(config.solar.longitude);
+        writer.putString(config.solar.timeZone);
+        break;
+
+    case SECTION_REGULATION:
+        writer.putFloat(config.regulation.setpoint);
+        writer.putFloat(config.regulation.kp);
+        writer.putFloat(config.regulation.ki);
+        writer.putFloat(config.regulation.kd);
+        writer.putFloat(config.regulation.maxRate);
+        break;
+
+    default:
+        break;
+    }
+}
 
-    // Wifi
-    _preferences.putString("w.ssid", config.wifi.ssid.c_str());
-    _preferences.putString("w.pass", config.wifi.password.c_str());
+// Lit une section ; les valeurs par défaut sont celles de l'ancien format
+static bool deserializeSection(ConfigSection section, ConfigBlobReader &reader, Config &config)
+{
+    switch (section)
+    {
+    case SECTION_WIFI:
+        config.wifi.ssid = reader.getString("");
+        config.wifi.password = reader.getString("");
+        break;
+
+    case SECTION_MQTT:
+        config.mqtt.server = reader.getString("");
+        config.mqtt.port = reader.getI32(1883);
+        config.mqtt.username = reader.getString("");
+        config.mqtt.password = reader.getString("");
+        config.mqtt.topic = reader.getString("");
+        break;
+
+    case SECTION_METER:
+        config.shellyEm.ip = reader.getString("");
+        config.shellyEm.channel = reader.getString("0");
+        config.shellyEm.pollPeriod = reader.getI32(1000);
+        config.shellyEm.model = reader.getString("em");
+        config.meter.source = reader.getString("shelly");
+        config.meter.linky.standard = reader.getBool(false);
+        config.meter.linky.rxPin = reader.getI32(16);
+        config.meter.modbus.transport = reader.getString("rtu");
+        config.meter.modbus.device = reader.getString("sdm120");
+        config.meter.modbus.address = reader.getI32(1);
+        config.meter.modbus.host = reader.getString("");
+        config.meter.modbus.port = reader.getI32(502);
+        config.meter.modbus.baudRate = reader.getI32(9600);
+        config.meter.modbus.rxPin = reader.getI32(16);
+        config.meter.modbus.txPin = reader.getI32(17);
+        config.meter.modbus.dePin = reader.getI32(-1);
+        config.meter.modbus.pollPeriod = reader.getI32(1000);
+        config.meter.mqtt.topic = reader.getString("");
+        config.meter.mqtt.key = reader.getString("");
+        break;
+
+    case SECTION_BOILER:
+    {
+        uint8_t mode = reader.getU8(BOILER_AUTO);
+        config.boiler.mode = mode <= BOILER_OFF ? (BoilerMode)mode : BOILER_AUTO;
+        config.boiler.temperature = reader.getI32(50);
+        config.boiler.triacOpening = reader.getI32(50);
+        config.boiler.heaterPower = reader.getI32(2000);
+        config.boiler.outputMode = reader.getString("phase");
+        uint8_t count = reader.getU8(0);
+        config.boiler.periods.clear();
+        for (uint8_t i = 0; i < count && reader.isValid(); i++)
+        {
+            Period p;
+            p.start = reader.getI32(0);
+            p.end = reader.getI32(0);
+            uint8_t periodMode = reader.getU8(PERIOD_AUTO);
+            p.mode = periodMode <= PERIOD_ON ? (PeriodMode)periodMode : PERIOD_AUTO;
+            uint8_t anchors = reader.getU8(0);
+            p.startSunrise = anchors & PERIOD_START_SUNRISE;
+            p.startSunset = anchors & PERIOD_START_SUNSET;
+            p.endSunrise = anchors & PERIOD_END_SUNRISE;
+            p.endSunset = anchors & PERIOD_END_SUNSET;
+            config.boiler.periods.push_back(p);
+        }
+        config.boiler.sensorResolution = reader.getU8(12);
+        config.boiler.sensorInterval = reader.getI32(30000);
+        break;
+    }
 
-    // Mqtt
-    _preferences.putString("m.serv", config.mqtt.server.c_str());
-    _preferences.putInt("m.port", config.mqtt.port);
-    _preferences.putString("m.user", config.mqtt.username.c_str());
-    _preferences.putString("m.pass", config.mqtt.password.c_str());
-    _preferences.putString("m.topic", config.mqtt.topic.c_str());
+    case SECTION_SOLAR:
+        config.solar.latitude = reader.getFloat(48.8566);
+        config.solar.longitude = reader.getFloat(2.3522);
+        config.solar.timeZone = reader.getString("Europe/Paris");
+        break;
+
+    case SECTION_REGULATION:
+        config.regulation.setpoint = reader.getFloat(-30);
+        config.regulation.kp = reader.getFloat(0.2);
+        config.regulation.ki = reader.getFloat(0.5);
+        config.regulation.kd = reader.getFloat(0);
+        config.regulation.maxRate = reader.getFloat(25);
+        break;
+
+    default:
+        break;
+    }
+    return reader.isValid();
+}
 
-    // ShellyEm
-    _preferences.putString("sh.ip", config.shellyEm.ip.c_str());
-    _preferences.putString("sh.chan", config.shellyEm.channel.c_str());
+// Copie une section d'une configuration à l'autre (migration, section illisible)
+static void copySection(ConfigSection section, const Config &from, Config &to)
+{
+    switch (section)
+    {
+    case SECTION_WIFI:
+        to.wifi = from.wifi;
+        break;
+    case SECTION_MQTT:
+        to.mqtt = from.mqtt;
+        break;
+    case SECTION_METER:
+        to.shellyEm = from.shellyEm;
+        to.meter = from.meter;
+        break;
+    case SECTION_BOILER:
+        to.boiler = from.boiler;
+        break;
+    case SECTION_SOLAR:
+        to.solar = from.solar;
+        break;
+    case SECTION_REGULATION:
+        to.regulation = from.regulation;
+        break;
+    default:
+        break;
+    }
+}
 
-    // Solar
-    _preferences.putFloat("so.lat", config.solar.latitude);
-    _preferences.putFloat("so.lon", config.solar.longitude);
-    _preferences.putString("so.tz", config.solar.timeZone.c_str());
+bool ConfigManager::writeSections(const Config &config)
+{
+    int written = 0;
+    bool saved = true;
+    for (int i = 0; i < SECTION_COUNT; i++)
+    {
+        ConfigBlobWriter writer;
+        serializeSection((ConfigSection)i, config, writer);
+        const std::vector<uint8_t> &payload = writer.getData();
+        uint32_t crc = configCrc32(payload.data(), payload.size());
+        if (crc == sectionCrc[i])
+        {
+            continue; // Section inchangée : pas d'écriture en flash
+        }
+        if (payload.size() > SECTION_MAX_SIZE)
+        {
+            Serial.printf("[-] Section %s trop grande (%u octets), non enregistrée\n", SECTION_KEYS[i], (unsigned)payload.size());
+            saved = false;
+            continue;
+        }
 
-    // Boiler
-    _preferences.putString("b.mode", config.boiler.mode.c_str());
-    _preferences.putInt("b.temp", config.boiler.temperature);
-    _preferences.putInt("b.triac", config.boiler.triacOpening);
-    _preferences.putUInt("b.p.size", config.boiler.periods.size());
-    for (size_t i = 0; i < config.boiler.periods.size(); ++i)
+        std::vector<uint8_t> blob(SECTION_HEADER_SIZE + payload.size());
+        uint16_t length = payload.size();
+        blob[0] = CONFIG_SCHEMA_VERSION;
+        blob[1] = 0;
+        memcpy(&blob[2], &length, sizeof(length));
+        memcpy(&blob[4], &crc, sizeof(crc));
+        memcpy(&blob[SECTION_HEADER_SIZE], payload.data(), payload.size());
+
+        if (written == 0)
+        {
+            _preferences.begin("config", false);
+        }
+        if (_preferences.putBytes(SECTION_KEYS[i], blob.data(), blob.size()) == blob.size())
+        {
+            sectionCrc[i] = crc;
+        }
+        else
+        {
+            // CRC inconnu : la section sera réécrite à la prochaine sauvegarde
+            Serial.printf("[-] Échec de l'écriture de la section %s\n", SECTION_KEYS[i]);
+            sectionCrc[i] = 0;
+            saved = false;
+        }
+        written++;
+    }
+    if (written > 0)
     {
-        std::string baseKey = "b.p." + std::to_string(i);
-        _preferences.putInt((baseKey + ".s").c_str(), config.boiler.periods[i].start);
-        _preferences.putInt((baseKey + ".e").c_str(), config.boiler.periods[i].end);
-        _preferences.putString((baseKey + ".m").c_str(), config.boiler.periods[i].mode.c_str());
-        // Set true if sunrise==config.boiler.periods[i].start
-        _preferences.putBool((baseKey + ".sr").c_str(), config.boiler.periods[i].startSunrise);
-        _preferences.putBool((baseKey + ".ss").c_str(), config.boiler.periods[i].startSunset);
-        // Set true if sunset==config.boiler.periods[i].end
-        _preferences.putBool((baseKey + ".er").c_str(), config.boiler.periods[i].endSunrise);
-        _preferences.putBool((baseKey + ".es").c_str(), config.boiler.periods[i].endSunset);
+        _preferences.end();
     }
+    Serial.printf("[-] Ecriture de la mémoire flash : %d section(s) modifiée(s)\n", written);
+    return saved;
+}
 
-    _preferences.end();
-    return true;
+// Sauvegarde la configuration dans la mémoire flash (sections modifiées uniquement)
+bool ConfigManager::saveConfig(const Config &config)
+{
+    return writeSections(config);
 }
 
 // Charge la configuration depuis la mémoire flash
 Config ConfigManager::loadConfig()
 {
     Config config;
+    config.version = 0;
     Serial.println("[-] Lecture de la mémoire flash ...");
+
+    bool valid[SECTION_COUNT];
+    bool complete = true;
+    std::vector<uint8_t> blob;
+    _preferences.begin("config", true);
+    for (int i = 0; i < SECTION_COUNT; i++)
+    {
+        valid[i] = false;
+        sectionCrc[i] = 0;
+        size_t size = _preferences.getBytesLength(SECTION_KEYS[i]);
+        if (size >= SECTION_HEADER_SIZE && size <= SECTION_HEADER_SIZE + SECTION_MAX_SIZE)
+        {
+            blob.resize(size);
+            _preferences.getBytes(SECTION_KEYS[i], blob.data(), size);
+            uint16_t length;
+            uint32_t crc;
+            memcpy(&length, &blob[2], sizeof(length));
+            memcpy(&crc, &blob[4], sizeof(crc));
+            const uint8_t *payload = blob.data() + SECTION_HEADER_SIZE;
+            // Les sections d'un schéma plus récent (retour à un ancien firmware) sont ignorées
+            if (blob[0] <= CONFIG_SCHEMA_VERSION && length == size - SECTION_HEADER_SIZE && configCrc32(payload, length) == crc)
+            {
+                ConfigBlobReader reader(payload, length);
+                valid[i] = deserializeSection((ConfigSection)i, reader, config);
+                sectionCrc[i] = valid[i] ? crc : 0;
+            }
+        }
+        if (!valid[i])
+        {
+            complete = false;
+        }
+    }
+    bool legacyKeys = _preferences.isKey("b.mode") || _preferences.isKey("w.ssid");
+    _preferences.end();
+
+    if (!complete)
+    {
+        // Premier démarrage, mise à jour depuis l'ancien format (une clé par champ) ou section corrompue :
+        // les sections manquantes sont reprises de l'ancien format, ou des valeurs par défaut
+        Config legacy = loadLegacyConfig();
+        for (int i = 0; i < SECTION_COUNT; i++)
+        {
+            if (!valid[i])
+            {
+                copySection((ConfigSection)i, legacy, config);
+            }
+        }
+        // Les clés de l'ancien format ne sont supprimées qu'une fois toutes les sections enregistrées :
+        // une coupure ou une écriture en échec avant ce point laisse l'ancien format relu au démarrage suivant
+        if (writeSections(config) && legacyKeys)
+        {
+            Serial.println("[-] Migration de la configuration vers le format par sections");
+            removeLegacyKeys();
+        }
+    }
+
+    // Éphéméride du jour (0 tant que l'heure n'est pas synchronisée)
+    solarEphemeris.update(config.solar.latitude, config.solar.longitude, config.solar.timeZone);
+    SolarDay sun = solarEphemeris.get();
+    config.solar.sunRiseMinutes = sun.sunrise > 0 ? sun.sunrise : 0;
+    config.solar.sunSetMinutes = sun.sunset > 0 ? sun.sunset : 0;
+
+    // Bornes des périodes ancrées au lever / coucher du soleil, conservées telles qu'enregistrées tant que
+    // l'heure n'est pas synchronisée (le planning et l'API les résolvent avec l'éphéméride du jour)
+    if (sun.day != 0)
+    {
+        for (Period &p : config.boiler.periods)
+        {
+            if (p.startSunrise)
+                p.start = config.solar.sunRiseMinutes;
+            else if (p.startSunset)
+                p.start = config.solar.sunSetMinutes;
+            if (p.endSunset)
+                p.end = config.solar.sunSetMinutes;
+            else if (p.endSunrise)
+                p.end = config.solar.sunRiseMinutes;
+        }
+    }
+
+    return config;
+}
+
+// Lecture de l'ancien format (une clé par champ) ; valeurs par défaut pour les clés absentes
+Config ConfigManager::loadLegacyConfig()
+{
+    Config config;
     _preferences.begin("config", true);
 
     // Wifi
@@ -77,21 +399,45 @@ Config ConfigManager::loadConfig()
     // ShellyEm
     config.shellyEm.ip = _preferences.getString("sh.ip", "").c_str();
     config.shellyEm.channel = _preferences.getString("sh.chan", "0").c_str();
+    config.shellyEm.pollPeriod = _preferences.getInt("sh.period", 1000);
+    config.shellyEm.model = _preferences.getString("sh.model", "em").c_str();
+
+    // Meter
+    config.meter.source = _preferences.getString("mt.src", "shelly").c_str();
+    config.meter.linky.standard = _preferences.getBool("tic.std", false);
+    config.meter.linky.rxPin = _preferences.getInt("tic.rx", 16);
+    config.meter.modbus.transport = _preferences.getString("mb.trans", "rtu").c_str();
+    config.meter.modbus.device = _preferences.getString("mb.dev", "sdm120").c_str();
+    config.meter.modbus.address = _preferences.getInt("mb.addr", 1);
+    config.meter.modbus.host = _preferences.getString("mb.host", "").c_str();
+    config.meter.modbus.port = _preferences.getInt("mb.port", 502);
+    config.meter.modbus.baudRate = _preferences.getInt("mb.baud", 9600);
+    config.meter.modbus.rxPin = _preferences.getInt("mb.rx", 16);
+    config.meter.modbus.txPin = _preferences.getInt("mb.tx", 17);
+    config.meter.modbus.dePin = _preferences.getInt("mb.de", -1);
+    config.meter.modbus.pollPeriod = _preferences.getInt("mb.period", 1000);
+    config.meter.mqtt.topic = _preferences.getString("mq.topic", "").c_str();
+    config.meter.mqtt.key = _preferences.getString("mq.key", "").c_str();
 
     // Solar
     config.solar.latitude = _preferences.getFloat("so.lat", 48.8566);
     config.solar.longitude = _preferences.getFloat("so.lon", 2.3522);
     config.solar.timeZone = _preferences.getString("so.tz", "Europe/Paris").c_str();
 
-    struct tm sunrise = SolarManager::calculateSunrise(config.solar.latitude, config.solar.longitude);
-    struct tm sunset = SolarManager::calculateSunset(config.solar.latitude, config.solar.longitude);
-    config.solar.sunRiseMinutes = sunrise.tm_hour * 60 + sunrise.tm_min;
-    config.solar.sunSetMinutes = sunset.tm_hour * 60 + sunset.tm_min;
+    // Regulation
+    config.regulation.setpoint = _preferences.getFloat("r.set", -30);
+    config.regulation.kp = _preferences.getFloat("r.kp", 0.2);
+    config.regulation.ki = _preferences.getFloat("r.ki", 0.5);
+    config.regulation.kd = _preferences.getFloat("r.kd", 0);
+    config.regulation.maxRate = _preferences.getFloat("r.rate", 25);
 
     // Boiler
-    config.boiler.mode = _preferences.getString("b.mode", "auto").c_str();
+    config.boiler.mode = BOILER_AUTO;
+    parseBoilerMode(_preferences.getString("b.mode", "auto").c_str(), config.boiler.mode);
     config.boiler.temperature = _preferences.getInt("b.temp", 50);
     config.boiler.triacOpening = _preferences.getInt("b.triac", 50);
+    config.boiler.heaterPower = _preferences.getInt("b.power", 2000);
+    config.boiler.outputMode = _preferences.getString("b.output", "phase").c_str();
     size_t boilerPeriodsSize = _preferences.getUInt("b.p.size", 0);
     config.boiler.periods.clear();
     for (size_t i = 0; i < boilerPeriodsSize; ++i)
@@ -99,53 +445,51 @@ Config ConfigManager::loadConfig()
         Period p;
         std::string baseKey = "b.p." + std::to_string(i);
 
-        // Start période time
-        if (_preferences.getBool((baseKey + ".sr").c_str()))
-        {
-            p.start = (sunrise.tm_hour * 60 + sunrise.tm_min);
-        }
-        else if (_preferences.getBool((baseKey + ".ss").c_str()))
-        {
-            p.start = (sunset.tm_hour * 60 + sunset.tm_min);
-        }
-        else
-        {
-            p.start = _preferences.getInt((baseKey + ".s").c_str(), 0);
-        }
-
-        // End periode time
-        if (_preferences.getBool((baseKey + ".es").c_str()))
-        {
-            p.end = (sunset.tm_hour * 60 + sunset.tm_min);
-        }
-        else if (_preferences.getBool((baseKey + ".er").c_str()))
-        {
-            p.end = (sunrise.tm_hour * 60 + sunrise.tm_min);
-        }
-        else
-        {
-            p.end = _preferences.getInt((baseKey + ".e").c_str(), 0);
-        }
-
+        p.start = _preferences.getInt((baseKey + ".s").c_str(), 0);
+        p.end = _preferences.getInt((baseKey + ".e").c_str(), 0);
         p.startSunrise = _preferences.getBool((baseKey + ".sr").c_str(), false);
         p.startSunset = _preferences.getBool((baseKey + ".ss").c_str(), false);
         p.endSunrise = _preferences.getBool((baseKey + ".er").c_str(), false);
         p.endSunset = _preferences.getBool((baseKey + ".es").c_str(), false);
 
-        p.mode = _preferences.getString((baseKey + ".m").c_str(), "auto").c_str();
+        p.mode = PERIOD_AUTO;
+        parsePeriodMode(_preferences.getString((baseKey + ".m").c_str(), "auto").c_str(), p.mode);
         config.boiler.periods.push_back(p);
     }
+    config.boiler.sensorResolution = 12;
+    config.boiler.sensorInterval = 30000;
 
     _preferences.end();
     return config;
 }
 
+// Supprime les clés de l'ancien format, les sections étant conservées
+void ConfigManager::removeLegacyKeys()
+{
+    _preferences.begin("config", false);
+    size_t periods = _preferences.getUInt("b.p.size", 0);
+    for (size_t i = 0; i < periods; ++i)
+    {
+        std::string baseKey = "b.p." + std::to_string(i);
+        for (const char *suffix : LEGACY_PERIOD_SUFFIXES)
+        {
+            _preferences.remove((baseKey + suffix).c_str());
+        }
+    }
+    for (const char *key : LEGACY_KEYS)
+    {
+        _preferences.remove(key);
+    }
+    _preferences.end();
+}
+
 // Efface la configuration de la mémoire flash
 void ConfigManager::clearConfig()
 {
     _preferences.begin("config", false);
     _preferences.clear();
     _preferences.end();
+    memset(sectionCrc, 0, sizeof(sectionCrc));
 }
 
 void ConfigManager::printConfig(const Config &config)
@@ -174,14 +518,28 @@ void ConfigManager::printConfig(const Config &config)
     Serial.println(config.shellyEm.ip.c_str());
     Serial.print("  Channel: ");
     Serial.println(config.shellyEm.channel.c_str());
+    Serial.print("  Model: ");
+    Serial.println(config.shellyEm.model.c_str());
+    Serial.print("  Poll period (ms): ");
+    Serial.println(config.shellyEm.pollPeriod);
+
+    Serial.println("Meter:");
+    Serial.print("  Source: ");
+    Serial.println(config.meter.source.c_str());
 
     Serial.println("Boiler:");
     Serial.print("  Mode: ");
-    Serial.println(config.boiler.mode.c_str());
+    Serial.println(boilerModeName(config.boiler.mode));
     Serial.print("  Temperature: ");
     Serial.println(config.boiler.temperature);
     Serial.print("  Triac Opening: ");
     Serial.println(config.boiler.triacOpening);
+    Serial.print("  Heater Power: ");
+    Serial.println(config.boiler.heaterPower);
+    Serial.print("  Output Mode: ");
+    Serial.println(config.boiler.outputMode.c_str());
+    Serial.print("  Sensor: ");
+    Serial.printf("%d bits, %d ms\n", config.boiler.sensorResolution, config.boiler.sensorInterval);
     Serial.println("  Periods:");
     for (size_t i = 0; i < config.boiler.periods.size(); ++i)
     {
@@ -207,7 +565,7 @@ void ConfigManager::printConfig(const Config &config)
             Serial.print(p.end);
 
         Serial.print(", Mode: ");
-        Serial.println(p.mode.c_str());
+        Serial.println(periodModeName(p.mode));
     }
 
     Serial.println("Solar:");
@@ -221,126 +579,10 @@ void ConfigManager::printConfig(const Config &config)
     Serial.println(config.solar.sunRiseMinutes);
     Serial.print("  Sunset Minutes: ");
     Serial.println(config.solar.sunSetMinutes);
-    Serial.println("---------------------\n");
-}
-
-std::string ConfigManager::getTriacMode(int sunRiseMinutes, int sunSetMinutes, const Config &config)
-{
-
-    time_t now;
-
-    struct tm *timeinfo;
-
-    time(&now);
-
-    timeinfo = localtime(&now);
-
-    int currentTimeInMinutes = timeinfo->tm_hour * 60 + timeinfo->tm_min;
-
-    BoilerConfig boilerConfig = config.boiler;
-
-    // Check for "ON" periods first
-    for (const auto &period : boilerConfig.periods)
-    {
-        if (period.mode == "on" || period.mode == "ON")
-        {
-            int startTime = 0;
-            if (period.startSunrise)
-            {
-                startTime = sunRiseMinutes;
-            }
-            else if (period.startSunset)
-            {
-                startTime = sunSetMinutes;
-            }
-            else
-            {
-                startTime = period.start;
-            }
 
-            int endTime = 0;
-            if (period.endSunrise)
-            {
-                endTime = sunRiseMinutes;
-            }
-            else if (period.endSunset)
-            {
-                endTime = sunSetMinutes;
-            }
-            else
-            {
-                endTime = period.end;
-            }
-
-            // Handle periods that cross midnight
-            if (startTime > endTime)
-            {
-                if (currentTimeInMinutes >= startTime || currentTimeInMinutes < endTime)
-                {
-                    return "ON";
-                }
-            }
-            else
-            {
-                if (currentTimeInMinutes >= startTime && currentTimeInMinutes < endTime)
-                {
-                    return "ON";
-                }
-            }
-        }
-    }
-
-    // Then check for "AUTO" periods
-    for (const auto &period : boilerConfig.periods)
-    {
-        if (period.mode == "auto" || period.mode == "AUTO")
-        {
-            int startTime = 0;
-            if (period.startSunrise)
-            {
-                startTime = sunRiseMinutes;
-            }
-            else if (period.startSunset)
-            {
-                startTime = sunSetMinutes;
-            }
-            else
-            {
-                startTime = period.start;
-            }
-
-            int endTime = 0;
-            if (period.endSunrise)
-            {
-                endTime = sunRiseMinutes;
-            }
-            else if (period.endSunset)
-            {
-                endTime = sunSetMinutes;
-            }
-            else
-            {
-                endTime = period.end;
-            }
-
-            // Handle periods that cross midnight
-            if (startTime > endTime)
-            {
-                if (currentTimeInMinutes >= startTime || currentTimeInMinutes < endTime)
-                {
-                    return "AUTO";
-                }
-            }
-            else
-            {
-                if (currentTimeInMinutes >= startTime && currentTimeInMinutes < endTime)
-                {
-                    return "AUTO";
-                }
-            }
-        }
-    }
-
-    // Default to "OFF"
-    return "OFF";
+    Serial.println("Regulation:");
+    Serial.printf("  Setpoint: %.0f W\n", config.regulation.setpoint);
+    Serial.printf("  Kp: %.3f  Ki: %.3f  Kd: %.3f\n", config.regulation.kp, config.regulation.ki, config.regulation.kd);
+    Serial.printf("  Max rate: %.1f %%/s\n", config.regulation.maxRate);
+    Serial.println("---------------------\n");
 }
@@ -4,18 +4,8 @@
 #include <Preferences.h>
 #include <string>
 #include <vector>
-
-// Structure pour une période de fonctionnement
-struct Period
-{
-    int start;
-    bool startSunrise; // La période commence au lever du soleil
-    bool startSunset;  // La période commence au coucher du soleil
-    int end;
-    bool endSunrise; // La période se termine au lever du soleil
-    bool endSunset;  // La période se termine au coucher du soleil
-    std::string mode;
-};
+#include "regulator.h"
+#include "boilerMode.h"
 
 // Structure pour la configuration WiFi
 struct WifiConfig
@@ -39,15 +29,59 @@ struct ShellyEmConfig
 {
     std::string ip;
     std::string channel;
+    int pollPeriod;    // Période d'interrogation (ms), 200 minimum
+    std::string model; // Modèle du compteur : "em" (Gen1), "proem" ou "pro3em" (Gen2)
+};
+
+// Structure pour la configuration de la TIC Linky
+struct LinkyConfig
+{
+    bool standard; // Mode standard (9600 bauds), sinon historique (1200 bauds)
+    int rxPin;     // Broche de réception de la TIC
+};
+
+// Structure pour la configuration d'un compteur Modbus
+struct ModbusMeterConfig
+{
+    std::string transport; // "rtu" (RS485) ou "tcp"
+    std::string device;    // "sdm120", "sdm630" ou "pzem"
+    int address;           // Adresse de l'esclave Modbus
+    std::string host;      // Adresse IP de la passerelle / du compteur (TCP)
+    int port;              // Port TCP
+    int baudRate;          // Vitesse de la liaison RTU
+    int rxPin;             // Broche de réception de la liaison RTU
+    int txPin;             // Broche d'émission de la liaison RTU
+    int dePin;             // Broche de direction du transceiver RS485, -1 si automatique
+    int pollPeriod;        // Période d'interrogation (ms), 200 minimum
+};
+
+// Structure pour la configuration d'un compteur publié sur MQTT
+struct MqttMeterConfig
+{
+    std::string topic; // Topic complet de la puissance
+    std::string key;   // Chemin de la puissance dans le JSON (ex: "ENERGY.Power"), vide si valeur seule
+};
+
+// Structure pour la configuration de la mesure de puissance réseau
+struct MeterConfig
+{
+    std::string source; // "shelly", "linky", "modbus" ou "mqtt"
+    LinkyConfig linky;
+    ModbusMeterConfig modbus;
+    MqttMeterConfig mqtt;
 };
 
 // Structure pour la configuration du chauffe-eau
 struct BoilerConfig
 {
-    std::string mode;
+    BoilerMode mode;
     int temperature;
     std::vector<Period> periods;
-    int triacOpening; // Pourcentage d'ouverture du triac en mode manuel (0-100)
+    int triacOpening; // Puissance commandée en mode manuel (% de la puissance nominale, 0-100)
+    int heaterPower;  // Puissance nominale de la résistance du chauffe-eau (W)
+    std::string outputMode; // Commande du triac : "phase" (angle de phase) ou "burst" (train d'ondes)
+    int sensorResolution;   // Résolution de la sonde de température (bits, 9-12)
+    int sensorInterval;     // Période de lecture de la sonde de température (ms)
 };
 
 // Structure pour la configuration solaire
@@ -66,8 +100,23 @@ struct Config
     WifiConfig wifi;
     MqttConfig mqtt;
     ShellyEmConfig shellyEm;
+    MeterConfig meter;
     BoilerConfig boiler;
     SolarConfig solar;
+    RegulationConfig regulation;
+    uint32_t version; // Version publiée par ConfigStore (0 si non publiée)
+};
+
+// Sections de la configuration, enregistrées chacune dans un blob NVS
+enum ConfigSection
+{
+    SECTION_WIFI,
+    SECTION_MQTT,
+    SECTION_METER, // Compteur (Shelly EM compris)
+    SECTION_BOILER,
+    SECTION_SOLAR,
+    SECTION_REGULATION,
+    SECTION_COUNT
 };
 
 class ConfigManager
@@ -76,14 +125,19 @@ public:
     ConfigManager();
 
     // Méthodes pour gérer la configuration
-    bool saveConfig(const Config &config); // Sauvegarde la configuration dans la mémoire flash
+    bool saveConfig(const Config &config); // Sauvegarde dans la mémoire flash les sections modifiées, false en cas d'échec
     Config loadConfig();                   // Charge la configuration depuis la mémoire flash
     void clearConfig();                    // Efface la configuration de la mémoire flash
-    std::string getTriacMode(int sunRiseMinutes, int sunSetMinutes, const Config &config);
     void printConfig(const Config &config);
 
 private:
+    Config loadLegacyConfig(); // Ancien format (une clé NVS par champ), lu pour la migration
+    void removeLegacyKeys();   // Supprime les clés de l'ancien format, une fois les sections enregistrées
+    // Écrit les sections dont le contenu a changé, retourne false si l'une d'elles n'a pas pu être enregistrée
+    bool writeSections(const Config &config);
+
     Preferences _preferences;
+    uint32_t sectionCrc[SECTION_COUNT]; // CRC du contenu enregistré de chaque section (0 si inconnu)
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,83 @@
+#include "configStore.h"
+#include "sensor.h"
+
+// Nombre maximum de périodes du planning (taille de la section NVS)
+static const size_t MAX_PERIODS = 32;
+
+ConfigStore::ConfigStore(ConfigManager &configManager) : configManager(configManager), version(0)
+{
+    writeMutex = xSemaphoreCreateMutex();
+}
+
+void ConfigStore::begin()
+{
+    std::shared_ptr<Config> loaded = std::make_shared<Config>(configManager.loadConfig());
+    loaded->version = ++version;
+    std::atomic_store(&current, std::shared_ptr<const Config>(loaded));
+}
+
+std::shared_ptr<const Config> ConfigStore::get() const
+{
+    return std::atomic_load(&current);
+}
+
+bool ConfigStore::update(const std::function<void(Config &config)> &mutate)
+{
+    xSemaphoreTake(writeMutex, portMAX_DELAY);
+    std::shared_ptr<Config> next = std::make_shared<Config>(*get());
+    mutate(*next);
+    if (!validate(*next))
+    {
+        xSemaphoreGive(writeMutex);
+        Serial.println("[Config] Configuration invalide, modification ignorée");
+        return false;
+    }
+    if (!configManager.saveConfig(*next))
+    {
+        // Version absente de la flash : non publiée (elle serait perdue au redémarrage)
+        xSemaphoreGive(writeMutex);
+        Serial.println("[Config] Échec de l'enregistrement, modification ignorée");
+        return false;
+    }
+    next->version = ++version;
+    std::atomic_store(&current, std::shared_ptr<const Config>(next));
+    Serial.printf("[Config] Version %u publiée\n", (unsigned)next->version);
+
+    for (const Listener &listener : listeners)
+    {
+        listener(*next);
+    }
+    xSemaphoreGive(writeMutex);
+    return true;
+}
+
+void ConfigStore::subscribe(Listener listener)
+{
+    xSemaphoreTake(writeMutex, portMAX_DELAY);
+    listeners.push_back(listener);
+    xSemaphoreGive(writeMutex);
+}
+
+bool ConfigStore::validate(const Config &config)
+{
+    if (config.mqtt.port <= 0 || config.mqtt.port > 65535)
+        return false;
+    if (config.boiler.temperature < 0 || config.boiler.temperature > 90)
+        return false;
+    if (config.boiler.triacOpening < 0 || config.boiler.triacOpening > 100)
+        return false;
+    if (config.boiler.heaterPower <= 0)
+        return false;
+    if (config.boiler.sensorResolution < SENSOR_MIN_RESOLUTION || config.boiler.sensorResolution > SENSOR_MAX_RESOLUTION || config.boiler.sensorInterval < SENSOR_MIN_INTERVAL)
+        return false;
+    if (config.solar.latitude < -90 || config.solar.latitude > 90 || config.solar.longitude < -180 || config.solar.longitude > 180)
+        return false;
+    if (config.boiler.periods.size() > MAX_PERIODS)
+        return false;
+    for (const Period &period : config.boiler.periods)
+    {
+        if (period.start < 0 || period.start > 1440 || period.end < 0 || period.end > 1440)
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,56 @@
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "configManager.h"
+
+/**
+ * Configuration courante partagée entre les tâches, par instantanés immuables (copie à l'écriture).
+ * Les lecteurs obtiennent l'instantané courant sans verrou applicatif et le conservent le temps de
+ * leur traitement : il n'est jamais modifié, et libéré avec la dernière référence.
+ * Les écrivains modifient une copie, la valident, la sauvegardent en flash puis publient la nouvelle
+ * version (Config::version) et préviennent les abonnés.
+ */
+class ConfigStore
+{
+public:
+    // Appelé après chaque publication, depuis la tâche de l'écrivain
+    typedef std::function<void(const Config &config)> Listener;
+
+    explicit ConfigStore(ConfigManager &configManager);
+
+    // Charge la configuration depuis la flash et publie la première version
+    void begin();
+
+    // Instantané courant (jamais nul après begin())
+    std::shared_ptr<const Config> get() const;
+
+    /**
+     * Modifie la configuration : `mutate` est appliqué à une copie de l'instantané courant.
+     * Les écritures sont sérialisées entre elles ; les lecteurs ne sont pas bloqués.
+     * @return false si la configuration modifiée est invalide (rien n'est sauvegardé ni publié)
+     *         ou n'a pas pu être enregistrée en flash (non publiée).
+     */
+    bool update(const std::function<void(Config &config)> &mutate);
+
+    // Abonnement aux changements de configuration (à faire au démarrage, avant les écritures)
+    void subscribe(Listener listener);
+
+    // Contrôle de cohérence d'une configuration avant publication
+    static bool validate(const Config &config);
+
+private:
+    ConfigManager &configManager;
+    std::shared_ptr<const Config> current;
+    std::atomic<uint32_t> version;
+    SemaphoreHandle_t writeMutex;
+    std::vector<Listener> listeners;
+};
+
+#endif // CONFIG_STORE_H
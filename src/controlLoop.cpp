@@ -0,0 +1,180 @@
+#include "controlLoop.h"
+#include <stdlib.h>
+#include <time.h>
+#include "timezone.h"
+
+volatile float lastTemperature = 0;
+volatile float triacOpeningPercentage = 0;
+volatile float lastPower = 0;
+int nowMinutes = 0;
+int sunriseMinutes = 0;
+int sunsetMinutes = 0;
+volatile bool temperatureReached = false;
+volatile uint32_t regulationLatencyUs = 0;
+volatile uint32_t maxRegulationLatencyUs = 0;
+
+ControlLoop::ControlLoop(SolarManager &solarManager, SolarEphemeris &solarEphemeris, PeriodSchedule &schedule, ControlStateMachine &controlState,
+                         EnergyManager &energyManager, RegulationTrace &regulationTrace, LatencyHistogram &histogram)
+    : solarManager(solarManager), solarEphemeris(solarEphemeris), schedule(schedule), controlState(controlState), energyManager(energyManager),
+      regulationTrace(regulationTrace), histogram(histogram), lastValidSampleTime(0), appliedVersion(0), scheduleVersion(0), cyclesPerUs(240)
+{
+}
+
+void ControlLoop::begin(const Config &config)
+{
+    appliedTimeZone = config.solar.timeZone;
+    cyclesPerUs = getCpuFrequencyMhz();
+}
+
+bool ControlLoop::wait(PowerMeter *meter, MeterSample &sample)
+{
+    if (meter == nullptr)
+    {
+        vTaskDelay(REGULATION_IDLE_PERIOD);
+        return false;
+    }
+    return meter->receive(sample, REGULATION_IDLE_PERIOD) && sample.quality != METER_INVALID;
+}
+
+void ControlLoop::run(const MeterSample *sample, const Config &config)
+{
+    uint32_t passStart = ESP.getCycleCount();
+    bool hasSample = sample != nullptr;
+    if (hasSample)
+    {
+        lastPower = sample->power;
+        lastValidSampleTime = millis();
+        energyManager.addGridSample(sample->power);
+    }
+
+    BoilerMode mode = config.boiler.mode;
+    if (config.version != appliedVersion)
+    {
+        // Nouvelle configuration : paramètres de la commande et fuseau horaire
+        appliedVersion = config.version;
+        solarManager.setOutputMode(parseTriacOutputMode(config.boiler.outputMode));
+        solarManager.configureRegulation(config.regulation);
+        if (config.solar.timeZone != appliedTimeZone)
+        {
+            // Nouveau fuseau horaire : l'heure locale et l'éphéméride sont recalculées
+            appliedTimeZone = config.solar.timeZone;
+            setenv("TZ", getPosixTimezone(appliedTimeZone.c_str()), 1);
+            tzset();
+        }
+    }
+
+    struct tm localNow;
+    if (getLocalTime(&localNow, 0))
+    {
+        // Éphéméride recalculée au changement de jour local, de position ou de fuseau horaire
+        solarEphemeris.update(config.solar.latitude, config.solar.longitude, appliedTimeZone);
+        SolarDay sun = solarEphemeris.get();
+        sunriseMinutes = sun.sunrise;
+        sunsetMinutes = sun.sunset;
+        nowMinutes = localNow.tm_hour * 60 + localNow.tm_min;
+
+        // Planning recompilé à la modification des périodes ou au changement de lever / coucher du soleil
+        if (config.version != scheduleVersion || sunriseMinutes != schedule.getSunrise() || sunsetMinutes != schedule.getSunset())
+        {
+            schedule.compile(config.boiler.periods, sunriseMinutes, sunsetMinutes);
+            scheduleVersion = config.version;
+        }
+
+        // Obtient le mode lié à la configuration personnalisé des périodes
+        PeriodMode periodMode = schedule.getMode(nowMinutes);
+
+        if (nowMinutes == sunriseMinutes)
+        {
+            // Remise à zero de température atteinte, avant le lever du soleil
+            temperatureReached = false;
+        }
+
+        // Choix de l'état de la commande
+        ControlState next;
+        if (lastTemperature > config.boiler.temperature || temperatureReached)
+        {
+            // Le chauffe eau est chaud, plus besoin de régulation
+            // Même si la température redescent en dessous de la température de consigne,
+            // on ne relance le chauffe eau qu'après le prochain lever de soleil
+            temperatureReached = true;
+            next = CONTROL_TEMPERATURE_REACHED;
+        }
+        else if (mode == BOILER_MANUAL)
+        {
+            next = CONTROL_MANUAL;
+        }
+        else if (mode == BOILER_AUTO && periodMode == PERIOD_AUTO)
+        {
+            // Sans mesure valide depuis METER_STALE_PERIOD, pas de routage à l'aveugle
+            bool meterLost = !hasSample && (lastValidSampleTime == 0 || millis() - lastValidSampleTime > METER_STALE_PERIOD);
+            next = meterLost ? CONTROL_METER_LOST : CONTROL_AUTO;
+        }
+        else if (mode == BOILER_ON || periodMode == PERIOD_ON)
+        {
+            next = CONTROL_FORCED_ON;
+        }
+        else
+        {
+            next = CONTROL_OFF;
+        }
+        controlState.transition(next);
+
+        switch (next)
+        {
+        case CONTROL_AUTO:
+            // Mode automatique : régulation à chaque nouvelle mesure
+            if (hasSample)
+            {
+                triacOpeningPercentage = solarManager.updateRegulation(sample->power, config.boiler.heaterPower, sample->quality != METER_UNSIGNED);
+
+                uint32_t latency = micros() - sample->micros;
+                regulationLatencyUs = latency;
+                if (latency > maxRegulationLatencyUs)
+                {
+                    maxRegulationLatencyUs = latency;
+                }
+            }
+            break;
+
+        case CONTROL_MANUAL:
+            // Mode "Manuel"
+            solarManager.setPower(config.boiler.triacOpening);
+            triacOpeningPercentage = config.boiler.triacOpening;
+            break;
+
+        case CONTROL_FORCED_ON:
+            // Mode "Marche Forcée"
+            solarManager.On();
+            triacOpeningPercentage = 100;
+            break;
+
+        case CONTROL_OFF:
+        case CONTROL_TEMPERATURE_REACHED:
+        case CONTROL_METER_LOST:
+            // Arrêt forcé, consigne atteinte ou compteur injoignable
+            solarManager.Off();
+            triacOpeningPercentage = 0;
+            break;
+        }
+
+        if (hasSample)
+        {
+            // Termes du régulateur significatifs uniquement en mode automatique
+            const RegulatorTerms &terms = solarManager.getRegulatorTerms();
+            bool regulating = next == CONTROL_AUTO;
+            TraceRecord record;
+            record.micros = micros();
+            record.latencyUs = record.micros - sample->micros;
+            record.power = sample->power;
+            record.error = regulating ? terms.error : 0;
+            record.integral = regulating ? terms.integral : 0;
+            record.derivative = regulating ? terms.derivative : 0;
+            record.output = triacOpeningPercentage;
+            record.firingDelayUs = solarManager.getFiringDelay();
+            record.state = next;
+            record.quality = sample->quality;
+            regulationTrace.record(record);
+        }
+    }
+    histogram.recordCycles(ESP.getCycleCount() - passStart, cyclesPerUs);
+}
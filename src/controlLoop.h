@@ -0,0 +1,76 @@
+#ifndef CONTROL_LOOP_H
+#define CONTROL_LOOP_H
+
+#include <Arduino.h>
+#include <string>
+#include <freertos/FreeRTOS.h>
+#include "configManager.h"
+#include "controlState.h"
+#include "energyManager.h"
+#include "periodSchedule.h"
+#include "powerMeter.h"
+#include "regulationTrace.h"
+#include "runtimeMetrics.h"
+#include "solarEphemeris.h"
+#include "solarManager.h"
+
+// Attente maximum de la régulation sans mesure, pour suivre les changements de mode et de planning
+const TickType_t REGULATION_IDLE_PERIOD = pdMS_TO_TICKS(1000);
+// Sans mesure valide depuis ce délai (ms), le mode automatique coupe le triac plutôt que de réguler à l'aveugle
+const unsigned long METER_STALE_PERIOD = 5000;
+
+// Valeurs partagées entre la régulation et les autres tâches (LED, communication, API)
+extern volatile float lastTemperature;        // Dernière température mesurée
+extern volatile float triacOpeningPercentage; // Puissance commandée au triac (% de la puissance nominale)
+extern volatile float lastPower;              // Dernière puissance mesurée
+extern int nowMinutes;                        // Heure en minute
+extern int sunriseMinutes;                    // Heure de lever du soleil en minute
+extern int sunsetMinutes;                     // Heure du coucher du soleil en minute
+extern volatile bool temperatureReached;      // True si la température a été atteinte dans la journée (Remise à zéro au lever du soleil)
+extern volatile uint32_t regulationLatencyUs;    // Délai entre la réception de la dernière mesure et la nouvelle commande du triac
+extern volatile uint32_t maxRegulationLatencyUs; // Délai maximum observé
+
+/**
+ * Passage de la tâche de régulation : attente de la mesure du compteur, choix de l'état de la commande
+ * (planning, mode, température, perte du compteur), commande du triac et trace du pas de régulation.
+ * Le même code est exécuté par la tâche signalProcessingTask du firmware et par le simulateur natif.
+ */
+class ControlLoop
+{
+public:
+    ControlLoop(SolarManager &solarManager, SolarEphemeris &solarEphemeris, PeriodSchedule &schedule, ControlStateMachine &controlState,
+                EnergyManager &energyManager, RegulationTrace &regulationTrace, LatencyHistogram &histogram);
+
+    // Fuseau horaire déjà appliqué au démarrage (configTzTime)
+    void begin(const Config &config);
+
+    /**
+     * Attend la prochaine mesure de `meter`, au plus REGULATION_IDLE_PERIOD.
+     * @return false si aucune mesure valide n'est arrivée.
+     */
+    bool wait(PowerMeter *meter, MeterSample &sample);
+
+    /**
+     * Un passage de la régulation.
+     * @param sample Mesure reçue, nullptr si aucune mesure valide n'est arrivée.
+     * @param config Instantané de la configuration, cohérent pour tout le passage.
+     */
+    void run(const MeterSample *sample, const Config &config);
+
+private:
+    SolarManager &solarManager;
+    SolarEphemeris &solarEphemeris;
+    PeriodSchedule &schedule;
+    ControlStateMachine &controlState;
+    EnergyManager &energyManager;
+    RegulationTrace &regulationTrace;
+    LatencyHistogram &histogram;
+
+    unsigned long lastValidSampleTime; // millis() de la dernière mesure valide
+    std::string appliedTimeZone;       // Fuseau horaire appliqué
+    uint32_t appliedVersion;           // Version de la configuration appliquée à la régulation
+    uint32_t scheduleVersion;          // Version de la configuration du planning compilé
+    uint32_t cyclesPerUs;
+};
+
+#endif // CONTROL_LOOP_H
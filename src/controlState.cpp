@@ -0,0 +1,76 @@
+#include "controlState.h"
+
+// Horodatage minimum d'une heure valide (01/01/2020)
+static const time_t MIN_VALID_TIMESTAMP = 1577836800;
+
+const char *controlStateName(ControlState state)
+{
+    switch (state)
+    {
+    case CONTROL_OFF:
+        return "off";
+    case CONTROL_AUTO:
+        return "auto";
+    case CONTROL_FORCED_ON:
+        return "on";
+    case CONTROL_MANUAL:
+        return "manual";
+    case CONTROL_TEMPERATURE_REACHED:
+        return "temperature_reached";
+    case CONTROL_METER_LOST:
+        return "meter_lost";
+    }
+    return "unknown";
+}
+
+ControlStateMachine::ControlStateMachine() : state(CONTROL_OFF), since(0), count(0)
+{
+    mutex = xSemaphoreCreateMutex();
+}
+
+bool ControlStateMachine::transition(ControlState next)
+{
+    if (next == state)
+    {
+        return false;
+    }
+
+    ControlTransition entry;
+    entry.from = state;
+    entry.to = next;
+    entry.millis = millis();
+    time_t now = time(nullptr);
+    entry.time = now >= MIN_VALID_TIMESTAMP ? now : 0;
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    history[count % CONTROL_HISTORY_SIZE] = entry;
+    count++;
+    state = next;
+    since = entry.millis;
+    xSemaphoreGive(mutex);
+
+    Serial.printf("[Control] %s -> %s\n", controlStateName(entry.from), controlStateName(next));
+    return true;
+}
+
+uint32_t ControlStateMachine::getTransitionCount()
+{
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    uint32_t total = count;
+    xSemaphoreGive(mutex);
+    return total;
+}
+
+size_t ControlStateMachine::getTransitions(ControlTransition *transitions, size_t max)
+{
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    size_t available = count < CONTROL_HISTORY_SIZE ? count : CONTROL_HISTORY_SIZE;
+    size_t copied = available < max ? available : max;
+    // Les `copied` plus récentes, dans l'ordre chronologique
+    for (size_t i = 0; i < copied; i++)
+    {
+        transitions[i] = history[(count - copied + i) % CONTROL_HISTORY_SIZE];
+    }
+    xSemaphoreGive(mutex);
+    return copied;
+}
@@ -0,0 +1,72 @@
+#ifndef CONTROL_STATE_H
+#define CONTROL_STATE_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <time.h>
+
+// Nombre de transitions conservées pour l'API
+const size_t CONTROL_HISTORY_SIZE = 16;
+
+// État de la commande du chauffe-eau
+enum ControlState : uint8_t
+{
+    CONTROL_OFF,                 // Arrêt (mode "off" ou hors période)
+    CONTROL_AUTO,                // Régulation sur le surplus
+    CONTROL_FORCED_ON,           // Marche forcée (mode "on" ou période "on")
+    CONTROL_MANUAL,              // Puissance fixe
+    CONTROL_TEMPERATURE_REACHED, // Consigne de température atteinte, arrêt jusqu'au prochain lever du soleil
+    CONTROL_METER_LOST           // Mode automatique sans mesure récente du compteur : arrêt
+};
+
+// Nom de l'état pour les journaux et l'API ("off", "auto", ...)
+const char *controlStateName(ControlState state);
+
+// Changement d'état horodaté
+struct ControlTransition
+{
+    ControlState from;
+    ControlState to;
+    unsigned long millis; // millis() de la transition
+    time_t time;          // Heure de la transition (0 si l'heure n'était pas synchronisée)
+};
+
+/**
+ * Machine à états de la commande du chauffe-eau.
+ * La tâche de régulation choisit l'état à chaque passage ; seuls les changements d'état sont
+ * journalisés et conservés (CONTROL_HISTORY_SIZE dernières transitions), ce qui les rend visibles
+ * depuis l'API sans coût pour la boucle de régulation.
+ */
+class ControlStateMachine
+{
+public:
+    ControlStateMachine();
+
+    /**
+     * Passe dans l'état `next`.
+     * @return true si l'état a changé (transition enregistrée).
+     */
+    bool transition(ControlState next);
+
+    ControlState getState() const { return state; }
+    // millis() de l'entrée dans l'état courant
+    unsigned long getSince() const { return since; }
+    // Nombre total de transitions depuis le démarrage
+    uint32_t getTransitionCount();
+
+    /**
+     * Copie les dernières transitions, de la plus ancienne à la plus récente.
+     * @return nombre de transitions copiées (au plus `max`).
+     */
+    size_t getTransitions(ControlTransition *transitions, size_t max);
+
+private:
+    volatile ControlState state;
+    volatile unsigned long since;
+    ControlTransition history[CONTROL_HISTORY_SIZE];
+    uint32_t count;
+    SemaphoreHandle_t mutex;
+};
+
+#endif // CONTROL_STATE_H
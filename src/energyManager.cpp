@@ -0,0 +1,106 @@
+#include "energyManager.h"
+#include <math.h>
+
+// Horodatage minimum d'une mesure valide (01/01/2020) : pas de changement de jour avant la synchronisation NTP
+static const time_t MIN_VALID_TIMESTAMP = 1577836800;
+// Écart maximum pris en compte entre deux mesures (ms), au-delà l'intervalle est ignoré
+static const unsigned long MAX_SAMPLE_GAP = 10 * 1000;
+
+EnergyManager::EnergyManager() : routedPower(0), gridPower(0), lastRoutedTime(0), lastGridTime(0)
+{
+    memset(&totals, 0, sizeof(totals));
+    mutex = xSemaphoreCreateMutex();
+}
+
+void EnergyManager::begin()
+{
+    preferences.begin("energy", true);
+    if (preferences.getBytesLength("totals") == sizeof(totals))
+    {
+        preferences.getBytes("totals", &totals, sizeof(totals));
+    }
+    preferences.end();
+    Serial.printf("[Energy] Routé aujourd'hui: %.0f Wh, total: %.0f Wh\n", totals.today.routed, totals.total.routed);
+}
+
+void EnergyManager::save()
+{
+    EnergyTotals copy = getTotals();
+    preferences.begin("energy", false);
+    preferences.putBytes("totals", &copy, sizeof(copy));
+    preferences.end();
+}
+
+EnergyTotals EnergyManager::getTotals()
+{
+    EnergyTotals copy;
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    copy = totals;
+    xSemaphoreGive(mutex);
+    return copy;
+}
+
+void EnergyManager::addRoutedSample(float powerPercentage, int heaterPower)
+{
+    unsigned long now = millis();
+    routedPower = heaterPower * powerPercentage / 100.0f;
+    if (lastRoutedTime != 0 && now - lastRoutedTime <= MAX_SAMPLE_GAP)
+    {
+        add(&EnergyCounters::routed, routedPower * (now - lastRoutedTime) / 3600000.0);
+    }
+    lastRoutedTime = now;
+}
+
+void EnergyManager::addGridSample(float power)
+{
+    unsigned long now = millis();
+    gridPower = power;
+    if (lastGridTime != 0 && now - lastGridTime <= MAX_SAMPLE_GAP)
+    {
+        double energy = fabs(power) * (now - lastGridTime) / 3600000.0;
+        add(power > 0 ? &EnergyCounters::imported : &EnergyCounters::exported, energy);
+    }
+    lastGridTime = now;
+}
+
+void EnergyManager::add(double EnergyCounters::*counter, double energy)
+{
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    rollover(time(nullptr));
+    totals.today.*counter += energy;
+    totals.thisMonth.*counter += energy;
+    totals.total.*counter += energy;
+    xSemaphoreGive(mutex);
+}
+
+void EnergyManager::rollover(time_t now)
+{
+    if (now < MIN_VALID_TIMESTAMP)
+    {
+        return; // Heure non synchronisée
+    }
+
+    struct tm local;
+    localtime_r(&now, &local);
+    uint32_t day = (local.tm_year + 1900) * 10000 + (local.tm_mon + 1) * 100 + local.tm_mday;
+    uint32_t month = day / 100;
+
+    if (day != totals.day)
+    {
+        // La veille n'est conservée que si le dernier jour compté est bien celui d'hier
+        time_t yesterdayTime = now - 24 * 3600;
+        localtime_r(&yesterdayTime, &local);
+        uint32_t yesterday = (local.tm_year + 1900) * 10000 + (local.tm_mon + 1) * 100 + local.tm_mday;
+        totals.yesterday = totals.day == yesterday ? totals.today : EnergyCounters{0, 0, 0};
+        totals.today = EnergyCounters{0, 0, 0};
+        totals.day = day;
+    }
+    if (month != totals.month)
+    {
+        // Le mois dernier n'est conservé que si le dernier mois compté est bien le mois précédent
+        uint32_t previousMonth = month % 100 == 1 ? (month / 100 - 1) * 100 + 12 : month - 1;
+        totals.lastMonth = totals.month == previousMonth ? totals.thisMonth : EnergyCounters{0, 0, 0};
+        totals.thisMonth = EnergyCounters{0, 0, 0};
+        totals.month = month;
+    }
+}
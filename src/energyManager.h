@@ -0,0 +1,63 @@
+#ifndef ENERGYMANAGER_H
+#define ENERGYMANAGER_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <time.h>
+
+// Compteurs d'énergie d'une période (Wh)
+struct EnergyCounters
+{
+    double routed;   // Énergie routée vers le chauffe-eau
+    double imported; // Énergie soutirée du réseau
+    double exported; // Énergie injectée sur le réseau
+};
+
+// Ensemble des compteurs, persisté tel quel dans la NVS
+struct EnergyTotals
+{
+    uint32_t day;   // Jour courant (local) au format AAAAMMJJ
+    uint32_t month; // Mois courant (local) au format AAAAMM
+    EnergyCounters today;
+    EnergyCounters yesterday;
+    EnergyCounters thisMonth;
+    EnergyCounters lastMonth;
+    EnergyCounters total;
+};
+
+/**
+ * Comptage de l'énergie routée vers le chauffe-eau et échangée avec le réseau.
+ * La puissance routée est estimée à partir de la commande du triac (linéarisée par la table d'angle de phase)
+ * et de la puissance nominale de la résistance, la puissance réseau provient du Shelly EM.
+ * Les compteurs journaliers et mensuels sont remis à zéro au changement de jour / mois (heure locale).
+ */
+class EnergyManager
+{
+public:
+    EnergyManager();
+
+    void begin(); // Recharge les compteurs depuis la NVS
+    void save();  // Sauvegarde les compteurs dans la NVS
+    // Intègre la puissance routée depuis le dernier appel (powerPercentage : % de la puissance nominale)
+    void addRoutedSample(float powerPercentage, int heaterPower);
+    // Intègre la puissance réseau depuis le dernier appel (> 0 soutirage, < 0 injection)
+    void addGridSample(float gridPower);
+
+    EnergyTotals getTotals();
+    float getRoutedPower() const { return routedPower; }
+    float getGridPower() const { return gridPower; }
+
+private:
+    void rollover(time_t now); // Remise à zéro des compteurs journaliers / mensuels
+    void add(double EnergyCounters::*counter, double energy);
+
+    Preferences preferences;
+    EnergyTotals totals;
+    volatile float routedPower;
+    volatile float gridPower;
+    unsigned long lastRoutedTime;
+    unsigned long lastGridTime;
+    SemaphoreHandle_t mutex;
+};
+
+#endif
@@ -0,0 +1,62 @@
+#include "historyFormat.h"
+#include <math.h>
+
+static size_t putVarint(uint8_t *out, uint32_t value)
+{
+    size_t n = 0;
+    while (value >= 0x80)
+    {
+        out[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (uint8_t)value;
+    return n;
+}
+
+static size_t putInt16(uint8_t *out, int16_t value)
+{
+    out[0] = (uint8_t)(value & 0xFF);
+    out[1] = (uint8_t)((value >> 8) & 0xFF);
+    return 2;
+}
+
+int16_t historyToFixedPoint(float value, uint16_t scale)
+{
+    if (isnan(value))
+        return INT16_MIN;
+    float scaled = roundf(value * scale);
+    if (scaled > INT16_MAX)
+        return INT16_MAX;
+    // INT16_MIN est réservé aux valeurs non définies
+    if (scaled <= INT16_MIN)
+        return INT16_MIN + 1;
+    return (int16_t)scaled;
+}
+
+size_t encodeHistoryHeader(uint8_t *out, uint32_t step, uint16_t scale)
+{
+    size_t n = 0;
+    out[n++] = 'R';
+    out[n++] = 'H';
+    out[n++] = HISTORY_BIN_VERSION;
+    out[n++] = step == 0 ? HISTORY_BIN_VALUE : HISTORY_BIN_BUCKET;
+    out[n++] = scale & 0xFF;
+    out[n++] = scale >> 8;
+    for (int i = 0; i < 4; i++)
+        out[n++] = (step >> (8 * i)) & 0xFF;
+    return n;
+}
+
+size_t encodeHistoryBucket(uint8_t *out, const HistoryBucket &bucket, time_t previous, uint32_t step, uint16_t scale)
+{
+    size_t n = 0;
+    n += putVarint(out + n, (uint32_t)(bucket.start - previous));
+    n += putInt16(out + n, historyToFixedPoint(bucket.avg, scale));
+    if (step != 0)
+    {
+        n += putInt16(out + n, historyToFixedPoint(bucket.min, scale));
+        n += putInt16(out + n, historyToFixedPoint(bucket.max, scale));
+        n += putInt16(out + n, (int16_t)(bucket.count < UINT16_MAX ? bucket.count : UINT16_MAX));
+    }
+    return n;
+}
@@ -0,0 +1,32 @@
+#ifndef HISTORY_FORMAT_H
+#define HISTORY_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "historyManager.h"
+
+/**
+ * Format binaire de l'historique (little-endian) :
+ *   en-tête : 'R' 'H', version (u8), champs (u8), échelle (u16), pas en secondes (u32)
+ *   puis par intervalle : delta d'horodatage (varint, absolu pour le premier),
+ *   valeur moyenne (i16 = valeur * échelle, INT16_MIN si non définie) et, si champs == HISTORY_BIN_BUCKET,
+ *   min (i16), max (i16), nombre de points (u16).
+ * L'échelle est propre à chaque série (HistoryTiers::getBinaryScale) : elle est choisie pour que les valeurs
+ * de la série tiennent dans un i16 (valeurs hors limites bornées à INT16_MAX / INT16_MIN + 1).
+ */
+static const uint8_t HISTORY_BIN_VERSION = 1;
+static const uint8_t HISTORY_BIN_VALUE = 1;
+static const uint8_t HISTORY_BIN_BUCKET = 2;
+static const size_t HISTORY_BIN_HEADER_SIZE = 10;
+static const size_t HISTORY_BIN_RECORD_MAX_SIZE = 5 + 4 * 2; // varint de 32 bits + 4 valeurs i16
+
+// Écrit l'en-tête dans `out` (HISTORY_BIN_HEADER_SIZE octets), retourne le nombre d'octets écrits
+size_t encodeHistoryHeader(uint8_t *out, uint32_t step, uint16_t scale);
+
+// Écrit un intervalle dans `out` (au plus HISTORY_BIN_RECORD_MAX_SIZE octets), `previous` : horodatage du précédent (0 pour le premier)
+size_t encodeHistoryBucket(uint8_t *out, const HistoryBucket &bucket, time_t previous, uint32_t step, uint16_t scale);
+
+// Valeur en virgule fixe (valeur * échelle), INT16_MIN si non définie
+int16_t historyToFixedPoint(float value, uint16_t scale);
+
+#endif // HISTORY_FORMAT_H
@@ -1,68 +1,113 @@
 #include "historyManager.h"
 
 // Implémentation pour HistoryManager utilisant `float`.
-HistoryManager::HistoryManager(size_t capacity) : capacity(capacity), head(0), tail(0), count(0)
+HistoryManager::HistoryManager(size_t capacity, uint32_t samplePeriod) : ring(capacity), samplePeriod(samplePeriod)
 {
-    buffer = new DataPoint[capacity];
-    mutex = xSemaphoreCreateMutex();
 }
 
-HistoryManager::~HistoryManager()
+DataPoint HistoryManager::add(float value)
 {
-    delete[] buffer;
-    vSemaphoreDelete(mutex);
+    DataPoint added;
+    added.value = value;
+    time(&added.timestamp);
+    add(added);
+    return added;
 }
 
-void HistoryManager::add(float value)
+void HistoryManager::add(const DataPoint &dataPoint)
 {
-    if (xSemaphoreTake(mutex, portMAX_DELAY) == pdTRUE)
-    {
-        DataPoint &dataPoint = buffer[tail];
-        dataPoint.value = value;
-        time(&dataPoint.timestamp);
-
-        tail = (tail + 1) % capacity;
+    ring.push(dataPoint);
+}
 
-        if (count < capacity)
+time_t HistoryManager::oldest()
+{
+    DataPoint dp;
+    for (;;)
+    {
+        uint32_t first = ring.begin();
+        if (first == ring.end())
         {
-            count++;
+            return 0;
         }
-        else
+        if (ring.read(first, dp))
         {
-            head = (head + 1) % capacity;
+            return dp.timestamp;
         }
-        xSemaphoreGive(mutex);
+        // Point écrasé pendant la lecture : nouvel essai avec le plus ancien point restant
     }
 }
 
-std::vector<DataPoint> HistoryManager::getData()
+uint32_t HistoryManager::lowerBound(time_t timestamp, uint32_t last)
 {
-    std::vector<DataPoint> data;
-    if (xSemaphoreTake(mutex, portMAX_DELAY) == pdTRUE)
+    // Les points sont ajoutés dans l'ordre chronologique : recherche dichotomique sur l'index absolu.
+    // Un point écrasé pendant la recherche est plus ancien que tous les points restants.
+    uint32_t low = ring.begin();
+    uint32_t high = last;
+    DataPoint dp;
+    while (low < high)
     {
-        data.reserve(count);
-        if (count > 0)
+        uint32_t mid = low + (high - low) / 2;
+        if (!ring.read(mid, dp) || dp.timestamp < timestamp)
         {
-            size_t current = head;
-            for (size_t i = 0; i < count; i++)
-            {
-                data.push_back(buffer[current]);
-                current = (current + 1) % capacity;
-            }
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
         }
-        xSemaphoreGive(mutex);
     }
-    return data;
+    return low;
 }
 
-void HistoryManager::serialize(JsonDocument &doc)
+bool HistoryManager::nextBucket(time_t &cursor, time_t origin, time_t to, uint32_t step, HistoryBucket &bucket)
 {
-    JsonArray array = doc.to<JsonArray>();
-    std::vector<DataPoint> data = getData();
-    for (const auto &dp : data)
+    uint32_t last = ring.end();
+    uint32_t i = lowerBound(cursor, last);
+
+    DataPoint first;
+    while (i < last && !ring.read(i, first))
+    {
+        // Rattrapé par l'écrivain : reprise au plus ancien point encore présent
+        uint32_t oldest = ring.begin();
+        i = oldest > i ? oldest : i + 1;
+    }
+    if (i >= last || first.timestamp >= to)
+    {
+        return false;
+    }
+
+    bucket.start = historyBucketStart(first.timestamp, origin, step);
+    time_t end = step == 0 ? first.timestamp + 1 : bucket.start + step;
+    if (end > to)
     {
-        JsonObject obj = array.add<JsonObject>();
-        obj["time"] = dp.timestamp;
-        obj["value"] = dp.value;
+        end = to;
+    }
+
+    float sum = 0;
+    size_t n = 0;
+    bucket.min = first.value;
+    bucket.max = first.value;
+    DataPoint dp;
+    for (; i < last; i++)
+    {
+        if (!ring.read(i, dp))
+        {
+            continue; // Point écrasé entre temps
+        }
+        if (dp.timestamp >= end)
+        {
+            break;
+        }
+        if (dp.value < bucket.min)
+            bucket.min = dp.value;
+        if (dp.value > bucket.max)
+            bucket.max = dp.value;
+        sum += dp.value;
+        n++;
     }
+    bucket.avg = n > 0 ? sum / n : first.value;
+    bucket.energy = sum * samplePeriod / 3600.0f;
+    bucket.count = n;
+    cursor = end;
+    return true;
 }
@@ -3,8 +3,8 @@
 
 #include <Arduino.h>
 #include <time.h>
-#include <vector>
-#include <ArduinoJson.h>
+#include <limits>
+#include "seqlockRing.h"
 
 // Structure pour un point de donnée horodaté (utilise `float` pour la valeur).
 struct DataPoint
@@ -13,24 +13,76 @@ struct DataPoint
     float value;
 };
 
+// Agrégat (min/max/moyenne) des points d'un intervalle de temps [start, start + step[
+struct HistoryBucket
+{
+    time_t start;   // Début de l'intervalle (ou horodatage du point en mode brut)
+    float min;      // Valeur minimale de l'intervalle
+    float max;      // Valeur maximale de l'intervalle
+    float avg;      // Moyenne des points de l'intervalle
+    float energy;   // Intégrale de la valeur sur l'intervalle, en valeur x heure (Wh pour une puissance)
+    uint32_t count; // Nombre de mesures agrégées
+};
+
+// Fin de période sans limite pour nextBucket (time_t est un entier signé de 32 bits sur l'ESP32 : pas de UINT32_MAX)
+const time_t HISTORY_TIME_MAX = std::numeric_limits<time_t>::max();
+
+// Horodatage reçu d'une requête (entier non signé), borné à HISTORY_TIME_MAX
+inline time_t historyTimeFromUnsigned(unsigned long timestamp)
+{
+    return timestamp > (unsigned long)HISTORY_TIME_MAX ? HISTORY_TIME_MAX : (time_t)timestamp;
+}
+
+/**
+ * Début de l'intervalle contenant `timestamp`, les intervalles de `step` secondes étant alignés sur `origin`.
+ * Avec `step` == 0 (points bruts), chaque point forme son propre intervalle.
+ */
+inline time_t historyBucketStart(time_t timestamp, time_t origin, uint32_t step)
+{
+    return step == 0 ? timestamp : origin + ((timestamp - origin) / step) * step;
+}
+
+/**
+ * Source d'historique interrogeable par intervalles (tampon RAM, journal sur la flash, agrégats)
+ */
+class HistorySource
+{
+public:
+    virtual ~HistorySource() {}
+
+    /**
+     * Calcule le prochain intervalle non vide à partir de `cursor`, sans copier les données.
+     * Les intervalles sont alignés sur `origin` et ont une durée de `step` secondes (0 = points bruts).
+     * Seuls les points dont l'horodatage est inférieur à `to` sont pris en compte.
+     * @return false s'il n'y a plus de point, sinon `cursor` est avancé à la fin de l'intervalle.
+     */
+    virtual bool nextBucket(time_t &cursor, time_t origin, time_t to, uint32_t step, HistoryBucket &bucket) = 0;
+
+    // Horodatage du plus ancien point disponible (0 si vide)
+    virtual time_t oldest() = 0;
+};
+
 // Classe de tampon circulaire pour stocker un historique de données de type `float`.
+// Un seul écrivain (voir SeqlockRing) : l'ajout ne bloque jamais, les lectures se font en place sans verrou.
 // Déclarations seulement — les implémentations sont dans `historyManager.cpp`.
-class HistoryManager
+class HistoryManager : public HistorySource
 {
 public:
-    HistoryManager(size_t capacity);
-    ~HistoryManager();
-    void add(float value);
-    std::vector<DataPoint> getData();
-    void serialize(JsonDocument &doc);
+    HistoryManager(size_t capacity, uint32_t samplePeriod = 60); // samplePeriod : intervalle entre deux points (s)
+    DataPoint add(float value);          // Ajoute un point horodaté et le retourne (pour diffusion incrémentale)
+    void add(const DataPoint &dataPoint); // Ajoute un point déjà horodaté (rechargement depuis la flash)
+    time_t oldest() override;             // Horodatage du plus ancien point (0 si vide)
+    bool nextBucket(time_t &cursor, time_t origin, time_t to, uint32_t step, HistoryBucket &bucket) override;
+
+    // Parcourt les points du plus ancien au plus récent (visit(const DataPoint &)), sans copie du tampon
+    template <typename Visitor>
+    size_t forEach(Visitor visit) const { return ring.forEach(visit); }
 
 private:
-    DataPoint *buffer;       // Le tampon de données alloué dynamiquement
-    size_t capacity;         // Capacité maximale du tampon
-    size_t head;             // Index du plus ancien élément
-    size_t tail;             // Index où sera inséré le prochain élément
-    size_t count;            // Nombre actuel d'éléments dans le tampon
-    SemaphoreHandle_t mutex; // Mutex pour la synchronisation entre les tâches
+    uint32_t lowerBound(time_t timestamp, uint32_t last); // Index absolu du premier point >= timestamp
+
+    SeqlockRing<DataPoint> ring; // Tampon des points
+    uint32_t samplePeriod;       // Intervalle entre deux points, en secondes (calcul de l'énergie)
 };
 
 #endif // HISTORY_MANAGER_H
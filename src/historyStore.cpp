@@ -0,0 +1,641 @@
+#include "historyStore.h"
+#include <LittleFS.h>
+#include <algorithm>
+
+// Horodatage minimum d'un point valide (01/01/2020) : ignore les points enregistrés avant la synchronisation NTP
+static const uint32_t MIN_VALID_TIMESTAMP = 1577836800;
+static const uint32_t SECONDS_PER_DAY = 24 * 60 * 60;
+// Taux d'occupation maximum de la partition avant suppression des segments les plus anciens
+static const size_t MAX_FS_USAGE_PERCENT = 85;
+
+std::atomic<bool> HistoryStore::writesSuspended(false);
+
+HistoryStore::HistoryStore(const char *name, uint32_t samplePeriod, uint16_t retentionDays)
+    : dir(String("/history/") + name), samplePeriod(samplePeriod), retentionDays(retentionDays), pendingCount(0), readSegmentId(0),
+      readSegmentCount(0)
+{
+    mutex = xSemaphoreCreateMutex();
+}
+
+HistoryStore::~HistoryStore()
+{
+    vSemaphoreDelete(mutex);
+}
+
+String HistoryStore::segmentPath(uint32_t id)
+{
+    return dir + "/" + String(id) + ".bin";
+}
+
+/**
+ * Lecture de l'index et réparation du dernier segment (écriture interrompue par une coupure de courant)
+ */
+bool HistoryStore::begin()
+{
+    if (!LittleFS.exists("/history"))
+    {
+        LittleFS.mkdir("/history");
+    }
+    if (!LittleFS.exists(dir))
+    {
+        LittleFS.mkdir(dir);
+    }
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    if (!loadIndex())
+    {
+        Serial.printf("[History] Index %s absent ou invalide, reconstruction ...\n", dir.c_str());
+        rebuildIndex();
+    }
+
+    // Seul le dernier segment peut avoir été modifié depuis l'écriture de l'index
+    if (!segments.empty() && !repairSegment(segments.back()))
+    {
+        removeSegment(segments.size() - 1);
+    }
+    saveIndex();
+
+    size_t total = 0;
+    for (const auto &segment : segments)
+    {
+        total += segment.count;
+    }
+    Serial.printf("[History] %s : %u segments, %u points\n", dir.c_str(), segments.size(), total);
+    xSemaphoreGive(mutex);
+    return true;
+}
+
+bool HistoryStore::loadIndex()
+{
+    segments.clear();
+    File index = LittleFS.open(dir + "/index.bin", "r");
+    if (!index)
+    {
+        return false;
+    }
+    size_t size = index.size();
+    if (size % sizeof(HistorySegment) != 0)
+    {
+        index.close();
+        return false;
+    }
+    segments.resize(size / sizeof(HistorySegment));
+    bool ok = index.read((uint8_t *)segments.data(), size) == size;
+    index.close();
+
+    // Ignore les entrées dont le fichier a disparu
+    for (size_t i = 0; ok && i < segments.size();)
+    {
+        if (!LittleFS.exists(segmentPath(segments[i].id)))
+        {
+            segments.erase(segments.begin() + i);
+        }
+        else
+        {
+            i++;
+        }
+    }
+    return ok;
+}
+
+/**
+ * Reconstruction complète de l'index en parcourant les fichiers de segment
+ */
+void HistoryStore::rebuildIndex()
+{
+    segments.clear();
+    File root = LittleFS.open(dir);
+    while (File file = root.openNextFile())
+    {
+        String name = file.name();
+        file.close();
+        if (!name.endsWith(".bin") || name == "index.bin")
+        {
+            continue;
+        }
+        HistorySegment segment = {(uint32_t)name.toInt(), 0, 0, 0};
+        if (repairSegment(segment))
+        {
+            segments.push_back(segment);
+        }
+        else
+        {
+            LittleFS.remove(segmentPath(segment.id));
+        }
+    }
+    std::sort(segments.begin(), segments.end(), [](const HistorySegment &a, const HistorySegment &b)
+              { return a.id < b.id; });
+}
+
+bool HistoryStore::saveIndex()
+{
+    // Écriture dans un fichier temporaire puis renommage, pour ne jamais laisser un index partiel
+    String tmpPath = dir + "/index.tmp";
+    File index = LittleFS.open(tmpPath, "w");
+    if (!index)
+    {
+        return false;
+    }
+    size_t size = segments.size() * sizeof(HistorySegment);
+    bool ok = index.write((const uint8_t *)segments.data(), size) == size;
+    index.close();
+    if (!ok)
+    {
+        LittleFS.remove(tmpPath);
+        return false;
+    }
+    LittleFS.remove(dir + "/index.bin");
+    return LittleFS.rename(tmpPath, dir + "/index.bin");
+}
+
+/**
+ * Met à jour l'entrée d'index d'après le contenu du fichier.
+ * Un enregistrement partiel en fin de fichier est supprimé en réécrivant le segment.
+ * @return false si le segment est vide ou illisible
+ */
+bool HistoryStore::repairSegment(HistorySegment &segment)
+{
+    String path = segmentPath(segment.id);
+    File file = LittleFS.open(path, "r");
+    if (!file)
+    {
+        return false;
+    }
+    size_t size = file.size();
+    size_t count = size / sizeof(HistoryRecord);
+
+    if (size % sizeof(HistoryRecord) != 0 && count > 0)
+    {
+        Serial.printf("[History] Réparation du segment %s\n", path.c_str());
+        String tmpPath = dir + "/repair.tmp";
+        File tmp = LittleFS.open(tmpPath, "w");
+        uint8_t buf[sizeof(HistoryRecord) * 16];
+        size_t remaining = count * sizeof(HistoryRecord);
+        while (tmp && remaining > 0)
+        {
+            size_t n = file.read(buf, std::min(remaining, sizeof(buf)));
+            if (n == 0)
+                break;
+            if (tmp.write(buf, n) != n)
+                break;
+            remaining -= n;
+        }
+        file.close();
+        bool copied = tmp && remaining == 0;
+        if (tmp)
+        {
+            tmp.close();
+        }
+        if (!copied)
+        {
+            // Copie incomplète (partition pleine) : on garde l'original plutôt qu'un segment tronqué
+            LittleFS.remove(tmpPath);
+            return false;
+        }
+        LittleFS.remove(path);
+        LittleFS.rename(tmpPath, path);
+        file = LittleFS.open(path, "r");
+        if (!file)
+        {
+            return false;
+        }
+    }
+
+    HistoryRecord first, last;
+    bool ok = count > 0 && readRecord(file, 0, first) && readRecord(file, count - 1, last);
+    file.close();
+    if (ok)
+    {
+        segment.first = first.timestamp;
+        segment.last = last.timestamp;
+        segment.count = count;
+    }
+    return ok;
+}
+
+bool HistoryStore::readRecord(File &file, size_t index, HistoryRecord &record)
+{
+    return file.seek(index * sizeof(HistoryRecord)) && file.read((uint8_t *)&record, sizeof(record)) == sizeof(record);
+}
+
+void HistoryStore::removeSegment(size_t segmentIndex)
+{
+    if (readFile && readSegmentId == segments[segmentIndex].id)
+    {
+        readFile.close();
+    }
+    LittleFS.remove(segmentPath(segments[segmentIndex].id));
+    segments.erase(segments.begin() + segmentIndex);
+}
+
+void HistoryStore::append(const DataPoint &point)
+{
+    if ((uint32_t)point.timestamp < MIN_VALID_TIMESTAMP)
+    {
+        return; // Heure non synchronisée
+    }
+
+    bool full;
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    if (pendingCount >= PENDING_SIZE)
+    {
+        // Écritures suspendues et lot plein : le point est abandonné
+        xSemaphoreGive(mutex);
+        return;
+    }
+    pending[pendingCount].timestamp = (uint32_t)point.timestamp;
+    pending[pendingCount].value = point.value;
+    pendingCount++;
+    full = pendingCount >= PENDING_SIZE;
+    xSemaphoreGive(mutex);
+
+    if (full)
+    {
+        flush();
+    }
+}
+
+/**
+ * Écriture du lot en attente : une seule ouverture de fichier par segment concerné
+ */
+bool HistoryStore::flush()
+{
+    if (areWritesSuspended())
+    {
+        return false; // Partition en cours de réécriture : le lot reste en attente
+    }
+    bool ok = true;
+    bool newSegment = false;
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    size_t i = 0;
+    while (i < pendingCount)
+    {
+        uint32_t id = pending[i].timestamp / SECONDS_PER_DAY;
+        size_t runEnd = i;
+        while (runEnd < pendingCount && pending[runEnd].timestamp / SECONDS_PER_DAY == id)
+        {
+            runEnd++;
+        }
+
+        if (segments.empty() || segments.back().id != id)
+        {
+            if (!segments.empty() && segments.back().id > id)
+            {
+                // Point antérieur au dernier segment (changement d'heure système) : ignoré
+                i = runEnd;
+                continue;
+            }
+            segments.push_back({id, pending[i].timestamp, pending[i].timestamp, 0});
+            newSegment = true;
+        }
+
+        HistorySegment &segment = segments.back();
+        File file = LittleFS.open(segmentPath(id), "a");
+        size_t size = (runEnd - i) * sizeof(HistoryRecord);
+        bool written = file && file.write((const uint8_t *)&pending[i], size) == size;
+        if (file)
+        {
+            file.close();
+        }
+        if (written)
+        {
+            segment.count += runEnd - i;
+            segment.last = pending[runEnd - 1].timestamp;
+        }
+        else
+        {
+            // Écriture en échec ou partielle : le segment est ramené à ses enregistrements complets
+            // (sinon les ajouts suivants seraient décalés), ou retiré s'il n'en contient aucun
+            ok = false;
+            if (readFile && readSegmentId == id)
+            {
+                readFile.close();
+            }
+            if (!repairSegment(segment))
+            {
+                removeSegment(segments.size() - 1);
+                newSegment = true; // Index à réécrire
+            }
+        }
+        i = runEnd;
+    }
+    pendingCount = 0;
+
+    if (newSegment)
+    {
+        saveIndex();
+    }
+    xSemaphoreGive(mutex);
+
+    if (newSegment)
+    {
+        compact();
+    }
+    return ok;
+}
+
+/**
+ * Compaction : suppression des segments expirés, puis des plus anciens tant que la partition est trop remplie
+ */
+void HistoryStore::compact()
+{
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    bool changed = false;
+    if (!segments.empty())
+    {
+        uint32_t lastId = segments.back().id;
+        while (segments.size() > 1 && segments.front().id + retentionDays < lastId)
+        {
+            Serial.printf("[History] Suppression du segment expiré %s\n", segmentPath(segments.front().id).c_str());
+            removeSegment(0);
+            changed = true;
+        }
+    }
+    while (segments.size() > 1 && LittleFS.usedBytes() * 100 > LittleFS.totalBytes() * MAX_FS_USAGE_PERCENT)
+    {
+        Serial.printf("[History] Partition pleine, suppression du segment %s\n", segmentPath(segments.front().id).c_str());
+        removeSegment(0);
+        changed = true;
+    }
+    if (changed)
+    {
+        saveIndex();
+    }
+    xSemaphoreGive(mutex);
+}
+
+/**
+ * Recharge dans le tampon RAM les points des `duration` dernières secondes enregistrées
+ */
+size_t HistoryStore::restore(HistoryManager &history, uint32_t duration)
+{
+    size_t restored = 0;
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    if (!segments.empty())
+    {
+        uint32_t since = segments.back().last > duration ? segments.back().last - duration : 0;
+        for (const auto &segment : segments)
+        {
+            if (segment.last < since)
+            {
+                continue;
+            }
+            File file = LittleFS.open(segmentPath(segment.id), "r");
+            HistoryRecord record;
+            while (file && file.read((uint8_t *)&record, sizeof(record)) == sizeof(record))
+            {
+                if (record.timestamp >= since)
+                {
+                    DataPoint point;
+                    point.timestamp = record.timestamp;
+                    point.value = record.value;
+                    history.add(point);
+                    restored++;
+                }
+            }
+            if (file)
+            {
+                file.close();
+            }
+        }
+    }
+    xSemaphoreGive(mutex);
+    Serial.printf("[History] %s : %u points rechargés\n", dir.c_str(), restored);
+    return restored;
+}
+
+time_t HistoryStore::oldest()
+{
+    time_t timestamp = 0;
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    if (!segments.empty())
+    {
+        timestamp = segments.front().first;
+    }
+    xSemaphoreGive(mutex);
+    return timestamp;
+}
+
+time_t HistoryStore::newest()
+{
+    time_t timestamp = 0;
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    if (!segments.empty())
+    {
+        timestamp = segments.back().last;
+    }
+    xSemaphoreGive(mutex);
+    return timestamp;
+}
+
+bool HistoryStore::openSegment(size_t segmentIndex)
+{
+    uint32_t id = segments[segmentIndex].id;
+    // Un fichier ouvert avant un ajout par flush() (autre descripteur) ne voit pas forcément les nouveaux points
+    if (readFile && readSegmentId == id && readSegmentCount == segments[segmentIndex].count)
+    {
+        return true;
+    }
+    if (readFile)
+    {
+        readFile.close();
+    }
+    readFile = LittleFS.open(segmentPath(id), "r");
+    readSegmentId = id;
+    readSegmentCount = segments[segmentIndex].count;
+    return (bool)readFile;
+}
+
+bool HistoryStore::nextBucket(time_t &cursor, time_t origin, time_t to, uint32_t step, HistoryBucket &bucket)
+{
+    bool found = false;
+    xSemaphoreTake(mutex, portMAX_DELAY);
+
+    // Premier segment susceptible de contenir un point >= cursor
+    size_t s = 0;
+    while (s < segments.size() && (time_t)segments[s].last < cursor)
+    {
+        s++;
+    }
+
+    // Un segment illisible ou sans enregistrement >= cursor ne termine pas la recherche : segment suivant
+    for (; !found && s < segments.size() && (time_t)segments[s].first < to; s++)
+    {
+        if (!openSegment(s))
+        {
+            continue;
+        }
+
+        // Recherche dichotomique du premier enregistrement >= cursor dans le segment
+        size_t low = 0;
+        size_t high = segments[s].count;
+        HistoryRecord record;
+        while (low < high)
+        {
+            size_t mid = (low + high) / 2;
+            if (readRecord(readFile, mid, record) && (time_t)record.timestamp < cursor)
+            {
+                low = mid + 1;
+            }
+            else
+            {
+                high = mid;
+            }
+        }
+
+        if (low >= segments[s].count || !readRecord(readFile, low, record))
+        {
+            continue;
+        }
+        if ((time_t)record.timestamp >= to)
+        {
+            break; // Segments suivants plus récents
+        }
+
+        bucket.start = historyBucketStart(record.timestamp, origin, step);
+        time_t end = step == 0 ? record.timestamp + 1 : bucket.start + step;
+        if (end > to)
+        {
+            end = to;
+        }
+
+        float sum = 0;
+        size_t n = 0;
+        bucket.min = record.value;
+        bucket.max = record.value;
+
+        // Lecture séquentielle, éventuellement sur les segments suivants
+        size_t index = low;
+        while ((time_t)record.timestamp < end)
+        {
+            if (record.value < bucket.min)
+                bucket.min = record.value;
+            if (record.value > bucket.max)
+                bucket.max = record.value;
+            sum += record.value;
+            n++;
+
+            index++;
+            bool more = true;
+            while (more && index >= segments[s].count)
+            {
+                // Segment suivant (les segments vides sont sautés)
+                s++;
+                index = 0;
+                more = s < segments.size() && (time_t)segments[s].first < end && openSegment(s);
+                if (more)
+                {
+                    readFile.seek(0);
+                }
+            }
+            if (!more || readFile.read((uint8_t *)&record, sizeof(record)) != sizeof(record))
+            {
+                break;
+            }
+        }
+
+        bucket.avg = sum / n;
+        bucket.energy = sum * samplePeriod / 3600.0f;
+        bucket.count = n;
+        cursor = end;
+        found = true;
+    }
+
+    xSemaphoreGive(mutex);
+    return found;
+}
+
+size_t HistoryStore::backup(std::vector<HistoryBackupFile> &files, size_t budget)
+{
+    // Fichiers candidats : agrégats journaliers d'abord (petits, 62 jours), puis segments du plus récent au plus ancien
+    struct Candidate
+    {
+        String path;
+        size_t size;
+        uint32_t priority;
+    };
+    std::vector<Candidate> candidates;
+    File root = LittleFS.open("/history");
+    while (root && root.isDirectory())
+    {
+        File series = root.openNextFile();
+        if (!series)
+        {
+            break;
+        }
+        if (!series.isDirectory())
+        {
+            series.close();
+            continue;
+        }
+        String seriesPath = String("/history/") + series.name();
+        while (File file = series.openNextFile())
+        {
+            String name = file.name();
+            size_t size = file.size();
+            file.close();
+            if (name == "days.agg")
+            {
+                candidates.push_back({seriesPath + "/" + name, size, UINT32_MAX});
+            }
+            else if (name.endsWith(".bin") && name != "index.bin")
+            {
+                candidates.push_back({seriesPath + "/" + name, size, (uint32_t)name.toInt()});
+            }
+        }
+        series.close();
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b)
+              { return a.priority > b.priority; });
+
+    size_t total = 0;
+    for (const Candidate &candidate : candidates)
+    {
+        if (total + candidate.size > budget)
+        {
+            continue;
+        }
+        File file = LittleFS.open(candidate.path, "r");
+        if (!file)
+        {
+            continue;
+        }
+        HistoryBackupFile copy;
+        copy.path = candidate.path;
+        copy.data.resize(candidate.size);
+        bool ok = file.read(copy.data.data(), candidate.size) == candidate.size;
+        file.close();
+        if (ok)
+        {
+            total += candidate.size;
+            files.push_back(std::move(copy));
+        }
+    }
+    Serial.printf("[History] Sauvegarde en RAM : %u fichiers sur %u, %u octets\n", files.size(), candidates.size(), total);
+    return total;
+}
+
+bool HistoryStore::restoreBackup(const std::vector<HistoryBackupFile> &files)
+{
+    bool ok = true;
+    if (!LittleFS.exists("/history"))
+    {
+        LittleFS.mkdir("/history");
+    }
+    for (const HistoryBackupFile &copy : files)
+    {
+        String seriesPath = copy.path.substring(0, copy.path.lastIndexOf('/'));
+        if (!LittleFS.exists(seriesPath))
+        {
+            LittleFS.mkdir(seriesPath);
+        }
+        File file = LittleFS.open(copy.path, "w");
+        ok = file && file.write(copy.data.data(), copy.data.size()) == copy.data.size() && ok;
+        if (file)
+        {
+            file.close();
+        }
+    }
+    Serial.printf("[History] Restauration de %u fichiers %s\n", files.size(), ok ? "terminée" : "incomplète");
+    return ok;
+}
@@ -0,0 +1,99 @@
+#ifndef HISTORY_STORE_H
+#define HISTORY_STORE_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <atomic>
+#include <vector>
+#include "historyManager.h"
+
+// Enregistrement d'un point sur la flash (8 octets, taille fixe pour permettre la recherche dichotomique)
+struct __attribute__((packed)) HistoryRecord
+{
+    uint32_t timestamp;
+    float value;
+};
+
+// Entrée de l'index : un segment correspond à un fichier contenant une journée (UTC) de points
+struct HistorySegment
+{
+    uint32_t id;    // Numéro du jour UTC (timestamp / 86400), également nom du fichier
+    uint32_t first; // Horodatage du premier point du segment
+    uint32_t last;  // Horodatage du dernier point du segment
+    uint32_t count; // Nombre de points du segment
+};
+
+// Copie en RAM d'un fichier de l'historique (sauvegarde pendant la réécriture de la partition LittleFS)
+struct HistoryBackupFile
+{
+    String path;
+    std::vector<uint8_t> data;
+};
+
+/**
+ * Journal persistant d'un historique sur la partition LittleFS.
+ * Les points sont ajoutés en fin de segment (fichiers journaliers en ajout seul) par lots,
+ * afin de limiter le nombre d'écritures sur la flash. Un petit fichier d'index permet
+ * de retrouver les segments au démarrage sans relire les fichiers, et la compaction
+ * supprime les segments expirés ou les plus anciens si la partition se remplit.
+ */
+class HistoryStore : public HistorySource
+{
+public:
+    HistoryStore(const char *name, uint32_t samplePeriod = 60, uint16_t retentionDays = 14);
+    ~HistoryStore();
+
+    bool begin();                         // Lit l'index et répare le dernier segment (à appeler après LittleFS.begin())
+    void append(const DataPoint &point);  // Ajoute un point au lot en attente (écrit lors du prochain flush)
+    bool flush();                         // Écrit le lot en attente sur la flash
+    void compact();                       // Supprime les segments expirés et libère de la place si nécessaire
+    size_t restore(HistoryManager &history, uint32_t duration); // Recharge les `duration` dernières secondes dans le tampon RAM
+
+    // Même principe que HistoryManager::nextBucket, en lisant les segments sur la flash
+    bool nextBucket(time_t &cursor, time_t origin, time_t to, uint32_t step, HistoryBucket &bucket) override;
+    time_t oldest() override;
+    time_t newest(); // Horodatage du dernier point écrit sur la flash (0 si vide)
+
+    /**
+     * Suspend (ou reprend) les écritures de tous les historiques sur la flash, pendant la réécriture de la partition.
+     * Les points restent en attente en RAM (les plus récents sont abandonnés si le lot est plein).
+     */
+    static void suspendWrites(bool suspended) { writesSuspended.store(suspended); }
+    static bool areWritesSuspended() { return writesSuspended.load(); }
+
+    /**
+     * Copie en RAM les fichiers de /history : agrégats journaliers puis segments, des plus récents aux plus anciens,
+     * dans la limite de `budget` octets. L'index n'est pas copié : il est reconstruit au démarrage suivant.
+     * @return nombre d'octets copiés.
+     */
+    static size_t backup(std::vector<HistoryBackupFile> &files, size_t budget);
+    // Réécrit les fichiers copiés par backup() (partition LittleFS montée)
+    static bool restoreBackup(const std::vector<HistoryBackupFile> &files);
+
+private:
+    String segmentPath(uint32_t id);
+    bool loadIndex();
+    void rebuildIndex();
+    bool saveIndex();
+    bool repairSegment(HistorySegment &segment);
+    bool readRecord(File &file, size_t index, HistoryRecord &record);
+    bool openSegment(size_t segmentIndex);
+    void removeSegment(size_t segmentIndex);
+
+    static const size_t PENDING_SIZE = 16; // Nombre de points conservés en RAM avant écriture forcée
+
+    String dir;                           // Répertoire des segments
+    uint32_t samplePeriod;                // Intervalle entre deux points, en secondes (calcul de l'énergie)
+    uint16_t retentionDays;               // Durée de conservation des segments
+    std::vector<HistorySegment> segments; // Index des segments, trié par ordre chronologique
+    HistoryRecord pending[PENDING_SIZE];  // Lot de points en attente d'écriture
+    size_t pendingCount;
+    File readFile;                        // Segment ouvert en lecture (cache pour nextBucket)
+    uint32_t readSegmentId;
+    uint32_t readSegmentCount;            // Nombre de points du segment à l'ouverture (réouverture après un ajout)
+    SemaphoreHandle_t mutex;              // Mutex pour la synchronisation entre les tâches
+
+    static std::atomic<bool> writesSuspended;
+};
+
+#endif // HISTORY_STORE_H
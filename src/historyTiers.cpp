@@ -0,0 +1,409 @@
+#include "historyTiers.h"
+#include <LittleFS.h>
+
+// Horodatage minimum d'une mesure valide (01/01/2020) : pas d'historique avant la synchronisation NTP
+static const time_t MIN_VALID_TIMESTAMP = 1577836800;
+static const uint32_t QUARTER_SECONDS = 15 * 60;
+// Écart maximum pris en compte entre deux mesures pour le calcul de l'énergie
+static const time_t MAX_SAMPLE_GAP = 10;
+
+HistoryTiers *HistoryTiers::registry = nullptr;
+
+bool parseHistoryTier(const char *name, HistoryTier &tier)
+{
+    if (strcmp(name, "second") == 0)
+        tier = HISTORY_TIER_SECOND;
+    else if (strcmp(name, "minute") == 0)
+        tier = HISTORY_TIER_MINUTE;
+    else if (strcmp(name, "quarter") == 0)
+        tier = HISTORY_TIER_QUARTER;
+    else if (strcmp(name, "day") == 0)
+        tier = HISTORY_TIER_DAY;
+    else
+        return false;
+    return true;
+}
+
+// --- AggregateHistory ---
+
+AggregateHistory::AggregateHistory(size_t capacity) : ring(capacity)
+{
+}
+
+void AggregateHistory::add(const HistoryAggregate &aggregate)
+{
+    ring.push(aggregate);
+}
+
+time_t AggregateHistory::oldest()
+{
+    HistoryAggregate aggregate;
+    for (;;)
+    {
+        uint32_t first = ring.begin();
+        if (first == ring.end())
+        {
+            return 0;
+        }
+        if (ring.read(first, aggregate))
+        {
+            return aggregate.start;
+        }
+    }
+}
+
+bool AggregateHistory::nextBucket(time_t &cursor, time_t origin, time_t to, uint32_t step, HistoryBucket &bucket)
+{
+    // Recherche dichotomique du premier agrégat >= cursor (un agrégat écrasé est plus ancien que les autres)
+    uint32_t last = ring.end();
+    uint32_t low = ring.begin();
+    uint32_t high = last;
+    HistoryAggregate a;
+    while (low < high)
+    {
+        uint32_t mid = low + (high - low) / 2;
+        if (!ring.read(mid, a) || (time_t)a.start < cursor)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    HistoryAggregate first;
+    while (low < last && !ring.read(low, first))
+    {
+        uint32_t oldest = ring.begin();
+        low = oldest > low ? oldest : low + 1;
+    }
+    if (low >= last || (time_t)first.start >= to)
+    {
+        return false;
+    }
+
+    bucket.start = historyBucketStart(first.start, origin, step);
+    time_t end = step == 0 ? first.start + 1 : bucket.start + step;
+    if (end > to)
+    {
+        end = to;
+    }
+
+    // Fusion des agrégats de l'intervalle (moyenne pondérée par le nombre de mesures)
+    double sum = 0;
+    bucket.min = first.min;
+    bucket.max = first.max;
+    bucket.energy = 0;
+    bucket.count = 0;
+    for (uint32_t i = low; i < last; i++)
+    {
+        if (!ring.read(i, a))
+        {
+            continue; // Agrégat écrasé entre temps
+        }
+        if ((time_t)a.start >= end)
+        {
+            break;
+        }
+        if (a.min < bucket.min)
+            bucket.min = a.min;
+        if (a.max > bucket.max)
+            bucket.max = a.max;
+        sum += (double)a.mean * a.count;
+        bucket.energy += a.energy;
+        bucket.count += a.count;
+    }
+    bucket.avg = bucket.count > 0 ? sum / bucket.count : first.mean;
+    cursor = end;
+    return true;
+}
+
+bool AggregateHistory::save(const char *path)
+{
+    if (HistoryStore::areWritesSuspended())
+    {
+        return false; // Partition en cours de réécriture
+    }
+    File file = LittleFS.open(path, "w");
+    if (!file)
+    {
+        return false;
+    }
+    bool ok = true;
+    ring.forEach([&file, &ok](const HistoryAggregate &aggregate)
+                 { ok = ok && file.write((const uint8_t *)&aggregate, sizeof(HistoryAggregate)) == sizeof(HistoryAggregate); });
+    file.close();
+    return ok;
+}
+
+bool AggregateHistory::load(const char *path)
+{
+    File file = LittleFS.open(path, "r");
+    if (!file)
+    {
+        return false;
+    }
+    HistoryAggregate aggregate;
+    while (file.read((uint8_t *)&aggregate, sizeof(aggregate)) == sizeof(aggregate))
+    {
+        add(aggregate);
+    }
+    file.close();
+    return true;
+}
+
+// --- HistoryTiers::Accumulator ---
+
+void HistoryTiers::Accumulator::reset(uint32_t periodStart)
+{
+    start = periodStart;
+    min = 0;
+    max = 0;
+    sum = 0;
+    energy = 0;
+    count = 0;
+}
+
+void HistoryTiers::Accumulator::add(float value, float hours)
+{
+    if (count == 0 || value < min)
+        min = value;
+    if (count == 0 || value > max)
+        max = value;
+    sum += value;
+    energy += value * hours;
+    count++;
+}
+
+void HistoryTiers::Accumulator::merge(const HistoryAggregate &aggregate)
+{
+    if (count == 0 || aggregate.min < min)
+        min = aggregate.min;
+    if (count == 0 || aggregate.max > max)
+        max = aggregate.max;
+    sum += (double)aggregate.mean * aggregate.count;
+    energy += aggregate.energy;
+    count += aggregate.count;
+}
+
+HistoryAggregate HistoryTiers::Accumulator::result() const
+{
+    HistoryAggregate aggregate;
+    aggregate.start = start;
+    aggregate.min = min;
+    aggregate.max = max;
+    aggregate.mean = count > 0 ? sum / count : 0;
+    aggregate.energy = energy;
+    aggregate.count = count;
+    return aggregate;
+}
+
+// --- HistoryTiers ---
+
+HistoryTiers::HistoryTiers(const char *name, uint16_t binaryScale, const HistoryCapacity &capacity)
+    : name(name),
+      binaryScale(binaryScale),
+      capacity(capacity),
+      secondHistory(capacity.seconds, 1),
+      minuteHistory(capacity.minutes, 60),
+      quarterHistory(capacity.quarters),
+      dayHistory(capacity.days),
+      store(name, 60),
+      lastSampleTime(0)
+{
+    minuteAcc.reset(0);
+    quarterAcc.reset(0);
+    dayAcc.reset(0);
+
+    nextTiers = registry;
+    registry = this;
+}
+
+HistoryTiers *HistoryTiers::find(const char *name)
+{
+    for (HistoryTiers *tiers = registry; tiers != nullptr; tiers = tiers->nextTiers)
+    {
+        if (strcmp(tiers->name, name) == 0)
+        {
+            return tiers;
+        }
+    }
+    return nullptr;
+}
+
+HistorySource *HistoryTiers::tier(HistoryTier tier)
+{
+    switch (tier)
+    {
+    case HISTORY_TIER_SECOND:
+        return capacity.seconds > 0 ? &secondHistory : nullptr;
+    case HISTORY_TIER_QUARTER:
+        return capacity.quarters > 0 ? &quarterHistory : nullptr;
+    case HISTORY_TIER_DAY:
+        return capacity.days > 0 ? &dayHistory : nullptr;
+    default:
+        return capacity.minutes > 0 ? &minuteHistory : nullptr;
+    }
+}
+
+HistorySource *HistoryTiers::archive(HistoryTier tier)
+{
+    // Le journal des minutes permet de recalculer les minutes et quarts d'heure au-delà des tampons RAM
+    return (tier == HISTORY_TIER_MINUTE || tier == HISTORY_TIER_QUARTER) ? &store : nullptr;
+}
+
+uint32_t HistoryTiers::localDayStart(time_t timestamp)
+{
+    struct tm local;
+    localtime_r(&timestamp, &local);
+    local.tm_hour = 0;
+    local.tm_min = 0;
+    local.tm_sec = 0;
+    local.tm_isdst = -1;
+    return (uint32_t)mktime(&local);
+}
+
+String HistoryTiers::daysPath() const
+{
+    return String("/history/") + name + "/days.agg";
+}
+
+/**
+ * Rechargement depuis la flash : minutes des dernières 24 h, agrégats journaliers,
+ * puis reconstruction des quarts d'heure et de la journée en cours à partir du journal des minutes.
+ */
+void HistoryTiers::begin()
+{
+    store.begin();
+    if (capacity.minutes > 0)
+    {
+        store.restore(minuteHistory, capacity.minutes * 60);
+    }
+    if (capacity.days > 0)
+    {
+        dayHistory.load(daysPath().c_str());
+    }
+
+    time_t newest = store.newest();
+    if (newest == 0)
+    {
+        return;
+    }
+
+    uint32_t currentQuarter = newest - newest % QUARTER_SECONDS;
+    uint32_t currentDay = localDayStart(newest);
+    time_t cursor = currentQuarter - capacity.quarters * QUARTER_SECONDS;
+    HistoryBucket bucket;
+    while (store.nextBucket(cursor, 0, newest + 1, QUARTER_SECONDS, bucket))
+    {
+        HistoryAggregate quarter;
+        quarter.start = bucket.start;
+        quarter.min = bucket.min;
+        quarter.max = bucket.max;
+        quarter.mean = bucket.avg;
+        quarter.energy = bucket.energy;
+        quarter.count = bucket.count * 60;
+
+        if (quarter.start == currentQuarter)
+        {
+            // Quart d'heure en cours : il sera clos par les prochaines mesures
+            quarterAcc.reset(currentQuarter);
+            quarterAcc.merge(quarter);
+            continue;
+        }
+        addQuarter(quarter);
+        if (quarter.start >= currentDay)
+        {
+            if (dayAcc.count == 0)
+            {
+                dayAcc.reset(currentDay);
+            }
+            dayAcc.merge(quarter);
+        }
+    }
+}
+
+bool HistoryTiers::addSample(float value, DataPoint &minutePoint)
+{
+    time_t now = time(nullptr);
+    if (now < MIN_VALID_TIMESTAMP)
+    {
+        return false; // Heure non synchronisée
+    }
+
+    if (capacity.seconds > 0)
+    {
+        DataPoint sample;
+        sample.timestamp = now;
+        sample.value = value;
+        secondHistory.add(sample);
+    }
+
+    time_t elapsed = lastSampleTime > 0 && now > lastSampleTime ? now - lastSampleTime : 1;
+    if (elapsed > MAX_SAMPLE_GAP)
+    {
+        elapsed = MAX_SAMPLE_GAP;
+    }
+    lastSampleTime = now;
+
+    bool closed = false;
+    uint32_t minuteStart = now - now % 60;
+    if (minuteAcc.count > 0 && minuteAcc.start != minuteStart)
+    {
+        HistoryAggregate minute = minuteAcc.result();
+        minutePoint.timestamp = minute.start;
+        minutePoint.value = minute.mean;
+        if (capacity.minutes > 0)
+        {
+            minuteHistory.add(minutePoint);
+        }
+        store.append(minutePoint);
+        closed = true;
+
+        // Rollup vers le quart d'heure, puis vers la journée
+        uint32_t quarterStart = minute.start - minute.start % QUARTER_SECONDS;
+        if (quarterAcc.count > 0 && quarterAcc.start != quarterStart)
+        {
+            HistoryAggregate quarter = quarterAcc.result();
+            addQuarter(quarter);
+
+            uint32_t dayStart = localDayStart(quarter.start);
+            if (dayAcc.count > 0 && dayAcc.start != dayStart)
+            {
+                if (capacity.days > 0)
+                {
+                    dayHistory.add(dayAcc.result());
+                    dayHistory.save(daysPath().c_str());
+                }
+                dayAcc.count = 0;
+            }
+            if (dayAcc.count == 0)
+            {
+                dayAcc.reset(dayStart);
+            }
+            dayAcc.merge(quarter);
+            quarterAcc.reset(quarterStart);
+        }
+        if (quarterAcc.count == 0)
+        {
+            quarterAcc.reset(quarterStart);
+        }
+        quarterAcc.merge(minute);
+    }
+    if (minuteAcc.count == 0 || minuteAcc.start != minuteStart)
+    {
+        minuteAcc.reset(minuteStart);
+    }
+    minuteAcc.add(value, elapsed / 3600.0f);
+    return closed;
+}
+
+void HistoryTiers::addQuarter(const HistoryAggregate &quarter)
+{
+    if (capacity.quarters > 0)
+    {
+        quarterHistory.add(quarter);
+    }
+}
+
+void HistoryTiers::flush()
+{
+    store.flush();
+}
@@ -0,0 +1,124 @@
+#ifndef HISTORY_TIERS_H
+#define HISTORY_TIERS_H
+
+#include <Arduino.h>
+#include <time.h>
+#include "historyManager.h"
+#include "historyStore.h"
+
+// Niveaux de résolution de l'historique
+enum HistoryTier
+{
+    HISTORY_TIER_SECOND,  // 1 point par seconde
+    HISTORY_TIER_MINUTE,  // Moyenne par minute (et journal sur la flash)
+    HISTORY_TIER_QUARTER, // Agrégat par quart d'heure (recalculé depuis le journal au-delà du tampon RAM)
+    HISTORY_TIER_DAY,     // Agrégat par jour (local)
+};
+
+/**
+ * Taille des tampons RAM d'une série, propre à chaque grandeur (12 octets par point, 28 par agrégat).
+ * Un niveau de taille 0 n'est pas alloué (tier() retourne nullptr).
+ */
+struct HistoryCapacity
+{
+    size_t seconds;  // Points à la seconde
+    size_t minutes;  // Points à la minute (au-delà : journal sur la flash)
+    size_t quarters; // Agrégats au quart d'heure (au-delà : recalculés depuis le journal sur la flash)
+    size_t days;     // Agrégats journaliers
+};
+
+// Convertit "second", "minute", "quarter" ou "day" en niveau de résolution, retourne false si inconnu
+bool parseHistoryTier(const char *name, HistoryTier &tier);
+
+// Agrégat d'une période : min / max / moyenne / énergie (intégrale de la valeur dans le temps)
+struct HistoryAggregate
+{
+    uint32_t start; // Début de la période
+    float min;
+    float max;
+    float mean;
+    float energy;   // En valeur x heure (Wh pour une puissance)
+    uint32_t count; // Nombre de mesures (secondes) agrégées
+};
+
+// Tampon circulaire d'agrégats, interrogeable comme les autres sources d'historique (un seul écrivain, lectures sans verrou)
+class AggregateHistory : public HistorySource
+{
+public:
+    AggregateHistory(size_t capacity);
+    void add(const HistoryAggregate &aggregate);
+    bool nextBucket(time_t &cursor, time_t origin, time_t to, uint32_t step, HistoryBucket &bucket) override;
+    time_t oldest() override;
+    bool save(const char *path); // Sauvegarde du tampon dans un fichier LittleFS
+    bool load(const char *path); // Rechargement du tampon depuis un fichier LittleFS
+
+private:
+    SeqlockRing<HistoryAggregate> ring;
+};
+
+/**
+ * Historique multi-résolution d'une grandeur échantillonnée chaque seconde.
+ * Les mesures alimentent un tampon haute résolution (1 s) et sont agrégées
+ * à la minute (tampon 24 h + journal sur la flash), au quart d'heure et au jour.
+ */
+class HistoryTiers
+{
+public:
+    // binaryScale : échelle des valeurs du format binaire (historyFormat.h), à choisir selon l'amplitude de la grandeur
+    HistoryTiers(const char *name, uint16_t binaryScale, const HistoryCapacity &capacity);
+
+    void begin();                             // Recharge l'historique depuis la flash (après configuration du fuseau horaire)
+    bool addSample(float value, DataPoint &minutePoint); // Ajoute une mesure, retourne true si une minute vient d'être close
+    void flush();                             // Écrit les points en attente sur la flash
+
+    const char *getName() const { return name; }
+    uint16_t getBinaryScale() const { return binaryScale; }
+    HistoryManager &minutes() { return minuteHistory; }
+    HistorySource *tier(HistoryTier tier);    // Tampon RAM du niveau demandé, nullptr si la série ne le conserve pas
+    HistorySource *archive(HistoryTier tier); // Source complémentaire sur la flash pour les périodes plus anciennes (ou nullptr)
+
+    // Registre des historiques, pour les recherches par nom (API web, MQTT)
+    static HistoryTiers *find(const char *name);
+    static HistoryTiers *first() { return registry; }
+    HistoryTiers *next() const { return nextTiers; }
+
+private:
+    // Accumulateur d'une période en cours
+    struct Accumulator
+    {
+        uint32_t start;
+        float min;
+        float max;
+        double sum;
+        float energy;
+        uint32_t count;
+
+        void reset(uint32_t periodStart);
+        void add(float value, float hours);
+        void merge(const HistoryAggregate &aggregate);
+        HistoryAggregate result() const;
+    };
+
+    void addQuarter(const HistoryAggregate &quarter);
+    static uint32_t localDayStart(time_t timestamp);
+    String daysPath() const;
+
+    const char *name;
+    uint16_t binaryScale;
+    HistoryCapacity capacity;
+    HistoryManager secondHistory;
+    HistoryManager minuteHistory;
+    AggregateHistory quarterHistory;
+    AggregateHistory dayHistory;
+    HistoryStore store;
+
+    Accumulator minuteAcc;
+    Accumulator quarterAcc;
+    Accumulator dayAcc;
+    time_t lastSampleTime;
+
+    static HistoryTiers *registry;
+    HistoryTiers *nextTiers;
+};
+
+#endif // HISTORY_TIERS_H
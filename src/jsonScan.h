@@ -0,0 +1,129 @@
+#ifndef JSON_SCAN_H
+#define JSON_SCAN_H
+
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Extraction de valeurs scalaires dans un document JSON en place, sans allocation.
+ * Adapté aux petites réponses des compteurs (quelques centaines d'octets) dont seules quelques
+ * valeurs numériques sont utiles : la clé est cherchée telle quelle, sans analyse de la structure,
+ * la première occurrence est retenue. Le texte n'a pas besoin d'être terminé par '\0'.
+ */
+
+/**
+ * Cherche `"key"` suivi de ':' à partir de `json`.
+ * @return pointeur sur le premier caractère de la valeur, ou nullptr si la clé est absente.
+ */
+inline const char *jsonScanFind(const char *json, size_t length, const char *key)
+{
+    size_t keyLength = strlen(key);
+    const char *end = json + length;
+    for (const char *p = json; p + keyLength + 2 < end; p++)
+    {
+        if (*p != '"' || p[keyLength + 1] != '"' || memcmp(p + 1, key, keyLength) != 0)
+        {
+            continue;
+        }
+        const char *value = p + keyLength + 2;
+        while (value < end && (*value == ' ' || *value == '\t' || *value == '\r' || *value == '\n'))
+            value++;
+        if (value >= end || *value != ':')
+        {
+            continue; // Chaîne identique à la clé, mais en position de valeur
+        }
+        value++;
+        while (value < end && (*value == ' ' || *value == '\t' || *value == '\r' || *value == '\n'))
+            value++;
+        return value < end ? value : nullptr;
+    }
+    return nullptr;
+}
+
+/**
+ * Lit la valeur numérique de la clé `key`.
+ * @return false si la clé est absente ou si sa valeur n'est pas un nombre.
+ */
+inline bool jsonScanNumber(const char *json, size_t length, const char *key, float &value)
+{
+    const char *start = jsonScanFind(json, length, key);
+    if (start == nullptr)
+    {
+        return false;
+    }
+    // Copie bornée : strtof a besoin d'un texte terminé
+    char number[24];
+    size_t size = 0;
+    const char *end = json + length;
+    while (start + size < end && size < sizeof(number) - 1 && strchr("+-.0123456789eE", start[size]) != nullptr)
+    {
+        number[size] = start[size];
+        size++;
+    }
+    number[size] = '\0';
+    char *parsed;
+    float result = strtof(number, &parsed);
+    if (parsed == number)
+    {
+        return false;
+    }
+    value = result;
+    return true;
+}
+
+/**
+ * Lit la valeur booléenne de la clé `key`.
+ * @return false si la clé est absente ou si sa valeur n'est pas true / false.
+ */
+inline bool jsonScanBool(const char *json, size_t length, const char *key, bool &value)
+{
+    const char *start = jsonScanFind(json, length, key);
+    size_t remaining = start == nullptr ? 0 : json + length - start;
+    if (remaining >= 4 && memcmp(start, "true", 4) == 0)
+    {
+        value = true;
+        return true;
+    }
+    if (remaining >= 5 && memcmp(start, "false", 5) == 0)
+    {
+        value = false;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Longueur de l'objet ou du tableau JSON qui commence en `json` ('{' ou '['), accolade fermante comprise.
+ * Les chaînes sont sautées (séquences d'échappement comprises) pour ne pas compter leurs accolades.
+ * @return 0 si `json` ne commence pas par un objet ou un tableau, ou s'il n'est pas terminé dans les `length` octets
+ *         (trame tronquée).
+ */
+inline size_t jsonScanObjectLength(const char *json, size_t length)
+{
+    if (length == 0 || (*json != '{' && *json != '['))
+    {
+        return 0;
+    }
+    int depth = 0;
+    bool inString = false;
+    for (size_t i = 0; i < length; i++)
+    {
+        char c = json[i];
+        if (inString)
+        {
+            if (c == '\\')
+                i++;
+            else if (c == '"')
+                inString = false;
+        }
+        else if (c == '"')
+            inString = true;
+        else if (c == '{' || c == '[')
+            depth++;
+        else if ((c == '}' || c == ']') && --depth == 0)
+            return i + 1;
+    }
+    return 0;
+}
+
+#endif // JSON_SCAN_H
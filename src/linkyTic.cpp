@@ -0,0 +1,140 @@
+#include "linkyTic.h"
+#include <string.h>
+
+// Caractères de contrôle de la TIC
+static const char TIC_STX = 0x02; // Début de trame
+static const char TIC_ETX = 0x03; // Fin de trame
+static const char TIC_EOT = 0x04; // Trame interrompue
+static const char TIC_LF = 0x0A;  // Début de groupe
+static const char TIC_CR = 0x0D;  // Fin de groupe
+
+// Codes d'erreur reportés dans les statistiques
+static const int TIC_ERROR_CHECKSUM = 1;
+static const int TIC_ERROR_NO_POWER = 2;
+
+LinkyTic::LinkyTic(bool standard, int rxPin)
+    : standard(standard), rxPin(rxPin), serial(Serial2), groupLength(0), inFrame(false), frameError(false), withdrawn(-1), injected(-1)
+{
+}
+
+void LinkyTic::begin(BaseType_t core, UBaseType_t priority)
+{
+    serial.begin(standard ? 9600 : 1200, SERIAL_7E1, rxPin, -1);
+    Serial.printf("[Linky] TIC mode %s sur la broche %d\n", standard ? "standard" : "historique", rxPin);
+    PowerMeter::begin(core, priority);
+}
+
+void LinkyTic::run()
+{
+    for (;;)
+    {
+        while (serial.available())
+        {
+            feed((char)(serial.read() & 0x7F));
+        }
+        vTaskDelay(pdMS_TO_TICKS(20));
+    }
+}
+
+void LinkyTic::feed(char c)
+{
+    switch (c)
+    {
+    case TIC_STX:
+        inFrame = true;
+        frameError = false;
+        withdrawn = -1;
+        injected = -1;
+        groupLength = 0;
+        break;
+
+    case TIC_ETX:
+        if (inFrame)
+        {
+            if (withdrawn >= 0)
+            {
+                // Sans SINSTI (consommateur seul, ou mode historique) l'injection n'est pas mesurée
+                publish((float)(withdrawn - (injected > 0 ? injected : 0)), injected >= 0 ? METER_ESTIMATED : METER_UNSIGNED);
+                recordNotification();
+            }
+            else
+            {
+                recordError(frameError ? TIC_ERROR_CHECKSUM : TIC_ERROR_NO_POWER);
+                publish(0, METER_INVALID);
+            }
+        }
+        inFrame = false;
+        break;
+
+    case TIC_EOT:
+        inFrame = false;
+        break;
+
+    case TIC_LF:
+        groupLength = 0;
+        break;
+
+    case TIC_CR:
+        if (inFrame)
+        {
+            parseGroup();
+        }
+        groupLength = 0;
+        break;
+
+    default:
+        if (groupLength < sizeof(group) - 1)
+        {
+            group[groupLength++] = c;
+        }
+        break;
+    }
+}
+
+/**
+ * Groupe : étiquette SEP [horodatage SEP] donnée SEP somme de contrôle
+ * SEP vaut espace (historique) ou tabulation (standard).
+ * La somme de contrôle porte sur l'étiquette jusqu'au dernier séparateur exclu (historique)
+ * ou inclus (standard), ramenée sur 6 bits + 0x20.
+ */
+void LinkyTic::parseGroup()
+{
+    if (groupLength < 4)
+    {
+        return;
+    }
+    group[groupLength] = '\0';
+    char separator = standard ? '\t' : ' ';
+
+    size_t checkedLength = standard ? groupLength - 1 : groupLength - 2;
+    uint8_t sum = 0;
+    for (size_t i = 0; i < checkedLength; i++)
+    {
+        sum += (uint8_t)group[i];
+    }
+    if (group[groupLength - 2] != separator || (char)((sum & 0x3F) + 0x20) != group[groupLength - 1])
+    {
+        frameError = true;
+        return;
+    }
+
+    // Étiquette : premier champ, donnée : dernier champ avant la somme de contrôle
+    group[groupLength - 2] = '\0';
+    char *labelEnd = strchr(group, separator);
+    char *data = strrchr(group, separator);
+    if (labelEnd == nullptr || data == nullptr)
+    {
+        return;
+    }
+    *labelEnd = '\0';
+    data++;
+
+    if (strcmp(group, standard ? "SINSTS" : "PAPP") == 0)
+    {
+        withdrawn = atol(data);
+    }
+    else if (standard && strcmp(group, "SINSTI") == 0)
+    {
+        injected = atol(data);
+    }
+}
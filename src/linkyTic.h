@@ -0,0 +1,48 @@
+#ifndef LINKYTIC_H
+#define LINKYTIC_H
+
+#include <Arduino.h>
+#include "powerMeter.h"
+
+/**
+ * Décodage de la télé-information client (TIC) d'un compteur Linky, reçue sur une UART (7E1).
+ * - Mode historique (1200 bauds) : groupe PAPP, puissance apparente soutirée (VA).
+ * - Mode standard (9600 bauds) : groupes SINSTS (VA soutirée) et SINSTI (VA injectée, compteurs producteurs).
+ * Une mesure est publiée à la fin de chaque trame (environ toutes les 1 à 2 secondes).
+ * La TIC ne donne que la puissance apparente : les mesures sont de qualité METER_ESTIMATED,
+ * ou METER_UNSIGNED sans SINSTI (l'injection n'est pas mesurée, la puissance reste à 0).
+ */
+class LinkyTic : public PowerMeter
+{
+public:
+    /**
+     * @param standard true pour le mode standard (9600 bauds), false pour le mode historique (1200 bauds).
+     * @param rxPin Broche de réception de la TIC (via un optocoupleur).
+     */
+    LinkyTic(bool standard, int rxPin);
+
+    void begin(BaseType_t core, UBaseType_t priority) override;
+    const char *getName() const override { return "linky"; }
+
+protected:
+    void run() override;
+
+private:
+    // Traite un caractère reçu
+    void feed(char c);
+    // Traite un groupe complet (entre LF et CR)
+    void parseGroup();
+
+    bool standard;
+    int rxPin;
+    HardwareSerial &serial;
+
+    char group[64]; // Groupe en cours de réception
+    size_t groupLength;
+    bool inFrame;
+    bool frameError;   // Groupe invalide (somme de contrôle) dans la trame en cours
+    long withdrawn;    // Puissance apparente soutirée (VA), -1 si absente de la trame
+    long injected;     // Puissance apparente injectée (VA), -1 si absente de la trame
+};
+
+#endif
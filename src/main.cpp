@@ -5,10 +5,18 @@
 #include "webServerManager.h"
 #include "sensor.h"
 #include "configManager.h"
-#include "shellyEm.h"
+#include "configStore.h"
+#include "powerMeter.h"
 #include "version.h"
 #include "solarManager.h"
-#include "historyManager.h"
+#include "historyTiers.h"
+#include "energyManager.h"
+#include "solarEphemeris.h"
+#include "periodSchedule.h"
+#include "controlState.h"
+#include "runtimeMetrics.h"
+#include "regulationTrace.h"
+#include "controlLoop.h"
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <time.h>
@@ -20,11 +28,20 @@
 #define pinPulseTriac 22
 #define pinZeroCross 23
 #define pinFan 13 // Ventilateur de refroidissement du triac
+#define pinTemperature 4 // Sonde de température DS18B20 (OneWire)
 
 // --- Gestion de l'historique ---
-const size_t HISTORY_SIZE = 24 * 60; // 24 heures de données, à raison d'un point par minute
-HistoryManager temperatureHistory(HISTORY_SIZE);
-HistoryManager triacHistory(HISTORY_SIZE);
+// Historiques multi-résolution (seconde, minute, quart d'heure, jour), minutes journalisées sur la partition LittleFS
+// Échelle du format binaire : centièmes de °C et de %, watts entiers pour la puissance (±32 kW dans un i16).
+// Tampons RAM (secondes, minutes, quarts d'heure, jours) : les minutes de la température et du triac couvrent les
+// 24 h du graphique de l'app web ; la sonde n'étant lue que toutes les 30 s, la température n'a pas de tampon à la
+// seconde. Au-delà des tampons, minutes et quarts d'heure sont relus sur la flash.
+HistoryTiers temperatureHistory("temperature", 100, HistoryCapacity{0, 24 * 60, 24 * 4, 62});       // 21,7 Ko
+HistoryTiers triacHistory("triac", 100, HistoryCapacity{10 * 60, 24 * 60, 24 * 4, 62});             // 28,9 Ko
+HistoryTiers powerHistory("power", 1, HistoryCapacity{10 * 60, 2 * 60, 24 * 4, 62});                // 13,1 Ko
+// Compteurs d'énergie routée / soutirée / injectée
+EnergyManager energyManager;
+const unsigned long HISTORY_FLUSH_PERIOD = 15 * 60 * 1000; // Écriture des points en attente toutes les 15 minutes
 // --------------------------------
 
 // Task Handles
@@ -34,22 +51,26 @@ TaskHandle_t LedTaskHandle;
 
 // Global Objects
 ConfigManager configManager;
-Config config;
+ConfigStore configStore(configManager); // Configuration courante (instantanés immuables)
 WifiManager wifiManager;
 SolarManager *solarManager = nullptr;
-MqttManager mqttManager(configManager);
-WebServerManager web(configManager, mqttManager, temperatureHistory, triacHistory);
-ShellyEm *shelly = nullptr;
-
-// Shared Data
-volatile float lastTemperature = 0;        // Dernière température mesurée
-volatile float triacOpeningPercentage = 0; // Pourcentage d'ouverture du triac
-volatile float lastPower = 0;              // Dernière puissance mesurée
-int nowMinutes = 0;                        // Heure en minute
-int sunriseMinutes = 0;                    // Heure de lever du soleil en minute
-int sunsetMinutes = 0;                     // Heure du coucherdu soleil en minute
-volatile bool temperatureReached = false;  // True si la température a été atteinte dans la journée (Remise à zéro au lever du soleil)
-volatile bool reboot = false;              // true si on demande à l'ESP32 un reboot
+MqttManager mqttManager(configStore);
+WebServerManager web(configStore, mqttManager, temperatureHistory, triacHistory, energyManager);
+PowerMeter *meter = nullptr; // Mesure de la puissance réseau (Shelly, Linky, Modbus ou MQTT)
+SolarEphemeris solarEphemeris; // Lever / coucher du soleil, calculés une fois par jour
+PeriodSchedule schedule;       // Planning des périodes, compilé par minute de la journée
+TemperatureSensor temperatureSensor(pinTemperature); // Sonde du chauffe-eau, lue sans bloquer la tâche de communication
+
+// Shared Data (valeurs de la régulation : controlLoop.h)
+volatile bool reboot = false; // true si on demande à l'ESP32 un reboot
+
+// Durées mesurées pour /api/metrics (cycles CPU, chaque tâche est épinglée sur un cœur)
+LatencyHistogram controlLoopHistogram;     // Passage de la boucle de régulation, hors attente de la mesure
+LatencyHistogram temperatureReadHistogram; // Lecture de la sonde de température
+LatencyHistogram broadcastHistogram;       // Diffusion des valeurs courantes à l'app web
+
+// Trace de chaque pas de régulation (téléchargeable via /api/trace)
+RegulationTrace regulationTrace;
 
 // LED Management
 enum WifiState
@@ -60,17 +81,8 @@ enum WifiState
 };
 volatile WifiState wifiState = WIFI_DISCONNECTED;
 
-// Mode de fonctionnement pour la LED verte
-enum TriacMode
-{
-    TRIAC_OFF,
-    TRIAC_AUTO,
-    TRIAC_FORCED_ON
-};
-volatile TriacMode triacMode = TRIAC_OFF;
-
-// Mutex for thread-safe operations
-SemaphoreHandle_t configMutex;
+// État de la commande du chauffe-eau (LED verte, API)
+ControlStateMachine controlState;
 
 // Task for LED Management
 void ledTask(void *pvParameters)
@@ -109,13 +121,14 @@ void ledTask(void *pvParameters)
             break;
         }
 
-        // Gestion de la LED verte selon le mode du triac
-        if (triacMode == TRIAC_FORCED_ON)
+        // Gestion de la LED verte selon l'état de la commande
+        ControlState state = controlState.getState();
+        if (state == CONTROL_FORCED_ON || state == CONTROL_MANUAL)
         {
             // Marche forcée : LED verte allumée en permanence
             digitalWrite(pinLedGreen, HIGH);
         }
-        else if (triacMode == TRIAC_AUTO && triacOpeningPercentage > 0)
+        else if (state == CONTROL_AUTO && triacOpeningPercentage > 0)
         {
             // Mode auto avec régulation en cours : LED verte clignotante (200ms ON, 200ms OFF)
             if (now - lastGreenBlinkTime >= 200)
@@ -146,90 +159,18 @@ void ledTask(void *pvParameters)
 }
 
 // Task for Signal Processing (Core 0)
+// La tâche dort jusqu'à l'arrivée d'une nouvelle mesure (ou au plus REGULATION_IDLE_PERIOD)
 void signalProcessingTask(void *pvParameters)
 {
     Serial.println("Signal Processing Task started on core 0");
-    static unsigned long lastShellyTime = 0;
+    ControlLoop controlLoop(*solarManager, solarEphemeris, schedule, controlState, energyManager, regulationTrace, controlLoopHistogram);
+    controlLoop.begin(*configStore.get());
 
     for (;;)
     {
-        unsigned long now = millis();
-
-        xSemaphoreTake(configMutex, portMAX_DELAY);
-        std::string mode = config.boiler.mode;
-        int boilerTemperature = config.boiler.temperature;
-        xSemaphoreGive(configMutex);
-
-        struct tm localNow;
-        if (getLocalTime(&localNow))
-        {
-
-            struct tm sunrise = solarManager->calculateSunrise(config.solar.latitude, config.solar.longitude);
-            struct tm sunset = solarManager->calculateSunset(config.solar.latitude, config.solar.longitude);
-
-            nowMinutes = localNow.tm_hour * 60 + localNow.tm_min;
-            sunriseMinutes = sunrise.tm_hour * 60 + sunrise.tm_min;
-            sunsetMinutes = sunset.tm_hour * 60 + sunset.tm_min;
-
-            // Obtient le mode lié à la configuration personnalisé des périodes
-            std::string periodMode = configManager.getTriacMode(sunriseMinutes, sunsetMinutes, config);
-
-            if (nowMinutes == sunriseMinutes)
-            {
-                // Remise à zero de température atteinte, avant le lever du soleil
-                temperatureReached = false;
-            }
-
-            if (lastTemperature > config.boiler.temperature || temperatureReached)
-            {
-                // Le chauffe eau est chaud, plus besoin de régulation
-                // Même si la température redescent en dessous de la température de consigne,
-                // on ne relance le chauffe eau qu'après le prochain lever de soleil
-                solarManager->Off();
-                triacOpeningPercentage = 0;
-                temperatureReached = true;
-                triacMode = TRIAC_OFF;
-            }
-            else if (mode == "Manual" || mode == "manual")
-            {
-                // Mode "Manuel"
-                triacMode = TRIAC_FORCED_ON;
-                triacOpeningPercentage = config.boiler.triacOpening;
-            }
-            else if ((mode == "Auto" || mode == "auto") && periodMode == "AUTO")
-            {
-                // Mode automatique
-                triacMode = TRIAC_AUTO;
-                // Toutes les 1 seconde, lecture de la puissance consommée
-                if (shelly != nullptr && (now - lastShellyTime) > 1000)
-                {
-
-                    lastPower = shelly->getPower();
-                    Serial.print("[ShellyEM] Puissance: ");
-                    Serial.println(lastPower);
-                    triacOpeningPercentage = solarManager->updateRegulation(lastPower);
-
-                    // keep throttle timing regardless of whether we read or not
-                    lastShellyTime = now;
-                }
-            }
-            else if ((mode == "On" || mode == "on") || periodMode == "ON")
-            {
-                // Mode "Marche Forcée"
-                triacMode = TRIAC_FORCED_ON;
-                solarManager->On();
-                triacOpeningPercentage = 100;
-            }
-            else if ((mode == "Off" || mode == "off") || periodMode == "OFF")
-            {
-                // Mode "Arrêt Forcé"
-                triacMode = TRIAC_OFF;
-                solarManager->Off();
-                triacOpeningPercentage = 0;
-            }
-        }
-        // Delay to prevent task from hogging the CPU
-        vTaskDelay(pdMS_TO_TICKS(10));
+        MeterSample sample;
+        bool hasSample = controlLoop.wait(meter, sample);
+        controlLoop.run(hasSample ? &sample : nullptr, *configStore.get());
     }
 }
 
@@ -238,25 +179,38 @@ void communicationTask(void *pvParameters)
 {
     Serial.println("Communication Task started on core 1");
     static unsigned long lastDiscoveryTime = 0;
-    static unsigned long lastTempTime = 0;
     static unsigned long lastMqttTime = 0;
     static unsigned long lastBroadCastweb = 0;
     static unsigned long lastcheckUpdate = 0;
-    static unsigned long lastHistorySaveTime = 0;
+    static unsigned long lastHistorySampleTime = 0;
+    static unsigned long lastHistoryFlushTime = 0;
+    static unsigned long lastMetricsTime = 0;
     String newFirmwareVersion = "";
+    uint32_t cyclesPerUs = getCpuFrequencyMhz();
+    uint32_t sensorVersion = 0; // Version de la configuration appliquée à la sonde de température
 
     for (;;)
     {
         unsigned long now = millis();
 
-        xSemaphoreTake(configMutex, portMAX_DELAY);
-        std::string mqttServer = config.mqtt.server;
-
-        xSemaphoreGive(configMutex);
+        std::shared_ptr<const Config> config = configStore.get();
+        const std::string &mqttServer = config->mqtt.server;
+        int heaterPower = config->boiler.heaterPower;
+        if (config->version != sensorVersion)
+        {
+            // La sonde n'est utilisée que depuis cette tâche : la configuration y est appliquée
+            temperatureSensor.configure(config->boiler.sensorResolution, config->boiler.sensorInterval);
+            sensorVersion = config->version;
+        }
 
         if (reboot)
         {
             reboot = false;
+            // Sauvegarde de l'historique en attente avant le redémarrage
+            temperatureHistory.flush();
+            triacHistory.flush();
+            powerHistory.flush();
+            energyManager.save();
             delay(3000);
             ESP.restart();
         }
@@ -276,29 +230,55 @@ void communicationTask(void *pvParameters)
             }
         }
 
-        // Lecture de la température toutes les 30 secondes
-        if (now - lastTempTime > 30 * 1000)
+        // Lecture de la température sans attente de la conversion (période configurable, 30 secondes par défaut)
+        // En cas d'erreur de lecture, la dernière température valide est conservée
+        uint32_t readStart = ESP.getCycleCount();
+        if (temperatureSensor.loop())
         {
-            float tmpTemperature = getTemperature();
-            if (tmpTemperature != -127) // -127 = erreur de lecture
-            {
-                lastTemperature = getTemperature();
-            }
-            lastTempTime = now;
+            temperatureReadHistogram.recordCycles(ESP.getCycleCount() - readStart, cyclesPerUs);
+            lastTemperature = temperatureSensor.getTemperature();
         }
         // Brocast des données vers l'app web toutes les secondes
         if (now - lastBroadCastweb > 1000)
         {
+            uint32_t broadcastStart = ESP.getCycleCount();
             web.broadcastData(lastTemperature, triacOpeningPercentage, temperatureReached, newFirmwareVersion);
+            broadcastHistogram.recordCycles(ESP.getCycleCount() - broadcastStart, cyclesPerUs);
             lastBroadCastweb = now;
         }
 
-        // Enregistrement de l'historique toutes les minutes
-        if (now - lastHistorySaveTime > 60 * 1000)
+        // Diffusion des métriques d'exécution aux clients du WebSocket /metrics/ws toutes les 5 secondes
+        if (now - lastMetricsTime > 5000)
+        {
+            web.broadcastMetrics();
+            lastMetricsTime = now;
+        }
+
+        // Échantillonnage de l'historique toutes les secondes (agrégé à la minute, au quart d'heure et au jour)
+        if (now - lastHistorySampleTime >= 1000)
+        {
+            energyManager.addRoutedSample(triacOpeningPercentage, heaterPower);
+
+            DataPoint temperaturePoint, triacPoint, powerPoint;
+            bool minuteClosed = temperatureHistory.addSample(lastTemperature, temperaturePoint);
+            minuteClosed = triacHistory.addSample(triacOpeningPercentage, triacPoint) && minuteClosed;
+            powerHistory.addSample(lastPower, powerPoint);
+            if (minuteClosed)
+            {
+                // Diffusion incrémentale de la nouvelle minute vers l'app web
+                web.broadcastHistoryPoint(temperaturePoint, triacPoint);
+            }
+            lastHistorySampleTime = now;
+        }
+
+        // Écriture par lots de l'historique sur la flash
+        if (now - lastHistoryFlushTime > HISTORY_FLUSH_PERIOD)
         {
-            temperatureHistory.add(lastTemperature);
-            triacHistory.add(triacOpeningPercentage);
-            lastHistorySaveTime = now;
+            temperatureHistory.flush();
+            triacHistory.flush();
+            powerHistory.flush();
+            energyManager.save();
+            lastHistoryFlushTime = now;
         }
 
         if (!mqttServer.empty())
@@ -318,7 +298,8 @@ void communicationTask(void *pvParameters)
             // Envoi des données à home assistant toutes les 30 secondes
             if (now - lastMqttTime > 30 * 1000)
             {
-                mqttManager.sendData(lastTemperature, triacOpeningPercentage);
+                mqttManager.sendData(lastTemperature, triacOpeningPercentage, energyManager.getTotals(), energyManager.getRoutedPower(),
+                                     solarEphemeris.get(), solarEphemeris.getElevation(time(nullptr)));
                 lastMqttTime = now;
             }
         }
@@ -335,9 +316,6 @@ void setup()
     wifiState = WIFI_AP_MODE; // Mode AP activé au démarrage
     reboot = false;
 
-    // Create Mutex
-    configMutex = xSemaphoreCreateMutex();
-
     // Pin initialization
     pinMode(pinLedRed, OUTPUT);
     pinMode(pinLedGreen, OUTPUT);
@@ -358,15 +336,19 @@ void setup()
         0);             // Pin task to core 0
 
     // Load configuration
-    config = configManager.loadConfig();
+    configStore.begin();
+    std::shared_ptr<const Config> config = configStore.get();
 
     // Print Config
-    configManager.printConfig(config);
+    configManager.printConfig(*config);
+
+    // Rechargement des compteurs d'énergie
+    energyManager.begin();
 
     // Setup WiFi
     wifiState = WIFI_AP_MODE; // Mode AP activé au démarrage
     wifiManager.setupAccessPoint("ESP32_WROOM_SOLAR_ROUTER");
-    String ip = wifiManager.connect(config.wifi.ssid.c_str(), config.wifi.password.c_str(), pinLedRed, 5);
+    String ip = wifiManager.connect(config->wifi.ssid.c_str(), config->wifi.password.c_str(), pinLedRed, 5);
     if (ip != "")
     {
         wifiState = WIFI_CONNECTED; // WiFi connecté
@@ -383,13 +365,8 @@ void setup()
     web.startServer();
 
     // Setup Sensor
-    setupSensor();
-
-    // Setup Shelly
-    if (config.shellyEm.ip != "")
-    {
-        shelly = new ShellyEm(String(config.shellyEm.ip.c_str()), String(config.shellyEm.channel.c_str()));
-    }
+    temperatureSensor.configure(config->boiler.sensorResolution, config->boiler.sensorInterval);
+    temperatureSensor.begin();
 
     // Setup Solar Manager
     solarManager = new SolarManager(pinPulseTriac, pinZeroCross);
@@ -397,7 +374,12 @@ void setup()
 
     // Synchronize time with NTP server for Paris timezone
     Serial.println("[-] Synchronisation Date/Heure NTP server time.google.com");
-    configTzTime(getPosixTimezone(config.solar.timeZone.c_str()), "time.google.com");
+    configTzTime(getPosixTimezone(config->solar.timeZone.c_str()), "time.google.com");
+
+    // Rechargement de l'historique depuis la flash (après le fuseau horaire : agrégats journaliers en heure locale)
+    temperatureHistory.begin();
+    triacHistory.begin();
+    powerHistory.begin();
 
     // Récupère la date et l'heure locale
     struct tm timeinfo_local;
@@ -410,18 +392,32 @@ void setup()
     }
 
     // Setup MQTT
-    if (config.mqtt.server != "")
+    if (config->mqtt.server != "")
     {
-        mqttManager.setup(config.mqtt.server.c_str(), config.mqtt.port, config.mqtt.username.c_str(), config.mqtt.password.c_str(), config.mqtt.topic.c_str());
+        mqttManager.setup(config->mqtt.server.c_str(), config->mqtt.port, config->mqtt.username.c_str(), config->mqtt.password.c_str(), config->mqtt.topic.c_str());
     }
 
-    // Interrupts (should be safe, they are short)
-    attachInterrupt(digitalPinToInterrupt(pinZeroCross), SolarManager::onZeroCrossStatic, RISING);
+    // Setup Meter (après MQTT : la source MQTT s'abonne à son topic)
+    meter = createPowerMeter(*config, mqttManager);
+    if (meter != nullptr)
+    {
+        meter->begin(0, 2); // Core 0, priorité inférieure à la régulation
+    }
+    else
+    {
+        Serial.println("[Meter] Aucune mesure de puissance configurée");
+    }
 
-    hw_timer_t *timer = timerBegin(0, 80, true);
-    timerAttachInterrupt(timer, &SolarManager::onTimerStatic, true);
-    timerAlarmWrite(timer, 100, true);
-    timerAlarmEnable(timer);
+    // Changements de configuration : période d'interrogation du compteur et état publié sur MQTT
+    // (la tâche de régulation suit la version de la configuration à chaque passage)
+    configStore.subscribe([](const Config &config)
+                          {
+        if (meter != nullptr)
+        {
+            meter->setPollPeriod(config.meter.source == "modbus" ? config.meter.modbus.pollPeriod : config.shellyEm.pollPeriod);
+        }
+        mqttManager.publishBoilerMode(boilerModeName(config.boiler.mode));
+        mqttManager.publishBoilerTemperature(config.boiler.temperature); });
 
     // Create remaining tasks
     xTaskCreatePinnedToCore(
@@ -441,6 +437,8 @@ void setup()
         2,                        // Priority of the task (medium)
         &CommunicationTaskHandle, // Task handle to keep track of created task
         1);                       // Pin task to core 1
+
+    Serial.printf("[-] Mémoire libre après le démarrage : %u octets\n", (unsigned)ESP.getFreeHeap());
 }
 
 void loop()
@@ -0,0 +1,287 @@
+#include "modbusMeter.h"
+#include <string.h>
+
+// Délai maximum d'attente d'une réponse (ms)
+static const unsigned long MODBUS_TIMEOUT = 300;
+// Période d'interrogation minimum (ms)
+static const uint32_t MODBUS_MIN_POLL_PERIOD = 200;
+
+// Fonction Modbus de lecture des registres d'entrée
+static const uint8_t MODBUS_READ_INPUT_REGISTERS = 0x04;
+
+// Erreurs de transport (les exceptions Modbus sont positives)
+static const int MODBUS_ERROR_TIMEOUT = -1;
+static const int MODBUS_ERROR_CRC = -2;
+static const int MODBUS_ERROR_CONNECT = -3;
+static const int MODBUS_ERROR_RESPONSE = -4;
+
+ModbusDevice parseModbusDevice(const std::string &device)
+{
+    if (device == "sdm630")
+        return MODBUS_SDM630;
+    if (device == "pzem")
+        return MODBUS_PZEM;
+    return MODBUS_SDM120;
+}
+
+// CRC16 Modbus (polynôme 0xA001), transmis octet de poids faible en premier
+static uint16_t modbusCrc(const uint8_t *data, size_t length)
+{
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < length; i++)
+    {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+        }
+    }
+    return crc;
+}
+
+ModbusMeter::ModbusMeter(const ModbusMeterConfig &config)
+    : config(config), device(parseModbusDevice(config.device)), tcp(config.transport == "tcp"), pollPeriod(1000), serial(Serial2), transactionId(0)
+{
+    setPollPeriod(config.pollPeriod);
+}
+
+void ModbusMeter::begin(BaseType_t core, UBaseType_t priority)
+{
+    if (tcp)
+    {
+        Serial.printf("[Modbus] Compteur %s sur %s:%d, esclave %d\n", config.device.c_str(), config.host.c_str(), config.port, config.address);
+    }
+    else
+    {
+        serial.begin(config.baudRate, SERIAL_8N1, config.rxPin, config.txPin);
+        if (config.dePin >= 0)
+        {
+            pinMode(config.dePin, OUTPUT);
+            digitalWrite(config.dePin, LOW); // Transceiver RS485 en réception
+        }
+        Serial.printf("[Modbus] Compteur %s en RTU %d bauds, esclave %d\n", config.device.c_str(), config.baudRate, config.address);
+    }
+    PowerMeter::begin(core, priority);
+}
+
+void ModbusMeter::setPollPeriod(uint32_t period)
+{
+    pollPeriod = period < MODBUS_MIN_POLL_PERIOD ? MODBUS_MIN_POLL_PERIOD : period;
+}
+
+void ModbusMeter::run()
+{
+    TickType_t lastWake = xTaskGetTickCount();
+    bool lastValid = true;
+
+    for (;;)
+    {
+        unsigned long start = millis();
+        float power = 0;
+        int error = 0;
+        bool valid = readPower(power, error);
+        recordRequest(valid, millis() - start, error, error == MODBUS_ERROR_TIMEOUT);
+        // Le PZEM ne mesure pas le sens du transit
+        publish(power, !valid ? METER_INVALID : device == MODBUS_PZEM ? METER_UNSIGNED : METER_GOOD);
+
+        if (valid != lastValid)
+        {
+            Serial.println(valid ? "[Modbus] Lecture rétablie" : "[Modbus] Échec de lecture de la puissance");
+            lastValid = valid;
+        }
+
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(pollPeriod));
+        if (xTaskGetTickCount() - lastWake > pdMS_TO_TICKS(pollPeriod))
+        {
+            // Requête plus longue que la période : pas de rafale de rattrapage
+            lastWake = xTaskGetTickCount();
+        }
+    }
+}
+
+bool ModbusMeter::readPower(float &power, int &error)
+{
+    uint16_t registers[2];
+    switch (device)
+    {
+    case MODBUS_PZEM:
+        error = readInputRegisters(0x0003, 2, registers);
+        if (error == 0)
+        {
+            // Mot de poids faible en premier, unité 0,1 W
+            power = ((uint32_t)registers[1] << 16 | registers[0]) / 10.0f;
+        }
+        break;
+    default:
+        error = readInputRegisters(device == MODBUS_SDM630 ? 0x0034 : 0x000C, 2, registers);
+        if (error == 0)
+        {
+            // Flottant IEEE 754, mot de poids fort en premier
+            uint32_t raw = (uint32_t)registers[0] << 16 | registers[1];
+            memcpy(&power, &raw, sizeof(power));
+        }
+        break;
+    }
+    return error == 0;
+}
+
+int ModbusMeter::readInputRegisters(uint16_t address, uint16_t count, uint16_t *registers)
+{
+    uint8_t request[5] = {MODBUS_READ_INPUT_REGISTERS, (uint8_t)(address >> 8), (uint8_t)address, (uint8_t)(count >> 8), (uint8_t)count};
+    // Réponse : fonction, nombre d'octets, registres
+    uint8_t response[2 + 2 * 8];
+    size_t responseLength = 2 + 2 * count;
+    if (responseLength > sizeof(response))
+    {
+        return MODBUS_ERROR_RESPONSE;
+    }
+
+    int error = tcp ? transferTcp(request, sizeof(request), response, responseLength)
+                    : transferRtu(request, sizeof(request), response, responseLength);
+    if (error != 0)
+    {
+        return error;
+    }
+    if (response[0] == (MODBUS_READ_INPUT_REGISTERS | 0x80))
+    {
+        return response[1]; // Exception Modbus
+    }
+    if (response[0] != MODBUS_READ_INPUT_REGISTERS || response[1] != 2 * count)
+    {
+        return MODBUS_ERROR_RESPONSE;
+    }
+    for (uint16_t i = 0; i < count; i++)
+    {
+        registers[i] = (uint16_t)response[2 + 2 * i] << 8 | response[3 + 2 * i];
+    }
+    return 0;
+}
+
+/**
+ * Échange RTU : adresse + PDU + CRC16. Une réponse d'exception (3 octets de PDU) termine la lecture.
+ */
+int ModbusMeter::transferRtu(const uint8_t *request, size_t requestLength, uint8_t *response, size_t responseLength)
+{
+    uint8_t frame[1 + 5 + 2];
+    frame[0] = (uint8_t)config.address;
+    memcpy(frame + 1, request, requestLength);
+    uint16_t crc = modbusCrc(frame, 1 + requestLength);
+    frame[1 + requestLength] = (uint8_t)crc;
+    frame[2 + requestLength] = (uint8_t)(crc >> 8);
+
+    // Octets résiduels d'un échange précédent abandonné
+    while (serial.available())
+    {
+        serial.read();
+    }
+    if (config.dePin >= 0)
+    {
+        digitalWrite(config.dePin, HIGH);
+    }
+    serial.write(frame, 3 + requestLength);
+    serial.flush();
+    if (config.dePin >= 0)
+    {
+        digitalWrite(config.dePin, LOW);
+    }
+
+    uint8_t buffer[1 + 2 + 2 * 8 + 2];
+    size_t expected = 1 + responseLength + 2;
+    size_t received = 0;
+    unsigned long start = millis();
+    while (received < expected)
+    {
+        if (millis() - start > MODBUS_TIMEOUT)
+        {
+            return MODBUS_ERROR_TIMEOUT;
+        }
+        if (!serial.available())
+        {
+            vTaskDelay(pdMS_TO_TICKS(2));
+            continue;
+        }
+        buffer[received++] = (uint8_t)serial.read();
+        if (received == 2 && (buffer[1] & 0x80))
+        {
+            expected = 5; // Adresse, fonction, code d'exception, CRC
+        }
+    }
+
+    crc = modbusCrc(buffer, received - 2);
+    if (buffer[received - 2] != (uint8_t)crc || buffer[received - 1] != (uint8_t)(crc >> 8))
+    {
+        return MODBUS_ERROR_CRC;
+    }
+    if (buffer[0] != (uint8_t)config.address)
+    {
+        return MODBUS_ERROR_RESPONSE;
+    }
+    memcpy(response, buffer + 1, received - 3);
+    return 0;
+}
+
+/**
+ * Échange TCP : en-tête MBAP (transaction, protocole 0, longueur, unité) + PDU.
+ * La connexion est conservée entre deux requêtes.
+ */
+int ModbusMeter::transferTcp(const uint8_t *request, size_t requestLength, uint8_t *response, size_t responseLength)
+{
+    if (!client.connected())
+    {
+        client.stop();
+        if (!client.connect(config.host.c_str(), config.port, (int32_t)MODBUS_TIMEOUT))
+        {
+            return MODBUS_ERROR_CONNECT;
+        }
+        recordReconnection();
+    }
+
+    transactionId++;
+    uint8_t frame[7 + 5];
+    frame[0] = (uint8_t)(transactionId >> 8);
+    frame[1] = (uint8_t)transactionId;
+    frame[2] = 0;
+    frame[3] = 0;
+    frame[4] = 0;
+    frame[5] = (uint8_t)(1 + requestLength);
+    frame[6] = (uint8_t)config.address;
+    memcpy(frame + 7, request, requestLength);
+
+    while (client.available())
+    {
+        client.read();
+    }
+    client.write(frame, 7 + requestLength);
+
+    uint8_t buffer[7 + 2 + 2 * 8];
+    size_t expected = 7 + responseLength;
+    size_t received = 0;
+    unsigned long start = millis();
+    while (received < expected)
+    {
+        if (millis() - start > MODBUS_TIMEOUT)
+        {
+            client.stop();
+            return MODBUS_ERROR_TIMEOUT;
+        }
+        int available = client.available();
+        if (available <= 0)
+        {
+            vTaskDelay(pdMS_TO_TICKS(2));
+            continue;
+        }
+        received += client.read(buffer + received, expected - received);
+        if (received >= 8 && (buffer[7] & 0x80))
+        {
+            expected = 9; // En-tête, fonction, code d'exception
+        }
+    }
+
+    if (buffer[0] != frame[0] || buffer[1] != frame[1] || buffer[6] != frame[6])
+    {
+        client.stop();
+        return MODBUS_ERROR_RESPONSE;
+    }
+    memcpy(response, buffer + 7, received - 7);
+    return 0;
+}
@@ -0,0 +1,55 @@
+#ifndef MODBUSMETER_H
+#define MODBUSMETER_H
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+#include "configManager.h"
+#include "powerMeter.h"
+
+// Compteur Modbus supporté
+enum ModbusDevice
+{
+    MODBUS_SDM120, // Eastron SDM120 : registre d'entrée 0x000C, puissance active (float32, W)
+    MODBUS_SDM630, // Eastron SDM630 : registre d'entrée 0x0034, puissance active totale (float32, W)
+    MODBUS_PZEM    // Peacefair PZEM-004T v3 : registres d'entrée 0x0003-0x0004 (uint32, 0,1 W, non signée)
+};
+
+// Convertit la valeur de configuration ("sdm120", "sdm630" ou "pzem") en modèle
+ModbusDevice parseModbusDevice(const std::string &device);
+
+/**
+ * Lecture de la puissance d'un compteur d'énergie Modbus, en RTU (RS485 sur Serial2) ou en TCP.
+ * La tâche interroge le compteur (fonction 0x04, lecture de registres d'entrée) à la période configurée.
+ */
+class ModbusMeter : public PowerMeter
+{
+public:
+    explicit ModbusMeter(const ModbusMeterConfig &config);
+
+    void begin(BaseType_t core, UBaseType_t priority) override;
+    const char *getName() const override { return "modbus"; }
+    void setPollPeriod(uint32_t period) override;
+
+protected:
+    void run() override;
+
+private:
+    /**
+     * Lit `count` registres d'entrée à partir de `address`.
+     * @return 0 si la lecture a réussi, sinon le code d'exception Modbus ou une erreur de transport (< 0).
+     */
+    int readInputRegisters(uint16_t address, uint16_t count, uint16_t *registers);
+    int transferRtu(const uint8_t *request, size_t requestLength, uint8_t *response, size_t responseLength);
+    int transferTcp(const uint8_t *request, size_t requestLength, uint8_t *response, size_t responseLength);
+    bool readPower(float &power, int &error);
+
+    ModbusMeterConfig config;
+    ModbusDevice device;
+    bool tcp;
+    uint32_t pollPeriod;
+    HardwareSerial &serial;
+    WiFiClient client;
+    uint16_t transactionId;
+};
+
+#endif
@@ -1,11 +1,16 @@
 #include "mqttManager.h"
 #include <ArduinoJson.h>
-#include "configManager.h"
+#include <algorithm>
+#include "configStore.h"
+#include "historyTiers.h"
+
+// Nombre maximum d'intervalles renvoyés par une requête d'historique MQTT
+static const size_t MQTT_HISTORY_MAX_BUCKETS = 96;
 
 // Le mode du chauffe-eau est maintenant un membre de la classe MqttManager
 
 // Constructeur de la classe
-MqttManager::MqttManager(ConfigManager &configManager) : configManager(configManager), client(espClient)
+MqttManager::MqttManager(ConfigStore &configStore) : configStore(configStore), client(espClient)
 {
 }
 
@@ -49,10 +54,22 @@ void MqttManager::connect(int timeout)
             Serial.print("Abonnement au topic : ");
             Serial.println(tempCommandTopic);
 
+            String historyQueryTopic = String(topic.c_str()) + "/history/get";
+            client.subscribe(historyQueryTopic.c_str());
+            Serial.print("Abonnement au topic : ");
+            Serial.println(historyQueryTopic);
+
+            for (const Subscription &subscription : subscriptions)
+            {
+                client.subscribe(subscription.topic.c_str());
+                Serial.print("Abonnement au topic : ");
+                Serial.println(subscription.topic.c_str());
+            }
+
             // Publier l'état initial
-            Config config = configManager.loadConfig();
-            publishBoilerMode(config.boiler.mode.c_str());
-            publishBoilerTemperature(config.boiler.temperature);
+            std::shared_ptr<const Config> config = configStore.get();
+            publishBoilerMode(boilerModeName(config->boiler.mode));
+            publishBoilerTemperature(config->boiler.temperature);
         }
         else
         {
@@ -69,12 +86,31 @@ void MqttManager::connect(int timeout)
     }
 }
 
+void MqttManager::subscribe(const std::string &topic, MessageHandler handler)
+{
+    subscriptions.push_back(Subscription{topic, handler});
+    if (client.connected())
+    {
+        client.subscribe(topic.c_str());
+    }
+}
+
 // Callback appelé lors de la réception d'un message MQTT
 void MqttManager::onMqttMessage(char *topic, byte *payload, unsigned int length)
 {
+    for (const Subscription &subscription : subscriptions)
+    {
+        if (subscription.topic == topic)
+        {
+            subscription.handler(payload, length);
+            return;
+        }
+    }
+
     String topicStr = String(topic);
     String modeTopic = String(this->topic.c_str()) + "/boiler/mode/set";
     String tempTopic = String(this->topic.c_str()) + "/boiler/temperature/set";
+    String historyTopic = String(this->topic.c_str()) + "/history/get";
 
     // Convertir le payload en String
     String payloadStr;
@@ -86,19 +122,20 @@ void MqttManager::onMqttMessage(char *topic, byte *payload, unsigned int length)
 
     if (topicStr == modeTopic)
     {
-        if (payloadStr == "auto" || payloadStr == "on" || payloadStr == "off")
+        // Le select Home Assistant ne propose que "auto", "on" et "off"
+        BoilerMode mode;
+        if (parseBoilerMode(payloadStr.c_str(), mode) && mode != BOILER_MANUAL)
         {
-            Config configTmp = this->configManager.loadConfig();
-            configTmp.boiler.mode = payloadStr.c_str();
-            this->configManager.saveConfig(configTmp);
-
-            // Mise à jour avec la nouvelle config
-            extern Config config;
-            config = this->configManager.loadConfig();
+            // Sauvegarde et publication de la nouvelle config (l'état est republié par l'abonné)
+            if (!configStore.update([mode](Config &config)
+                                    { config.boiler.mode = mode; }))
+            {
+                Serial.println("[MQTT] Mode chauffe-eau non enregistré");
+                return;
+            }
 
             Serial.print("[MQTT] Mode chauffe-eau mis à jour : ");
             Serial.println(payloadStr);
-            this->publishBoilerMode(payloadStr);
         }
         else
         {
@@ -111,16 +148,15 @@ void MqttManager::onMqttMessage(char *topic, byte *payload, unsigned int length)
         int temp = payloadStr.toInt();
         if (temp >= 0 && temp <= 80) // Validation de la plage de température
         {
-            Config configTmp = this->configManager.loadConfig();
-            configTmp.boiler.temperature = temp;
-            this->configManager.saveConfig(configTmp);
-
-            extern Config config;
-            config = configTmp;
+            if (!configStore.update([temp](Config &config)
+                                    { config.boiler.temperature = temp; }))
+            {
+                Serial.println("[MQTT] Température de consigne non enregistrée");
+                return;
+            }
 
             Serial.print("[MQTT] Température de consigne mise à jour : ");
             Serial.println(temp);
-            this->publishBoilerTemperature(temp);
         }
         else
         {
@@ -128,6 +164,104 @@ void MqttManager::onMqttMessage(char *topic, byte *payload, unsigned int length)
             Serial.println(payloadStr);
         }
     }
+    else if (topicStr == historyTopic)
+    {
+        handleHistoryQuery(payloadStr);
+    }
+}
+
+/**
+ * Requête d'historique agrégé : {"series":"power","tier":"quarter","from":...,"to":...,"step":...}
+ * La réponse est publiée sur <topic>/history/result : {"series","tier","step","buckets":[[time,min,max,avg,energy],...]}
+ * Elle est limitée à MQTT_HISTORY_MAX_BUCKETS intervalles (relancer la requête à partir de "next" pour la suite).
+ */
+void MqttManager::handleHistoryQuery(const String &payload)
+{
+    JsonDocument query;
+    if (deserializeJson(query, payload))
+    {
+        Serial.println("[MQTT] Requête d'historique invalide");
+        return;
+    }
+
+    HistoryTiers *history = HistoryTiers::find(query["series"] | "");
+    HistoryTier tier = HISTORY_TIER_QUARTER;
+    if (history == nullptr || !parseHistoryTier(query["tier"] | "quarter", tier) || history->tier(tier) == nullptr)
+    {
+        Serial.println("[MQTT] Série ou niveau d'historique inconnu");
+        return;
+    }
+
+    time_t now = time(nullptr);
+    time_t from = historyTimeFromUnsigned(query["from"] | (uint32_t)(now - 24 * 3600));
+    time_t to = historyTimeFromUnsigned(query["to"] | (uint32_t)(now + 1));
+    uint32_t step = query["step"] | 0;
+    if (tier == HISTORY_TIER_QUARTER && step < 15 * 60)
+    {
+        step = 15 * 60; // Les quarts d'heure anciens sont recalculés depuis le journal des minutes
+        from -= from % step;
+    }
+
+    // Lecture sur la flash jusqu'au début du tampon RAM, puis dans le tampon RAM
+    HistorySource *ram = history->tier(tier);
+    HistorySource *archive = history->archive(tier);
+    time_t ramStart = ram->oldest();
+    time_t archiveEnd = archive == nullptr ? 0 : (ramStart == 0 ? to : ramStart);
+    if (step > 0 && archiveEnd > from)
+    {
+        archiveEnd = historyBucketStart(archiveEnd + step - 1, from, step);
+    }
+
+    JsonDocument doc;
+    doc["series"] = history->getName();
+    doc["tier"] = query["tier"] | "quarter";
+    doc["step"] = step;
+    JsonArray buckets = doc["buckets"].to<JsonArray>();
+
+    time_t cursor = from;
+    HistoryBucket bucket;
+    size_t count = 0;
+    while (count < MQTT_HISTORY_MAX_BUCKETS && cursor < to)
+    {
+        bool found;
+        if (cursor < archiveEnd)
+        {
+            found = archive->nextBucket(cursor, from, std::min(to, archiveEnd), step, bucket);
+            if (!found)
+            {
+                cursor = archiveEnd;
+                continue;
+            }
+        }
+        else
+        {
+            found = ram->nextBucket(cursor, from, to, step, bucket);
+            if (!found)
+            {
+                break;
+            }
+        }
+        JsonArray item = buckets.add<JsonArray>();
+        item.add((uint32_t)bucket.start);
+        item.add(bucket.min);
+        item.add(bucket.max);
+        item.add(bucket.avg);
+        item.add(bucket.energy);
+        count++;
+    }
+    if (count == MQTT_HISTORY_MAX_BUCKETS && cursor < to)
+    {
+        doc["next"] = (uint32_t)cursor;
+    }
+
+    // Publication en flux pour ne pas être limité par la taille du buffer MQTT
+    String resultTopic = String(this->topic.c_str()) + "/history/result";
+    size_t length = measureJson(doc);
+    if (client.beginPublish(resultTopic.c_str(), length, false))
+    {
+        serializeJson(doc, client);
+        client.endPublish();
+    }
 }
 
 // Publier l'état du mode du chauffe-eau
@@ -273,14 +407,78 @@ void MqttManager::sendDiscovery()
     {
         Serial.println("    - Échec de l'envoi du message discovery (boiler temp setpoint).");
     }
+
+    // Découverte des capteurs de puissance et d'énergie (tableau de bord Énergie de Home Assistant)
+    sendSensorDiscovery("routed_power", "Puissance routée", "W", "power", "measurement", "mdi:flash");
+    sendSensorDiscovery("routed_energy_today", "Énergie routée aujourd'hui", "Wh", "energy", "total_increasing", "mdi:water-boiler");
+    sendSensorDiscovery("routed_energy_month", "Énergie routée ce mois", "Wh", "energy", "total_increasing", "mdi:water-boiler");
+    sendSensorDiscovery("routed_energy_total", "Énergie routée totale", "Wh", "energy", "total_increasing", "mdi:water-boiler");
+    sendSensorDiscovery("imported_energy_today", "Énergie soutirée aujourd'hui", "Wh", "energy", "total_increasing", "mdi:transmission-tower-import");
+    sendSensorDiscovery("exported_energy_today", "Énergie injectée aujourd'hui", "Wh", "energy", "total_increasing", "mdi:transmission-tower-export");
+    sendSensorDiscovery("sun_elevation", "Élévation du soleil", "°", nullptr, "measurement", "mdi:weather-sunny");
+    sendSensorDiscovery("sunrise", "Lever du soleil", nullptr, nullptr, nullptr, "mdi:weather-sunset-up");
+    sendSensorDiscovery("sunset", "Coucher du soleil", nullptr, nullptr, nullptr, "mdi:weather-sunset-down");
 }
 
-void MqttManager::sendData(float temperature, float triacOpeningPercentage)
+void MqttManager::sendSensorDiscovery(const char *id, const char *name, const char *unit, const char *deviceClass, const char *stateClass, const char *icon)
+{
+    JsonDocument doc;
+    doc["name"] = name;
+    doc["state_topic"] = topic + "/state";
+    // Capteurs sans unité ni classe (heures de lever / coucher) : clés omises
+    if (unit != nullptr)
+        doc["unit_of_measurement"] = unit;
+    if (deviceClass != nullptr)
+        doc["device_class"] = deviceClass;
+    if (stateClass != nullptr)
+        doc["state_class"] = stateClass;
+    doc["unique_id"] = String("boiler_") + id;
+    doc["value_template"] = String("{{ value_json.") + id + " }}";
+    doc["icon"] = icon;
+    doc["device"]["name"] = "Routeur solaire";
+    doc["device"]["identifiers"] = "Routeur_solaire";
+    doc["device"]["model"] = "ESP32";
+    doc["device"]["manufacturer"] = "Mon routeur solaire";
+
+    String json;
+    serializeJson(doc, json);
+    String discoveryTopic = String("homeassistant/sensor/boiler/") + id + "/config";
+    if (client.publish(discoveryTopic.c_str(), json.c_str(), true))
+    {
+        Serial.printf("[-] Send discovery message to homeassistant (%s)\n", id);
+    }
+    else
+    {
+        Serial.printf("    - Échec de l'envoi du message discovery (%s).\n", id);
+    }
+}
+
+void MqttManager::sendData(float temperature, float triacOpeningPercentage, const EnergyTotals &energy, float routedPower, const SolarDay &sun, float sunElevation)
 {
     JsonDocument doc;
     // Arrondir les valeurs à deux décimales
     doc["temperature"] = round(temperature * 100) / 100.0;
     doc["triac_opening_percentage"] = round(triacOpeningPercentage * 100) / 100.0;
+    // Puissance en W, énergies en Wh
+    doc["routed_power"] = round(routedPower);
+    doc["routed_energy_today"] = round(energy.today.routed);
+    doc["routed_energy_month"] = round(energy.thisMonth.routed);
+    doc["routed_energy_total"] = round(energy.total.routed);
+    doc["imported_energy_today"] = round(energy.today.imported);
+    doc["exported_energy_today"] = round(energy.today.exported);
+    // Soleil : élévation en °, lever / coucher en heure locale (HH:MM)
+    if (!isnan(sunElevation))
+    {
+        doc["sun_elevation"] = round(sunElevation * 10) / 10.0;
+    }
+    if (sun.day != 0 && sun.sunrise >= 0)
+    {
+        char hhmm[6];
+        snprintf(hhmm, sizeof(hhmm), "%02d:%02d", sun.sunrise / 60, sun.sunrise % 60);
+        doc["sunrise"] = hhmm;
+        snprintf(hhmm, sizeof(hhmm), "%02d:%02d", sun.sunset / 60, sun.sunset % 60);
+        doc["sunset"] = hhmm;
+    }
 
     String payload;
     serializeJson(doc, payload);
@@ -4,18 +4,22 @@
 #include <WiFi.h>
 #include <PubSubClient.h>
 #include <ArduinoJson.h>
-#include "configManager.h"
+#include <functional>
+#include <vector>
+#include "configStore.h"
+#include "energyManager.h"
+#include "solarEphemeris.h"
 
 class MqttManager
 {
 public:
     // Constructeur avec WiFiClient en paramètre
-    MqttManager(ConfigManager &configManager);
+    MqttManager(ConfigStore &configStore);
 
     void setup(const char *server, int port, const char *username, const char *password, const char *topic);
     // Méthodes de connexion et d'envoi
     void connect(int timeout = 5);
-    void sendData(float temperature, float triacOpeningPercentage);
+    void sendData(float temperature, float triacOpeningPercentage, const EnergyTotals &energy, float routedPower, const SolarDay &sun, float sunElevation);
     // Méthode pour que homeAssistant découvre l'ESP32
     void sendDiscovery();
 
@@ -26,6 +30,11 @@ public:
     void publishBoilerMode(String boilerMode);
     void publishBoilerTemperature(int temperature);
 
+    // Message reçu sur un topic externe : contenu brut (non terminé par '\0')
+    typedef std::function<void(const uint8_t *payload, unsigned int length)> MessageHandler;
+    // Abonnement à un topic externe (complet, hors <topic>), rétabli à chaque connexion au broker
+    void subscribe(const std::string &topic, MessageHandler handler);
+
     // Ajout du getter pour boilerMode
     // String getBoilerMode() const { return boilerMode; }
 
@@ -39,13 +48,24 @@ private:
     // Référence vers un client WiFi et un objet client MQTT
     WiFiClient espClient;
     PubSubClient client;
-    ConfigManager &configManager;
+    ConfigStore &configStore;
+
+    struct Subscription
+    {
+        std::string topic;
+        MessageHandler handler;
+    };
+    std::vector<Subscription> subscriptions;
 
     // Mode du chauffe-eau
     // String boilerMode;
 
     // Callback pour la réception de messages MQTT
     void onMqttMessage(char *topic, byte *payload, unsigned int length);
+    // Découverte d'un capteur d'énergie / puissance Home Assistant
+    void sendSensorDiscovery(const char *id, const char *name, const char *unit, const char *deviceClass, const char *stateClass, const char *icon);
+    // Réponse à une requête d'historique (topic <topic>/history/get)
+    void handleHistoryQuery(const String &payload);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,66 @@
+#include "mqttMeter.h"
+#include <ArduinoJson.h>
+#include <stdlib.h>
+
+// Codes d'erreur reportés dans les statistiques
+static const int MQTT_METER_ERROR_FORMAT = 1;
+
+MqttMeter::MqttMeter(MqttManager &mqttManager, const std::string &topic, const std::string &key) : key(key)
+{
+    mqttManager.subscribe(topic, [this](const uint8_t *payload, unsigned int length)
+                          { onMessage(payload, length); });
+}
+
+void MqttMeter::onMessage(const uint8_t *payload, unsigned int length)
+{
+    bool valid = false;
+    float power = 0;
+
+    if (key.empty())
+    {
+        char value[32];
+        if (length > 0 && length < sizeof(value))
+        {
+            memcpy(value, payload, length);
+            value[length] = '\0';
+            char *end;
+            power = strtof(value, &end);
+            valid = end != value;
+        }
+    }
+    else
+    {
+        JsonDocument doc;
+        if (!deserializeJson(doc, payload, length))
+        {
+            // Parcours du chemin pointé ("ENERGY.Power")
+            JsonVariant value = doc.as<JsonVariant>();
+            size_t start = 0;
+            while (start <= key.size())
+            {
+                size_t end = key.find('.', start);
+                if (end == std::string::npos)
+                {
+                    end = key.size();
+                }
+                value = value[key.substr(start, end - start)];
+                start = end + 1;
+            }
+            if (value.is<float>())
+            {
+                power = value.as<float>();
+                valid = true;
+            }
+        }
+    }
+
+    if (valid)
+    {
+        publish(power, METER_GOOD);
+        recordNotification();
+    }
+    else
+    {
+        recordError(MQTT_METER_ERROR_FORMAT);
+    }
+}
@@ -0,0 +1,34 @@
+#ifndef MQTTMETER_H
+#define MQTTMETER_H
+
+#include <string>
+#include "mqttManager.h"
+#include "powerMeter.h"
+
+/**
+ * Puissance réseau publiée sur un topic MQTT par un autre équipement (Tasmota, Home Assistant, ...).
+ * Le message contient soit la puissance seule ("-250.5"), soit un document JSON dont la puissance
+ * est désignée par un chemin pointé (ex: "ENERGY.Power" pour Tasmota).
+ * Chaque message reçu est publié immédiatement, depuis la tâche de communication.
+ */
+class MqttMeter : public PowerMeter
+{
+public:
+    /**
+     * @param mqttManager Client MQTT du routeur (le broker doit être configuré).
+     * @param topic Topic complet de la puissance.
+     * @param key Chemin de la puissance dans le document JSON, vide si le message contient la valeur seule.
+     */
+    MqttMeter(MqttManager &mqttManager, const std::string &topic, const std::string &key);
+
+    // Pas de tâche : les mesures arrivent avec les messages MQTT
+    void begin(BaseType_t core, UBaseType_t priority) override {}
+    const char *getName() const override { return "mqtt"; }
+
+private:
+    void onMessage(const uint8_t *payload, unsigned int length);
+
+    std::string key;
+};
+
+#endif
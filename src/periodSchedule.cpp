@@ -0,0 +1,61 @@
+#include "periodSchedule.h"
+#include <string.h>
+
+PeriodSchedule::PeriodSchedule() : sunrise(-1), sunset(-1)
+{
+    memset(table, PERIOD_OFF, sizeof(table));
+}
+
+void PeriodSchedule::fill(int start, int end, PeriodMode mode)
+{
+    if (start > MINUTES_PER_DAY)
+        start = MINUTES_PER_DAY;
+    if (end > MINUTES_PER_DAY)
+        end = MINUTES_PER_DAY;
+    if (start > end)
+    {
+        // Période à cheval sur minuit
+        memset(table + start, mode, MINUTES_PER_DAY - start);
+        memset(table, mode, end);
+    }
+    else if (start < end)
+    {
+        memset(table + start, mode, end - start);
+    }
+}
+
+void PeriodSchedule::compile(const std::vector<Period> &periods, int sunrise, int sunset)
+{
+    this->sunrise = sunrise;
+    this->sunset = sunset;
+    memset(table, PERIOD_OFF, sizeof(table));
+
+    // Périodes "auto" d'abord, puis "on" par-dessus : la marche forcée est prioritaire
+    for (PeriodMode pass : {PERIOD_AUTO, PERIOD_ON})
+    {
+        for (const Period &period : periods)
+        {
+            if (period.mode != pass)
+            {
+                continue;
+            }
+            int start = period.start;
+            if (period.startSunrise)
+                start = sunrise;
+            else if (period.startSunset)
+                start = sunset;
+
+            int end = period.end;
+            if (period.endSunrise)
+                end = sunrise;
+            else if (period.endSunset)
+                end = sunset;
+
+            if (start < 0 || end < 0)
+            {
+                continue;
+            }
+            fill(start, end, pass);
+        }
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef PERIOD_SCHEDULE_H
+#define PERIOD_SCHEDULE_H
+
+#include <stdint.h>
+#include <vector>
+#include "boilerMode.h"
+
+// Nombre de minutes dans une journée
+const int MINUTES_PER_DAY = 1440;
+
+/**
+ * Planning des périodes compilé en une table d'une entrée par minute de la journée.
+ * La table est reconstruite à l'enregistrement des périodes et au changement de l'heure de lever
+ * ou de coucher du soleil ; la lecture du mode courant est alors un simple accès indexé, sans
+ * allocation ni comparaison de chaînes.
+ * Compilation et lecture se font depuis la tâche de régulation : pas de verrou.
+ */
+class PeriodSchedule
+{
+public:
+    PeriodSchedule();
+
+    /**
+     * Compile les périodes. Les périodes ancrées au lever / coucher du soleil sont ignorées
+     * si l'heure correspondante n'est pas connue (< 0 : heure non synchronisée, jour ou nuit polaire).
+     * @param periods Périodes de la configuration du chauffe-eau.
+     * @param sunrise Lever du soleil (minutes depuis minuit, heure locale).
+     * @param sunset Coucher du soleil (minutes depuis minuit, heure locale).
+     */
+    void compile(const std::vector<Period> &periods, int sunrise, int sunset);
+
+    // Mode à la minute `minute` de la journée (0-1439)
+    PeriodMode getMode(int minute) const
+    {
+        return minute >= 0 && minute < MINUTES_PER_DAY ? (PeriodMode)table[minute] : PERIOD_OFF;
+    }
+
+    // Heures de lever / coucher prises en compte à la dernière compilation
+    int getSunrise() const { return sunrise; }
+    int getSunset() const { return sunset; }
+
+private:
+    // Marque [start, end[ (éventuellement à cheval sur minuit) avec `mode`
+    void fill(int start, int end, PeriodMode mode);
+
+    uint8_t table[MINUTES_PER_DAY];
+    int sunrise;
+    int sunset;
+};
+
+#endif // PERIOD_SCHEDULE_H
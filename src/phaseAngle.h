@@ -0,0 +1,103 @@
+#ifndef PHASE_ANGLE_H
+#define PHASE_ANGLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Fréquence du secteur (Hz), à définir dans platformio.ini (-DMAINS_FREQUENCY=60 pour un réseau 60 Hz)
+#ifndef MAINS_FREQUENCY
+#define MAINS_FREQUENCY 50
+#endif
+
+static_assert(MAINS_FREQUENCY == 50 || MAINS_FREQUENCY == 60, "MAINS_FREQUENCY doit valoir 50 ou 60");
+
+// Durée d'une demi-période du secteur (µs)
+constexpr uint32_t MAINS_HALF_PERIOD_US = 1000000UL / (2 * MAINS_FREQUENCY);
+
+constexpr double PHASE_ANGLE_PI = 3.14159265358979323846;
+
+// sin(x) évaluable à la compilation (série de Taylor après réduction à [-PI, PI])
+constexpr double phaseAngleSin(double x)
+{
+    while (x > PHASE_ANGLE_PI)
+        x -= 2 * PHASE_ANGLE_PI;
+    while (x < -PHASE_ANGLE_PI)
+        x += 2 * PHASE_ANGLE_PI;
+    double term = x;
+    double sum = x;
+    for (int n = 1; n < 15; n++)
+    {
+        term *= -x * x / ((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+/**
+ * Fraction de la puissance nominale délivrée à une charge résistive lorsque le triac est amorcé
+ * à l'angle alpha (0..PI) de chaque demi-période : intégrale de sin² entre alpha et PI.
+ * P / Pmax = 1 - alpha / PI + sin(2 alpha) / (2 PI)
+ */
+constexpr double phaseAnglePowerFraction(double alpha)
+{
+    return 1.0 - alpha / PHASE_ANGLE_PI + phaseAngleSin(2 * alpha) / (2 * PHASE_ANGLE_PI);
+}
+
+// Angle d'amorçage donnant la fraction de puissance demandée (recherche dichotomique, la fonction est décroissante)
+constexpr double phaseAngleForPower(double fraction)
+{
+    double low = 0;
+    double high = PHASE_ANGLE_PI;
+    for (int i = 0; i < 48; i++)
+    {
+        double mid = (low + high) / 2;
+        if (phaseAnglePowerFraction(mid) > fraction)
+            low = mid;
+        else
+            high = mid;
+    }
+    return (low + high) / 2;
+}
+
+// Nombre d'entrées de la table (pas de 0,5 % de la puissance nominale)
+constexpr size_t PHASE_ANGLE_LUT_SIZE = 201;
+
+struct PhaseAngleTable
+{
+    uint16_t delay[PHASE_ANGLE_LUT_SIZE]; // Retard d'amorçage après le passage à zéro (µs)
+};
+
+constexpr PhaseAngleTable makePhaseAngleTable()
+{
+    PhaseAngleTable table{};
+    for (size_t i = 0; i < PHASE_ANGLE_LUT_SIZE; i++)
+    {
+        double fraction = (double)i / (PHASE_ANGLE_LUT_SIZE - 1);
+        table.delay[i] = (uint16_t)(phaseAngleForPower(fraction) / PHASE_ANGLE_PI * MAINS_HALF_PERIOD_US + 0.5);
+    }
+    return table;
+}
+
+// Table calculée à la compilation : fraction de puissance -> retard d'amorçage (en flash)
+inline constexpr PhaseAngleTable PHASE_ANGLE_LUT = makePhaseAngleTable();
+
+static_assert(PHASE_ANGLE_LUT.delay[0] == MAINS_HALF_PERIOD_US, "0 % de puissance : pas d'amorçage");
+static_assert(PHASE_ANGLE_LUT.delay[PHASE_ANGLE_LUT_SIZE - 1] == 0, "100 % de puissance : amorçage au passage à zéro");
+
+/**
+ * Retard d'amorçage (µs après le passage à zéro) pour délivrer `percentage` % de la puissance nominale,
+ * par interpolation linéaire dans la table.
+ */
+inline uint32_t phaseAngleDelayUs(float percentage)
+{
+    if (percentage <= 0)
+        return MAINS_HALF_PERIOD_US;
+    if (percentage >= 100)
+        return 0;
+    float position = percentage * (PHASE_ANGLE_LUT_SIZE - 1) / 100.0f;
+    size_t index = (size_t)position;
+    float weight = position - index;
+    return PHASE_ANGLE_LUT.delay[index] + (int32_t)((PHASE_ANGLE_LUT.delay[index + 1] - PHASE_ANGLE_LUT.delay[index]) * weight);
+}
+
+#endif // PHASE_ANGLE_H
@@ -0,0 +1,120 @@
+#include "powerMeter.h"
+
+// Nombre de mesures conservées si la régulation prend du retard
+static const UBaseType_t QUEUE_LENGTH = 8;
+
+PowerMeter::PowerMeter() : taskHandle(nullptr)
+{
+    memset(&stats, 0, sizeof(stats));
+    stats.voltage = NAN;
+    stats.powerFactor = NAN;
+    queue = xQueueCreate(QUEUE_LENGTH, sizeof(MeterSample));
+    statsMutex = xSemaphoreCreateMutex();
+}
+
+void PowerMeter::begin(BaseType_t core, UBaseType_t priority)
+{
+    if (taskHandle != nullptr)
+    {
+        return;
+    }
+    xTaskCreatePinnedToCore(taskEntry, "MeterTask", 6144, this, priority, &taskHandle, core);
+}
+
+void PowerMeter::taskEntry(void *parameter)
+{
+    PowerMeter *meter = static_cast<PowerMeter *>(parameter);
+    Serial.printf("[Meter] Tâche d'acquisition %s démarrée\n", meter->getName());
+    meter->run();
+    vTaskDelete(nullptr);
+}
+
+bool PowerMeter::receive(MeterSample &sample, TickType_t timeout)
+{
+    return xQueueReceive(queue, &sample, timeout) == pdTRUE;
+}
+
+MeterStats PowerMeter::getStats()
+{
+    MeterStats copy;
+    xSemaphoreTake(statsMutex, portMAX_DELAY);
+    copy = stats;
+    xSemaphoreGive(statsMutex);
+    return copy;
+}
+
+void PowerMeter::publish(float power, MeterQuality quality, float voltage, float powerFactor)
+{
+    if (quality != METER_INVALID)
+    {
+        xSemaphoreTake(statsMutex, portMAX_DELAY);
+        stats.voltage = voltage;
+        stats.powerFactor = powerFactor;
+        xSemaphoreGive(statsMutex);
+    }
+
+    MeterSample sample;
+    sample.power = power;
+    sample.voltage = voltage;
+    sample.powerFactor = powerFactor;
+    sample.micros = micros();
+    sample.quality = quality;
+    if (xQueueSend(queue, &sample, 0) != pdTRUE)
+    {
+        // File pleine : la mesure la plus ancienne est abandonnée au profit de la plus récente
+        MeterSample dropped;
+        xQueueReceive(queue, &dropped, 0);
+        xQueueSend(queue, &sample, 0);
+    }
+}
+
+void PowerMeter::recordRequest(bool success, uint32_t latencyMs, int error, bool timeout)
+{
+    xSemaphoreTake(statsMutex, portMAX_DELAY);
+    stats.requests++;
+    stats.lastError = error;
+    if (success)
+    {
+        stats.lastLatencyMs = latencyMs;
+        if (latencyMs > stats.maxLatencyMs)
+        {
+            stats.maxLatencyMs = latencyMs;
+        }
+        stats.averageLatencyMs = stats.requests - stats.errors == 1 ? latencyMs : stats.averageLatencyMs * 0.9f + latencyMs * 0.1f;
+        stats.lastValid = millis();
+        requestHistogram.record(latencyMs * 1000);
+    }
+    else
+    {
+        stats.errors++;
+        if (timeout)
+        {
+            stats.timeouts++;
+        }
+    }
+    xSemaphoreGive(statsMutex);
+}
+
+void PowerMeter::recordReconnection()
+{
+    xSemaphoreTake(statsMutex, portMAX_DELAY);
+    stats.reconnections++;
+    xSemaphoreGive(statsMutex);
+}
+
+void PowerMeter::recordNotification()
+{
+    xSemaphoreTake(statsMutex, portMAX_DELAY);
+    stats.notifications++;
+    stats.lastNotification = millis();
+    stats.lastValid = stats.lastNotification;
+    xSemaphoreGive(statsMutex);
+}
+
+void PowerMeter::recordError(int error)
+{
+    xSemaphoreTake(statsMutex, portMAX_DELAY);
+    stats.errors++;
+    stats.lastError = error;
+    xSemaphoreGive(statsMutex);
+}
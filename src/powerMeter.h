@@ -0,0 +1,127 @@
+#ifndef POWERMETER_H
+#define POWERMETER_H
+
+#include <Arduino.h>
+#include <math.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include "runtimeMetrics.h"
+
+struct Config;
+class MqttManager;
+
+// Qualité d'une mesure de puissance
+enum MeterQuality
+{
+    METER_INVALID,   // Lecture en échec : la puissance n'est pas significative
+    METER_ESTIMATED, // Puissance approchée (puissance apparente, sens du transit inconnu ou déduit)
+    METER_GOOD,      // Puissance active signée mesurée par le compteur
+    METER_UNSIGNED   // Soutirage seul : 0 pendant l'injection, dont le montant est inconnu (voir Regulator::update)
+};
+
+// Mesure horodatée transmise à la régulation
+struct MeterSample
+{
+    float power;          // Puissance réseau (W), > 0 soutirage, < 0 injection
+    float voltage;        // Tension (V), NAN si non mesurée
+    float powerFactor;    // Facteur de puissance, NAN si non mesuré
+    unsigned long micros; // Instant de réception de la mesure
+    MeterQuality quality;
+};
+
+// Statistiques de l'acquisition
+struct MeterStats
+{
+    uint32_t requests;              // Nombre de requêtes envoyées (compteurs interrogés)
+    uint32_t errors;                // Nombre de lectures en échec (erreur de transport, délai dépassé, réponse invalide)
+    uint32_t timeouts;              // Dont délais dépassés
+    uint32_t reconnections;         // Nombre d'ouvertures de connexion (TCP)
+    uint32_t notifications;         // Nombre de mesures poussées par le compteur (WebSocket, trame TIC, MQTT)
+    unsigned long lastNotification; // millis() de la dernière notification (0 si aucune)
+    uint32_t lastLatencyMs;         // Durée de la dernière requête réussie
+    uint32_t maxLatencyMs;          // Durée maximum d'une requête réussie
+    float averageLatencyMs;         // Durée moyenne (moyenne glissante) des requêtes réussies
+    int lastError;                  // Dernier code d'erreur (code HTTP, exception Modbus, ...)
+    unsigned long lastValid;        // millis() de la dernière mesure valide (0 si aucune)
+    float voltage;                  // Dernière tension mesurée (V), NAN si non mesurée
+    float powerFactor;              // Dernier facteur de puissance mesuré, NAN si non mesuré
+};
+
+/**
+ * Source de mesure de la puissance échangée avec le réseau.
+ * Chaque implémentation dépose ses mesures horodatées dans une file lue par la régulation,
+ * depuis sa propre tâche (compteurs interrogés ou liaison série) ou depuis la tâche qui reçoit
+ * les notifications (WebSocket, MQTT).
+ */
+class PowerMeter
+{
+public:
+    virtual ~PowerMeter() {}
+
+    /**
+     * Démarre l'acquisition (tâche dédiée pour les compteurs interrogés).
+     * @param core Cœur sur lequel épingler la tâche.
+     * @param priority Priorité de la tâche.
+     */
+    virtual void begin(BaseType_t core, UBaseType_t priority);
+
+    // Nom de la source ("shelly", "linky", "modbus", "mqtt")
+    virtual const char *getName() const = 0;
+
+    // Modifie la période d'interrogation (ms), sans effet pour les sources qui poussent leurs mesures
+    virtual void setPollPeriod(uint32_t period) {}
+
+    /**
+     * Traite une trame poussée par le compteur sur le WebSocket /shelly.
+     * @return true si une mesure a été extraite de la trame.
+     */
+    virtual bool handleNotification(const uint8_t *data, size_t len) { return false; }
+
+    /**
+     * Attend la prochaine mesure.
+     * @param sample Mesure reçue.
+     * @param timeout Attente maximum.
+     * @return false si aucune mesure n'est arrivée pendant `timeout`.
+     */
+    bool receive(MeterSample &sample, TickType_t timeout);
+
+    MeterStats getStats();
+    // Répartition des durées des requêtes réussies au compteur
+    LatencySnapshot getRequestHistogram() const { return requestHistogram.get(); }
+    // Tâche d'acquisition (nullptr pour les sources qui poussent leurs mesures)
+    TaskHandle_t getTaskHandle() const { return taskHandle; }
+
+protected:
+    PowerMeter();
+
+    // Boucle de la tâche d'acquisition
+    virtual void run() {}
+
+    // Ajoute une mesure à la file (la plus ancienne est abandonnée si la file est pleine)
+    void publish(float power, MeterQuality quality, float voltage = NAN, float powerFactor = NAN);
+    // Résultat d'une requête au compteur
+    void recordRequest(bool success, uint32_t latencyMs, int error = 0, bool timeout = false);
+    void recordReconnection();
+    // Mesure poussée par le compteur
+    void recordNotification();
+    // Lecture en échec hors requête (trame invalide)
+    void recordError(int error);
+
+private:
+    static void taskEntry(void *parameter);
+
+    QueueHandle_t queue;
+    SemaphoreHandle_t statsMutex;
+    MeterStats stats;
+    LatencyHistogram requestHistogram;
+    TaskHandle_t taskHandle;
+};
+
+/**
+ * Crée la source de mesure choisie dans la configuration (config.meter.source).
+ * @return nullptr si la source n'est pas configurée.
+ */
+PowerMeter *createPowerMeter(const Config &config, MqttManager &mqttManager);
+
+#endif
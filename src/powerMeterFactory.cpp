@@ -0,0 +1,33 @@
+#include "powerMeter.h"
+#include "configManager.h"
+#include "linkyTic.h"
+#include "modbusMeter.h"
+#include "mqttMeter.h"
+#include "shellyEm.h"
+
+PowerMeter *createPowerMeter(const Config &config, MqttManager &mqttManager)
+{
+    const MeterConfig &meter = config.meter;
+    if (meter.source == "linky")
+    {
+        return new LinkyTic(meter.linky.standard, meter.linky.rxPin);
+    }
+    if (meter.source == "modbus")
+    {
+        return new ModbusMeter(meter.modbus);
+    }
+    if (meter.source == "mqtt")
+    {
+        if (meter.mqtt.topic == "" || config.mqtt.server == "")
+        {
+            return nullptr;
+        }
+        return new MqttMeter(mqttManager, meter.mqtt.topic, meter.mqtt.key);
+    }
+    if (config.shellyEm.ip == "")
+    {
+        return nullptr;
+    }
+    return new ShellyEm(String(config.shellyEm.ip.c_str()), String(config.shellyEm.channel.c_str()),
+                        parseShellyModel(config.shellyEm.model), config.shellyEm.pollPeriod);
+}
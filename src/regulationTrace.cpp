@@ -0,0 +1,94 @@
+#include "regulationTrace.h"
+
+bool parseTraceTrigger(const std::string &name, TraceTrigger &trigger)
+{
+    if (name == "none")
+        trigger = TRACE_TRIGGER_NONE;
+    else if (name == "import")
+        trigger = TRACE_TRIGGER_IMPORT;
+    else if (name == "export")
+        trigger = TRACE_TRIGGER_EXPORT;
+    else
+        return false;
+    return true;
+}
+
+const char *traceTriggerName(TraceTrigger trigger)
+{
+    switch (trigger)
+    {
+    case TRACE_TRIGGER_NONE:
+        return "none";
+    case TRACE_TRIGGER_IMPORT:
+        return "import";
+    case TRACE_TRIGGER_EXPORT:
+        return "export";
+    }
+    return "unknown";
+}
+
+RegulationTrace::RegulationTrace()
+    : ring(REGULATION_TRACE_CAPACITY), frozen(false), trigger(TRACE_TRIGGER_NONE), threshold(0), postRecords(0), triggerEnd(0)
+{
+}
+
+void RegulationTrace::record(const TraceRecord &record)
+{
+    if (frozen.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+    ring.push(record);
+    uint32_t end = ring.end();
+
+    uint32_t triggered = triggerEnd.load(std::memory_order_relaxed);
+    if (triggered == 0)
+    {
+        TraceTrigger armed = (TraceTrigger)trigger.load(std::memory_order_relaxed);
+        float limit = threshold.load(std::memory_order_relaxed);
+        if ((armed == TRACE_TRIGGER_IMPORT && record.power > limit) || (armed == TRACE_TRIGGER_EXPORT && record.power < -limit))
+        {
+            triggerEnd.store(end, std::memory_order_relaxed);
+            triggered = end;
+        }
+    }
+    if (triggered != 0 && end - triggered >= postRecords.load(std::memory_order_relaxed))
+    {
+        frozen.store(true, std::memory_order_release);
+    }
+}
+
+void RegulationTrace::arm(TraceTrigger trigger, float threshold, uint32_t postRecords)
+{
+    frozen.store(true, std::memory_order_relaxed);
+    this->trigger.store(trigger, std::memory_order_relaxed);
+    this->threshold.store(threshold, std::memory_order_relaxed);
+    this->postRecords.store(postRecords < REGULATION_TRACE_CAPACITY ? postRecords : REGULATION_TRACE_CAPACITY - 1, std::memory_order_relaxed);
+    triggerEnd.store(0, std::memory_order_relaxed);
+    frozen.store(false, std::memory_order_release);
+}
+
+void RegulationTrace::freeze()
+{
+    frozen.store(true, std::memory_order_release);
+}
+
+void RegulationTrace::resume()
+{
+    arm(TRACE_TRIGGER_NONE, 0, 0);
+}
+
+TraceStatus RegulationTrace::getStatus() const
+{
+    TraceStatus status;
+    status.capacity = REGULATION_TRACE_CAPACITY;
+    status.first = ring.begin();
+    status.end = ring.end();
+    status.frozen = frozen.load(std::memory_order_acquire);
+    status.trigger = (TraceTrigger)trigger.load(std::memory_order_relaxed);
+    status.threshold = threshold.load(std::memory_order_relaxed);
+    status.postRecords = postRecords.load(std::memory_order_relaxed);
+    uint32_t triggered = triggerEnd.load(std::memory_order_relaxed);
+    status.triggerIndex = triggered != 0 ? triggered - 1 : UINT32_MAX;
+    return status;
+}
@@ -0,0 +1,94 @@
+#ifndef REGULATION_TRACE_H
+#define REGULATION_TRACE_H
+
+#include <atomic>
+#include <stdint.h>
+#include <string>
+#include "seqlockRing.h"
+
+// Nombre de pas de régulation conservés (32 octets chacun), à définir dans platformio.ini si besoin
+#ifndef REGULATION_TRACE_CAPACITY
+#define REGULATION_TRACE_CAPACITY 1024
+#endif
+
+// Un pas de régulation (une mesure du compteur traitée par la tâche de régulation)
+struct TraceRecord
+{
+    uint32_t micros;        // Instant de la commande (µs depuis le démarrage)
+    uint32_t latencyUs;     // Délai entre la réception de la mesure et la commande
+    float power;            // Puissance réseau mesurée (W), > 0 soutirage
+    float error;            // Écart à la consigne (% de la puissance nominale), 0 hors régulation
+    float integral;         // Terme intégral du régulateur (%), 0 hors régulation
+    float derivative;       // Terme dérivé du régulateur (%), 0 hors régulation
+    float output;           // Commande appliquée (% de la puissance nominale)
+    uint16_t firingDelayUs; // Retard d'amorçage du triac (MAINS_HALF_PERIOD_US = bloqué)
+    uint8_t state;          // État de la commande (ControlState)
+    uint8_t quality;        // Qualité de la mesure (MeterQuality)
+};
+
+static_assert(sizeof(TraceRecord) == 32, "TraceRecord est téléchargé tel quel (format binaire)");
+
+// Condition de gel de la trace
+enum TraceTrigger : uint8_t
+{
+    TRACE_TRIGGER_NONE,   // Enregistrement continu
+    TRACE_TRIGGER_IMPORT, // Soutirage supérieur au seuil
+    TRACE_TRIGGER_EXPORT  // Injection supérieure au seuil
+};
+
+// Conversion du déclencheur depuis / vers l'API ("none", "import", "export")
+bool parseTraceTrigger(const std::string &name, TraceTrigger &trigger);
+const char *traceTriggerName(TraceTrigger trigger);
+
+// État de la trace pour l'API
+struct TraceStatus
+{
+    uint32_t capacity;     // Nombre maximum de pas conservés
+    uint32_t first;        // Index absolu du plus ancien pas conservé
+    uint32_t end;          // Index absolu suivant le plus récent pas (total enregistré)
+    bool frozen;           // Enregistrement arrêté (déclencheur ou gel manuel)
+    TraceTrigger trigger;  // Déclencheur armé
+    float threshold;       // Seuil du déclencheur (W)
+    uint32_t postRecords;  // Pas enregistrés après le déclenchement avant le gel
+    uint32_t triggerIndex; // Index absolu du pas déclencheur, UINT32_MAX si pas encore déclenché
+};
+
+/**
+ * Trace en RAM de chaque pas de régulation, pour analyser hors ligne les oscillations.
+ * Un seul écrivain (la tâche de régulation) : l'enregistrement est une copie de 32 octets dans un
+ * SeqlockRing, sans verrou ni allocation. Les lecteurs (téléchargement) parcourent le tampon en place.
+ *
+ * Un déclencheur (soutirage ou injection au-delà d'un seuil) gèle la trace `postRecords` pas après
+ * l'événement : le tampon contient alors le contexte qui précède et qui suit l'événement.
+ */
+class RegulationTrace
+{
+public:
+    RegulationTrace();
+
+    // Enregistre un pas (tâche de régulation uniquement), sans effet si la trace est gelée
+    void record(const TraceRecord &record);
+
+    /**
+     * Arme le déclencheur et relance l'enregistrement.
+     * @param postRecords Pas enregistrés après l'événement (limité à la capacité de la trace).
+     */
+    void arm(TraceTrigger trigger, float threshold, uint32_t postRecords);
+    // Gel immédiat (manuel)
+    void freeze();
+    // Désarme le déclencheur et relance l'enregistrement continu
+    void resume();
+
+    TraceStatus getStatus() const;
+    const SeqlockRing<TraceRecord> &getRing() const { return ring; }
+
+private:
+    SeqlockRing<TraceRecord> ring;
+    std::atomic<bool> frozen;
+    std::atomic<uint8_t> trigger;
+    std::atomic<float> threshold;
+    std::atomic<uint32_t> postRecords;
+    std::atomic<uint32_t> triggerEnd; // Valeur de ring.end() après le pas déclencheur, 0 si pas encore déclenché
+};
+
+#endif // REGULATION_TRACE_H
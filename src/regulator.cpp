@@ -0,0 +1,64 @@
+#include "regulator.h"
+
+Regulator::Regulator() : integral(0), output(0), lastGridPower(0), hasLastGridPower(false), terms{0, 0, 0}
+{
+    config = RegulationConfig{-30, 0.2f, 0.5f, 0, 25};
+}
+
+void Regulator::configure(const RegulationConfig &config)
+{
+    this->config = config;
+}
+
+void Regulator::reset(float output)
+{
+    this->output = output;
+    integral = output;
+    hasLastGridPower = false;
+}
+
+float Regulator::update(float gridPower, float heaterPower, float dt, bool exportMeasured)
+{
+    if (heaterPower <= 0 || dt <= 0)
+    {
+        return output;
+    }
+
+    // Écart en % de la puissance nominale : > 0 s'il reste de la puissance à router
+    float scale = 100.0f / heaterPower;
+    float setpoint = exportMeasured || config.setpoint > 0 ? config.setpoint : UNSIGNED_METER_SETPOINT;
+    float error = (setpoint - gridPower) * scale;
+
+    float proportional = config.kp * error;
+    float derivative = 0;
+    if (hasLastGridPower)
+    {
+        // Dérivée sur la mesure, pour ne pas réagir brutalement à un changement de consigne
+        derivative = -config.kd * (gridPower - lastGridPower) * scale / dt;
+    }
+    lastGridPower = gridPower;
+    hasLastGridPower = true;
+
+    integral += config.ki * error * dt;
+    float command = proportional + integral + derivative;
+
+    // Limitation de pente puis saturation
+    if (config.maxRate > 0)
+    {
+        float maxStep = config.maxRate * dt;
+        if (command > output + maxStep)
+            command = output + maxStep;
+        if (command < output - maxStep)
+            command = output - maxStep;
+    }
+    if (command < 0)
+        command = 0;
+    if (command > 100)
+        command = 100;
+
+    // Anti-windup : l'intégrale est recalée sur la commande effectivement appliquée
+    integral = command - proportional - derivative;
+    output = command;
+    terms = RegulatorTerms{error, integral, derivative};
+    return output;
+}
@@ -0,0 +1,60 @@
+#ifndef REGULATOR_H
+#define REGULATOR_H
+
+// Paramètres de la régulation de la puissance routée
+struct RegulationConfig
+{
+    float setpoint; // Puissance réseau visée (W), négative pour conserver une légère injection
+    float kp;       // Gain proportionnel (% de puissance par % d'écart)
+    float ki;       // Gain intégral (1/s)
+    float kd;       // Gain dérivé (s), appliqué à la mesure
+    float maxRate;  // Variation maximale de la commande (% par seconde), 0 = pas de limite
+};
+
+// Consigne appliquée lorsque le compteur ne mesure pas l'injection, si la consigne configurée n'est pas positive (W)
+const float UNSIGNED_METER_SETPOINT = 50;
+
+// Termes du dernier calcul de la commande (% de la puissance nominale), pour la trace de la régulation
+struct RegulatorTerms
+{
+    float error;      // Écart à la consigne
+    float integral;   // Terme intégral (après anti-windup)
+    float derivative; // Terme dérivé
+};
+
+/**
+ * Régulateur PID de la puissance routée vers le chauffe-eau.
+ * L'écart (consigne - puissance réseau) est ramené en % de la puissance nominale du chauffe-eau,
+ * ce qui rend les gains indépendants de la résistance installée.
+ * L'intégrale suit la commande réellement appliquée (saturation 0-100 % et limitation de pente),
+ * ce qui évite l'emballement de l'intégrale (anti-windup par recalcul).
+ */
+class Regulator
+{
+public:
+    Regulator();
+
+    void configure(const RegulationConfig &config);
+    // Reprise sans à-coup à partir de la commande courante (changement de mode)
+    void reset(float output);
+    /**
+     * Nouvelle mesure de la puissance réseau (> 0 soutirage) après `dt` secondes, retourne la commande (%).
+     * Sans mesure de l'injection (`exportMeasured` false : Linky sans SINSTI, PZEM), 0 W signifie une injection
+     * de montant inconnu : une consigne négative ou nulle ferait baisser la commande jusqu'à 0 et rien ne serait
+     * routé. La consigne est alors portée à UNSIGNED_METER_SETPOINT : la commande monte lentement (terme intégral)
+     * tant que rien n'est soutiré, et se stabilise sur un léger soutirage.
+     */
+    float update(float gridPower, float heaterPower, float dt, bool exportMeasured = true);
+    float getOutput() const { return output; }
+    const RegulatorTerms &getTerms() const { return terms; }
+
+private:
+    RegulationConfig config;
+    float integral;
+    float output;
+    float lastGridPower;
+    bool hasLastGridPower;
+    RegulatorTerms terms;
+};
+
+#endif // REGULATOR_H
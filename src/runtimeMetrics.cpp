@@ -0,0 +1,66 @@
+#include "runtimeMetrics.h"
+
+// En RAM : lue depuis les interruptions du triac, y compris pendant les écritures en flash
+DRAM_ATTR const uint32_t LATENCY_BOUNDS_US[LATENCY_BUCKETS] = {10, 50, 100, 500, 1000, 5000, 10000, 50000, 100000, 500000, 1000000, 5000000};
+
+LatencyHistogram::LatencyHistogram() : count(0), sumUs(0), maxUs(0)
+{
+    for (size_t i = 0; i <= LATENCY_BUCKETS; i++)
+    {
+        buckets[i] = 0;
+    }
+}
+
+void IRAM_ATTR LatencyHistogram::record(uint32_t us)
+{
+    size_t bucket = 0;
+    while (bucket < LATENCY_BUCKETS && us > LATENCY_BOUNDS_US[bucket])
+    {
+        bucket++;
+    }
+    buckets[bucket] = buckets[bucket] + 1;
+    sumUs = sumUs + us;
+    if (us > maxUs)
+    {
+        maxUs = us;
+    }
+    count = count + 1;
+}
+
+void IRAM_ATTR LatencyHistogram::recordCycles(uint32_t cycles, uint32_t cyclesPerUs)
+{
+    record(cyclesPerUs > 0 ? cycles / cyclesPerUs : cycles);
+}
+
+LatencySnapshot LatencyHistogram::get() const
+{
+    LatencySnapshot snapshot;
+    for (size_t i = 0; i <= LATENCY_BUCKETS; i++)
+    {
+        snapshot.buckets[i] = buckets[i];
+    }
+    snapshot.count = count;
+    snapshot.sumUs = sumUs;
+    snapshot.maxUs = maxUs;
+    return snapshot;
+}
+
+void appendPrometheusHistogram(String &out, const char *name, const char *help, const LatencySnapshot &histogram)
+{
+    char line[128];
+    snprintf(line, sizeof(line), "# HELP %s %s\n# TYPE %s histogram\n", name, help, name);
+    out += line;
+
+    uint32_t cumulative = 0;
+    for (size_t i = 0; i < LATENCY_BUCKETS; i++)
+    {
+        cumulative += histogram.buckets[i];
+        snprintf(line, sizeof(line), "%s_bucket{le=\"%g\"} %u\n", name, LATENCY_BOUNDS_US[i] / 1e6, (unsigned)cumulative);
+        out += line;
+    }
+    cumulative += histogram.buckets[LATENCY_BUCKETS];
+    snprintf(line, sizeof(line), "%s_bucket{le=\"+Inf\"} %u\n", name, (unsigned)cumulative);
+    out += line;
+    snprintf(line, sizeof(line), "%s_sum %.6f\n%s_count %u\n", name, histogram.sumUs / 1e6, name, (unsigned)cumulative);
+    out += line;
+}
@@ -0,0 +1,53 @@
+#ifndef RUNTIME_METRICS_H
+#define RUNTIME_METRICS_H
+
+#include <Arduino.h>
+
+// Nombre de classes de l'histogramme (hors classe +Inf)
+const size_t LATENCY_BUCKETS = 12;
+
+// Bornes supérieures des classes (µs), de 10 µs (interruptions) à 5 s (requêtes au compteur)
+extern const uint32_t LATENCY_BOUNDS_US[LATENCY_BUCKETS];
+
+// Copie d'un histogramme pour l'API
+struct LatencySnapshot
+{
+    uint32_t buckets[LATENCY_BUCKETS + 1]; // Effectif de chaque classe (non cumulé), la dernière est +Inf
+    uint32_t count;                        // Nombre de mesures
+    uint64_t sumUs;                        // Somme des durées (µs)
+    uint32_t maxUs;                        // Durée maximum (µs)
+};
+
+/**
+ * Histogramme de durées à classes fixes, sans allocation ni verrou.
+ * Un seul écrivain par histogramme (une tâche ou une interruption) : record() peut être appelé
+ * depuis une interruption. Les lecteurs copient les compteurs avec get(), la copie peut être
+ * décalée d'une mesure entre les classes et le total, ce qui est sans conséquence pour des statistiques.
+ */
+class LatencyHistogram
+{
+public:
+    LatencyHistogram();
+
+    // Enregistre une durée (µs)
+    void record(uint32_t us);
+    // Enregistre une durée mesurée en cycles CPU (ESP.getCycleCount(), même cœur au début et à la fin)
+    void recordCycles(uint32_t cycles, uint32_t cyclesPerUs);
+
+    LatencySnapshot get() const;
+
+private:
+    volatile uint32_t buckets[LATENCY_BUCKETS + 1];
+    volatile uint32_t count;
+    volatile uint64_t sumUs;
+    volatile uint32_t maxUs;
+};
+
+/**
+ * Ajoute un histogramme au format texte Prometheus (_bucket cumulés, _sum et _count, en secondes).
+ * @param name Nom de la métrique (ex: "solar_router_control_loop_seconds").
+ * @param help Description (ligne # HELP).
+ */
+void appendPrometheusHistogram(String &out, const char *name, const char *help, const LatencySnapshot &histogram);
+
+#endif // RUNTIME_METRICS_H
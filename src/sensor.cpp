@@ -1,35 +1,155 @@
-#include <Arduino.h>
-#include <OneWire.h>
-#include <DallasTemperature.h>
+#include "sensor.h"
 
-// Data wire is plugged into port 4 on the
-#define pinTemperature 4
+// Horodatage minimum d'une heure valide (01/01/2020)
+static const time_t MIN_VALID_TIMESTAMP = 1577836800;
+// Échéance d'une conversion : durée nominale plus cette marge (ms)
+static const uint32_t CONVERSION_MARGIN = 250;
 
-// Setup a oneWire instance to communicate with any OneWire devices (not just Maxim/Dallas temperature ICs)
-OneWire oneWire(pinTemperature);
+TemperatureSensor::TemperatureSensor(uint8_t pin)
+    : oneWire(pin), sensors(&oneWire), hasAddress(false), parasite(false), resolution(SENSOR_MAX_RESOLUTION), interval(30000),
+      conversionTime(750), converting(false), requested(false), conversionStart(0), lastRequest(0)
+{
+    memset(&stats, 0, sizeof(stats));
+    stats.value = NAN;
+    statsMutex = xSemaphoreCreateMutex();
+}
+
+void TemperatureSensor::begin()
+{
+    sensors.begin();
+    // Les conversions sont lancées sans attente, la fin est vérifiée par loop()
+    sensors.setWaitForConversion(false);
+    if (findSensor())
+    {
+        Serial.printf("[Sensor] Sonde trouvée, résolution %d bits%s\n", resolution, parasite ? ", alimentation parasite" : "");
+    }
+    else
+    {
+        Serial.println("[Sensor] Aucune sonde de température trouvée");
+    }
+}
+
+void TemperatureSensor::configure(int resolution, uint32_t interval)
+{
+    if (resolution < SENSOR_MIN_RESOLUTION || resolution > SENSOR_MAX_RESOLUTION)
+    {
+        resolution = SENSOR_MAX_RESOLUTION;
+    }
+    this->interval = interval < (uint32_t)SENSOR_MIN_INTERVAL ? SENSOR_MIN_INTERVAL : interval;
+    if (resolution != this->resolution)
+    {
+        this->resolution = resolution;
+        conversionTime = sensors.millisToWaitForConversion(resolution);
+        // Conversion en cours à l'ancienne résolution abandonnée, la suivante est lancée aussitôt
+        converting = false;
+        requested = false;
+        if (hasAddress)
+        {
+            sensors.setResolution(address, resolution);
+        }
+    }
+}
+
+bool TemperatureSensor::findSensor()
+{
+    hasAddress = sensors.getAddress(address, 0);
+    if (hasAddress)
+    {
+        sensors.setResolution(address, resolution);
+        parasite = sensors.isParasitePowerMode();
+        conversionTime = sensors.millisToWaitForConversion(resolution);
+    }
+    return hasAddress;
+}
+
+bool TemperatureSensor::loop()
+{
+    unsigned long now = millis();
+    if (!converting)
+    {
+        if (requested && now - lastRequest < interval)
+        {
+            return false;
+        }
+        requested = true;
+        lastRequest = now;
+        if ((!hasAddress && !findSensor()) || !sensors.requestTemperaturesByAddress(address))
+        {
+            // Sonde absente : nouvelle recherche à la prochaine période
+            hasAddress = false;
+            xSemaphoreTake(statsMutex, portMAX_DELAY);
+            stats.errors++;
+            xSemaphoreGive(statsMutex);
+            return false;
+        }
+        converting = true;
+        conversionStart = now;
+        return false;
+    }
+
+    uint32_t elapsed = now - conversionStart;
+    // En alimentation parasite, la sonde ne peut pas signaler la fin : attente de la durée nominale
+    bool complete = parasite ? elapsed >= conversionTime : sensors.isConversionComplete();
+    if (complete)
+    {
+        converting = false;
+        return readConversion(now);
+    }
+    if (elapsed > conversionTime + CONVERSION_MARGIN)
+    {
+        converting = false;
+        hasAddress = false;
+        xSemaphoreTake(statsMutex, portMAX_DELAY);
+        stats.timeouts++;
+        xSemaphoreGive(statsMutex);
+        Serial.println("[Sensor] Conversion non terminée à l'échéance");
+    }
+    return false;
+}
 
-// Pass our oneWire reference to Dallas Temperature.
-DallasTemperature sensors(&oneWire);
+bool TemperatureSensor::readConversion(unsigned long now)
+{
+    // Lecture du scratchpad avec vérification du CRC (faux si la sonde ne répond pas)
+    uint8_t scratchPad[9];
+    if (!sensors.isConnected(address, scratchPad))
+    {
+        hasAddress = false;
+        xSemaphoreTake(statsMutex, portMAX_DELAY);
+        stats.errors++;
+        xSemaphoreGive(statsMutex);
+        Serial.println("[Sensor] Erreur de lecture de la température (CRC ou sonde absente)");
+        return false;
+    }
+
+    // DS18B20 : 1/16 °C, bits de poids faible indéfinis sous 12 bits de résolution
+    int16_t raw = (int16_t)((scratchPad[1] << 8) | scratchPad[0]);
+    raw &= ~((1 << (SENSOR_MAX_RESOLUTION - resolution)) - 1);
+    float value = raw / 16.0f;
+    time_t nowTime = time(nullptr);
 
-void setupSensor()
+    xSemaphoreTake(statsMutex, portMAX_DELAY);
+    stats.reads++;
+    stats.lastConversionMs = now - conversionStart;
+    stats.value = value;
+    stats.lastGood = now;
+    stats.lastGoodTime = nowTime >= MIN_VALID_TIMESTAMP ? nowTime : 0;
+    xSemaphoreGive(statsMutex);
+    return true;
+}
+
+float TemperatureSensor::getTemperature()
 {
-  sensors.begin(); // Démare la lecture de capteur de température
+    xSemaphoreTake(statsMutex, portMAX_DELAY);
+    float value = stats.value;
+    xSemaphoreGive(statsMutex);
+    return value;
 }
 
-float getTemperature()
+TemperatureStats TemperatureSensor::getStats()
 {
-  // Recupère la température
-  sensors.requestTemperatures();
-  float tempC = sensors.getTempCByIndex(0);
-  if (tempC != DEVICE_DISCONNECTED_C)
-  {
-    Serial.print("Température actuelle : ");
-    Serial.println(tempC);
-    return tempC;
-  }
-  else
-  {
-    Serial.println("Error: Could not read temperature data");
-    return -127; // Retourne -127 en cas d'erreur de lecture
-  }
-}
\ No newline at end of file
+    TemperatureStats copy;
+    xSemaphoreTake(statsMutex, portMAX_DELAY);
+    copy = stats;
+    xSemaphoreGive(statsMutex);
+    return copy;
+}
@@ -1,7 +1,78 @@
 #ifndef TEMP_SENSOR_FUNCTIONS_H
 #define TEMP_SENSOR_FUNCTIONS_H
 
-void setupSensor();
-float getTemperature();
+#include <Arduino.h>
+#include <OneWire.h>
+#include <DallasTemperature.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <time.h>
 
-#endif
\ No newline at end of file
+// Résolution de la sonde (bits) : 9 (0,5 °C, 94 ms) à 12 (0,0625 °C, 750 ms)
+const int SENSOR_MIN_RESOLUTION = 9;
+const int SENSOR_MAX_RESOLUTION = 12;
+// Période minimum entre deux lectures (ms), supérieure à la durée d'une conversion en 12 bits
+const int SENSOR_MIN_INTERVAL = 1000;
+
+// Statistiques de la sonde de température
+struct TemperatureStats
+{
+    uint32_t reads;            // Lectures valides
+    uint32_t errors;           // Lectures en échec (CRC invalide, sonde absente ou débranchée)
+    uint32_t timeouts;         // Conversions non terminées avant l'échéance
+    uint32_t lastConversionMs; // Durée de la dernière conversion
+    float value;               // Dernière température valide (°C), NAN si aucune
+    unsigned long lastGood;    // millis() de la dernière lecture valide (0 si aucune)
+    time_t lastGoodTime;       // Heure de la dernière lecture valide (0 si l'heure n'était pas synchronisée)
+};
+
+/**
+ * Sonde DS18B20 lue sans bloquer la tâche appelante.
+ * loop() lance une conversion toutes les `interval` ms (setWaitForConversion(false)), puis vérifie à chaque
+ * appel si elle est terminée (bit de fin de conversion, ou durée nominale en alimentation parasite) et lit
+ * le scratchpad, dont le CRC est vérifié. Une conversion non terminée à l'échéance est abandonnée et la
+ * sonde recherchée à nouveau. Le bus n'est utilisé que depuis la tâche qui appelle loop().
+ */
+class TemperatureSensor
+{
+public:
+    explicit TemperatureSensor(uint8_t pin);
+
+    void begin();
+
+    // Résolution (bits, SENSOR_MIN_RESOLUTION..SENSOR_MAX_RESOLUTION) et période de lecture (ms)
+    void configure(int resolution, uint32_t interval);
+
+    /**
+     * Avance l'acquisition, à appeler régulièrement (quelques dizaines de ms au plus entre deux appels).
+     * @return true si une nouvelle température valide vient d'être lue.
+     */
+    bool loop();
+
+    // Dernière température valide (°C), NAN si aucune
+    float getTemperature();
+    TemperatureStats getStats();
+
+private:
+    // Recherche la première sonde du bus et lui applique la résolution
+    bool findSensor();
+    // Lecture du scratchpad à la fin de la conversion
+    bool readConversion(unsigned long now);
+
+    OneWire oneWire;
+    DallasTemperature sensors;
+    DeviceAddress address;
+    bool hasAddress;
+    bool parasite;              // Sonde alimentée par le bus : pas de lecture du bit de fin de conversion
+    int resolution;
+    uint32_t interval;
+    uint32_t conversionTime;    // Durée nominale d'une conversion à la résolution choisie (ms)
+    bool converting;
+    bool requested;             // Au moins une conversion lancée (lastRequest significatif)
+    unsigned long conversionStart;
+    unsigned long lastRequest;
+    TemperatureStats stats;
+    SemaphoreHandle_t statsMutex;
+};
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef SEQLOCK_RING_H
+#define SEQLOCK_RING_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Tampon circulaire à un seul écrivain et plusieurs lecteurs, sans verrou.
+ * L'écrivain ne bloque jamais : chaque case porte un numéro de séquence (seqlock par case)
+ * qui permet aux lecteurs de détecter une case en cours d'écriture ou écrasée pendant la lecture.
+ * Les lecteurs parcourent le tampon en place, sans copie ni allocation.
+ *
+ * Contrainte : un seul écrivain à la fois (ici la tâche de communication, ou setup() avant le démarrage des tâches).
+ */
+template <typename T>
+class SeqlockRing
+{
+public:
+    explicit SeqlockRing(size_t capacity) : capacity(capacity), written(0)
+    {
+        slots = new Slot[capacity];
+        for (size_t i = 0; i < capacity; i++)
+        {
+            slots[i].seq.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    ~SeqlockRing()
+    {
+        delete[] slots;
+    }
+
+    // Ajoute un élément (écrase le plus ancien si le tampon est plein)
+    void push(const T &value)
+    {
+        uint32_t index = written.load(std::memory_order_relaxed);
+        Slot &slot = slots[index % capacity];
+        // Case marquée "en cours d'écriture" avant la modification des données
+        slot.seq.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.value = value;
+        slot.seq.store(index + 1, std::memory_order_release);
+        written.store(index + 1, std::memory_order_release);
+    }
+
+    // Index absolu du plus ancien élément encore disponible
+    uint32_t begin() const
+    {
+        uint32_t end = written.load(std::memory_order_acquire);
+        return end > capacity ? end - capacity : 0;
+    }
+
+    // Index absolu suivant le plus récent élément
+    uint32_t end() const
+    {
+        return written.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Lit l'élément d'index absolu `index`.
+     * @return false si l'élément a été écrasé (ou est en cours d'écriture) : la lecture est à reprendre plus loin.
+     */
+    bool read(uint32_t index, T &value) const
+    {
+        const Slot &slot = slots[index % capacity];
+        if (slot.seq.load(std::memory_order_acquire) != index + 1)
+        {
+            return false;
+        }
+        value = slot.value;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slot.seq.load(std::memory_order_relaxed) == index + 1;
+    }
+
+    /**
+     * Parcourt les éléments du plus ancien au plus récent, sans copie du tampon.
+     * Les éléments écrasés pendant le parcours sont ignorés (la lecture reprend au plus ancien disponible).
+     * @return le nombre d'éléments visités.
+     */
+    template <typename Visitor>
+    size_t forEach(Visitor visit) const
+    {
+        size_t visited = 0;
+        uint32_t last = end();
+        T value;
+        for (uint32_t i = begin(); i < last; i++)
+        {
+            if (!read(i, value))
+            {
+                // Rattrapé par l'écrivain : reprise au plus ancien élément encore présent
+                uint32_t first = begin();
+                if (first > i)
+                {
+                    i = first - 1;
+                }
+                continue;
+            }
+            visit(value);
+            visited++;
+        }
+        return visited;
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<uint32_t> seq; // Index absolu + 1 de l'élément stocké, 0 pendant l'écriture
+        T value;
+    };
+
+    Slot *slots;
+    size_t capacity;
+    std::atomic<uint32_t> written; // Nombre total d'éléments écrits
+};
+
+#endif // SEQLOCK_RING_H
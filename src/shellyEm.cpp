@@ -1,34 +1,210 @@
 #include "shellyEm.h"
-#include <HTTPClient.h>
+#include "jsonScan.h"
+#include <algorithm>
 
-ShellyEm::ShellyEm(const String &adresseIp, const String &channel)
-    : ip(adresseIp), channel(channel) {}
+// Délai maximum d'établissement de la connexion TCP (ms)
+static const int32_t CONNECT_TIMEOUT = 1000;
+// Délai maximum d'attente de la réponse (ms)
+static const uint16_t RESPONSE_TIMEOUT = 1500;
+
+ShellyModel parseShellyModel(const std::string &model)
+{
+    if (model == "proem")
+        return SHELLY_PRO_EM;
+    if (model == "pro3em")
+        return SHELLY_PRO_3EM;
+    return SHELLY_EM;
+}
+
+ShellyEm::ShellyEm(const String &adresseIp, const String &channel, ShellyModel model, uint32_t pollPeriod)
+    : ip(adresseIp), channel(channel), model(model), pollPeriod(SHELLY_DEFAULT_POLL_PERIOD)
+{
+    setPollPeriod(pollPeriod);
+    // Le channel "1" de l'interface correspond à l'index 0 du compteur
+    String id = channel == "1" ? "0" : "1";
+    switch (model)
+    {
+    case SHELLY_PRO_EM:
+        url = "http://" + ip + "/rpc/EM1.GetStatus?id=" + id;
+        component = "em1:" + id;
+        powerKey = "act_power";
+        voltageKey = "voltage";
+        powerFactorKey = "pf";
+        break;
+    case SHELLY_PRO_3EM:
+        // Puissance totale des 3 phases, tension et facteur de puissance de la phase A
+        url = "http://" + ip + "/rpc/EM.GetStatus?id=0";
+        component = "em:0";
+        powerKey = "total_act_power";
+        voltageKey = "a_voltage";
+        powerFactorKey = "a_pf";
+        break;
+    default:
+        url = "http://" + ip + "/emeter/" + id;
+        powerKey = "power";
+        voltageKey = "voltage";
+        powerFactorKey = "pf";
+        break;
+    }
+
+    // Connexion conservée entre deux requêtes (keep-alive)
+    http.setReuse(true);
+    http.setConnectTimeout(CONNECT_TIMEOUT);
+    http.setTimeout(RESPONSE_TIMEOUT);
+}
+
+void ShellyEm::setPollPeriod(uint32_t period)
+{
+    pollPeriod = period < SHELLY_MIN_POLL_PERIOD ? SHELLY_MIN_POLL_PERIOD : period;
+}
+
+bool ShellyEm::handleNotification(const uint8_t *data, size_t len)
+{
+    if (model == SHELLY_EM)
+    {
+        return false; // Pas de WebSocket sortant sur les modèles Gen1
+    }
+
+    const char *json = (const char *)data;
+    const char *method = jsonScanFind(json, len, "method");
+    size_t remaining = method == nullptr ? 0 : json + len - method;
+    if (!(remaining >= 14 && memcmp(method, "\"NotifyStatus\"", 14) == 0) &&
+        !(remaining >= 18 && memcmp(method, "\"NotifyFullStatus\"", 18) == 0))
+    {
+        return false;
+    }
+    // Les valeurs sont cherchées dans l'objet du composant configuré uniquement (pas dans celui d'un autre channel)
+    const char *object = jsonScanFind(json, len, component.c_str());
+    size_t objectLength = object == nullptr ? 0 : jsonScanObjectLength(object, json + len - object);
+    if (objectLength == 0)
+    {
+        return false; // Composant absent, ou trame tronquée
+    }
+
+    // NotifyStatus ne contient que les valeurs modifiées : la puissance peut être absente
+    ShellyReading reading;
+    if (!parse(object, objectLength, reading))
+    {
+        return false;
+    }
+    publish(reading.power, reading.valid ? METER_GOOD : METER_INVALID, reading.voltage, reading.powerFactor);
+    recordNotification();
+    return true;
+}
+
+void ShellyEm::run()
+{
+    TickType_t lastWake = xTaskGetTickCount();
+    bool lastValid = true;
+
+    for (;;)
+    {
+        unsigned long lastNotification = getStats().lastNotification;
+
+        if (lastNotification != 0 && millis() - lastNotification < pollPeriod)
+        {
+            // Mesures poussées par le compteur : pas d'interrogation
+            vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(pollPeriod));
+            continue;
+        }
+
+        ShellyReading reading = {NAN, NAN, NAN, false}; // Mesure invalide si la requête échoue
+        bool valid = poll(reading) && reading.valid;
+        publish(reading.power, valid ? METER_GOOD : METER_INVALID, reading.voltage, reading.powerFactor);
+
+        // Trace uniquement les changements d'état, pour ne pas saturer la console à 5 mesures par seconde
+        if (valid != lastValid)
+        {
+            Serial.println(valid ? "[ShellyEM] Lecture rétablie" : "[ShellyEM] Échec de lecture de la puissance");
+            lastValid = valid;
+        }
+
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(pollPeriod));
+        if (xTaskGetTickCount() - lastWake > pdMS_TO_TICKS(pollPeriod))
+        {
+            // Requête plus longue que la période : pas de rafale de rattrapage
+            lastWake = xTaskGetTickCount();
+        }
+    }
+}
+
+bool ShellyEm::parse(const char *json, size_t length, ShellyReading &reading) const
+{
+    if (!jsonScanNumber(json, length, powerKey, reading.power))
+    {
+        return false;
+    }
+    if (!jsonScanNumber(json, length, voltageKey, reading.voltage))
+    {
+        reading.voltage = NAN;
+    }
+    if (!jsonScanNumber(json, length, powerFactorKey, reading.powerFactor))
+    {
+        reading.powerFactor = NAN;
+    }
+    // Gen1 : "is_valid" ; Gen2 : tableau "errors" présent uniquement en cas de défaut
+    bool isValid = true;
+    jsonScanBool(json, length, "is_valid", isValid);
+    reading.valid = isValid && jsonScanFind(json, length, "errors") == nullptr;
+    return true;
+}
 
 /**
- * Récupère la puissance sur le channel du ShellyEM via son API REST.
- * @return Puissance (Watt) sur le channel, ou 0 en cas d'erreur.
+ * Lit les valeurs du channel du ShellyEM via son API REST.
+ * La réponse est lue dans le tampon `payload` et analysée en place.
+ * @param reading Valeurs lues sur le channel.
+ * @return false en cas d'erreur de transport ou de réponse illisible.
  */
-float ShellyEm::getPower()
+bool ShellyEm::poll(ShellyReading &reading)
 {
     if (ip == "" || channel == "")
-        return 0;
-    String url = "http://" + ip + "/emeter/" + (channel == "1" ? "0" : "1");
-    HTTPClient http;
-    http.begin(url);
+        return false;
+
+    bool reconnect = !client.connected();
+    unsigned long start = millis();
+
+    http.begin(client, url);
     int httpCode = http.GET();
+    bool valid = false;
+    bool complete = false;
     if (httpCode == 200)
     {
-        String payload = http.getString();
-        int idx = payload.indexOf("\"power\":");
-        if (idx != -1)
+        // Longueur annoncée (-1 si inconnue) : la réponse est lue sans passer par une String
+        int size = http.getSize();
+        WiFiClient *stream = http.getStreamPtr();
+        size_t length = 0;
+        while (length < sizeof(payload) - 1 && (size < 0 || length < (size_t)size) && millis() - start < RESPONSE_TIMEOUT)
         {
-            int start = idx + 8;
-            int end = payload.indexOf(',', start);
-            String powerStr = payload.substring(start, end);
-            http.end();
-            return powerStr.toFloat();
+            int available = stream->available();
+            if (available <= 0)
+            {
+                if (!stream->connected())
+                    break;
+                vTaskDelay(pdMS_TO_TICKS(2));
+                continue;
+            }
+            size_t chunk = std::min((size_t)available, sizeof(payload) - 1 - length);
+            length += stream->read((uint8_t *)payload + length, chunk);
         }
+        payload[length] = '\0';
+        complete = size >= 0 && length == (size_t)size;
+        // Réponse interrompue : une valeur tronquée ("-52" pour "-523.4") serait lue comme valide
+        valid = jsonScanObjectLength(payload, length) > 0 && parse(payload, length, reading);
+    }
+    if (!complete)
+    {
+        // Réponse non lue entièrement ou en erreur : la connexion ne peut pas être réutilisée
+        client.stop();
     }
     http.end();
-    return 0;
+    uint32_t latency = millis() - start;
+
+    if (reconnect)
+    {
+        recordReconnection();
+    }
+    bool timeout = httpCode == HTTPC_ERROR_READ_TIMEOUT || (httpCode == HTTPC_ERROR_CONNECTION_REFUSED && latency >= (uint32_t)CONNECT_TIMEOUT);
+    recordRequest(valid, latency, httpCode, timeout);
+
+    return valid;
 }
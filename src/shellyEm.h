@@ -2,27 +2,89 @@
 #define SHELLYEM_H
 
 #include <Arduino.h>
+#include <HTTPClient.h>
+#include <WiFiClient.h>
+#include <string>
+#include "powerMeter.h"
+
+// Période d'interrogation minimum du ShellyEM (ms)
+#define SHELLY_MIN_POLL_PERIOD 200
+// Période d'interrogation par défaut (ms)
+#define SHELLY_DEFAULT_POLL_PERIOD 1000
+// Taille maximum d'une réponse du ShellyEM (EM.GetStatus du Pro 3EM : environ 700 octets)
+#define SHELLY_PAYLOAD_SIZE 1024
+
+// Modèle du compteur Shelly
+enum ShellyModel
+{
+    SHELLY_EM,     // Shelly EM (Gen1) : GET /emeter/<id>, "power"
+    SHELLY_PRO_EM, // Shelly Pro EM (Gen2) : composant EM1 "em1:<id>", "act_power"
+    SHELLY_PRO_3EM // Shelly Pro 3EM (Gen2) : composant EM "em:0", "total_act_power" (somme des 3 phases)
+};
+
+// Convertit la valeur de configuration ("em", "proem" ou "pro3em") en modèle
+ShellyModel parseShellyModel(const std::string &model);
+
+// Valeurs lues dans une réponse ou une notification du ShellyEM
+struct ShellyReading
+{
+    float power;       // Puissance active (W)
+    float voltage;     // Tension (V), NAN si absente
+    float powerFactor; // Facteur de puissance, NAN si absent
+    bool valid;        // false si le compteur signale une mesure invalide (is_valid Gen1, errors Gen2)
+};
 
 /// @brief Classe pour interagir avec le module ShellyEM.
-/// Cette classe permet de récupérer la puissance sur un channel spécifique du ShellyEM via son API REST.
-class ShellyEm
+/// La puissance est lue par une tâche dédiée via l'API REST du ShellyEM (connexion HTTP conservée entre
+/// deux requêtes), et les mesures horodatées sont déposées dans une file lue par la régulation.
+/// Les modèles Gen2 peuvent en plus pousser leurs mesures via leur WebSocket sortant (notifications
+/// JSON-RPC NotifyStatus, dès qu'une valeur change) : l'interrogation n'est alors qu'un secours,
+/// utilisée lorsque aucune notification n'est arrivée pendant la période d'interrogation.
+/// Les réponses sont lues dans un tampon fixe et analysées en place (jsonScan.h) : aucune allocation par mesure.
+class ShellyEm : public PowerMeter
 {
     String ip;
     String channel;
+    ShellyModel model;
+    uint32_t pollPeriod;
+    String url;                 // URL d'interrogation, construite une seule fois
+    String component;           // Composant Gen2 portant la mesure ("em1:0", "em:0")
+    const char *powerKey;       // Clés JSON des valeurs lues
+    const char *voltageKey;
+    const char *powerFactorKey;
+
+    WiFiClient client;
+    HTTPClient http;
+    char payload[SHELLY_PAYLOAD_SIZE];
+
+protected:
+    void run() override;
+    // Une requête REST : lecture de la réponse et extraction des valeurs
+    bool poll(ShellyReading &reading);
+    // Extrait les valeurs du document JSON `json` (réponse ou objet du composant)
+    bool parse(const char *json, size_t length, ShellyReading &reading) const;
 
 public:
     /**
      * Constructeur de la classe ShellyEm.
      * @param adresseIp Adresse IP du ShellyEM.
      * @param channel Channel du ShellyEM à interroger (ex: "0" pour le premier channel).
+     * @param model Modèle du compteur.
+     * @param pollPeriod Période d'interrogation (ms), SHELLY_MIN_POLL_PERIOD minimum.
      */
-    ShellyEm(const String &adresseIp, const String &channel);
+    ShellyEm(const String &adresseIp, const String &channel, ShellyModel model = SHELLY_EM, uint32_t pollPeriod = SHELLY_DEFAULT_POLL_PERIOD);
+
+    const char *getName() const override { return "shelly"; }
+
+    // Modifie la période d'interrogation (ms), prise en compte à la requête suivante
+    void setPollPeriod(uint32_t period) override;
 
     /**
-     * Récupère la puissance sur le channel du ShellyEM via son API REST.
-     * @return Puissance (Watt) sur le channel, ou 0 en cas d'erreur.
+     * Traite une trame reçue du WebSocket sortant d'un Shelly Gen2 (NotifyStatus / NotifyFullStatus).
+     * Appelée depuis la tâche du serveur web.
+     * @return true si la trame contenait la puissance du channel configuré (mesure ajoutée à la file).
      */
-    float getPower();
+    bool handleNotification(const uint8_t *data, size_t len) override;
 };
 
 #endif
@@ -0,0 +1,153 @@
+#include "solarEphemeris.h"
+#include <math.h>
+
+// Horodatage minimum d'une heure valide (01/01/2020) : pas d'éphéméride avant la synchronisation NTP
+static const time_t MIN_VALID_TIMESTAMP = 1577836800;
+// Angle zénithal du lever / coucher (réfraction atmosphérique et rayon apparent du soleil)
+static const double SUNRISE_ZENITH = 90.833;
+
+// Conversion d'une date / heure UTC en time_t, sans dépendre du fuseau horaire (formule du jour julien)
+static time_t timegmCompat(int year, int month, int day)
+{
+    int a = (14 - month) / 12;
+    int y = year + 4800 - a;
+    int m = month + 12 * a - 3;
+    long long julianDay = day + (153 * m + 2) / 5 + 365LL * y + y / 4 - y / 100 + y / 400 - 32045;
+    return (time_t)((julianDay - 2440588LL) * 86400LL);
+}
+
+// Équation du temps (minutes) et déclinaison (radians) pour la fraction d'année gamma (radians)
+static void solarPosition(double gamma, double &eqTime, double &declination)
+{
+    eqTime = 229.18 * (0.000075 +
+                       0.001868 * cos(gamma) -
+                       0.032077 * sin(gamma) -
+                       0.014615 * cos(2 * gamma) -
+                       0.040849 * sin(2 * gamma));
+
+    declination = 0.006918 -
+                  0.399912 * cos(gamma) +
+                  0.070257 * sin(gamma) -
+                  0.006758 * cos(2 * gamma) +
+                  0.000907 * sin(2 * gamma) -
+                  0.002697 * cos(3 * gamma) +
+                  0.00148 * sin(3 * gamma);
+}
+
+SolarEphemeris::SolarEphemeris() : latitude(NAN), longitude(NAN)
+{
+    today = SolarDay{0, -1, -1, 0, 0};
+    mutex = xSemaphoreCreateMutex();
+}
+
+bool SolarEphemeris::update(float latitude, float longitude, const std::string &timeZone)
+{
+    time_t now = time(nullptr);
+    if (now < MIN_VALID_TIMESTAMP)
+    {
+        return false;
+    }
+    struct tm local;
+    localtime_r(&now, &local);
+    uint32_t day = (local.tm_year + 1900) * 10000 + (local.tm_mon + 1) * 100 + local.tm_mday;
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    bool upToDate = day == today.day && latitude == this->latitude && longitude == this->longitude && timeZone == this->timeZone;
+    xSemaphoreGive(mutex);
+    if (upToDate)
+    {
+        return true;
+    }
+
+    // Position du soleil à midi (UTC) du jour local
+    int dayOfYear = local.tm_yday + 1;
+    double gamma = 2.0 * M_PI / 365.0 * (dayOfYear - 1);
+    double eqTime, declination;
+    solarPosition(gamma, eqTime, declination);
+    double latRad = latitude * M_PI / 180.0;
+
+    // Minutes UTC depuis minuit du lever, du coucher et du midi solaire
+    double noonUtc = 720.0 - 4.0 * longitude - eqTime;
+    double cosHourAngle = cos(SUNRISE_ZENITH * M_PI / 180.0) / (cos(latRad) * cos(declination)) - tan(latRad) * tan(declination);
+
+    // Conversion en minutes locales : les instants UTC sont ramenés à minuit local (changement d'heure compris)
+    struct tm midnight = local;
+    midnight.tm_hour = 0;
+    midnight.tm_min = 0;
+    midnight.tm_sec = 0;
+    midnight.tm_isdst = -1;
+    time_t localMidnight = mktime(&midnight);
+    time_t utcMidnight = timegmCompat(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday);
+    auto toLocalMinutes = [&](double utcMinutes) -> int
+    {
+        time_t instant = utcMidnight + (time_t)(utcMinutes * 60.0);
+        return (int)((instant - localMidnight) / 60);
+    };
+
+    SolarDay computed;
+    computed.day = day;
+    computed.solarNoon = toLocalMinutes(noonUtc);
+    computed.noonElevation = 90.0 - fabs(latitude - declination * 180.0 / M_PI);
+    if (cosHourAngle >= -1.0 && cosHourAngle <= 1.0)
+    {
+        double hourAngle = acos(cosHourAngle) * 180.0 / M_PI;
+        computed.sunrise = toLocalMinutes(noonUtc - 4.0 * hourAngle);
+        computed.sunset = toLocalMinutes(noonUtc + 4.0 * hourAngle);
+    }
+    else
+    {
+        // Nuit polaire (cos > 1) ou soleil de minuit (cos < -1)
+        computed.sunrise = -1;
+        computed.sunset = -1;
+    }
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    today = computed;
+    this->latitude = latitude;
+    this->longitude = longitude;
+    this->timeZone = timeZone;
+    xSemaphoreGive(mutex);
+
+    Serial.printf("[Soleil] %lu : lever %02d:%02d, midi solaire %02d:%02d, coucher %02d:%02d\n", (unsigned long)day,
+                  computed.sunrise / 60, computed.sunrise % 60, computed.solarNoon / 60, computed.solarNoon % 60,
+                  computed.sunset / 60, computed.sunset % 60);
+    return true;
+}
+
+SolarDay SolarEphemeris::get()
+{
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    SolarDay copy = today;
+    xSemaphoreGive(mutex);
+    return copy;
+}
+
+float SolarEphemeris::getElevation(time_t now)
+{
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    double lat = latitude;
+    double lon = longitude;
+    xSemaphoreGive(mutex);
+    if (isnan(lat))
+    {
+        return NAN;
+    }
+
+    struct tm utc;
+    gmtime_r(&now, &utc);
+    double utcMinutes = utc.tm_hour * 60.0 + utc.tm_min + utc.tm_sec / 60.0;
+    double gamma = 2.0 * M_PI / 365.0 * (utc.tm_yday + (utc.tm_hour - 12) / 24.0);
+    double eqTime, declination;
+    solarPosition(gamma, eqTime, declination);
+
+    // Angle horaire à partir du temps solaire vrai
+    double trueSolarMinutes = utcMinutes + eqTime + 4.0 * lon;
+    double hourAngle = (trueSolarMinutes / 4.0 - 180.0) * M_PI / 180.0;
+    double latRad = lat * M_PI / 180.0;
+    double cosZenith = sin(latRad) * sin(declination) + cos(latRad) * cos(declination) * cos(hourAngle);
+    if (cosZenith > 1.0)
+        cosZenith = 1.0;
+    if (cosZenith < -1.0)
+        cosZenith = -1.0;
+    return (float)(90.0 - acos(cosZenith) * 180.0 / M_PI);
+}
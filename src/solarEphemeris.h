@@ -0,0 +1,50 @@
+#ifndef SOLAR_EPHEMERIS_H
+#define SOLAR_EPHEMERIS_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <string>
+#include <time.h>
+
+// Éphéméride solaire d'un jour local
+struct SolarDay
+{
+    uint32_t day;        // Jour local (AAAAMMJJ), 0 si non calculé
+    int sunrise;         // Lever du soleil (minutes depuis minuit, heure locale), -1 si le soleil ne se lève pas
+    int sunset;          // Coucher du soleil (minutes depuis minuit, heure locale), -1 si le soleil ne se couche pas
+    int solarNoon;       // Midi solaire (minutes depuis minuit, heure locale)
+    float noonElevation; // Élévation du soleil au midi solaire (°)
+};
+
+/**
+ * Cache de l'éphéméride solaire : lever, coucher, midi solaire et élévation maximum sont calculés
+ * une seule fois par jour local (formules NOAA), et à chaque changement de position ou de fuseau horaire.
+ * Les lecteurs (planning, API, MQTT) obtiennent une copie du jour en cache, sans calcul trigonométrique.
+ */
+class SolarEphemeris
+{
+public:
+    SolarEphemeris();
+
+    /**
+     * Recalcule l'éphéméride si le jour local, la position ou le fuseau horaire a changé.
+     * @return false si l'heure n'est pas encore synchronisée (pas d'éphéméride).
+     */
+    bool update(float latitude, float longitude, const std::string &timeZone);
+
+    // Éphéméride du jour en cache (day == 0 si non calculée)
+    SolarDay get();
+
+    // Élévation du soleil (°) à l'instant `now`, calculée à la demande (API, MQTT)
+    float getElevation(time_t now);
+
+private:
+    SolarDay today;
+    float latitude;
+    float longitude;
+    std::string timeZone;
+    SemaphoreHandle_t mutex;
+};
+
+#endif // SOLAR_EPHEMERIS_H
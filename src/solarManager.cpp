@@ -1,11 +1,61 @@
 #include "solarManager.h"
 #include "Arduino.h"
+#include <esp_timer.h>
+#include <hal/cpu_hal.h>
+#include <hal/gpio_ll.h>
+#include <hal/timer_ll.h>
+#include <soc/gpio_struct.h>
+#include <soc/timer_group_struct.h>
 
 SolarManager *SolarManager::instance = nullptr;
 
+// Durée de l'impulsion de gâchette (µs) : le triac nécessite une impulsion très courte (10-100µs) pour s'amorcer
+static const uint32_t TRIAC_PULSE_US = 100;
+// Retard minimum : au passage à zéro le courant est trop faible pour que le triac reste amorcé
+static const uint32_t MIN_FIRING_DELAY_US = 150;
+// Retard maximum : l'impulsion doit se terminer avant le passage à zéro suivant
+static const uint32_t MAX_FIRING_DELAY_US = MAINS_HALF_PERIOD_US - 300;
+// Période nominale de la régulation (s) et écart au-delà duquel la régulation reprend de zéro (ms)
+static const float REGULATION_PERIOD = 1.0f;
+static const unsigned long MAX_REGULATION_GAP = 5000;
+// Anti-rebond du détecteur de passage à zéro (µs)
+static const unsigned long ZERO_CROSS_DEBOUNCE_US = 2000;
+
+/*
+ * Accès directs au timer et à la sortie du triac depuis les interruptions.
+ * Les interruptions sont en IRAM : elles ne peuvent appeler aucune fonction en flash (timerWrite, timerAlarmWrite,
+ * digitalWrite, micros), inaccessible pendant une écriture sur la flash (LittleFS, NVS, mise à jour).
+ * Les fonctions *_ll_* de l'ESP-IDF sont inline et compilées dans l'interruption.
+ * timerBegin(0, ...) utilise le timer 0 du groupe 0.
+ */
+static inline void IRAM_ATTR triacTimerStart(uint64_t alarm)
+{
+    timer_ll_set_counter_value(&TIMERG0, TIMER_0, 0);
+    timer_ll_set_alarm_value(&TIMERG0, TIMER_0, alarm);
+    timer_ll_set_alarm_enable(&TIMERG0, TIMER_0, true);
+}
+
+static inline void IRAM_ATTR triacTimerAlarm(uint64_t alarm)
+{
+    timer_ll_set_alarm_value(&TIMERG0, TIMER_0, alarm);
+    timer_ll_set_alarm_enable(&TIMERG0, TIMER_0, true);
+}
+
+static inline void IRAM_ATTR triacGate(uint8_t pin, uint32_t level)
+{
+    gpio_ll_set_level(&GPIO, (gpio_num_t)pin, level);
+}
+
 SolarManager::SolarManager(uint8_t _pinTriac, uint8_t _pinZeroCross)
-    : _pinTriac(_pinTriac), _pinZeroCross(_pinZeroCross), delayTriac(0), powerDelay(100), avgPowerPerPoint(0)
+    : _pinTriac(_pinTriac), _pinZeroCross(_pinZeroCross), lastPower(0), powerPercentage(0), lastRegulationTime(0), timer(nullptr),
+      firingDelay(MAINS_HALF_PERIOD_US), firingAt(0), firingState(FIRING_IDLE), lastZeroCross(0), cyclesPerUs(240),
+      outputMode(OUTPUT_PHASE_ANGLE), burstLevel(0), burstError(0), burstFirstHalf(true), burstOn(false)
 {
+    isrStats.zeroCrossCount = 0;
+    isrStats.debouncedCount = 0;
+    isrStats.timerCount = 0;
+    isrStats.busyCycles = 0;
+    isrStats.maxCycles = 0;
     instance = this;
 }
 
@@ -14,7 +64,15 @@ void SolarManager::begin()
     pinMode(_pinTriac, OUTPUT);
     pinMode(_pinZeroCross, INPUT_PULLUP); // Essayer avec PULLUP pour l'optocoupleur
     digitalWrite(_pinTriac, LOW);
+    cyclesPerUs = getCpuFrequencyMhz();
     Serial.printf("[SolarManager] Pins initialized - Triac: %d, ZeroCross: %d (INPUT_PULLUP)\n", _pinTriac, _pinZeroCross);
+
+    // Timer 1 MHz (80 MHz / 80), sans rechargement automatique : une alarme par événement
+    timer = timerBegin(0, 80, true);
+    timerAttachInterrupt(timer, &SolarManager::onTimerStatic, false);
+
+    // Interrupts (should be safe, they are short)
+    attachInterrupt(digitalPinToInterrupt(_pinZeroCross), SolarManager::onZeroCrossStatic, RISING);
 }
 
 void IRAM_ATTR SolarManager::onTimerStatic()
@@ -26,253 +84,184 @@ void IRAM_ATTR SolarManager::onTimerStatic()
 void IRAM_ATTR SolarManager::onZeroCrossStatic()
 {
     if (instance)
-        instance->handleZeroCross();
+        instance->handleZeroCross((unsigned long)esp_timer_get_time());
 }
 
 /**
- * Méthode executée toutes les 100 microsecondes, pour gérer l'ouverture du triac
- * Passe 100 fois par demi-cycle de la sinusoide
- * Le triac nécessite une impulsion très courte (10-100µs) pour s'amorcer
- * IMPORTANT: powerDelay va de 0 (100% puissance) à 100 (0% puissance)
- * Avec un timer à 100µs, une demi-période de 10ms = 100 comptages
+ * Mise à jour des statistiques d'interruption (durée mesurée en cycles CPU)
  */
-void SolarManager::handleTimer()
+void IRAM_ATTR SolarManager::recordIsr(uint32_t startCycles)
 {
-    delayTriac += 1;
-    if (delayTriac > powerDelay && powerDelay < 98)
-    {
-        digitalWrite(_pinTriac, HIGH);
-    }
-    else
+    uint32_t cycles = cpu_hal_get_cycle_count() - startCycles;
+    isrStats.busyCycles = isrStats.busyCycles + cycles;
+    if (cycles > isrStats.maxCycles)
     {
-        digitalWrite(_pinTriac, LOW);
+        isrStats.maxCycles = cycles;
     }
+    isrHistogram.recordCycles(cycles, cyclesPerUs);
 }
 
 /**
- * Méthode executée lors du passage à zéro de la sinusoide du secteur
+ * Alarme du timer : deux alarmes par demi-période au plus.
+ * La première amorce le triac, la seconde termine l'impulsion de gâchette.
  */
-void SolarManager::handleZeroCross()
+void IRAM_ATTR SolarManager::handleTimer()
 {
-    if ((millis() - lastZeroCross) > 2)
+    uint32_t start = cpu_hal_get_cycle_count();
+    isrStats.timerCount = isrStats.timerCount + 1;
+
+    if (firingState == FIRING_PENDING)
     {
-        delayTriac = 0;
-        lastZeroCross = millis();
-        digitalWrite(_pinTriac, LOW);
+        triacGate(_pinTriac, HIGH);
+        firingState = FIRING_PULSE;
+        // Le compteur continue depuis le passage à zéro : fin d'impulsion à retard + TRIAC_PULSE_US
+        triacTimerAlarm(firingAt + TRIAC_PULSE_US);
     }
+    else
+    {
+        triacGate(_pinTriac, LOW);
+        firingState = FIRING_IDLE;
+    }
+    recordIsr(start);
 }
 
 /**
- * Régulation du Triac selon la puissance mesurée, retourne le pourcentage d'ouverture du triac
+ * Méthode executée lors du passage à zéro de la sinusoide du secteur :
+ * programme une alarme unique à l'instant d'amorçage de cette demi-période (résolution 1 µs).
+ * En mode train d'ondes, l'amorçage se fait juste après le passage à zéro, une période sur N.
+ * `now` est l'instant du passage à zéro (µs) : fourni par l'appelant, il peut venir d'une horloge simulée.
  */
-float SolarManager::updateRegulation(float power)
+void IRAM_ATTR SolarManager::handleZeroCross(unsigned long now)
 {
-    lastPower = power; // Mémorise la dernière puissance mesurée
-
-    // La valeur '2000' correspond à la puissance max du chauffe-eau. A rendre configurable.
-    int powerDifference = int(power * 100 / 2000);
-
-    if (powerDifference != 0 && powerDifference < 98)
+    uint32_t start = cpu_hal_get_cycle_count();
+    if (now - lastZeroCross < ZERO_CROSS_DEBOUNCE_US)
     {
-        float powerPerPoint = power / powerDifference;
-        // Calcul de la moyenne mobile (puissance / % d'ouverture)
-        const float alpha = 0.05; // Facteur de lissage = 5%
-        avgPowerPerPoint = alpha * powerPerPoint + (1.0f - alpha) * avgPowerPerPoint;
+        // Rebond : ignoré pour la commande, mais la durée de l'interruption reste comptée
+        isrStats.debouncedCount = isrStats.debouncedCount + 1;
+        recordIsr(start);
+        return;
     }
+    lastZeroCross = now;
+    isrStats.zeroCrossCount = isrStats.zeroCrossCount + 1;
 
-    if (abs(power) < avgPowerPerPoint && power < 0)
-    {
-        // Si la puissance mesurée est inférieure à la puissance moyenne par point
-        // On ne change pas le retard  = stabilisation avec une légère suproduction
-    }
-    else if (abs(power) < avgPowerPerPoint && power > 0)
+    triacGate(_pinTriac, LOW);
+    firingState = FIRING_IDLE;
+
+    uint32_t delay = firingDelay;
+    if (outputMode == OUTPUT_BURST)
     {
-        // Légère surconsommation  on augmente le retard de 1 pour diminuer la puissance
-        powerDelay = powerDelay + 1;
+        // Décision une fois par période complète (deux alternances) pour ne pas créer de composante continue
+        if (burstFirstHalf)
+        {
+            burstError = burstError + burstLevel;
+            burstOn = burstError >= 1000;
+            if (burstOn)
+            {
+                burstError = burstError - 1000;
+            }
+        }
+        burstFirstHalf = !burstFirstHalf;
+        delay = burstOn ? MIN_FIRING_DELAY_US : MAINS_HALF_PERIOD_US;
     }
-    else
+
+    if (delay <= MAX_FIRING_DELAY_US)
     {
-        // Ajustement du retard
-        powerDelay = powerDelay + powerDifference;
+        if (delay < MIN_FIRING_DELAY_US)
+        {
+            delay = MIN_FIRING_DELAY_US;
+        }
+        firingAt = delay;
+        firingState = FIRING_PENDING;
+        triacTimerStart(delay);
     }
-
-    if (powerDelay < 0)
-        powerDelay = 0;
-    if (powerDelay > 100)
-        powerDelay = 100;
-
-    float triacOpeningPercentage = 100.0f - powerDelay;
-
-    return triacOpeningPercentage;
+    recordIsr(start);
 }
 
-/**
- * Marche forcée du triac
- * On met powerDelay à 0 pour déclencher immédiatement après chaque zero-cross
- */
-void SolarManager::On()
+TriacIsrStats SolarManager::getIsrStats()
 {
-    powerDelay = 0;
+    TriacIsrStats stats;
+    stats.zeroCrossCount = isrStats.zeroCrossCount;
+    stats.debouncedCount = isrStats.debouncedCount;
+    stats.timerCount = isrStats.timerCount;
+    stats.busyCycles = isrStats.busyCycles;
+    stats.maxCycles = isrStats.maxCycles;
+    return stats;
 }
 
 /**
- * Stop forcé du triac
+ * Régulation du Triac selon la puissance mesurée (> 0 soutirage, < 0 injection),
+ * retourne la puissance commandée en % de la puissance nominale du chauffe-eau.
+ * La table d'angle de phase (ou le train d'ondes) rend la puissance délivrée linéaire avec la commande,
+ * le régulateur PID travaille donc directement en % de la puissance nominale.
  */
-void SolarManager::Off()
+float SolarManager::updateRegulation(float power, int heaterPower, bool exportMeasured)
 {
-    powerDelay = 100;
-    digitalWrite(_pinTriac, LOW);
-}
+    lastPower = power; // Mémorise la dernière puissance mesurée
 
-// Portable conversion of a UTC struct tm to time_t without changing TZ.
-// Uses civil date formula to compute seconds since epoch for the UTC date/time.
-static time_t timegm_compat(const struct tm *tm)
-{
-    int year = tm->tm_year + 1900;
-    int month = tm->tm_mon + 1; // 1..12
-    int day = tm->tm_mday;
+    unsigned long now = millis();
+    float dt = (now - lastRegulationTime) / 1000.0f;
+    if (lastRegulationTime == 0 || now - lastRegulationTime > MAX_REGULATION_GAP || regulator.getOutput() != powerPercentage)
+    {
+        // Première mesure, mesures interrompues ou commande modifiée par un autre mode : reprise sans à-coup
+        regulator.reset(powerPercentage);
+        dt = REGULATION_PERIOD;
+    }
+    lastRegulationTime = now;
 
-    int a = (14 - month) / 12;
-    int y = year + 4800 - a;
-    int m = month + 12 * a - 3;
-    long long julianDay = day + (153 * m + 2) / 5 + 365LL * y + y / 4 - y / 100 + y / 400 - 32045;
-    long long days = julianDay - 2440588LL; // days since 1970-01-01
+    setPower(regulator.update(power, heaterPower, dt, exportMeasured));
+    return powerPercentage;
+}
 
-    long long secs = days * 86400LL + (long long)tm->tm_hour * 3600LL + (long long)tm->tm_min * 60LL + (long long)tm->tm_sec;
-    return (time_t)secs;
+void SolarManager::configureRegulation(const RegulationConfig &config)
+{
+    regulator.configure(config);
 }
 
 /**
- * @brief Calcule l'heure du lever du soleil en heure locale (retour par valeur)
+ * Commande de la puissance en % de la puissance nominale, convertie en retard d'amorçage
  */
-struct tm SolarManager::calculateSunrise(double latitude, double longitude)
+void SolarManager::setPower(float percentage)
 {
-    struct tm invalid{};
-    invalid.tm_year = -1; // sentinel for error
-
-    struct tm now;
-    if (!getLocalTime(&now))
-    {
-        return invalid;
-    }
-
-    int dayOfYear = now.tm_yday + 1;
-    double latRad = latitude * M_PI / 180.0;
-
-    // Calcul de l'angle gamma pour l'équation du temps
-    double gamma = 2.0 * M_PI / 365.0 * (dayOfYear - 1 + ((now.tm_hour - 12) / 24.0));
-
-    double eqTime = 229.18 * (0.000075 +
-                              0.001868 * cos(gamma) -
-                              0.032077 * sin(gamma) -
-                              0.014615 * cos(2 * gamma) -
-                              0.040849 * sin(2 * gamma));
-
-    double decl = 0.006918 -
-                  0.399912 * cos(gamma) +
-                  0.070257 * sin(gamma) -
-                  0.006758 * cos(2 * gamma) +
-                  0.000907 * sin(2 * gamma) -
-                  0.002697 * cos(3 * gamma) +
-                  0.00148 * sin(3 * gamma);
-
-    double ha = acos(cos(M_PI / 180.0 * 90.833) / (cos(latRad) * cos(decl)) - tan(latRad) * tan(decl));
-
-    // Minutes UTC depuis minuit
-    double sunriseMinutesUTC = 720.0 - 4.0 * longitude - eqTime - ha * 180.0 / M_PI * 4.0;
-
-    // Build a UTC struct tm for today at 00:00 UTC, then add sunriseMinutesUTC
-    time_t now_t = time(nullptr);
-    struct tm gm{};
-    gmtime_r(&now_t, &gm); // gm holds current UTC date
-
-    struct tm tm_utc_midnight = gm;
-    tm_utc_midnight.tm_hour = 0;
-    tm_utc_midnight.tm_min = 0;
-    tm_utc_midnight.tm_sec = 0;
-
-    // Set hours/min/sec according to sunriseMinutesUTC
-    int sunriseHour = (int)(sunriseMinutesUTC / 60.0);
-    int sunriseMin = (int)fmod(sunriseMinutesUTC, 60.0);
-
-    struct tm tm_sun_utc = tm_utc_midnight;
-    tm_sun_utc.tm_hour = sunriseHour;
-    tm_sun_utc.tm_min = sunriseMin;
-    tm_sun_utc.tm_sec = 0;
-
-    time_t sunriseTimeUTC = timegm_compat(&tm_sun_utc);
+    if (percentage < 0)
+        percentage = 0;
+    if (percentage > 100)
+        percentage = 100;
+    powerPercentage = percentage;
+    // Pris en compte au prochain passage à zéro
+    firingDelay = phaseAngleDelayUs(percentage);
+    // En train d'ondes, la puissance est proportionnelle au nombre de périodes conduites
+    burstLevel = (uint16_t)(percentage * 10 + 0.5f);
+}
 
-    struct tm sunriseLocal{};
-    if (localtime_r(&sunriseTimeUTC, &sunriseLocal) == nullptr)
+void SolarManager::setOutputMode(TriacOutputMode mode)
+{
+    if (mode != outputMode)
     {
-        return invalid;
+        burstError = 0;
+        burstFirstHalf = true;
+        outputMode = mode;
     }
+}
 
-    return sunriseLocal;
+TriacOutputMode parseTriacOutputMode(const std::string &mode)
+{
+    return mode == "burst" ? OUTPUT_BURST : OUTPUT_PHASE_ANGLE;
 }
 
 /**
- * @brief Calcule l'heure du coucher du soleil en heure locale (retour par valeur)
+ * Marche forcée du triac
+ * Amorçage immédiatement après chaque zero-cross
  */
-struct tm SolarManager::calculateSunset(double latitude, double longitude)
+void SolarManager::On()
 {
-    struct tm invalid{};
-    invalid.tm_year = -1; // sentinel for error
-
-    struct tm now;
-    if (!getLocalTime(&now))
-    {
-        return invalid;
-    }
-
-    int dayOfYear = now.tm_yday + 1;
-    double latRad = latitude * M_PI / 180.0;
-
-    double gamma = 2.0 * M_PI / 365.0 * (dayOfYear - 1 + ((now.tm_hour - 12) / 24.0));
-
-    double eqTime = 229.18 * (0.000075 +
-                              0.001868 * cos(gamma) -
-                              0.032077 * sin(gamma) -
-                              0.014615 * cos(2 * gamma) -
-                              0.040849 * sin(2 * gamma));
-
-    double decl = 0.006918 -
-                  0.399912 * cos(gamma) +
-                  0.070257 * sin(gamma) -
-                  0.006758 * cos(2 * gamma) +
-                  0.000907 * sin(2 * gamma) -
-                  0.002697 * cos(3 * gamma) +
-                  0.00148 * sin(3 * gamma);
-
-    double ha = acos(cos(M_PI / 180.0 * 90.833) / (cos(latRad) * cos(decl)) - tan(latRad) * tan(decl));
-
-    double sunsetMinutesUTC = 720.0 - 4.0 * longitude - eqTime + ha * 180.0 / M_PI * 4.0;
-
-    // Build a UTC struct tm for today at 00:00 UTC, then add sunsetMinutesUTC
-    time_t now_t = time(nullptr);
-    struct tm gm{};
-    gmtime_r(&now_t, &gm); // gm holds current UTC date
-
-    struct tm tm_utc_midnight = gm;
-    tm_utc_midnight.tm_hour = 0;
-    tm_utc_midnight.tm_min = 0;
-    tm_utc_midnight.tm_sec = 0;
-
-    int sunsetHour = (int)(sunsetMinutesUTC / 60.0);
-    int sunsetMin = (int)fmod(sunsetMinutesUTC, 60.0);
-
-    struct tm tm_sun_utc = tm_utc_midnight;
-    tm_sun_utc.tm_hour = sunsetHour;
-    tm_sun_utc.tm_min = sunsetMin;
-    tm_sun_utc.tm_sec = 0;
-
-    time_t sunsetTimeUTC = timegm_compat(&tm_sun_utc);
-
-    struct tm sunsetLocal{};
-    if (localtime_r(&sunsetTimeUTC, &sunsetLocal) == nullptr)
-    {
-        return invalid;
-    }
+    setPower(100);
+}
 
-    return sunsetLocal;
+/**
+ * Stop forcé du triac
+ */
+void SolarManager::Off()
+{
+    setPower(0);
+    digitalWrite(_pinTriac, LOW);
 }
@@ -3,31 +3,49 @@
 
 #include <Arduino.h>
 #include <math.h>
+#include <string>
+#include "phaseAngle.h"
+#include "regulator.h"
+#include "runtimeMetrics.h"
+
+// Statistiques des interruptions de commande du triac (cumul depuis le démarrage)
+struct TriacIsrStats
+{
+    uint32_t zeroCrossCount; // Interruptions de passage à zéro
+    uint32_t debouncedCount; // Dont fronts rejetés par l'anti-rebond (non comptés dans zeroCrossCount)
+    uint32_t timerCount;     // Interruptions du timer (amorçage + fin d'impulsion)
+    uint64_t busyCycles;     // Cycles CPU passés dans les interruptions
+    uint32_t maxCycles;      // Durée maximale d'une interruption (cycles CPU)
+};
+
+// Mode de commande du triac
+enum TriacOutputMode
+{
+    OUTPUT_PHASE_ANGLE, // Amorçage à l'angle de phase calculé, à chaque demi-période
+    OUTPUT_BURST,       // Trains d'alternances complètes, amorcées au passage à zéro (moins de perturbations)
+};
+
+// Convertit la valeur de configuration ("phase" ou "burst") en mode de commande
+TriacOutputMode parseTriacOutputMode(const std::string &mode);
 
 class SolarManager
 {
 public:
     SolarManager(uint8_t pinTriac, uint8_t _pinZeroCross);
     void begin();
-    float updateRegulation(float power);
+    float updateRegulation(float power, int heaterPower, bool exportMeasured = true);
+    void setPower(float percentage); // Commande directe de la puissance (% de la puissance nominale)
+    void setOutputMode(TriacOutputMode mode);
+    void configureRegulation(const RegulationConfig &config);
+    const RegulatorTerms &getRegulatorTerms() const { return regulator.getTerms(); }
+    // Retard d'amorçage courant (µs), MAINS_HALF_PERIOD_US = triac bloqué
+    uint32_t getFiringDelay() const { return firingDelay; }
     void On();
     void Off();
 
-    /**
-     * Fonction pour calculer l'heure de lever du soleil et la retourner sous forme de struct tm (par valeur).
-     * En cas d'erreur, la structure retournée aura `tm_year == -1`.
-     */
-    static struct tm calculateSunrise(double latitude, double longitude);
-
-    /**
-     * Fonction pour calculer l'heure de coucher du soleil (retour par valeur).
-     * En cas d'erreur, la structure retournée aura `tm_year == -1`.
-     */
-    static struct tm calculateSunset(double latitude, double longitude);
-
-    // Accès aux variables utiles
-    volatile int delayTriac;
-    volatile int powerDelay;
+    TriacIsrStats getIsrStats();
+    // Répartition des durées des interruptions du triac (passage à zéro et timer)
+    LatencySnapshot getIsrHistogram() const { return isrHistogram.get(); }
 
     // Wrappers statiques pour interruptions
     static void IRAM_ATTR onTimerStatic();
@@ -38,12 +56,38 @@ public:
 private:
     uint8_t _pinTriac;
     uint8_t _pinZeroCross;
-    float lastPower;        // Dernière puissance mesurée
-    float avgPowerPerPoint; // Ecart moyen de puissance par pourcentage d'ouverture du triac
+    float lastPower;       // Dernière puissance mesurée
+    float powerPercentage; // Puissance commandée (% de la puissance nominale)
+    Regulator regulator;
+    unsigned long lastRegulationTime;
 
+    // Étapes de l'amorçage au cours d'une demi-période
+    enum FiringState
+    {
+        FIRING_IDLE,    // Pas d'amorçage en cours
+        FIRING_PENDING, // Alarme programmée à l'instant d'amorçage
+        FIRING_PULSE,   // Impulsion de gâchette en cours, alarme programmée à la fin de l'impulsion
+    };
+
+    hw_timer_t *timer;                // Timer matériel 1 MHz en mode "one-shot", réarmé à chaque passage à zéro
+    volatile uint32_t firingDelay;    // Retard d'amorçage après le passage à zéro (µs), MAINS_HALF_PERIOD_US = pas d'amorçage
+    volatile uint32_t firingAt;       // Instant d'amorçage programmé pour la demi-période en cours (µs)
+    volatile FiringState firingState;
     volatile unsigned long lastZeroCross;
+    volatile TriacIsrStats isrStats;
+    LatencyHistogram isrHistogram;
+    uint32_t cyclesPerUs; // Fréquence du CPU (MHz), pour convertir les durées mesurées en cycles
+
+    // Mode train d'ondes : répartition des périodes conduites par modulation sigma-delta
+    volatile TriacOutputMode outputMode;
+    volatile uint16_t burstLevel;  // Puissance demandée (pour mille)
+    volatile uint16_t burstError;  // Erreur accumulée du modulateur (pour mille)
+    volatile bool burstFirstHalf;  // true pour la première alternance d'une période
+    volatile bool burstOn;         // La période en cours est conduite
+
     void handleTimer();
-    void handleZeroCross();
+    void handleZeroCross(unsigned long now);
+    void recordIsr(uint32_t startCycles);
 };
 
 #endif
@@ -5,6 +5,12 @@
 #include <ArduinoJson.h>
 #include <Update.h>
 #include "mbedtls/sha256.h"
+#include <Preferences.h>
+#include <LittleFS.h>
+#include "historyTiers.h"
+
+// Mémoire laissée libre pendant la mise à jour (client HTTPS) lors de la sauvegarde de l'historique en RAM
+static const size_t HISTORY_BACKUP_HEAP_RESERVE = 96 * 1024;
 
 // --- Constantes ---
 const char *GITHUB_REPO = "idefix38/esp32-routeur-solaire";
@@ -344,15 +350,48 @@ void UpdateManager::startUpdate()
     Serial.println("[Update] Starting OTA update...");
 
     // 1. Mise à jour du système de fichiers
-    if (filesystemUrl && filesystemSha256)
+    // L'image remplace toute la partition LittleFS (et donc l'historique enregistré) :
+    // elle n'est appliquée que si son contenu a changé depuis la dernière mise à jour.
+    bool filesystemUpdated = false;
+    Preferences preferences;
+    preferences.begin("update", false);
+    String installedFsSha256 = preferences.getString("fs.sha", "");
+    if (filesystemUrl && filesystemSha256 && installedFsSha256.equalsIgnoreCase(filesystemSha256))
+    {
+        Serial.println("[Update] Filesystem unchanged, skipping filesystem update.");
+    }
+    else if (filesystemUrl && filesystemSha256)
     {
+        // Historique copié en RAM (dans la limite de la mémoire disponible) puis réécrit sur la nouvelle image,
+        // les écritures de l'historique étant suspendues pendant la réécriture de la partition
+        for (HistoryTiers *history = HistoryTiers::first(); history != nullptr; history = history->next())
+        {
+            history->flush();
+        }
+        HistoryStore::suspendWrites(true);
+        std::vector<HistoryBackupFile> historyBackup;
+        size_t freeHeap = ESP.getFreeHeap();
+        HistoryStore::backup(historyBackup, freeHeap > HISTORY_BACKUP_HEAP_RESERVE ? freeHeap - HISTORY_BACKUP_HEAP_RESERVE : 0);
+
         Serial.println("[Update] Updating filesystem...");
         if (!performUpdate(filesystemUrl, filesystemSha256, U_SPIFFS))
         {
             Serial.println("[Update] Filesystem update failed!");
+            HistoryStore::suspendWrites(false);
+            preferences.end();
             return; // Arrêter si la mise à jour du FS échoue
         }
+        preferences.putString("fs.sha", filesystemSha256);
+        filesystemUpdated = true;
+
+        // Nouvelle image montée à la place de l'ancienne, puis restauration de l'historique
+        LittleFS.end();
+        if (LittleFS.begin())
+        {
+            HistoryStore::restoreBackup(historyBackup);
+        }
     }
+    preferences.end();
 
     // 2. Mise à jour du firmware applicatif
     if (firmwareUrl && firmwareSha256)
@@ -361,10 +400,22 @@ void UpdateManager::startUpdate()
         if (!performUpdate(firmwareUrl, firmwareSha256, U_FLASH))
         {
             Serial.println("[Update] Firmware update failed!");
+            if (filesystemUpdated)
+            {
+                // Index de l'historique en RAM obsolètes depuis la réécriture de la partition : rechargement au démarrage
+                ESP.restart();
+            }
             return; // La mise à jour du firmware a échoué
         }
     }
 
     Serial.println("[Update] Update successful! Rebooting...");
-    ESP.restart();
+    if (filesystemUpdated)
+    {
+        // La partition LittleFS vient d'être réécrite : l'historique est rechargé depuis la copie restaurée au démarrage
+        ESP.restart();
+    }
+    // Redémarrage par la tâche de communication, après sauvegarde de l'historique
+    extern volatile bool reboot;
+    reboot = true;
 }
\ No newline at end of file
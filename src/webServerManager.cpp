@@ -1,14 +1,65 @@
 #include "webServerManager.h"
+#include "configStore.h"
+#include "controlState.h"
+#include "historyFormat.h"
 #include "mqttManager.h"
+#include "powerMeter.h"
+#include "regulationTrace.h"
+#include "runtimeMetrics.h"
+#include "shellyEm.h"
+#include "solarEphemeris.h"
 #include "solarManager.h"
 #include "version.h"
+#include <algorithm>
+#include <memory>
+
+extern volatile uint32_t regulationLatencyUs;
+extern volatile uint32_t maxRegulationLatencyUs;
+extern PowerMeter *meter;
+extern SolarEphemeris solarEphemeris;
+extern ControlStateMachine controlState;
+extern LatencyHistogram controlLoopHistogram;
+extern LatencyHistogram temperatureReadHistogram;
+extern LatencyHistogram broadcastHistogram;
+extern RegulationTrace regulationTrace;
+extern TemperatureSensor temperatureSensor;
+extern TaskHandle_t LedTaskHandle;
+extern TaskHandle_t SignalProcessingTaskHandle;
+extern TaskHandle_t CommunicationTaskHandle;
+
+// Tâche suivie par les métriques d'exécution
+struct TrackedTask
+{
+    const char *name;
+    TaskHandle_t handle;
+};
+
+// Tâches du routeur (celles qui ne sont pas encore créées ont un handle nul)
+static size_t getTrackedTasks(TrackedTask *tasks)
+{
+    size_t count = 0;
+    tasks[count++] = {"led", LedTaskHandle};
+    tasks[count++] = {"signal_processing", SignalProcessingTaskHandle};
+    tasks[count++] = {"communication", CommunicationTaskHandle};
+    tasks[count++] = {"meter", meter != nullptr ? meter->getTaskHandle() : nullptr};
+    return count;
+}
 
 // Constructeur
-WebServerManager::WebServerManager(ConfigManager &configManager, MqttManager &mqttManager, HistoryManager &tempHistory, HistoryManager &triacHist)
-    : configManager(configManager), mqttManager(mqttManager), temperatureHistory(tempHistory), triacHistory(triacHist), server(80), ws("/ws")
+WebServerManager::WebServerManager(ConfigStore &configStore, MqttManager &mqttManager, HistoryTiers &tempHistory, HistoryTiers &triacHist, EnergyManager &energyManager)
+    : configStore(configStore), mqttManager(mqttManager), temperatureHistory(tempHistory), triacHistory(triacHist), energyManager(energyManager), server(80), ws("/ws"), metricsWs("/metrics/ws"), shellyWs("/shelly")
 {
-    lastBroadcastedJson = "";
-    newClientConnected = false;
+    lastTemperature = 0;
+    lastTriacOpeningPercentage = 0;
+    lastTemperatureReached = false;
+    lastFirmwareVersion = "";
+    lastRoutedPower = 0;
+    lastRoutedEnergy = 0;
+    lastIsrStats = TriacIsrStats{0, 0, 0, 0};
+    lastIsrStatsTime = 0;
+    hasBroadcasted = false;
+    historySeq = 0;
+    wsMutex = xSemaphoreCreateMutex();
 }
 
 void WebServerManager::onWsEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len)
@@ -16,13 +67,70 @@ void WebServerManager::onWsEvent(AsyncWebSocket *server, AsyncWebSocketClient *c
     if (type == WS_EVT_CONNECT)
     {
         Serial.printf(" [-] WebSocket client #%u connected from %s\n", client->id(), client->remoteIP().toString().c_str());
-        // Set flag to send data to the new client immediately
-        this->newClientConnected = true;
+        // L'historique complet sera envoyé à ce seul client par la tâche de communication
+        requestHistory(client->id());
+        // Force l'envoi des valeurs courantes au prochain cycle
+        hasBroadcasted = false;
     }
     else if (type == WS_EVT_DISCONNECT)
     {
         Serial.printf(" [-] WebSocket client #%u disconnected\n", client->id());
     }
+    else if (type == WS_EVT_DATA)
+    {
+        // Le client demande une resynchronisation lorsqu'il détecte un trou dans les numéros de séquence
+        AwsFrameInfo *info = (AwsFrameInfo *)arg;
+        if (info->final && info->index == 0 && info->len == len && info->opcode == WS_TEXT)
+        {
+            JsonDocument doc;
+            if (!deserializeJson(doc, data, len) && doc["type"] == "resync")
+            {
+                Serial.printf(" [-] WebSocket client #%u resync\n", client->id());
+                requestHistory(client->id());
+            }
+        }
+    }
+}
+
+void WebServerManager::onShellyWsEvent(AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len)
+{
+    if (type == WS_EVT_CONNECT)
+    {
+        Serial.printf("[ShellyEM] WebSocket connecté depuis %s\n", client->remoteIP().toString().c_str());
+    }
+    else if (type == WS_EVT_DISCONNECT)
+    {
+        Serial.println("[ShellyEM] WebSocket déconnecté");
+    }
+    else if (type == WS_EVT_DATA)
+    {
+        AwsFrameInfo *info = (AwsFrameInfo *)arg;
+        if (info->opcode != WS_TEXT || info->num != 0 || !info->final)
+        {
+            return; // Les notifications tiennent dans une seule trame texte
+        }
+        if (info->index == 0)
+        {
+            shellyFrame.clear();
+        }
+        shellyFrame.append((const char *)data, len);
+        if (info->index + len == info->len && meter != nullptr)
+        {
+            meter->handleNotification((const uint8_t *)shellyFrame.data(), shellyFrame.size());
+        }
+    }
+}
+
+void WebServerManager::requestHistory(uint32_t clientId)
+{
+    if (xSemaphoreTake(wsMutex, portMAX_DELAY) == pdTRUE)
+    {
+        if (std::find(pendingHistoryClients.begin(), pendingHistoryClients.end(), clientId) == pendingHistoryClients.end())
+        {
+            pendingHistoryClients.push_back(clientId);
+        }
+        xSemaphoreGive(wsMutex);
+    }
 }
 
 void WebServerManager::handleReboot(AsyncWebServerRequest *request)
@@ -37,7 +145,8 @@ void WebServerManager::handleReboot(AsyncWebServerRequest *request)
 void WebServerManager::handleGetConfig(AsyncWebServerRequest *request)
 {
     Serial.println(" GET: /getConfig");
-    Config config = this->configManager.loadConfig();
+    std::shared_ptr<const Config> snapshot = configStore.get();
+    const Config &config = *snapshot;
 
     JsonDocument doc;
     JsonObject wifiObj = doc["wifi"].to<JsonObject>();
@@ -54,26 +163,67 @@ void WebServerManager::handleGetConfig(AsyncWebServerRequest *request)
     JsonObject shellyObj = doc["shellyEm"].to<JsonObject>();
     shellyObj["ip"] = config.shellyEm.ip;
     shellyObj["channel"] = config.shellyEm.channel;
+    shellyObj["pollPeriod"] = config.shellyEm.pollPeriod;
+    shellyObj["model"] = config.shellyEm.model;
+
+    JsonObject meterObj = doc["meter"].to<JsonObject>();
+    meterObj["source"] = config.meter.source;
+    meterObj["linky"]["standard"] = config.meter.linky.standard;
+    meterObj["linky"]["rxPin"] = config.meter.linky.rxPin;
+    JsonObject modbusObj = meterObj["modbus"].to<JsonObject>();
+    modbusObj["transport"] = config.meter.modbus.transport;
+    modbusObj["device"] = config.meter.modbus.device;
+    modbusObj["address"] = config.meter.modbus.address;
+    modbusObj["host"] = config.meter.modbus.host;
+    modbusObj["port"] = config.meter.modbus.port;
+    modbusObj["baudRate"] = config.meter.modbus.baudRate;
+    modbusObj["rxPin"] = config.meter.modbus.rxPin;
+    modbusObj["txPin"] = config.meter.modbus.txPin;
+    modbusObj["dePin"] = config.meter.modbus.dePin;
+    modbusObj["pollPeriod"] = config.meter.modbus.pollPeriod;
+    meterObj["mqtt"]["topic"] = config.meter.mqtt.topic;
+    meterObj["mqtt"]["key"] = config.meter.mqtt.key;
 
     JsonObject boilerObj = doc["boiler"].to<JsonObject>();
-    boilerObj["mode"] = config.boiler.mode;
+    boilerObj["mode"] = boilerModeName(config.boiler.mode);
     boilerObj["temperature"] = config.boiler.temperature;
     boilerObj["triacOpening"] = config.boiler.triacOpening;
+    boilerObj["heaterPower"] = config.boiler.heaterPower;
+    boilerObj["outputMode"] = config.boiler.outputMode;
+    boilerObj["sensorResolution"] = config.boiler.sensorResolution;
+    boilerObj["sensorInterval"] = config.boiler.sensorInterval;
+    JsonObject regulationObj = boilerObj["regulation"].to<JsonObject>();
+    regulationObj["setpoint"] = config.regulation.setpoint;
+    regulationObj["kp"] = config.regulation.kp;
+    regulationObj["ki"] = config.regulation.ki;
+    regulationObj["kd"] = config.regulation.kd;
+    regulationObj["maxRate"] = config.regulation.maxRate;
+    // Éphéméride du jour si l'heure est synchronisée, sinon valeurs calculées au chargement de la configuration
+    SolarDay sun = solarEphemeris.get();
+    int sunrise = sun.day != 0 && sun.sunrise >= 0 ? sun.sunrise : config.solar.sunRiseMinutes;
+    int sunset = sun.day != 0 && sun.sunset >= 0 ? sun.sunset : config.solar.sunSetMinutes;
+
+    // Bornes ancrées au lever / coucher du soleil résolues avec l'éphéméride du jour (l'instantané chargé au
+    // démarrage, avant la synchronisation de l'heure, n'en contient qu'une valeur approchée)
     JsonArray boilerPeriods = boilerObj["periods"].to<JsonArray>();
     for (const auto &p : config.boiler.periods)
     {
         JsonObject periodObj = boilerPeriods.add<JsonObject>();
-        periodObj["start"] = p.start;
-        periodObj["end"] = p.end;
-        periodObj["mode"] = p.mode;
+        periodObj["start"] = p.startSunrise ? sunrise : (p.startSunset ? sunset : p.start);
+        periodObj["end"] = p.endSunrise ? sunrise : (p.endSunset ? sunset : p.end);
+        periodObj["startSunrise"] = p.startSunrise;
+        periodObj["startSunset"] = p.startSunset;
+        periodObj["endSunrise"] = p.endSunrise;
+        periodObj["endSunset"] = p.endSunset;
+        periodObj["mode"] = periodModeName(p.mode);
     }
 
     JsonObject solarObj = doc["solar"].to<JsonObject>();
     solarObj["latitude"] = config.solar.latitude;
     solarObj["longitude"] = config.solar.longitude;
     solarObj["timeZone"] = config.solar.timeZone;
-    solarObj["sunRiseMinutes"] = config.solar.sunRiseMinutes;
-    solarObj["sunSetMinutes"] = config.solar.sunSetMinutes;
+    solarObj["sunRiseMinutes"] = sunrise;
+    solarObj["sunSetMinutes"] = sunset;
 
     String jsonString;
     serializeJson(doc, jsonString);
@@ -81,30 +231,668 @@ void WebServerManager::handleGetConfig(AsyncWebServerRequest *request)
     request->send(response);
 }
 
-void WebServerManager::handleGetTemperatureHistory(AsyncWebServerRequest *request)
+// État d'une réponse d'historique envoyée par morceaux (chunked)
+struct HistoryStream
 {
-    Serial.println(" GET: /api/history/temperature");
-    // Alloue un document JSON suffisamment grand. 1440 points * ~35 octets/point + tampon = ~55KB
-    JsonDocument doc;
-    temperatureHistory.serialize(doc);
-    String jsonString;
-    serializeJson(doc, jsonString);
-    AsyncWebServerResponse *response = request->beginResponse(200, "application/json", jsonString);
+    HistorySource *history; // Tampon RAM du niveau de résolution demandé
+    HistorySource *store;   // Journal sur la flash pour les périodes plus anciennes (ou nullptr)
+    time_t storeEnd;        // Les intervalles antérieurs à cette date sont lus sur la flash
+    time_t origin;   // Début de la période demandée (alignement des intervalles)
+    time_t cursor;   // Début du prochain intervalle à envoyer
+    time_t to;       // Fin (exclue) de la période demandée
+    uint32_t step;   // Durée d'un intervalle en secondes (0 = points bruts)
+    bool binary;     // true = format binaire, false = JSON
+    uint16_t scale;  // Échelle des valeurs du format binaire (propre à la série)
+    bool started;    // En-tête (ou '[') déjà produit
+    bool finished;   // Dernier octet produit
+    bool first;      // Prochain enregistrement = premier enregistrement
+    time_t lastTime; // Horodatage du dernier enregistrement (delta binaire)
+    uint8_t pending[160]; // Un enregistrement JSON avec ses 4 valeurs à deux décimales
+    size_t pendingLen;
+    size_t pendingPos;
+};
+
+// Valeur JSON à deux décimales, null pour une valeur non définie (NaN ou infini, non représentables en JSON)
+static const char *formatJsonValue(char *out, size_t size, float value)
+{
+    if (!isfinite(value))
+    {
+        return "null";
+    }
+    snprintf(out, size, "%.2f", value);
+    return out;
+}
+
+// Produit le prochain morceau (en-tête, enregistrement ou fin) dans le tampon `pending`
+static size_t encodeNextHistoryRecord(HistoryStream &st)
+{
+    uint8_t *out = st.pending;
+    if (!st.started)
+    {
+        st.started = true;
+        if (!st.binary)
+        {
+            out[0] = '[';
+            return 1;
+        }
+        return encodeHistoryHeader(out, st.step, st.scale);
+    }
+
+    // Les points absents du tampon RAM (plus anciens que 24 h) sont lus dans le journal sur la flash
+    HistoryBucket bucket;
+    bool found = st.store != nullptr && st.cursor < st.storeEnd && st.store->nextBucket(st.cursor, st.origin, std::min(st.to, st.storeEnd), st.step, bucket);
+    if (!found)
+    {
+        if (st.cursor < st.storeEnd)
+        {
+            st.cursor = st.storeEnd;
+        }
+        found = st.history->nextBucket(st.cursor, st.origin, st.to, st.step, bucket);
+    }
+    if (!found)
+    {
+        st.finished = true;
+        if (!st.binary)
+        {
+            out[0] = ']';
+            return 1;
+        }
+        return 0;
+    }
+
+    size_t n = 0;
+    if (st.binary)
+    {
+        n = encodeHistoryBucket(out, bucket, st.lastTime, st.step, st.scale);
+    }
+    else if (st.step == 0)
+    {
+        char value[16];
+        n = snprintf((char *)out, sizeof(st.pending), "%s{\"time\":%lu,\"value\":%s}",
+                     st.first ? "" : ",", (unsigned long)bucket.start, formatJsonValue(value, sizeof(value), bucket.avg));
+    }
+    else
+    {
+        char min[16], max[16], avg[16], energy[16];
+        n = snprintf((char *)out, sizeof(st.pending), "%s{\"time\":%lu,\"min\":%s,\"max\":%s,\"avg\":%s,\"energy\":%s,\"count\":%lu}",
+                     st.first ? "" : ",", (unsigned long)bucket.start, formatJsonValue(min, sizeof(min), bucket.min),
+                     formatJsonValue(max, sizeof(max), bucket.max), formatJsonValue(avg, sizeof(avg), bucket.avg),
+                     formatJsonValue(energy, sizeof(energy), bucket.energy), (unsigned long)bucket.count);
+    }
+    st.lastTime = bucket.start;
+    st.first = false;
+    return n;
+}
+
+// Remplit le tampon de la réponse chunked avec les morceaux produits par `encode`, retourne 0 lorsque toute la réponse a été envoyée
+template <typename Stream>
+static size_t fillChunk(Stream &st, size_t (*encode)(Stream &), uint8_t *buffer, size_t maxLen)
+{
+    size_t written = 0;
+    while (written < maxLen)
+    {
+        if (st.pendingPos < st.pendingLen)
+        {
+            size_t n = std::min(st.pendingLen - st.pendingPos, maxLen - written);
+            memcpy(buffer + written, st.pending + st.pendingPos, n);
+            st.pendingPos += n;
+            written += n;
+            continue;
+        }
+        if (st.finished)
+        {
+            break;
+        }
+        st.pendingPos = 0;
+        st.pendingLen = encode(st);
+    }
+    return written;
+}
+
+/**
+ * Envoi d'un historique par morceaux, sans construire la réponse complète en mémoire.
+ * Paramètres optionnels :
+ *   from, to : période demandée (timestamps en secondes, `to` exclu)
+ *   step     : durée des intervalles d'agrégation min/max/moyenne en secondes (0 ou absent = points bruts)
+ *   format   : "json" (défaut) ou "bin" (format binaire compact, voir historyFormat.h)
+ *   tier     : niveau de résolution "second", "minute" (défaut), "quarter" ou "day" (400 si la série ne le conserve pas)
+ */
+void WebServerManager::handleGetHistory(AsyncWebServerRequest *request, HistoryTiers &history)
+{
+    Serial.printf(" GET: %s\n", request->url().c_str());
+
+    HistoryTier tier = HISTORY_TIER_MINUTE;
+    if (request->hasParam("tier") && !parseHistoryTier(request->getParam("tier")->value().c_str(), tier))
+    {
+        request->send(400, "application/json", "{\"status\":\"Invalid tier\"}");
+        return;
+    }
+
+    HistorySource *source = history.tier(tier);
+    if (source == nullptr)
+    {
+        request->send(400, "application/json", "{\"status\":\"Tier not available for this series\"}");
+        return;
+    }
+
+    std::shared_ptr<HistoryStream> st = std::make_shared<HistoryStream>();
+    st->history = source;
+    st->origin = request->hasParam("from") ? historyTimeFromUnsigned(strtoul(request->getParam("from")->value().c_str(), nullptr, 10)) : 0;
+    st->to = request->hasParam("to") ? historyTimeFromUnsigned(strtoul(request->getParam("to")->value().c_str(), nullptr, 10)) : HISTORY_TIME_MAX;
+    st->step = request->hasParam("step") ? strtoul(request->getParam("step")->value().c_str(), nullptr, 10) : 0;
+    st->binary = request->hasParam("format") && request->getParam("format")->value() == "bin";
+    st->scale = history.getBinaryScale();
+    if (tier == HISTORY_TIER_QUARTER && st->step < 15 * 60)
+    {
+        // Le journal sur la flash contient des minutes : les quarts d'heure sont recalculés par intervalles de 15 min
+        st->step = 15 * 60;
+        st->origin -= st->origin % st->step;
+    }
+    st->cursor = st->origin;
+    st->store = history.archive(tier);
+    // Frontière flash / RAM alignée sur un début d'intervalle pour ne pas couper un intervalle en deux
+    time_t ramStart = st->history->oldest();
+    st->storeEnd = ramStart == 0 ? st->to : ramStart; // Tampon RAM vide : tout est lu sur la flash
+    if (st->step != 0 && ramStart > st->origin)
+    {
+        st->storeEnd = historyBucketStart(ramStart + st->step - 1, st->origin, st->step);
+    }
+    st->started = false;
+    st->finished = false;
+    st->first = true;
+    st->lastTime = 0;
+    st->pendingLen = 0;
+    st->pendingPos = 0;
+
+    AsyncWebServerResponse *response = request->beginChunkedResponse(st->binary ? "application/octet-stream" : "application/json",
+                                                                     [st](uint8_t *buffer, size_t maxLen, size_t index) -> size_t
+                                                                     { return fillChunk(*st, encodeNextHistoryRecord, buffer, maxLen); });
     request->send(response);
 }
 
-void WebServerManager::handleGetTriacHistory(AsyncWebServerRequest *request)
+// Format binaire de la trace de régulation (little-endian) :
+//   en-tête : 'R' 'T', version (u8), taille d'un pas (u8), index du premier pas (u32), index du pas déclencheur (u32, UINT32_MAX si aucun)
+//   puis les pas consécutifs, tels que TraceRecord (32 octets)
+static const uint8_t TRACE_BIN_VERSION = 1;
+
+// État d'une réponse de trace envoyée par morceaux (chunked)
+struct TraceStream
 {
-    Serial.println(" GET: /api/history/triac");
-    // Alloue un document JSON suffisamment grand. 1440 points * ~35 octets/point + tampon = ~55KB
-    JsonDocument doc;
-    triacHistory.serialize(doc);
-    String jsonString;
-    serializeJson(doc, jsonString);
-    AsyncWebServerResponse *response = request->beginResponse(200, "application/json", jsonString);
+    const SeqlockRing<TraceRecord> *ring;
+    uint32_t cursor;       // Index absolu du prochain pas à envoyer
+    uint32_t end;          // Fin (exclue) de la trace à la requête
+    uint32_t triggerIndex; // Index absolu du pas déclencheur (en-tête binaire)
+    bool binary;           // true = format binaire, false = CSV
+    bool started;          // En-tête déjà produit
+    bool finished;         // Dernier octet produit
+    uint8_t pending[160];
+    size_t pendingLen;
+    size_t pendingPos;
+};
+
+// Produit le prochain morceau (en-tête ou pas de régulation) dans le tampon `pending`
+static size_t encodeNextTraceRecord(TraceStream &st)
+{
+    uint8_t *out = st.pending;
+    if (!st.started)
+    {
+        st.started = true;
+        if (!st.binary)
+        {
+            return snprintf((char *)out, sizeof(st.pending), "index,micros,latency_us,power,error,integral,derivative,output,firing_delay_us,state,quality\n");
+        }
+        size_t n = 0;
+        out[n++] = 'R';
+        out[n++] = 'T';
+        out[n++] = TRACE_BIN_VERSION;
+        out[n++] = sizeof(TraceRecord);
+        for (int i = 0; i < 4; i++)
+            out[n++] = (st.cursor >> (8 * i)) & 0xFF;
+        for (int i = 0; i < 4; i++)
+            out[n++] = (st.triggerIndex >> (8 * i)) & 0xFF;
+        return n;
+    }
+
+    TraceRecord record;
+    while (st.cursor < st.end && !st.ring->read(st.cursor, record))
+    {
+        // Pas écrasé pendant l'envoi (trace non gelée) : reprise au plus ancien pas encore présent
+        st.cursor = std::max(st.cursor + 1, st.ring->begin());
+    }
+    if (st.cursor >= st.end)
+    {
+        st.finished = true;
+        return 0;
+    }
+
+    size_t n;
+    if (st.binary)
+    {
+        memcpy(out, &record, sizeof(record));
+        n = sizeof(record);
+    }
+    else
+    {
+        n = snprintf((char *)out, sizeof(st.pending), "%lu,%lu,%lu,%.1f,%.3f,%.3f,%.3f,%.2f,%u,%s,%u\n",
+                     (unsigned long)st.cursor, (unsigned long)record.micros, (unsigned long)record.latencyUs, record.power,
+                     record.error, record.integral, record.derivative, record.output, (unsigned)record.firingDelayUs,
+                     controlStateName((ControlState)record.state), (unsigned)record.quality);
+    }
+    st.cursor++;
+    return n;
+}
+
+/**
+ * Téléchargement de la trace de régulation, du plus ancien au plus récent pas.
+ * Paramètre optionnel format : "csv" (défaut) ou "bin" (voir TRACE_BIN_*).
+ * Les index ne sont garantis consécutifs que si la trace est gelée (déclencheur ou POST /api/trace).
+ */
+void WebServerManager::handleGetTrace(AsyncWebServerRequest *request)
+{
+    Serial.println(" GET: /api/trace");
+
+    TraceStatus status = regulationTrace.getStatus();
+    std::shared_ptr<TraceStream> st = std::make_shared<TraceStream>();
+    st->ring = &regulationTrace.getRing();
+    st->cursor = status.first;
+    st->end = status.end;
+    st->triggerIndex = status.triggerIndex;
+    st->binary = request->hasParam("format") && request->getParam("format")->value() == "bin";
+    st->started = false;
+    st->finished = false;
+    st->pendingLen = 0;
+    st->pendingPos = 0;
+
+    AsyncWebServerResponse *response = request->beginChunkedResponse(st->binary ? "application/octet-stream" : "text/csv",
+                                                                     [st](uint8_t *buffer, size_t maxLen, size_t index) -> size_t
+                                                                     { return fillChunk(*st, encodeNextTraceRecord, buffer, maxLen); });
     request->send(response);
 }
 
+/**
+ * État de la trace de régulation (index absolus des pas)
+ */
+void WebServerManager::handleGetTraceStatus(AsyncWebServerRequest *request)
+{
+    Serial.println(" GET: /api/trace/status");
+
+    TraceStatus status = regulationTrace.getStatus();
+    JsonDocument doc;
+    doc["capacity"] = status.capacity;
+    doc["first"] = status.first;
+    doc["end"] = status.end;
+    doc["frozen"] = status.frozen;
+    doc["trigger"] = traceTriggerName(status.trigger);
+    doc["threshold"] = status.threshold;
+    doc["post"] = status.postRecords;
+    if (status.triggerIndex != UINT32_MAX)
+    {
+        doc["triggerIndex"] = status.triggerIndex;
+    }
+    else
+    {
+        doc["triggerIndex"] = nullptr;
+    }
+
+    String json;
+    serializeJson(doc, json);
+    request->send(200, "application/json", json);
+}
+
+/**
+ * Commande de la trace de régulation :
+ *   {"action":"arm","trigger":"import"|"export","threshold":<W>,"post":<pas>} gèle la trace `post` pas après l'événement
+ *   {"action":"freeze"} gèle immédiatement, {"action":"resume"} relance l'enregistrement continu
+ */
+void WebServerManager::handleTraceCommand(AsyncWebServerRequest *request, uint8_t *data, size_t len)
+{
+    Serial.println(" POST: /api/trace");
+
+    JsonDocument doc;
+    DeserializationError error = deserializeJson(doc, data, len);
+    if (error)
+    {
+        request->send(400, "application/json", "{\"status\":\"Invalid JSON\"}");
+        return;
+    }
+
+    std::string action = doc["action"] | "";
+    if (action == "arm")
+    {
+        TraceTrigger trigger;
+        if (!parseTraceTrigger(doc["trigger"] | "", trigger))
+        {
+            request->send(400, "application/json", "{\"status\":\"Invalid trigger\"}");
+            return;
+        }
+        regulationTrace.arm(trigger, doc["threshold"] | 0.0f, doc["post"] | (uint32_t)(REGULATION_TRACE_CAPACITY / 2));
+    }
+    else if (action == "freeze")
+    {
+        regulationTrace.freeze();
+    }
+    else if (action == "resume")
+    {
+        regulationTrace.resume();
+    }
+    else
+    {
+        request->send(400, "application/json", "{\"status\":\"Invalid action\"}");
+        return;
+    }
+    handleGetTraceStatus(request);
+}
+
+// Ajoute les compteurs d'une période à un objet JSON (valeurs en Wh)
+static void addEnergyCounters(JsonObject obj, const EnergyCounters &counters)
+{
+    obj["routed"] = round(counters.routed * 10) / 10.0;
+    obj["imported"] = round(counters.imported * 10) / 10.0;
+    obj["exported"] = round(counters.exported * 10) / 10.0;
+}
+
+/**
+ * Compteurs d'énergie : puissances instantanées (W) et énergies par période (Wh)
+ */
+void WebServerManager::handleGetEnergy(AsyncWebServerRequest *request)
+{
+    Serial.println(" GET: /api/energy");
+
+    EnergyTotals totals = energyManager.getTotals();
+    JsonDocument doc;
+    doc["routedPower"] = round(energyManager.getRoutedPower());
+    doc["gridPower"] = round(energyManager.getGridPower());
+    addEnergyCounters(doc["today"].to<JsonObject>(), totals.today);
+    addEnergyCounters(doc["yesterday"].to<JsonObject>(), totals.yesterday);
+    addEnergyCounters(doc["month"].to<JsonObject>(), totals.thisMonth);
+    addEnergyCounters(doc["lastMonth"].to<JsonObject>(), totals.lastMonth);
+    addEnergyCounters(doc["total"].to<JsonObject>(), totals.total);
+
+    String json;
+    serializeJson(doc, json);
+    request->send(200, "application/json", json);
+}
+
+/**
+ * Statistiques des interruptions de commande du triac, sur l'intervalle depuis la requête précédente
+ */
+void WebServerManager::handleGetTriacStats(AsyncWebServerRequest *request)
+{
+    Serial.println(" GET: /api/triac/stats");
+
+    if (SolarManager::instance == nullptr)
+    {
+        request->send(503, "application/json", "{\"status\":\"Triac not initialized\"}");
+        return;
+    }
+
+    TriacIsrStats stats = SolarManager::instance->getIsrStats();
+    unsigned long now = millis();
+    float seconds = lastIsrStatsTime == 0 ? now / 1000.0f : (now - lastIsrStatsTime) / 1000.0f;
+    uint32_t cyclesPerUs = getCpuFrequencyMhz();
+
+    JsonDocument doc;
+    if (seconds > 0)
+    {
+        doc["zeroCrossPerSecond"] = (stats.zeroCrossCount - lastIsrStats.zeroCrossCount) / seconds;
+        doc["timerPerSecond"] = (stats.timerCount - lastIsrStats.timerCount) / seconds;
+        // Part du temps CPU (cœur des interruptions) passée dans les interruptions du triac
+        doc["isrLoadPercent"] = (stats.busyCycles - lastIsrStats.busyCycles) / (seconds * cyclesPerUs * 10000.0f);
+    }
+    doc["maxIsrUs"] = (float)stats.maxCycles / cyclesPerUs;
+    doc["zeroCrossCount"] = stats.zeroCrossCount;
+    doc["debouncedCount"] = stats.debouncedCount;
+    doc["timerCount"] = stats.timerCount;
+    // Délai entre la réception d'une mesure et l'application de la nouvelle commande
+    doc["regulationLatencyUs"] = regulationLatencyUs;
+    doc["maxRegulationLatencyUs"] = maxRegulationLatencyUs;
+    lastIsrStats = stats;
+    lastIsrStatsTime = now;
+
+    String json;
+    serializeJson(doc, json);
+    request->send(200, "application/json", json);
+}
+
+/**
+ * Statistiques de l'acquisition du compteur (latence et erreurs des requêtes au ShellyEM)
+ */
+void WebServerManager::handleGetMeter(AsyncWebServerRequest *request)
+{
+    Serial.println(" GET: /api/meter");
+
+    if (meter == nullptr)
+    {
+        request->send(503, "application/json", "{\"status\":\"Meter not configured\"}");
+        return;
+    }
+
+    MeterStats stats = meter->getStats();
+    unsigned long now = millis();
+
+    JsonDocument doc;
+    doc["source"] = meter->getName();
+    doc["requests"] = stats.requests;
+    doc["errors"] = stats.errors;
+    doc["timeouts"] = stats.timeouts;
+    doc["reconnections"] = stats.reconnections;
+    doc["notifications"] = stats.notifications;
+    doc["lastError"] = stats.lastError;
+    doc["lastLatencyMs"] = stats.lastLatencyMs;
+    doc["maxLatencyMs"] = stats.maxLatencyMs;
+    doc["averageLatencyMs"] = stats.averageLatencyMs;
+    if (!isnan(stats.voltage))
+    {
+        doc["voltage"] = stats.voltage;
+    }
+    if (!isnan(stats.powerFactor))
+    {
+        doc["powerFactor"] = stats.powerFactor;
+    }
+    if (stats.lastValid != 0)
+    {
+        doc["lastValidAgeMs"] = now - stats.lastValid;
+    }
+    else
+    {
+        doc["lastValidAgeMs"] = nullptr;
+    }
+
+    String json;
+    serializeJson(doc, json);
+    request->send(200, "application/json", json);
+}
+
+/**
+ * État de la commande du chauffe-eau et dernières transitions (de la plus ancienne à la plus récente)
+ */
+void WebServerManager::handleGetControl(AsyncWebServerRequest *request)
+{
+    Serial.println(" GET: /api/control");
+
+    ControlTransition transitions[CONTROL_HISTORY_SIZE];
+    size_t count = controlState.getTransitions(transitions, CONTROL_HISTORY_SIZE);
+    unsigned long now = millis();
+
+    JsonDocument doc;
+    doc["state"] = controlStateName(controlState.getState());
+    doc["sinceMs"] = now - controlState.getSince();
+    doc["transitionCount"] = controlState.getTransitionCount();
+    JsonArray array = doc["transitions"].to<JsonArray>();
+    for (size_t i = 0; i < count; i++)
+    {
+        JsonObject entry = array.add<JsonObject>();
+        entry["from"] = controlStateName(transitions[i].from);
+        entry["to"] = controlStateName(transitions[i].to);
+        entry["ageMs"] = now - transitions[i].millis;
+        if (transitions[i].time != 0)
+        {
+            entry["time"] = (uint32_t)transitions[i].time;
+        }
+    }
+
+    String json;
+    serializeJson(doc, json);
+    request->send(200, "application/json", json);
+}
+
+/**
+ * Dernière température valide de la sonde et statistiques d'acquisition
+ */
+void WebServerManager::handleGetTemperature(AsyncWebServerRequest *request)
+{
+    Serial.println(" GET: /api/temperature");
+
+    TemperatureStats stats = temperatureSensor.getStats();
+    std::shared_ptr<const Config> config = configStore.get();
+
+    JsonDocument doc;
+    if (stats.lastGood != 0)
+    {
+        doc["temperature"] = stats.value;
+        doc["ageMs"] = millis() - stats.lastGood;
+    }
+    else
+    {
+        doc["temperature"] = nullptr;
+        doc["ageMs"] = nullptr;
+    }
+    if (stats.lastGoodTime != 0)
+    {
+        doc["time"] = (uint32_t)stats.lastGoodTime;
+    }
+    doc["resolution"] = config->boiler.sensorResolution;
+    doc["interval"] = config->boiler.sensorInterval;
+    doc["reads"] = stats.reads;
+    doc["errors"] = stats.errors;
+    doc["timeouts"] = stats.timeouts;
+    doc["lastConversionMs"] = stats.lastConversionMs;
+
+    String json;
+    serializeJson(doc, json);
+    request->send(200, "application/json", json);
+}
+
+/**
+ * Éphéméride solaire du jour (minutes depuis minuit, heure locale) et élévation courante du soleil
+ */
+void WebServerManager::handleGetSolar(AsyncWebServerRequest *request)
+{
+    Serial.println(" GET: /api/solar");
+
+    SolarDay sun = solarEphemeris.get();
+    if (sun.day == 0)
+    {
+        request->send(503, "application/json", "{\"status\":\"Time not synchronized\"}");
+        return;
+    }
+
+    JsonDocument doc;
+    doc["day"] = sun.day;
+    doc["sunrise"] = sun.sunrise;
+    doc["sunset"] = sun.sunset;
+    doc["solarNoon"] = sun.solarNoon;
+    doc["noonElevation"] = sun.noonElevation;
+    doc["elevation"] = solarEphemeris.getElevation(time(nullptr));
+
+    String json;
+    serializeJson(doc, json);
+    request->send(200, "application/json", json);
+}
+
+/**
+ * Métriques d'exécution au format texte Prometheus : mémoire, pile et part CPU des tâches,
+ * interruptions du triac et histogrammes de durée (boucle de régulation, interruptions, requêtes
+ * au compteur, lecture de la température, diffusion web).
+ */
+void WebServerManager::handleGetMetrics(AsyncWebServerRequest *request)
+{
+    String out;
+    out.reserve(6144);
+    char line[160];
+
+    snprintf(line, sizeof(line), "# TYPE solar_router_uptime_seconds gauge\nsolar_router_uptime_seconds %lu\n", millis() / 1000);
+    out += line;
+    snprintf(line, sizeof(line), "# TYPE solar_router_heap_free_bytes gauge\nsolar_router_heap_free_bytes %u\n", (unsigned)ESP.getFreeHeap());
+    out += line;
+    snprintf(line, sizeof(line), "# TYPE solar_router_heap_min_free_bytes gauge\nsolar_router_heap_min_free_bytes %u\n", (unsigned)ESP.getMinFreeHeap());
+    out += line;
+    // Plus grand bloc allouable : un écart croissant avec la mémoire libre indique une fragmentation
+    snprintf(line, sizeof(line), "# TYPE solar_router_heap_largest_free_block_bytes gauge\nsolar_router_heap_largest_free_block_bytes %u\n", (unsigned)ESP.getMaxAllocHeap());
+    out += line;
+
+    // Marge de pile minimum observée (octets)
+    TrackedTask tasks[4];
+    size_t taskCount = getTrackedTasks(tasks);
+    out += "# HELP solar_router_task_stack_free_bytes Stack high-water mark\n# TYPE solar_router_task_stack_free_bytes gauge\n";
+    for (size_t i = 0; i < taskCount; i++)
+    {
+        if (tasks[i].handle != nullptr)
+        {
+            snprintf(line, sizeof(line), "solar_router_task_stack_free_bytes{task=\"%s\"} %u\n", tasks[i].name, (unsigned)uxTaskGetStackHighWaterMark(tasks[i].handle));
+            out += line;
+        }
+    }
+
+#if (configGENERATE_RUN_TIME_STATS == 1) && (configUSE_TRACE_FACILITY == 1)
+    // Part d'un cœur utilisée par chaque tâche depuis le démarrage (IDLE0 / IDLE1 : temps libre de chaque cœur)
+    UBaseType_t systemTaskCount = uxTaskGetNumberOfTasks();
+    std::unique_ptr<TaskStatus_t[]> status(new TaskStatus_t[systemTaskCount]);
+    uint32_t totalRunTime = 0;
+    systemTaskCount = uxTaskGetSystemState(status.get(), systemTaskCount, &totalRunTime);
+    if (totalRunTime > 0)
+    {
+        out += "# HELP solar_router_task_cpu_ratio Share of one core used since boot\n# TYPE solar_router_task_cpu_ratio gauge\n";
+        for (UBaseType_t i = 0; i < systemTaskCount; i++)
+        {
+            snprintf(line, sizeof(line), "solar_router_task_cpu_ratio{task=\"%s\"} %.4f\n", status[i].pcTaskName, (double)status[i].ulRunTimeCounter / totalRunTime);
+            out += line;
+        }
+    }
+#endif
+
+    if (SolarManager::instance != nullptr)
+    {
+        TriacIsrStats stats = SolarManager::instance->getIsrStats();
+        snprintf(line, sizeof(line), "# TYPE solar_router_zero_cross_interrupts_total counter\nsolar_router_zero_cross_interrupts_total %u\n", (unsigned)stats.zeroCrossCount);
+        out += line;
+        snprintf(line, sizeof(line), "# TYPE solar_router_zero_cross_debounced_total counter\nsolar_router_zero_cross_debounced_total %u\n", (unsigned)stats.debouncedCount);
+        out += line;
+        snprintf(line, sizeof(line), "# TYPE solar_router_timer_interrupts_total counter\nsolar_router_timer_interrupts_total %u\n", (unsigned)stats.timerCount);
+        out += line;
+        appendPrometheusHistogram(out, "solar_router_triac_isr_seconds", "Triac interrupt duration", SolarManager::instance->getIsrHistogram());
+    }
+
+    snprintf(line, sizeof(line), "# TYPE solar_router_regulation_latency_seconds gauge\nsolar_router_regulation_latency_seconds %.6f\n", regulationLatencyUs / 1e6);
+    out += line;
+    appendPrometheusHistogram(out, "solar_router_control_loop_seconds", "Control loop pass duration", controlLoopHistogram.get());
+
+    if (meter != nullptr)
+    {
+        MeterStats stats = meter->getStats();
+        snprintf(line, sizeof(line), "# TYPE solar_router_meter_requests_total counter\nsolar_router_meter_requests_total %u\n", (unsigned)stats.requests);
+        out += line;
+        snprintf(line, sizeof(line), "# TYPE solar_router_meter_errors_total counter\nsolar_router_meter_errors_total %u\n", (unsigned)stats.errors);
+        out += line;
+        appendPrometheusHistogram(out, "solar_router_meter_request_seconds", "Successful meter request duration", meter->getRequestHistogram());
+    }
+
+    TemperatureStats temperature = temperatureSensor.getStats();
+    snprintf(line, sizeof(line), "# TYPE solar_router_temperature_errors_total counter\nsolar_router_temperature_errors_total %u\n", (unsigned)temperature.errors);
+    out += line;
+    snprintf(line, sizeof(line), "# TYPE solar_router_temperature_timeouts_total counter\nsolar_router_temperature_timeouts_total %u\n", (unsigned)temperature.timeouts);
+    out += line;
+    if (temperature.lastGood != 0)
+    {
+        snprintf(line, sizeof(line), "# TYPE solar_router_temperature_age_seconds gauge\nsolar_router_temperature_age_seconds %.1f\n", (millis() - temperature.lastGood) / 1000.0f);
+        out += line;
+    }
+    appendPrometheusHistogram(out, "solar_router_temperature_read_seconds", "Temperature sensor read duration", temperatureReadHistogram.get());
+    appendPrometheusHistogram(out, "solar_router_broadcast_seconds", "Web live data broadcast duration", broadcastHistogram.get());
+
+    request->send(200, "text/plain; version=0.0.4", out);
+}
+
 void WebServerManager::handleSaveWifiSettings(AsyncWebServerRequest *request, uint8_t *data, size_t len)
 {
     Serial.println(" POST: /saveWifiSettings");
@@ -119,14 +907,20 @@ void WebServerManager::handleSaveWifiSettings(AsyncWebServerRequest *request, ui
         return;
     }
 
-    Config config = this->configManager.loadConfig();
-    config.wifi.ssid = doc["ssid"] | "";
-    const char *password = doc["password"] | "";
-    if (password != "" && strcmp(password, "********") != 0)
+    // Appliqué au prochain redémarrage
+    bool valid = configStore.update([&doc](Config &config)
+                                    {
+        config.wifi.ssid = doc["ssid"] | "";
+        const char *password = doc["password"] | "";
+        if (password != "" && strcmp(password, "********") != 0)
+        {
+            config.wifi.password = password;
+        } });
+    if (!valid)
     {
-        config.wifi.password = password;
+        request->send(400, "application/json", "{\"status\":\"Invalid configuration\"}");
+        return;
     }
-    this->configManager.saveConfig(config);
 
     request->send(200, "application/json", "{\"status\":\"success\"}");
 }
@@ -145,17 +939,23 @@ void WebServerManager::handleSaveMqttSettings(AsyncWebServerRequest *request, ui
         return;
     }
 
-    Config config = this->configManager.loadConfig();
-    config.mqtt.server = doc["server"] | "";
-    config.mqtt.port = doc["port"] | 1883;
-    config.mqtt.topic = doc["topic"] | "";
-    config.mqtt.username = doc["username"] | "";
-    const char *password = doc["password"] | "";
-    if (password != "" && strcmp(password, "********") != 0)
+    // Appliqué au prochain redémarrage
+    bool valid = configStore.update([&doc](Config &config)
+                                    {
+        config.mqtt.server = doc["server"] | "";
+        config.mqtt.port = doc["port"] | 1883;
+        config.mqtt.topic = doc["topic"] | "";
+        config.mqtt.username = doc["username"] | "";
+        const char *password = doc["password"] | "";
+        if (password != "" && strcmp(password, "********") != 0)
+        {
+            config.mqtt.password = password;
+        } });
+    if (!valid)
     {
-        config.mqtt.password = password;
+        request->send(400, "application/json", "{\"status\":\"Invalid configuration\"}");
+        return;
     }
-    this->configManager.saveConfig(config);
 
     request->send(200, "application/json", "{\"status\":\"success\"}");
 }
@@ -174,29 +974,48 @@ void WebServerManager::handleSaveSolarSettings(AsyncWebServerRequest *request, u
         return;
     }
 
-    Config configTmp = this->configManager.loadConfig();
+    bool valid = configStore.update([&doc](Config &config)
+                                    {
+        if (!doc["shellyEm"].isNull())
+        {
+            config.shellyEm.ip = doc["shellyEm"]["ip"] | "";
+            config.shellyEm.channel = doc["shellyEm"]["channel"] | "0";
+            config.shellyEm.model = doc["shellyEm"]["model"] | "em";
+            config.shellyEm.pollPeriod = std::max(doc["shellyEm"]["pollPeriod"] | 1000, SHELLY_MIN_POLL_PERIOD);
+        }
 
-    if (!doc["shellyEm"].isNull())
-    {
-        configTmp.shellyEm.ip = doc["shellyEm"]["ip"] | "";
-        configTmp.shellyEm.channel = doc["shellyEm"]["channel"] | "0";
-    }
+        if (!doc["meter"].isNull())
+        {
+            JsonVariant meterObj = doc["meter"];
+            config.meter.source = meterObj["source"] | "shelly";
+            config.meter.linky.standard = meterObj["linky"]["standard"] | false;
+            config.meter.linky.rxPin = meterObj["linky"]["rxPin"] | 16;
+            config.meter.modbus.transport = meterObj["modbus"]["transport"] | "rtu";
+            config.meter.modbus.device = meterObj["modbus"]["device"] | "sdm120";
+            config.meter.modbus.address = meterObj["modbus"]["address"] | 1;
+            config.meter.modbus.host = meterObj["modbus"]["host"] | "";
+            config.meter.modbus.port = meterObj["modbus"]["port"] | 502;
+            config.meter.modbus.baudRate = meterObj["modbus"]["baudRate"] | 9600;
+            config.meter.modbus.rxPin = meterObj["modbus"]["rxPin"] | 16;
+            config.meter.modbus.txPin = meterObj["modbus"]["txPin"] | 17;
+            config.meter.modbus.dePin = meterObj["modbus"]["dePin"] | -1;
+            config.meter.modbus.pollPeriod = std::max(meterObj["modbus"]["pollPeriod"] | 1000, 200);
+            config.meter.mqtt.topic = meterObj["mqtt"]["topic"] | "";
+            config.meter.mqtt.key = meterObj["mqtt"]["key"] | "";
+        }
 
-    if (!doc["solar"].isNull())
+        if (!doc["solar"].isNull())
+        {
+            config.solar.latitude = doc["solar"]["latitude"] | 48.8566;
+            config.solar.longitude = doc["solar"]["longitude"] | 2.3522;
+            config.solar.timeZone = doc["solar"]["timeZone"] | "Europe/Paris";
+        } });
+    if (!valid)
     {
-        configTmp.solar.latitude = doc["solar"]["latitude"] | 48.8566;
-        configTmp.solar.longitude = doc["solar"]["longitude"] | 2.3522;
-        configTmp.solar.timeZone = doc["solar"]["timeZone"] | "Europe/Paris";
+        request->send(400, "application/json", "{\"status\":\"Invalid configuration\"}");
+        return;
     }
 
-    this->configManager.saveConfig(configTmp);
-
-    extern Config config;
-    config = configTmp;
-
-    this->mqttManager.publishBoilerMode(config.boiler.mode.c_str());
-    this->mqttManager.publishBoilerTemperature(config.boiler.temperature);
-
     request->send(200, "application/json", "{\"status\":\"success\"}");
 }
 
@@ -214,38 +1033,68 @@ void WebServerManager::handleSaveBoilerSettings(AsyncWebServerRequest *request,
         return;
     }
 
-    Config configTmp = this->configManager.loadConfig();
-
-    configTmp.boiler.mode = doc["mode"] | "auto";
-    configTmp.boiler.temperature = doc["temperature"] | 50;
-    configTmp.boiler.triacOpening = doc["triacOpening"] | 50;
-    if (!doc["periods"].isNull())
+    BoilerMode mode;
+    if (!parseBoilerMode(doc["mode"] | "auto", mode))
     {
-        configTmp.boiler.periods.clear();
-        for (JsonObject p : doc["periods"].as<JsonArray>())
+        request->send(400, "application/json", "{\"status\":\"Invalid mode\"}");
+        return;
+    }
+
+    // Ancrage des bornes au lever / coucher du soleil : indiqué par l'app web (startSunrise, ...) ;
+    // à défaut (anciens clients), les bornes égales au lever / coucher du jour leur restent attachées
+    SolarDay sun = solarEphemeris.get();
+    std::shared_ptr<const Config> current = configStore.get();
+    int sunrise = sun.day != 0 && sun.sunrise >= 0 ? sun.sunrise : current->solar.sunRiseMinutes;
+    int sunset = sun.day != 0 && sun.sunset >= 0 ? sun.sunset : current->solar.sunSetMinutes;
+
+    bool valid = configStore.update([&](Config &config)
+                                    {
+        config.boiler.mode = mode;
+        config.boiler.temperature = doc["temperature"] | 50;
+        config.boiler.triacOpening = doc["triacOpening"] | 50;
+        config.boiler.heaterPower = doc["heaterPower"] | config.boiler.heaterPower;
+        config.boiler.outputMode = doc["outputMode"] | config.boiler.outputMode;
+        config.boiler.sensorResolution = doc["sensorResolution"] | config.boiler.sensorResolution;
+        config.boiler.sensorInterval = doc["sensorInterval"] | config.boiler.sensorInterval;
+        if (!doc["regulation"].isNull())
         {
-            Period period;
-            period.start = p["start"];
-            period.end = p["end"];
-            period.mode = p["mode"] | "auto";
-            period.startSunrise = p["start"] == configTmp.solar.sunRiseMinutes;
-            period.startSunset = p["start"] == configTmp.solar.sunSetMinutes;
-            period.endSunrise = p["end"] == configTmp.solar.sunRiseMinutes;
-            period.endSunset = p["end"] == configTmp.solar.sunSetMinutes;
-            configTmp.boiler.periods.push_back(period);
+            JsonObject regulation = doc["regulation"];
+            config.regulation.setpoint = regulation["setpoint"] | config.regulation.setpoint;
+            config.regulation.kp = regulation["kp"] | config.regulation.kp;
+            config.regulation.ki = regulation["ki"] | config.regulation.ki;
+            config.regulation.kd = regulation["kd"] | config.regulation.kd;
+            config.regulation.maxRate = regulation["maxRate"] | config.regulation.maxRate;
         }
+        if (!doc["periods"].isNull())
+        {
+            config.boiler.periods.clear();
+            for (JsonObject p : doc["periods"].as<JsonArray>())
+            {
+                Period period;
+                period.start = p["start"];
+                period.end = p["end"];
+                period.mode = PERIOD_AUTO;
+                parsePeriodMode(p["mode"] | "auto", period.mode);
+                period.startSunrise = p["startSunrise"] | (p["start"] == sunrise);
+                period.startSunset = !period.startSunrise && (p["startSunset"] | (p["start"] == sunset));
+                period.endSunrise = p["endSunrise"] | (p["end"] == sunrise);
+                period.endSunset = !period.endSunrise && (p["endSunset"] | (p["end"] == sunset));
+                if (period.startSunrise || period.startSunset)
+                    period.start = period.startSunrise ? sunrise : sunset;
+                if (period.endSunrise || period.endSunset)
+                    period.end = period.endSunrise ? sunrise : sunset;
+                config.boiler.periods.push_back(period);
+            }
+        } });
+    if (!valid)
+    {
+        request->send(400, "application/json", "{\"status\":\"Invalid configuration\"}");
+        return;
     }
 
-    this->configManager.saveConfig(configTmp);
-
-    extern Config config;
-    config = configTmp;
-    extern bool temperatureReached;
+    extern volatile bool temperatureReached;
     temperatureReached = false;
 
-    this->mqttManager.publishBoilerMode(config.boiler.mode.c_str());
-    this->mqttManager.publishBoilerTemperature(config.boiler.temperature);
-
     request->send(200, "application/json", "{\"status\":\"success\"}");
 }
 
@@ -377,11 +1226,43 @@ void WebServerManager::setupLocalWeb()
 void WebServerManager::setupApiRoutes()
 {
     // API routes
-    server.on("/api/history/temperature", HTTP_GET, [this](AsyncWebServerRequest *request)
-              { handleGetTemperatureHistory(request); });
+    // Une route par historique enregistré (temperature, triac, power)
+    for (HistoryTiers *history = HistoryTiers::first(); history != nullptr; history = history->next())
+    {
+        String uri = String("/api/history/") + history->getName();
+        server.on(uri.c_str(), HTTP_GET, [this, history](AsyncWebServerRequest *request)
+                  { handleGetHistory(request, *history); });
+    }
+
+    server.on("/api/energy", HTTP_GET, [this](AsyncWebServerRequest *request)
+              { handleGetEnergy(request); });
+
+    server.on("/api/triac/stats", HTTP_GET, [this](AsyncWebServerRequest *request)
+              { handleGetTriacStats(request); });
+
+    server.on("/api/meter", HTTP_GET, [this](AsyncWebServerRequest *request)
+              { handleGetMeter(request); });
+
+    server.on("/api/solar", HTTP_GET, [this](AsyncWebServerRequest *request)
+              { handleGetSolar(request); });
+
+    server.on("/api/control", HTTP_GET, [this](AsyncWebServerRequest *request)
+              { handleGetControl(request); });
 
-    server.on("/api/history/triac", HTTP_GET, [this](AsyncWebServerRequest *request)
-              { handleGetTriacHistory(request); });
+    server.on("/api/temperature", HTTP_GET, [this](AsyncWebServerRequest *request)
+              { handleGetTemperature(request); });
+
+    server.on("/api/trace/status", HTTP_GET, [this](AsyncWebServerRequest *request)
+              { handleGetTraceStatus(request); });
+
+    server.on("/api/trace", HTTP_GET, [this](AsyncWebServerRequest *request)
+              { handleGetTrace(request); });
+
+    server.on("/api/trace", HTTP_POST, [](AsyncWebServerRequest *request) {}, NULL, [this](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total)
+              { handleTraceCommand(request, data, len); });
+
+    server.on("/api/metrics", HTTP_GET, [this](AsyncWebServerRequest *request)
+              { handleGetMetrics(request); });
 
     server.on("/saveWifiSettings", HTTP_POST, [](AsyncWebServerRequest *request) {}, NULL, [this](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total)
               { handleSaveWifiSettings(request, data, len); });
@@ -428,6 +1309,12 @@ void WebServerManager::setupApiRoutes()
     ws.onEvent([this](AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len)
                { onWsEvent(server, client, type, arg, data, len); });
     server.addHandler(&ws);
+
+    server.addHandler(&metricsWs);
+
+    shellyWs.onEvent([this](AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len)
+                     { onShellyWsEvent(client, type, arg, data, len); });
+    server.addHandler(&shellyWs);
 }
 
 void WebServerManager::startServer()
@@ -438,12 +1325,48 @@ void WebServerManager::startServer()
     Serial.println("[-] Serveur Web Ok");
 }
 
+/**
+ * Envoi des valeurs courantes (trame "live") à tous les clients.
+ * L'historique n'est plus inclus : il est envoyé une seule fois par client (trame "history"),
+ * puis complété point par point (trame "append", voir broadcastHistoryPoint).
+ */
 void WebServerManager::broadcastData(float temperature, float triacOpeningPercentage, bool temperatureReached, String lastFirmwareVersion)
 {
+    // Historique complet pour les clients nouvellement connectés ou en demande de resynchronisation
+    std::vector<uint32_t> clients;
+    if (xSemaphoreTake(wsMutex, portMAX_DELAY) == pdTRUE)
+    {
+        clients.swap(pendingHistoryClients);
+        xSemaphoreGive(wsMutex);
+    }
+    for (uint32_t clientId : clients)
+    {
+        sendHistory(clientId);
+    }
+
+    int routedPower = round(energyManager.getRoutedPower());
+    int routedEnergy = round(energyManager.getTotals().today.routed);
+
+    // N'envoie la trame que si une valeur a changé
+    if (hasBroadcasted &&
+        temperature == lastTemperature &&
+        triacOpeningPercentage == lastTriacOpeningPercentage &&
+        temperatureReached == lastTemperatureReached &&
+        routedPower == lastRoutedPower &&
+        routedEnergy == lastRoutedEnergy &&
+        lastFirmwareVersion == this->lastFirmwareVersion)
+    {
+        return;
+    }
+
     JsonDocument doc;
+    doc["type"] = "live";
+    doc["seq"] = historySeq;
     doc["temperature"] = temperature;
     doc["triacOpeningPercentage"] = triacOpeningPercentage;
     doc["temperatureReached"] = temperatureReached;
+    doc["routedPower"] = routedPower;
+    doc["routedEnergyToday"] = routedEnergy;
     doc["currentFirmwareVersion"] = FIRMWARE_VERSION;
 
     if (lastFirmwareVersion != "")
@@ -451,39 +1374,135 @@ void WebServerManager::broadcastData(float temperature, float triacOpeningPercen
         doc["lastFirmwareVersion"] = lastFirmwareVersion;
     }
 
-    // Ajouter les historiques (sérialiser en tableaux JSON)
+    String json;
+    serializeJson(doc, json);
+    ws.textAll(json);
+
+    lastTemperature = temperature;
+    lastTriacOpeningPercentage = triacOpeningPercentage;
+    lastTemperatureReached = temperatureReached;
+    lastRoutedPower = routedPower;
+    lastRoutedEnergy = routedEnergy;
+    this->lastFirmwareVersion = lastFirmwareVersion;
+    hasBroadcasted = true;
+}
+
+/**
+ * Diffuse le dernier point ajouté aux historiques (trame "append"), avec un numéro de séquence
+ */
+void WebServerManager::broadcastHistoryPoint(const DataPoint &temperature, const DataPoint &triac)
+{
+    historySeq++;
+
+    JsonDocument doc;
+    doc["type"] = "append";
+    doc["seq"] = historySeq;
+    JsonArray temperatureArray = doc["temperature"].to<JsonArray>();
+    temperatureArray.add(temperature.timestamp);
+    temperatureArray.add(temperature.value);
+    JsonArray triacArray = doc["triac"].to<JsonArray>();
+    triacArray.add(triac.timestamp);
+    triacArray.add(triac.value);
+
+    String json;
+    serializeJson(doc, json);
+    ws.textAll(json);
+}
+
+// Résumé d'un histogramme pour le WebSocket des métriques
+static void addLatencySummary(JsonObject object, const LatencySnapshot &histogram)
+{
+    object["count"] = histogram.count;
+    object["meanUs"] = histogram.count > 0 ? (uint32_t)(histogram.sumUs / histogram.count) : 0;
+    object["maxUs"] = histogram.maxUs;
+}
+
+/**
+ * Diffusion des métriques d'exécution (trame "metrics") aux clients du WebSocket /metrics/ws.
+ * Rien n'est calculé tant qu'aucun client n'est connecté.
+ */
+void WebServerManager::broadcastMetrics()
+{
+    metricsWs.cleanupClients();
+    if (metricsWs.count() == 0)
     {
-        JsonArray tempArray = doc["temperatureHistory"].to<JsonArray>();
-        std::vector<DataPoint> tdata = temperatureHistory.getData();
-        for (const auto &p : tdata)
-        {
-            JsonObject obj = tempArray.add<JsonObject>();
-            obj["time"] = p.timestamp;
-            obj["value"] = p.value;
-        }
+        return;
     }
 
+    JsonDocument doc;
+    doc["type"] = "metrics";
+    doc["uptime"] = millis() / 1000;
+    JsonObject heap = doc["heap"].to<JsonObject>();
+    heap["free"] = ESP.getFreeHeap();
+    heap["minFree"] = ESP.getMinFreeHeap();
+    heap["largestFreeBlock"] = ESP.getMaxAllocHeap();
+
+    TrackedTask tasks[4];
+    size_t taskCount = getTrackedTasks(tasks);
+    JsonObject stacks = doc["stackFree"].to<JsonObject>();
+    for (size_t i = 0; i < taskCount; i++)
     {
-        JsonArray triacArray = doc["triacHistory"].to<JsonArray>();
-        std::vector<DataPoint> thdata = triacHistory.getData();
-        for (const auto &p : thdata)
+        if (tasks[i].handle != nullptr)
         {
-            JsonObject obj = triacArray.add<JsonObject>();
-            obj["time"] = p.timestamp;
-            obj["value"] = p.value;
+            stacks[tasks[i].name] = uxTaskGetStackHighWaterMark(tasks[i].handle);
         }
     }
 
-    String currentJson;
-    serializeJson(doc, currentJson);
+    JsonObject latency = doc["latency"].to<JsonObject>();
+    addLatencySummary(latency["controlLoop"].to<JsonObject>(), controlLoopHistogram.get());
+    addLatencySummary(latency["temperatureRead"].to<JsonObject>(), temperatureReadHistogram.get());
+    addLatencySummary(latency["broadcast"].to<JsonObject>(), broadcastHistogram.get());
+    if (SolarManager::instance != nullptr)
+    {
+        addLatencySummary(latency["triacIsr"].to<JsonObject>(), SolarManager::instance->getIsrHistogram());
+    }
+    if (meter != nullptr)
+    {
+        addLatencySummary(latency["meterRequest"].to<JsonObject>(), meter->getRequestHistogram());
+    }
+
+    String json;
+    serializeJson(doc, json);
+    metricsWs.textAll(json);
+}
+
+/**
+ * Envoi de l'historique complet (trame "history") à un seul client.
+ * Les points sont envoyés sous forme de tableaux [time, value] pour limiter la taille du message,
+ * et lus en place dans les tampons (sans copie intermédiaire).
+ */
+void WebServerManager::sendHistory(uint32_t clientId)
+{
+    if (ws.client(clientId) == nullptr)
+    {
+        return; // Client déconnecté entre temps
+    }
+
+    JsonDocument doc;
+    doc["type"] = "history";
+    doc["seq"] = historySeq;
+
+    {
+        JsonArray tempArray = doc["temperatureHistory"].to<JsonArray>();
+        temperatureHistory.minutes().forEach([&tempArray](const DataPoint &p)
+                                             {
+            JsonArray point = tempArray.add<JsonArray>();
+            point.add(p.timestamp);
+            point.add(p.value); });
+    }
 
-    // Send data if it has changed or if a new client connected
-    if (newClientConnected || currentJson != lastBroadcastedJson)
     {
-        ws.textAll(currentJson);
-        lastBroadcastedJson = currentJson;
-        newClientConnected = false;
+        JsonArray triacArray = doc["triacHistory"].to<JsonArray>();
+        triacHistory.minutes().forEach([&triacArray](const DataPoint &p)
+                                       {
+            JsonArray point = triacArray.add<JsonArray>();
+            point.add(p.timestamp);
+            point.add(p.value); });
     }
+
+    String json;
+    serializeJson(doc, json);
+    ws.text(clientId, json);
 }
 
 // Fonction pour déterminer le Content - Type(MIME type) d'un fichier en fonction de son extension
@@ -4,30 +4,44 @@
 #include <ESPAsyncWebServer.h>
 #include <LittleFS.h>
 #include <ArduinoJson.h>
+#include <string>
+#include <vector>
 #include "sensor.h"
-#include "configManager.h"
+#include "configStore.h"
 #include "mqttManager.h"
 #include "solarManager.h"
 #include "updateManager.h"
-#include "historyManager.h"
+#include "historyTiers.h"
+#include "energyManager.h"
 
 using namespace ArduinoJson;
 
 class WebServerManager
 {
 public:
-    WebServerManager(ConfigManager &configManager, MqttManager &mqttManager, HistoryManager &tempHistory, HistoryManager &triacHist);
+    WebServerManager(ConfigStore &configStore, MqttManager &mqttManager, HistoryTiers &tempHistory, HistoryTiers &triacHist, EnergyManager &energyManager);
     void setupLocalWeb();
     void setupApiRoutes();
     void startServer();
     void broadcastData(float temperature, float triacOpeningPercentage, bool temperatureReached, String newVersion = "");
+    void broadcastHistoryPoint(const DataPoint &temperature, const DataPoint &triac);
+    void broadcastMetrics();
 
 private:
     void addFileRoutes(File dir);
     void handleGetConfig(AsyncWebServerRequest *request);
     void handleReboot(AsyncWebServerRequest *request);
-    void handleGetTemperatureHistory(AsyncWebServerRequest *request);
-    void handleGetTriacHistory(AsyncWebServerRequest *request);
+    void handleGetHistory(AsyncWebServerRequest *request, HistoryTiers &history);
+    void handleGetEnergy(AsyncWebServerRequest *request);
+    void handleGetTriacStats(AsyncWebServerRequest *request);
+    void handleGetMeter(AsyncWebServerRequest *request);
+    void handleGetSolar(AsyncWebServerRequest *request);
+    void handleGetControl(AsyncWebServerRequest *request);
+    void handleGetTemperature(AsyncWebServerRequest *request);
+    void handleGetMetrics(AsyncWebServerRequest *request);
+    void handleGetTrace(AsyncWebServerRequest *request);
+    void handleGetTraceStatus(AsyncWebServerRequest *request);
+    void handleTraceCommand(AsyncWebServerRequest *request, uint8_t *data, size_t len);
     void addCorsHeaders(AsyncWebServerResponse *response);
     void handleSaveWifiSettings(AsyncWebServerRequest *request, uint8_t *data, size_t len);
     void handleSaveMqttSettings(AsyncWebServerRequest *request, uint8_t *data, size_t len);
@@ -35,18 +49,48 @@ private:
     void handleSaveBoilerSettings(AsyncWebServerRequest *request, uint8_t *data, size_t len);
     String getContentType(String filename);
 
-    ConfigManager &configManager;
+    ConfigStore &configStore;
     MqttManager &mqttManager;
-    HistoryManager &temperatureHistory;
-    HistoryManager &triacHistory;
+    HistoryTiers &temperatureHistory;
+    HistoryTiers &triacHistory;
+    EnergyManager &energyManager;
     UpdateManager updateManager;
     AsyncWebServer server;
     AsyncWebSocket ws;
     void onWsEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len);
 
+    // WebSocket /metrics/ws : métriques d'exécution diffusées périodiquement (voir broadcastMetrics)
+    AsyncWebSocket metricsWs;
+
+    // WebSocket sortant des compteurs Shelly Gen2 (le Shelly se connecte à ws://<routeur>/shelly)
+    AsyncWebSocket shellyWs;
+    std::string shellyFrame; // Trame en cours de réception (fragmentée sur plusieurs paquets TCP)
+    void onShellyWsEvent(AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len);
+
+    // Envoi de l'historique complet à un seul client (connexion ou demande de resynchronisation)
+    void sendHistory(uint32_t clientId);
+    void requestHistory(uint32_t clientId);
+
     // Variables to track data changes for WebSocket broadcasting
-    String lastBroadcastedJson;
-    bool newClientConnected;
+    float lastTemperature;
+    float lastTriacOpeningPercentage;
+    bool lastTemperatureReached;
+    String lastFirmwareVersion;
+    int lastRoutedPower;  // Puissance routée (W, arrondie)
+    int lastRoutedEnergy; // Énergie routée du jour (Wh, arrondie)
+
+    // Statistiques d'interruption du triac lors de la dernière requête (calcul des fréquences sur l'intervalle)
+    TriacIsrStats lastIsrStats;
+    unsigned long lastIsrStatsTime;
+    bool hasBroadcasted;
+
+    // Numéro de séquence de l'historique, incrémenté à chaque point ajouté.
+    // Permet au client de détecter un message "append" manqué et de demander une resynchronisation.
+    uint32_t historySeq;
+
+    // Clients en attente de l'historique complet (protégé par wsMutex, alimenté par la tâche async_tcp)
+    std::vector<uint32_t> pendingHistoryClients;
+    SemaphoreHandle_t wsMutex;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,327 @@
+#ifndef NATIVE_ARDUINO_STUB_H
+#define NATIVE_ARDUINO_STUB_H
+
+/**
+ * Substitut du cœur Arduino ESP32 pour l'environnement natif (tests unitaires, bancs de mesure, simulateur).
+ * Seul ce qu'utilisent les modules compilés sur la machine hôte est fourni.
+ *
+ * Le temps est virtuel : micros() / millis() lisent une horloge avancée par les tests ou le simulateur
+ * (stubAdvanceMicros), et par delay() / vTaskDelay(). Les sorties (digitalWrite) sont mémorisées et les
+ * interruptions attachées (attachInterrupt, timerAttachInterrupt) peuvent être déclenchées par le test.
+ */
+
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <algorithm>
+#include <string>
+#include "stubClock.h"
+// Comme le cœur ESP32, Arduino.h donne accès à FreeRTOS
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <freertos/queue.h>
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define ARDUINO_ISR_ATTR
+
+#define LOW 0x0
+#define HIGH 0x1
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+
+inline time_t stubTime(time_t *out)
+{
+    time_t now = stubEpochOffset == 0 ? (time_t)(stubMicros / 1000000) : stubEpochOffset + (time_t)(stubMicros / 1000000);
+    if (out != nullptr)
+        *out = now;
+    return now;
+}
+// time() de la libc remplacé par l'heure virtuelle dans les modules compilés (horodatage de l'historique, ...)
+#define time(out) stubTime(out)
+
+inline bool getLocalTime(struct tm *info, uint32_t ms = 5000)
+{
+    time_t now = stubTime(nullptr);
+    if (stubEpochOffset == 0)
+        return false;
+    localtime_r(&now, info);
+    return true;
+}
+
+// --- GPIO et interruptions ---
+
+const int STUB_PIN_COUNT = 40;
+inline int stubPinLevel[STUB_PIN_COUNT];
+inline int stubPinMode[STUB_PIN_COUNT];
+inline uint32_t stubPinWrites[STUB_PIN_COUNT];
+inline void (*stubPinIsr[STUB_PIN_COUNT])();
+
+inline void pinMode(uint8_t pin, uint8_t mode)
+{
+    if (pin < STUB_PIN_COUNT)
+        stubPinMode[pin] = mode;
+}
+inline void digitalWrite(uint8_t pin, uint8_t level)
+{
+    if (pin < STUB_PIN_COUNT)
+    {
+        stubPinLevel[pin] = level;
+        stubPinWrites[pin]++;
+    }
+}
+inline int digitalRead(uint8_t pin) { return pin < STUB_PIN_COUNT ? stubPinLevel[pin] : LOW; }
+inline int digitalPinToInterrupt(uint8_t pin) { return pin; }
+inline void attachInterrupt(int pin, void (*handler)(), int mode)
+{
+    if (pin >= 0 && pin < STUB_PIN_COUNT)
+        stubPinIsr[pin] = handler;
+}
+inline void detachInterrupt(int pin)
+{
+    if (pin >= 0 && pin < STUB_PIN_COUNT)
+        stubPinIsr[pin] = nullptr;
+}
+
+// --- Timer matériel (API Arduino 2.x, utilisée hors interruption) ---
+
+struct hw_timer_s
+{
+    uint8_t group;
+    uint8_t num;
+    void (*isr)();
+};
+typedef struct hw_timer_s hw_timer_t;
+inline hw_timer_t stubTimers[4] = {{0, 0, nullptr}, {1, 0, nullptr}, {0, 1, nullptr}, {1, 1, nullptr}};
+
+inline hw_timer_t *timerBegin(uint8_t num, uint16_t divider, bool countUp) { return num < 4 ? &stubTimers[num] : nullptr; }
+inline void timerAttachInterrupt(hw_timer_t *timer, void (*handler)(), bool edge) { timer->isr = handler; }
+inline void timerDetachInterrupt(hw_timer_t *timer) { timer->isr = nullptr; }
+
+// --- String (sous-ensemble de l'API Arduino) ---
+
+class String
+{
+public:
+    String() {}
+    String(const char *text) : value(text != nullptr ? text : "") {}
+    String(const std::string &text) : value(text) {}
+    String(const String &other) = default;
+    String(String &&other) = default;
+    explicit String(char c) : value(1, c) {}
+    explicit String(int number, unsigned char base = 10) : value(format((long)number, base)) {}
+    explicit String(unsigned int number, unsigned char base = 10) : value(formatUnsigned(number, base)) {}
+    explicit String(long number, unsigned char base = 10) : value(format(number, base)) {}
+    explicit String(unsigned long number, unsigned char base = 10) : value(formatUnsigned(number, base)) {}
+    explicit String(float number, unsigned int decimals = 2) : value(formatFloat(number, decimals)) {}
+    explicit String(double number, unsigned int decimals = 2) : value(formatFloat(number, decimals)) {}
+
+    String &operator=(const String &other) = default;
+    String &operator=(String &&other) = default;
+    String &operator=(const char *text)
+    {
+        value = text != nullptr ? text : "";
+        return *this;
+    }
+
+    const char *c_str() const { return value.c_str(); }
+    unsigned int length() const { return value.size(); }
+    bool isEmpty() const { return value.empty(); }
+    bool reserve(unsigned int size)
+    {
+        value.reserve(size);
+        return true;
+    }
+    char charAt(unsigned int index) const { return index < value.size() ? value[index] : 0; }
+    char operator[](unsigned int index) const { return charAt(index); }
+
+    String &operator+=(const String &other)
+    {
+        value += other.value;
+        return *this;
+    }
+    String &operator+=(const char *text)
+    {
+        value += text != nullptr ? text : "";
+        return *this;
+    }
+    String &operator+=(char c)
+    {
+        value += c;
+        return *this;
+    }
+    String &operator+=(int number) { return *this += String(number); }
+    String &operator+=(unsigned int number) { return *this += String(number); }
+    String &operator+=(long number) { return *this += String(number); }
+    String &operator+=(unsigned long number) { return *this += String(number); }
+    bool concat(const String &other)
+    {
+        value += other.value;
+        return true;
+    }
+    bool concat(const char *text, unsigned int length)
+    {
+        value.append(text, length);
+        return true;
+    }
+
+    bool operator==(const String &other) const { return value == other.value; }
+    bool operator==(const char *text) const { return value == (text != nullptr ? text : ""); }
+    bool operator!=(const String &other) const { return !(*this == other); }
+    bool operator!=(const char *text) const { return !(*this == text); }
+    bool operator<(const String &other) const { return value < other.value; }
+    bool equals(const String &other) const { return *this == other; }
+    bool equalsIgnoreCase(const String &other) const { return strcasecmp(value.c_str(), other.value.c_str()) == 0; }
+    bool startsWith(const String &prefix) const { return value.compare(0, prefix.value.size(), prefix.value) == 0; }
+    bool endsWith(const String &suffix) const
+    {
+        return value.size() >= suffix.value.size() && value.compare(value.size() - suffix.value.size(), suffix.value.size(), suffix.value) == 0;
+    }
+
+    int indexOf(char c, unsigned int from = 0) const { return toIndex(value.find(c, from)); }
+    int indexOf(const String &text, unsigned int from = 0) const { return toIndex(value.find(text.value, from)); }
+    int indexOf(const char *text, unsigned int from = 0) const { return toIndex(value.find(text, from)); }
+    int lastIndexOf(char c) const { return toIndex(value.rfind(c)); }
+    String substring(unsigned int from) const { return from < value.size() ? String(value.substr(from)) : String(); }
+    String substring(unsigned int from, unsigned int to) const
+    {
+        if (from > to)
+            std::swap(from, to);
+        return from < value.size() ? String(value.substr(from, to - from)) : String();
+    }
+
+    long toInt() const { return strtol(value.c_str(), nullptr, 10); }
+    float toFloat() const { return strtof(value.c_str(), nullptr); }
+    double toDouble() const { return strtod(value.c_str(), nullptr); }
+
+    void trim()
+    {
+        size_t start = value.find_first_not_of(" \t\r\n");
+        size_t end = value.find_last_not_of(" \t\r\n");
+        value = start == std::string::npos ? "" : value.substr(start, end - start + 1);
+    }
+    void toLowerCase() { std::transform(value.begin(), value.end(), value.begin(), ::tolower); }
+    void toUpperCase() { std::transform(value.begin(), value.end(), value.begin(), ::toupper); }
+    void replace(const String &from, const String &to)
+    {
+        if (from.value.empty())
+            return;
+        for (size_t pos = value.find(from.value); pos != std::string::npos; pos = value.find(from.value, pos + to.value.size()))
+            value.replace(pos, from.value.size(), to.value);
+    }
+
+private:
+    static int toIndex(size_t position) { return position == std::string::npos ? -1 : (int)position; }
+    static std::string formatUnsigned(unsigned long number, unsigned char base)
+    {
+        char buffer[72];
+        char *p = buffer + sizeof(buffer) - 1;
+        *p = '\0';
+        do
+        {
+            unsigned digit = number % base;
+            *--p = (char)(digit < 10 ? '0' + digit : 'a' + digit - 10);
+            number /= base;
+        } while (number > 0);
+        return p;
+    }
+    static std::string format(long number, unsigned char base)
+    {
+        if (number < 0 && base == 10)
+            return "-" + formatUnsigned((unsigned long)(-number), base);
+        return formatUnsigned((unsigned long)number, base);
+    }
+    static std::string formatFloat(double number, unsigned int decimals)
+    {
+        char buffer[48];
+        snprintf(buffer, sizeof(buffer), "%.*f", decimals, number);
+        return buffer;
+    }
+
+    std::string value;
+};
+
+inline String operator+(const String &left, const String &right)
+{
+    String result(left);
+    result += right;
+    return result;
+}
+inline String operator+(const String &left, const char *right)
+{
+    String result(left);
+    result += right;
+    return result;
+}
+inline String operator+(const char *left, const String &right)
+{
+    String result(left);
+    result += right;
+    return result;
+}
+inline String operator+(const String &left, char right)
+{
+    String result(left);
+    result += right;
+    return result;
+}
+
+// --- Port série : sortie standard ---
+
+class HardwareSerial
+{
+public:
+    void begin(unsigned long baud) {}
+    size_t print(const char *text) { return fputs(text, stdout) < 0 ? 0 : strlen(text); }
+    size_t print(const String &text) { return print(text.c_str()); }
+    size_t print(char c) { return putchar(c) == EOF ? 0 : 1; }
+    size_t print(int number) { return printf("%d", number); }
+    size_t print(unsigned int number) { return printf("%u", number); }
+    size_t print(long number) { return printf("%ld", number); }
+    size_t print(unsigned long number) { return printf("%lu", number); }
+    size_t print(double number, int decimals = 2) { return printf("%.*f", decimals, number); }
+    template <typename T>
+    size_t println(const T &value)
+    {
+        size_t n = print(value);
+        return n + print('\n');
+    }
+    size_t println() { return print('\n'); }
+    size_t printf(const char *format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+        int n = vprintf(format, args);
+        va_end(args);
+        return n < 0 ? 0 : n;
+    }
+};
+inline HardwareSerial Serial;
+
+// --- Puce ---
+
+class EspClass
+{
+public:
+    // Horloge CPU virtuelle à 240 MHz, dérivée de l'horloge virtuelle
+    uint32_t getCycleCount() { return (uint32_t)(stubMicros * 240); }
+    uint32_t getFreeHeap() { return 200 * 1024; }
+    uint32_t getMaxAllocHeap() { return 100 * 1024; }
+    void restart() {}
+};
+inline EspClass ESP;
+
+inline uint32_t getCpuFrequencyMhz() { return 240; }
+
+#endif // NATIVE_ARDUINO_STUB_H
@@ -0,0 +1,158 @@
+#ifndef NATIVE_FS_STUB_H
+#define NATIVE_FS_STUB_H
+
+/**
+ * Substitut de l'API fs::FS / fs::File de l'ESP32 pour l'environnement natif.
+ * Les fichiers sont de vrais fichiers, rangés dans un répertoire temporaire (voir LittleFS.h) :
+ * le comportement (tailles, renommage, lecture d'un fichier en cours d'écriture) est celui d'un système de fichiers réel.
+ */
+
+#include <Arduino.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <memory>
+#include <vector>
+
+namespace fs
+{
+
+// Nombre d'octets acceptés par la prochaine écriture (-1 : pas de limite), pour simuler une écriture partielle
+inline long stubNextWriteLimit = -1;
+
+class File
+{
+public:
+    File() {}
+
+    // Ouvre le fichier ou le répertoire `hostPath`, désigné par `path` sur la partition
+    static File open(const std::string &hostPath, const std::string &path, const char *mode)
+    {
+        struct stat info;
+        bool exists = stat(hostPath.c_str(), &info) == 0;
+        if (exists && S_ISDIR(info.st_mode))
+        {
+            DIR *dir = opendir(hostPath.c_str());
+            return dir == nullptr ? File() : File(std::make_shared<Handle>(nullptr, dir, hostPath, path));
+        }
+        // "w" tronque, "a" ajoute, "r" lit : les fichiers sont ouverts en lecture/écriture comme sur LittleFS
+        const char *hostMode = mode[0] == 'w' ? "w+b" : mode[0] == 'a' ? "a+b" : "rb";
+        if (!exists && mode[0] == 'r')
+            return File();
+        FILE *file = fopen(hostPath.c_str(), hostMode);
+        return file == nullptr ? File() : File(std::make_shared<Handle>(file, nullptr, hostPath, path));
+    }
+
+    explicit operator bool() const { return handle != nullptr; }
+
+    size_t write(const uint8_t *data, size_t size)
+    {
+        if (!handle || handle->file == nullptr)
+            return 0;
+        if (stubNextWriteLimit >= 0)
+        {
+            size = std::min(size, (size_t)stubNextWriteLimit);
+            stubNextWriteLimit = -1;
+        }
+        return fwrite(data, 1, size, handle->file);
+    }
+    size_t write(uint8_t c) { return write(&c, 1); }
+
+    size_t read(uint8_t *data, size_t size)
+    {
+        if (!handle || handle->file == nullptr)
+            return 0;
+        return fread(data, 1, size, handle->file);
+    }
+    int read()
+    {
+        uint8_t c;
+        return read(&c, 1) == 1 ? c : -1;
+    }
+    int available()
+    {
+        return handle && handle->file != nullptr ? (int)(size() - position()) : 0;
+    }
+
+    bool seek(uint32_t position)
+    {
+        return handle && handle->file != nullptr && fseek(handle->file, position, SEEK_SET) == 0 && position <= size();
+    }
+    size_t position() const { return handle && handle->file != nullptr ? (size_t)ftell(handle->file) : 0; }
+    size_t size() const
+    {
+        if (!handle || handle->file == nullptr)
+            return 0;
+        fflush(handle->file);
+        struct stat info;
+        return fstat(fileno(handle->file), &info) == 0 ? (size_t)info.st_size : 0;
+    }
+    void flush()
+    {
+        if (handle && handle->file != nullptr)
+            fflush(handle->file);
+    }
+    size_t printf(const char *format, ...)
+    {
+        if (!handle || handle->file == nullptr)
+            return 0;
+        va_list args;
+        va_start(args, format);
+        int n = vfprintf(handle->file, format, args);
+        va_end(args);
+        return n < 0 ? 0 : n;
+    }
+
+    void close() { handle.reset(); }
+
+    const char *path() const { return handle ? handle->path.c_str() : ""; }
+    const char *name() const
+    {
+        if (!handle)
+            return "";
+        size_t slash = handle->path.rfind('/');
+        return handle->path.c_str() + (slash == std::string::npos ? 0 : slash + 1);
+    }
+    bool isDirectory() const { return handle && handle->dir != nullptr; }
+
+    File openNextFile(const char *mode = "r")
+    {
+        if (!handle || handle->dir == nullptr)
+            return File();
+        while (struct dirent *entry = readdir(handle->dir))
+        {
+            if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+                continue;
+            std::string separator = handle->path == "/" ? "" : "/";
+            return open(handle->hostPath + "/" + entry->d_name, handle->path + separator + entry->d_name, mode);
+        }
+        return File();
+    }
+
+private:
+    struct Handle
+    {
+        FILE *file;
+        DIR *dir;
+        std::string hostPath;
+        std::string path;
+
+        Handle(FILE *file, DIR *dir, const std::string &hostPath, const std::string &path) : file(file), dir(dir), hostPath(hostPath), path(path) {}
+        ~Handle()
+        {
+            if (file != nullptr)
+                fclose(file);
+            if (dir != nullptr)
+                closedir(dir);
+        }
+    };
+
+    explicit File(std::shared_ptr<Handle> handle) : handle(std::move(handle)) {}
+
+    std::shared_ptr<Handle> handle;
+};
+
+} // namespace fs
+
+using fs::File;
+
+#endif // NATIVE_FS_STUB_H
@@ -0,0 +1,62 @@
+#ifndef NATIVE_HTTPCLIENT_STUB_H
+#define NATIVE_HTTPCLIENT_STUB_H
+
+#include <Arduino.h>
+#include <functional>
+#include <WiFiClient.h>
+
+#define HTTP_CODE_OK 200
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_READ_TIMEOUT (-11)
+
+// Réponse d'un serveur simulé à une requête GET
+struct StubHttpResponse
+{
+    int code;           // Code HTTP, ou code d'erreur HTTPC_ERROR_* (aucun corps)
+    std::string body;   // Corps de la réponse
+    uint32_t latencyMs; // Durée de la requête, ajoutée à l'horloge virtuelle
+    bool chunked;       // Longueur non annoncée (getSize() = -1), connexion fermée par le serveur en fin de réponse
+    size_t truncate;    // Si non nul, nombre d'octets effectivement reçus (réponse interrompue)
+};
+
+// Serveur simulé : renvoie la réponse à l'URL demandée (connexion refusée si non défini)
+inline std::function<StubHttpResponse(const String &url)> stubHttpHandler;
+
+class HTTPClient
+{
+public:
+    void setReuse(bool reuse) {}
+    void setConnectTimeout(int32_t timeout) {}
+    void setTimeout(uint16_t timeout) {}
+
+    bool begin(WiFiClient &client, const String &url)
+    {
+        this->client = &client;
+        this->url = url;
+        return true;
+    }
+
+    int GET()
+    {
+        StubHttpResponse response = stubHttpHandler ? stubHttpHandler(url) : StubHttpResponse{HTTPC_ERROR_CONNECTION_REFUSED, "", 0, false, 0};
+        delay(response.latencyMs);
+        size = response.chunked ? -1 : (int)response.body.size();
+        if (response.code > 0)
+        {
+            std::string received = response.truncate != 0 ? response.body.substr(0, response.truncate) : response.body;
+            client->stubLoad(received, 64, response.truncate != 0 || response.chunked);
+        }
+        return response.code;
+    }
+
+    int getSize() { return size; }
+    WiFiClient *getStreamPtr() { return client; }
+    void end() {}
+
+private:
+    WiFiClient *client = nullptr;
+    String url;
+    int size = -1;
+};
+
+#endif // NATIVE_HTTPCLIENT_STUB_H
@@ -0,0 +1,90 @@
+#ifndef NATIVE_LITTLEFS_STUB_H
+#define NATIVE_LITTLEFS_STUB_H
+
+#include <FS.h>
+#include <ftw.h>
+#include <unistd.h>
+
+/**
+ * Partition LittleFS simulée dans un répertoire temporaire de la machine hôte.
+ * Taille annoncée : celle de la partition "spiffs" de partition-esp32.csv (384 Ko).
+ */
+class LittleFSFS
+{
+public:
+    bool begin(bool formatOnFail = false)
+    {
+        mounted = true;
+        return true;
+    }
+    void end() { mounted = false; }
+
+    File open(const String &path, const char *mode = "r") { return open(path.c_str(), mode); }
+    File open(const char *path, const char *mode = "r")
+    {
+        if (!mounted)
+            return File();
+        return File::open(hostPath(path), path, mode);
+    }
+    bool exists(const String &path) { return exists(path.c_str()); }
+    bool exists(const char *path)
+    {
+        struct stat info;
+        return mounted && stat(hostPath(path).c_str(), &info) == 0;
+    }
+    bool mkdir(const String &path) { return mounted && ::mkdir(hostPath(path.c_str()).c_str(), 0755) == 0; }
+    bool remove(const String &path) { return mounted && ::unlink(hostPath(path.c_str()).c_str()) == 0; }
+    bool rmdir(const String &path) { return mounted && ::rmdir(hostPath(path.c_str()).c_str()) == 0; }
+    bool rename(const String &from, const String &to)
+    {
+        return mounted && ::rename(hostPath(from.c_str()).c_str(), hostPath(to.c_str()).c_str()) == 0;
+    }
+
+    size_t totalBytes() { return 0x60000; }
+    size_t usedBytes()
+    {
+        used = 0;
+        nftw(root().c_str(), countBytes, 8, FTW_PHYS);
+        return used;
+    }
+
+    // Efface le contenu de la partition (début de test)
+    void format()
+    {
+        nftw(root().c_str(), removeEntry, 8, FTW_DEPTH | FTW_PHYS);
+        ::mkdir(root().c_str(), 0755);
+    }
+
+    const std::string &root()
+    {
+        if (rootPath.empty())
+        {
+            char pattern[] = "/tmp/littlefs-XXXXXX";
+            rootPath = mkdtemp(pattern);
+        }
+        return rootPath;
+    }
+
+private:
+    std::string hostPath(const char *path) { return root() + (path[0] == '/' ? "" : "/") + path; }
+
+    static int countBytes(const char *path, const struct stat *info, int type, struct FTW *ftw)
+    {
+        if (type == FTW_F)
+            used += info->st_size;
+        return 0;
+    }
+    static int removeEntry(const char *path, const struct stat *info, int type, struct FTW *ftw)
+    {
+        ::remove(path);
+        return 0;
+    }
+
+    bool mounted = true;
+    std::string rootPath;
+    static inline size_t used = 0;
+};
+
+inline LittleFSFS LittleFS;
+
+#endif // NATIVE_LITTLEFS_STUB_H
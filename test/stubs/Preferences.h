@@ -0,0 +1,105 @@
+#ifndef NATIVE_PREFERENCES_STUB_H
+#define NATIVE_PREFERENCES_STUB_H
+
+#include <Arduino.h>
+#include <map>
+#include <vector>
+
+/**
+ * Substitut de la NVS : chaque espace de noms est un dictionnaire en mémoire, partagé par toutes les instances
+ * (comme la NVS, les valeurs survivent à un nouvel objet Preferences). stubPreferencesReset() efface tout.
+ */
+class Preferences
+{
+    typedef std::map<std::string, std::vector<uint8_t>> Namespace;
+
+public:
+    bool begin(const char *name, bool readOnly = false)
+    {
+        current = &storage()[name];
+        this->readOnly = readOnly;
+        return true;
+    }
+    void end() { current = nullptr; }
+    bool clear()
+    {
+        if (current == nullptr || readOnly)
+            return false;
+        current->clear();
+        return true;
+    }
+    bool remove(const char *key) { return current != nullptr && !readOnly && current->erase(key) > 0; }
+    bool isKey(const char *key) { return current != nullptr && current->count(key) > 0; }
+
+    size_t putBytes(const char *key, const void *value, size_t length)
+    {
+        if (current == nullptr || readOnly)
+            return 0;
+        const uint8_t *bytes = static_cast<const uint8_t *>(value);
+        (*current)[key].assign(bytes, bytes + length);
+        return length;
+    }
+    size_t getBytesLength(const char *key)
+    {
+        const std::vector<uint8_t> *value = find(key);
+        return value == nullptr ? 0 : value->size();
+    }
+    size_t getBytes(const char *key, void *buffer, size_t length)
+    {
+        const std::vector<uint8_t> *value = find(key);
+        if (value == nullptr || value->size() > length)
+            return 0;
+        memcpy(buffer, value->data(), value->size());
+        return value->size();
+    }
+
+    size_t putBool(const char *key, bool value) { return put(key, value); }
+    size_t putInt(const char *key, int32_t value) { return put(key, value); }
+    size_t putUInt(const char *key, uint32_t value) { return put(key, value); }
+    size_t putFloat(const char *key, float value) { return put(key, value); }
+    size_t putString(const char *key, const String &value) { return putBytes(key, value.c_str(), value.length()); }
+
+    bool getBool(const char *key, bool defaultValue = false) { return get(key, defaultValue); }
+    int32_t getInt(const char *key, int32_t defaultValue = 0) { return get(key, defaultValue); }
+    uint32_t getUInt(const char *key, uint32_t defaultValue = 0) { return get(key, defaultValue); }
+    float getFloat(const char *key, float defaultValue = NAN) { return get(key, defaultValue); }
+    String getString(const char *key, const String &defaultValue = String())
+    {
+        const std::vector<uint8_t> *value = find(key);
+        return value == nullptr ? defaultValue : String(std::string(value->begin(), value->end()));
+    }
+
+private:
+    static std::map<std::string, Namespace> &storage()
+    {
+        static std::map<std::string, Namespace> namespaces;
+        return namespaces;
+    }
+    friend void stubPreferencesReset();
+
+    const std::vector<uint8_t> *find(const char *key)
+    {
+        if (current == nullptr)
+            return nullptr;
+        auto it = current->find(key);
+        return it == current->end() ? nullptr : &it->second;
+    }
+    template <typename T>
+    size_t put(const char *key, T value)
+    {
+        return putBytes(key, &value, sizeof(value));
+    }
+    template <typename T>
+    T get(const char *key, T defaultValue)
+    {
+        T value;
+        return getBytesLength(key) == sizeof(T) && getBytes(key, &value, sizeof(T)) == sizeof(T) ? value : defaultValue;
+    }
+
+    Namespace *current = nullptr;
+    bool readOnly = false;
+};
+
+inline void stubPreferencesReset() { Preferences::storage().clear(); }
+
+#endif // NATIVE_PREFERENCES_STUB_H
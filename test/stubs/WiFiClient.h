@@ -0,0 +1,48 @@
+#ifndef NATIVE_WIFICLIENT_STUB_H
+#define NATIVE_WIFICLIENT_STUB_H
+
+#include <Arduino.h>
+
+/**
+ * Connexion TCP simulée : le corps de la réponse HTTP (voir HTTPClient.h) est lu depuis `body`,
+ * par tranches de `chunkSize` octets au plus par appel à available() pour reproduire une réception fragmentée.
+ */
+class WiFiClient
+{
+public:
+    // Connexion fermée par le serveur une fois la réponse interrompue entièrement lue
+    bool connected() { return open && !(closeAfter && offset >= body.size()); }
+    void stop()
+    {
+        open = false;
+        body.clear();
+        offset = 0;
+    }
+    int available() { return (int)std::min(body.size() - offset, chunkSize); }
+    int read(uint8_t *buffer, size_t size)
+    {
+        size_t n = std::min(size, body.size() - offset);
+        memcpy(buffer, body.data() + offset, n);
+        offset += n;
+        return (int)n;
+    }
+
+    // Réponse en cours de lecture (HTTPClient)
+    void stubLoad(const std::string &response, size_t chunk, bool close)
+    {
+        open = true;
+        closeAfter = close;
+        body = response;
+        offset = 0;
+        chunkSize = chunk == 0 ? response.size() : chunk;
+    }
+
+private:
+    bool open = false;
+    std::string body;
+    size_t offset = 0;
+    size_t chunkSize = 0;
+    bool closeAfter = false;
+};
+
+#endif // NATIVE_WIFICLIENT_STUB_H
@@ -0,0 +1,9 @@
+#ifndef NATIVE_ESP_TIMER_STUB_H
+#define NATIVE_ESP_TIMER_STUB_H
+
+#include <Arduino.h>
+
+// Horloge système (µs depuis le démarrage) : l'horloge virtuelle
+inline int64_t esp_timer_get_time() { return (int64_t)stubMicros; }
+
+#endif // NATIVE_ESP_TIMER_STUB_H
@@ -0,0 +1,35 @@
+#ifndef NATIVE_FREERTOS_STUB_H
+#define NATIVE_FREERTOS_STUB_H
+
+/**
+ * Substitut de FreeRTOS pour l'environnement natif.
+ * Par défaut aucune tâche n'est réellement exécutée : les tests déroulent les traitements pas à pas sur
+ * l'horloge virtuelle (Arduino.h), les attentes avancent cette horloge et les files ne bloquent pas.
+ * Le simulateur exécute les tâches avec l'ordonnanceur coopératif de task.h.
+ * Les sémaphores sont de vrais mutex, les tests multi-threads peuvent donc les utiliser.
+ */
+
+#include "../stubClock.h"
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+#define portMAX_DELAY ((TickType_t)0xFFFFFFFF)
+#define portTICK_PERIOD_MS 1
+#define configTICK_RATE_HZ 1000
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define tskNO_AFFINITY 0x7FFFFFFF
+
+#ifndef configGENERATE_RUN_TIME_STATS
+#define configGENERATE_RUN_TIME_STATS 0
+#endif
+#ifndef configUSE_TRACE_FACILITY
+#define configUSE_TRACE_FACILITY 0
+#endif
+
+#endif // NATIVE_FREERTOS_STUB_H
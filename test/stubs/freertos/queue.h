@@ -0,0 +1,63 @@
+#ifndef NATIVE_FREERTOS_QUEUE_STUB_H
+#define NATIVE_FREERTOS_QUEUE_STUB_H
+
+#include <string.h>
+#include <mutex>
+#include <vector>
+#include "FreeRTOS.h"
+#include "task.h"
+
+/**
+ * File de taille fixe, allouée à la création comme sous FreeRTOS. L'envoi est refusé si la file est pleine.
+ * La réception attend un élément (au plus `timeout`) dans une tâche ordonnancée par le simulateur,
+ * et échoue immédiatement si la file est vide ailleurs.
+ */
+struct StubQueue
+{
+    size_t length;
+    size_t itemSize;
+    std::vector<uint8_t> storage;
+    size_t head;
+    size_t count;
+    std::mutex mutex;
+
+    StubQueue(size_t length, size_t itemSize) : length(length), itemSize(itemSize), storage(length * itemSize), head(0), count(0) {}
+};
+typedef StubQueue *QueueHandle_t;
+
+inline QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) { return new StubQueue(length, itemSize); }
+inline void vQueueDelete(QueueHandle_t queue) { delete queue; }
+
+inline BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t timeout)
+{
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    if (queue->count >= queue->length)
+        return pdFALSE;
+    memcpy(&queue->storage[((queue->head + queue->count) % queue->length) * queue->itemSize], item, queue->itemSize);
+    queue->count++;
+    return pdTRUE;
+}
+
+inline UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    return queue->count;
+}
+
+inline BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t timeout)
+{
+    if (timeout > 0 && uxQueueMessagesWaiting(queue) == 0)
+    {
+        uint64_t until = timeout == portMAX_DELAY ? UINT64_MAX : stubMicros + (uint64_t)timeout * 1000;
+        stubTaskBlock(until, [queue] { return uxQueueMessagesWaiting(queue) > 0; });
+    }
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    if (queue->count == 0)
+        return pdFALSE;
+    memcpy(item, &queue->storage[queue->head * queue->itemSize], queue->itemSize);
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    return pdTRUE;
+}
+
+#endif // NATIVE_FREERTOS_QUEUE_STUB_H
@@ -0,0 +1,28 @@
+#ifndef NATIVE_FREERTOS_SEMPHR_STUB_H
+#define NATIVE_FREERTOS_SEMPHR_STUB_H
+
+#include <mutex>
+#include "FreeRTOS.h"
+
+typedef std::timed_mutex *SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateMutex() { return new std::timed_mutex(); }
+inline void vSemaphoreDelete(SemaphoreHandle_t semaphore) { delete semaphore; }
+
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t timeout)
+{
+    if (timeout == portMAX_DELAY)
+    {
+        semaphore->lock();
+        return pdTRUE;
+    }
+    return semaphore->try_lock_for(std::chrono::milliseconds(timeout)) ? pdTRUE : pdFALSE;
+}
+
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+    semaphore->unlock();
+    return pdTRUE;
+}
+
+#endif // NATIVE_FREERTOS_SEMPHR_STUB_H
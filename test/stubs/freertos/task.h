@@ -0,0 +1,218 @@
+#ifndef NATIVE_FREERTOS_TASK_STUB_H
+#define NATIVE_FREERTOS_TASK_STUB_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "FreeRTOS.h"
+
+typedef void (*TaskFunction_t)(void *);
+
+/**
+ * Tâches.
+ * Par défaut une tâche créée est seulement déclarée : le test appelle lui-même le traitement.
+ *
+ * Après stubSchedulerStart() (simulateur), les tâches créées sont exécutées par un ordonnanceur coopératif
+ * sur l'horloge virtuelle. Chaque tâche a son propre thread, mais une seule s'exécute à la fois, jusqu'à ce
+ * qu'elle se bloque (vTaskDelay, delay, xQueueReceive avec attente) ; son exécution ne consomme pas de temps
+ * virtuel. Le simulateur avance l'horloge jusqu'au prochain événement (interruption simulée ou réveil d'une
+ * tâche : stubNextTaskWake) puis exécute les tâches prêtes (stubRunReadyTasks), par priorité décroissante.
+ * Les tâches ne sont pas préemptées : une tâche qui se bloque en tenant un sémaphore bloquerait la simulation.
+ */
+struct StubTask
+{
+    TaskFunction_t function;
+    const char *name;
+    void *parameter;
+    UBaseType_t priority;
+
+    // Ordonnancement (simulateur)
+    std::thread thread;
+    std::condition_variable elected; // Signalé quand l'ordonnanceur donne la main à la tâche
+    uint64_t wakeAt;                 // Échéance de l'attente en cours, UINT64_MAX sans échéance
+    std::function<bool()> ready;     // Condition de réveil anticipé (file non vide), vide pour une simple attente
+    bool finished;                   // Fonction de la tâche terminée (vTaskDelete) ou simulation arrêtée
+    uint32_t runs;                   // Nombre de réveils de la tâche
+
+    StubTask(TaskFunction_t function, const char *name, void *parameter, UBaseType_t priority)
+        : function(function), name(name), parameter(parameter), priority(priority), wakeAt(UINT64_MAX), finished(false), runs(0)
+    {
+    }
+};
+typedef StubTask *TaskHandle_t;
+
+// Levée dans une tâche ordonnancée pour l'arrêter (vTaskDelete(nullptr), fin de simulation)
+struct StubTaskExit
+{
+};
+
+inline bool stubSchedulerActive = false;
+inline bool stubSchedulerStopping = false;
+inline std::vector<StubTask *> stubScheduledTasks;
+inline std::mutex stubSchedulerMutex;
+inline std::condition_variable stubSchedulerCondition;   // Signalé quand la tâche en cours rend la main
+inline StubTask *stubRunningTask = nullptr;              // Tâche en cours d'exécution, nullptr : le simulateur a la main
+inline thread_local StubTask *stubCurrentTask = nullptr; // Tâche exécutée par ce thread
+
+// Rend la main au simulateur jusqu'à la prochaine élection de `task`
+inline void stubTaskSwitchOut(StubTask *task)
+{
+    std::unique_lock<std::mutex> lock(stubSchedulerMutex);
+    stubRunningTask = nullptr;
+    stubSchedulerCondition.notify_one();
+    task->elected.wait(lock, [task] { return stubRunningTask == task; });
+    if (stubSchedulerStopping)
+        throw StubTaskExit();
+}
+
+/**
+ * Bloque la tâche courante jusqu'à l'instant `until` ou jusqu'à ce que `ready` soit vraie.
+ * @return false hors d'une tâche ordonnancée (aucune attente)
+ */
+inline bool stubTaskBlock(uint64_t until, std::function<bool()> ready)
+{
+    StubTask *task = stubCurrentTask;
+    if (task == nullptr)
+        return false;
+    task->wakeAt = until;
+    task->ready = std::move(ready);
+    stubTaskSwitchOut(task);
+    return true;
+}
+
+inline bool stubTaskSleep(uint64_t until) { return stubTaskBlock(until, nullptr); }
+
+inline bool stubTaskRunnable(const StubTask *task) { return !task->finished && (stubMicros >= task->wakeAt || (task->ready && task->ready())); }
+
+inline void stubTaskEntry(StubTask *task)
+{
+    stubCurrentTask = task;
+    try
+    {
+        std::unique_lock<std::mutex> lock(stubSchedulerMutex);
+        task->elected.wait(lock, [task] { return stubRunningTask == task; });
+        lock.unlock();
+        if (!stubSchedulerStopping)
+            task->function(task->parameter);
+    }
+    catch (const StubTaskExit &)
+    {
+    }
+    std::lock_guard<std::mutex> lock(stubSchedulerMutex);
+    task->finished = true;
+    stubRunningTask = nullptr;
+    stubSchedulerCondition.notify_one();
+}
+
+// Les tâches créées à partir de maintenant sont exécutées par l'ordonnanceur
+inline void stubSchedulerStart()
+{
+    stubSchedulerActive = true;
+    stubSleepHook = stubTaskSleep;
+}
+
+// Instant du prochain réveil d'une tâche en attente, UINT64_MAX si aucune
+inline uint64_t stubNextTaskWake()
+{
+    uint64_t next = UINT64_MAX;
+    for (const StubTask *task : stubScheduledTasks)
+    {
+        if (!task->finished && task->wakeAt < next)
+            next = task->wakeAt;
+    }
+    return next;
+}
+
+// Exécute les tâches prêtes à l'instant courant, par priorité décroissante, jusqu'à ce qu'elles soient toutes bloquées
+inline void stubRunReadyTasks()
+{
+    for (;;)
+    {
+        StubTask *next = nullptr;
+        for (StubTask *task : stubScheduledTasks)
+        {
+            if (stubTaskRunnable(task) && (next == nullptr || task->priority > next->priority))
+                next = task;
+        }
+        if (next == nullptr)
+            return;
+        next->wakeAt = UINT64_MAX;
+        next->ready = nullptr;
+        next->runs++;
+
+        std::unique_lock<std::mutex> lock(stubSchedulerMutex);
+        stubRunningTask = next;
+        next->elected.notify_one();
+        stubSchedulerCondition.wait(lock, [] { return stubRunningTask == nullptr; });
+    }
+}
+
+// Arrête les tâches ordonnancées (exception StubTaskExit levée depuis leur attente) et revient au mode par défaut
+inline void stubSchedulerStop()
+{
+    stubSchedulerStopping = true;
+    for (StubTask *task : stubScheduledTasks)
+    {
+        {
+            std::unique_lock<std::mutex> lock(stubSchedulerMutex);
+            if (!task->finished)
+            {
+                stubRunningTask = task;
+                task->elected.notify_one();
+                stubSchedulerCondition.wait(lock, [] { return stubRunningTask == nullptr; });
+            }
+        }
+        task->thread.join();
+        delete task;
+    }
+    stubScheduledTasks.clear();
+    stubSchedulerStopping = false;
+    stubSchedulerActive = false;
+    stubSleepHook = nullptr;
+}
+
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stackDepth, void *parameter,
+                                          UBaseType_t priority, TaskHandle_t *handle, BaseType_t core)
+{
+    TaskHandle_t task = new StubTask(function, name, parameter, priority);
+    if (stubSchedulerActive)
+    {
+        // Prête à s'exécuter au prochain passage de l'ordonnanceur
+        task->wakeAt = stubMicros;
+        stubScheduledTasks.push_back(task);
+        task->thread = std::thread(stubTaskEntry, task);
+    }
+    if (handle != nullptr)
+        *handle = task;
+    return pdPASS;
+}
+
+inline BaseType_t xTaskCreate(TaskFunction_t function, const char *name, uint32_t stackDepth, void *parameter, UBaseType_t priority,
+                              TaskHandle_t *handle)
+{
+    return xTaskCreatePinnedToCore(function, name, stackDepth, parameter, priority, handle, tskNO_AFFINITY);
+}
+
+inline void vTaskDelete(TaskHandle_t task)
+{
+    if (task == nullptr && stubCurrentTask != nullptr)
+        throw StubTaskExit();
+}
+inline TickType_t xTaskGetTickCount() { return (TickType_t)millis(); }
+inline void vTaskDelay(TickType_t ticks) { delay(ticks); }
+
+inline void vTaskDelayUntil(TickType_t *previousWake, TickType_t period)
+{
+    TickType_t wake = *previousWake + period;
+    TickType_t now = xTaskGetTickCount();
+    if ((int32_t)(wake - now) > 0)
+        delay(wake - now);
+    *previousWake = wake;
+}
+
+inline UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) { return 0; }
+inline const char *pcTaskGetName(TaskHandle_t task) { return task != nullptr ? task->name : ""; }
+
+#endif // NATIVE_FREERTOS_TASK_STUB_H
@@ -0,0 +1,8 @@
+#ifndef NATIVE_CPU_HAL_STUB_H
+#define NATIVE_CPU_HAL_STUB_H
+
+#include <Arduino.h>
+
+inline uint32_t cpu_hal_get_cycle_count() { return ESP.getCycleCount(); }
+
+#endif // NATIVE_CPU_HAL_STUB_H
@@ -0,0 +1,9 @@
+#ifndef NATIVE_GPIO_LL_STUB_H
+#define NATIVE_GPIO_LL_STUB_H
+
+#include <Arduino.h>
+#include <soc/gpio_struct.h>
+
+inline void gpio_ll_set_level(gpio_dev_t *hw, gpio_num_t pin, uint32_t level) { digitalWrite((uint8_t)pin, level ? HIGH : LOW); }
+
+#endif // NATIVE_GPIO_LL_STUB_H
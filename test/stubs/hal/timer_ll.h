@@ -0,0 +1,47 @@
+#ifndef NATIVE_TIMER_LL_STUB_H
+#define NATIVE_TIMER_LL_STUB_H
+
+#include <Arduino.h>
+#include <soc/timer_group_struct.h>
+
+inline void timer_ll_set_counter_value(timg_dev_t *hw, timer_idx_t num, uint64_t value)
+{
+    hw->hw_timer[num].loadValue = value;
+    hw->hw_timer[num].loadMicros = stubMicros;
+}
+
+inline void timer_ll_set_alarm_value(timg_dev_t *hw, timer_idx_t num, uint64_t alarm) { hw->hw_timer[num].alarm = alarm; }
+
+inline void timer_ll_set_alarm_enable(timg_dev_t *hw, timer_idx_t num, bool enable) { hw->hw_timer[num].alarmEnabled = enable; }
+
+/**
+ * Instant (horloge virtuelle, µs) de la prochaine alarme du timer, UINT64_MAX si aucune alarme n'est armée.
+ * Une alarme déjà dépassée se déclenche immédiatement, comme sur le matériel.
+ */
+inline uint64_t stubTimerAlarmAt(timg_dev_t *hw, timer_idx_t num)
+{
+    const StubHwTimer &timer = hw->hw_timer[num];
+    if (!timer.alarmEnabled)
+        return UINT64_MAX;
+    uint64_t at = timer.loadMicros + (timer.alarm > timer.loadValue ? timer.alarm - timer.loadValue : 0);
+    return at < stubMicros ? stubMicros : at;
+}
+
+/**
+ * Déclenche l'interruption du timer matériel `timer` si son alarme est échue.
+ * L'alarme est désarmée avant l'appel (pas de rechargement automatique).
+ * @return true si l'interruption a été exécutée
+ */
+inline bool stubTimerFire(hw_timer_t *timer)
+{
+    timg_dev_t *hw = timer->group == 0 ? &TIMERG0 : &TIMERG1;
+    timer_idx_t num = (timer_idx_t)timer->num;
+    if (stubTimerAlarmAt(hw, num) > stubMicros)
+        return false;
+    hw->hw_timer[num].alarmEnabled = false;
+    if (timer->isr != nullptr)
+        timer->isr();
+    return true;
+}
+
+#endif // NATIVE_TIMER_LL_STUB_H
@@ -0,0 +1,17 @@
+#ifndef NATIVE_GPIO_STRUCT_STUB_H
+#define NATIVE_GPIO_STRUCT_STUB_H
+
+// Registres GPIO : les niveaux sont ceux de digitalWrite() (Arduino.h)
+typedef struct
+{
+    int unused;
+} gpio_dev_t;
+
+typedef enum
+{
+    GPIO_NUM_0 = 0
+} gpio_num_t;
+
+inline gpio_dev_t GPIO;
+
+#endif // NATIVE_GPIO_STRUCT_STUB_H
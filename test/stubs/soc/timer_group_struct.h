@@ -0,0 +1,34 @@
+#ifndef NATIVE_TIMER_GROUP_STRUCT_STUB_H
+#define NATIVE_TIMER_GROUP_STRUCT_STUB_H
+
+#include <stdint.h>
+
+typedef enum
+{
+    TIMER_0 = 0,
+    TIMER_1 = 1,
+    TIMER_MAX
+} timer_idx_t;
+
+/**
+ * Timer 1 MHz d'un groupe, en mode "one-shot".
+ * Le compteur n'est pas incrémenté : il vaut loadValue + (temps virtuel écoulé depuis loadMicros).
+ * L'alarme arrive donc à loadMicros + alarm - loadValue (voir stubTimerAlarmAt).
+ */
+struct StubHwTimer
+{
+    uint64_t loadValue;
+    uint64_t loadMicros;
+    uint64_t alarm;
+    bool alarmEnabled;
+};
+
+typedef struct
+{
+    StubHwTimer hw_timer[TIMER_MAX];
+} timg_dev_t;
+
+inline timg_dev_t TIMERG0;
+inline timg_dev_t TIMERG1;
+
+#endif // NATIVE_TIMER_GROUP_STRUCT_STUB_H
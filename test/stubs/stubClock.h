@@ -0,0 +1,38 @@
+#ifndef NATIVE_STUB_CLOCK_H
+#define NATIVE_STUB_CLOCK_H
+
+/**
+ * Horloge virtuelle commune aux substituts (Arduino, FreeRTOS, ESP-IDF).
+ * Elle n'avance que sur demande : stubAdvanceMicros(), delay(), vTaskDelay(), ou par le simulateur
+ * qui la fait progresser d'un événement au suivant.
+ */
+
+#include <stdint.h>
+#include <time.h>
+
+inline uint64_t stubMicros = 0;     // Temps écoulé depuis le "démarrage" (µs)
+inline time_t stubEpochOffset = 0;  // Heure = stubEpochOffset + stubMicros / 1e6, 0 = heure non synchronisée
+
+inline void stubAdvanceMicros(uint64_t us) { stubMicros += us; }
+
+// Synchronise l'heure virtuelle (équivalent d'une synchronisation NTP)
+inline void stubSetTime(time_t now) { stubEpochOffset = now - (time_t)(stubMicros / 1000000); }
+
+/**
+ * Attente d'une tâche exécutée par l'ordonnanceur du simulateur (freertos/task.h) jusqu'à l'instant `until`.
+ * Renvoie false hors d'une tâche ordonnancée : l'attente avance alors directement l'horloge.
+ */
+inline bool (*stubSleepHook)(uint64_t until) = nullptr;
+
+inline unsigned long micros() { return (unsigned long)stubMicros; }
+inline unsigned long millis() { return (unsigned long)(stubMicros / 1000); }
+inline void delay(uint32_t ms)
+{
+    uint64_t until = stubMicros + (uint64_t)ms * 1000;
+    if (stubSleepHook == nullptr || !stubSleepHook(until))
+        stubMicros = until;
+}
+inline void delayMicroseconds(uint32_t us) { stubMicros += us; }
+inline void yield() {}
+
+#endif // NATIVE_STUB_CLOCK_H
@@ -0,0 +1,244 @@
+#include <unity.h>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <string>
+#include "historyManager.h"
+#include "jsonScan.h"
+#include "periodSchedule.h"
+#include "regulator.h"
+#include "shellyEm.h"
+#include "timezone.h"
+
+/**
+ * Bancs de mesure des traitements exécutés à chaque mesure ou à chaque demi-période.
+ * Chaque banc affiche la durée par opération (ns, machine hôte : ordre de grandeur relatif uniquement)
+ * et le nombre d'allocations par opération, qui doit rester nul sur les chemins de la régulation.
+ */
+
+static std::atomic<size_t> allocations(0);
+
+void *operator new(size_t size)
+{
+    allocations++;
+    void *p = malloc(size == 0 ? 1 : size);
+    if (p == nullptr)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t size) noexcept { free(p); }
+
+struct BenchResult
+{
+    double nsPerOp;
+    double allocationsPerOp;
+};
+
+// Empêche le compilateur d'éliminer un calcul dont le résultat n'est pas utilisé
+static volatile float sink;
+
+template <typename Operation>
+static BenchResult bench(const char *name, size_t iterations, Operation operation)
+{
+    // Préchauffage (caches, allocations paresseuses)
+    for (size_t i = 0; i < iterations / 10 + 1; i++)
+        operation(i);
+
+    size_t allocationsBefore = allocations.load();
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++)
+        operation(i);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    size_t allocated = allocations.load() - allocationsBefore;
+
+    BenchResult result;
+    result.nsPerOp = std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+    result.allocationsPerOp = (double)allocated / iterations;
+    char line[128];
+    snprintf(line, sizeof(line), "%-40s %10.1f ns/op %8.2f alloc/op", name, result.nsPerOp, result.allocationsPerOp);
+    TEST_MESSAGE(line);
+    return result;
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void bench_regulator_update()
+{
+    Regulator regulator;
+    BenchResult result = bench("Regulator::update", 1000000, [&](size_t i)
+                               { sink = regulator.update(-500.0f + (i % 100), 2000, 1.0f); });
+    TEST_ASSERT_EQUAL_FLOAT(0, result.allocationsPerOp);
+}
+
+void bench_period_schedule()
+{
+    PeriodSchedule schedule;
+    std::vector<Period> periods = {{0, true, false, 0, false, true, PERIOD_AUTO}, {1320, false, false, 360, false, false, PERIOD_ON}};
+    BenchResult lookup = bench("PeriodSchedule::getMode", 1000000, [&](size_t i)
+                               { sink = schedule.getMode(i % MINUTES_PER_DAY); });
+    TEST_ASSERT_EQUAL_FLOAT(0, lookup.allocationsPerOp);
+    BenchResult compile = bench("PeriodSchedule::compile", 10000, [&](size_t i)
+                                { schedule.compile(periods, 400 + i % 60, 1200); });
+    TEST_ASSERT_EQUAL_FLOAT(0, compile.allocationsPerOp);
+}
+
+void bench_history()
+{
+    HistoryManager history(1440, 60);
+    BenchResult add = bench("HistoryManager::add", 1000000, [&](size_t i)
+                            { history.add(DataPoint{(time_t)(1700000000 + i * 60), (float)i}); });
+    TEST_ASSERT_EQUAL_FLOAT(0, add.allocationsPerOp);
+
+    time_t origin = history.oldest();
+    BenchResult query = bench("HistoryManager::nextBucket 1h", 1000, [&](size_t i)
+                              {
+                                  time_t cursor = origin;
+                                  HistoryBucket bucket;
+                                  while (history.nextBucket(cursor, origin, HISTORY_TIME_MAX, 3600, bucket))
+                                      sink = bucket.avg;
+                              });
+    TEST_ASSERT_EQUAL_FLOAT(0, query.allocationsPerOp);
+}
+
+void bench_shelly_notification()
+{
+    ShellyEm meter("192.168.1.10", "1", SHELLY_PRO_3EM);
+    const std::string frame = R"({"src":"shellypro3em-c8f09e8","dst":"router","method":"NotifyStatus","params":{"ts":1700000000.12,)"
+                              R"("em:0":{"id":0,"a_current":2.1,"a_voltage":230.1,"a_act_power":-480.3,"a_aprt_power":483.0,"a_pf":-0.99,)"
+                              R"("b_current":0.3,"b_voltage":231.0,"b_act_power":45.2,"b_aprt_power":60.1,"b_pf":0.75,)"
+                              R"("c_current":0.2,"c_voltage":229.8,"c_act_power":20.7,"c_aprt_power":35.0,"c_pf":0.59,)"
+                              R"("n_current":null,"total_current":2.6,"total_act_power":-414.4,"total_aprt_power":578.1}}})";
+    MeterSample sample;
+    BenchResult result = bench("ShellyEm::handleNotification", 200000, [&](size_t i)
+                               {
+                                   meter.handleNotification((const uint8_t *)frame.data(), frame.size());
+                                   meter.receive(sample, 0);
+                               });
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, -414.4f, sample.power);
+    TEST_ASSERT_EQUAL_FLOAT(0, result.allocationsPerOp);
+}
+
+// Réponses REST des compteurs (Gen1 /emeter/0 et Pro 3EM EM.GetStatus)
+static const char GEN1_RESPONSE[] = R"({"power":-512.37,"pf":-0.96,"current":2.31,"voltage":231.05,"is_valid":true,"total":123456.7,)"
+                                    R"("total_returned":98765.4})";
+static const char PRO3EM_RESPONSE[] = R"({"id":0,"a_current":2.101,"a_voltage":230.1,"a_act_power":-480.3,"a_aprt_power":483.0,"a_pf":-0.99,)"
+                                      R"("a_freq":50.0,"b_current":0.312,"b_voltage":231.0,"b_act_power":45.2,"b_aprt_power":60.1,"b_pf":0.75,)"
+                                      R"("b_freq":50.0,"c_current":0.204,"c_voltage":229.8,"c_act_power":20.7,"c_aprt_power":35.0,"c_pf":0.59,)"
+                                      R"("c_freq":50.0,"n_current":null,"total_current":2.617,"total_act_power":-414.4,"total_aprt_power":578.1,)"
+                                      R"("user_calibrated_phase":[]})";
+
+struct ParsedReading
+{
+    float power;
+    float voltage;
+    float powerFactor;
+    bool valid;
+};
+
+/**
+ * Ancienne lecture (avant jsonScan) : réponse recopiée dans une String par tranches de 64 octets (http.getString()),
+ * puis chaque valeur extraite par indexOf / substring / toFloat.
+ * Sur la machine hôte, String repose sur std::string (petites chaînes sans allocation, comme la String de l'ESP32) :
+ * le nombre d'allocations est du même ordre que sur la cible.
+ */
+static bool legacyParse(const char *response, size_t length, const char *powerKey, const char *voltageKey, const char *pfKey,
+                        ParsedReading &reading)
+{
+    String payload;
+    for (size_t offset = 0; offset < length; offset += 64)
+        payload.concat(response + offset, std::min((size_t)64, length - offset));
+
+    auto number = [&](const char *name, float &value)
+    {
+        String key = String("\"") + name + "\":";
+        int idx = payload.indexOf(key);
+        if (idx == -1)
+            return false;
+        int begin = idx + key.length();
+        int end = payload.indexOf(',', begin);
+        value = payload.substring(begin, end).toFloat();
+        return true;
+    };
+    if (!number(powerKey, reading.power))
+        return false;
+    if (!number(voltageKey, reading.voltage))
+        reading.voltage = NAN;
+    if (!number(pfKey, reading.powerFactor))
+        reading.powerFactor = NAN;
+    reading.valid = payload.indexOf("\"is_valid\":false") == -1 && payload.indexOf("\"errors\":") == -1;
+    return true;
+}
+
+// Lecture actuelle (ShellyEm::poll / parse) : tampon fixe, valeurs lues en place
+static bool scanParse(const char *response, size_t length, const char *powerKey, const char *voltageKey, const char *pfKey,
+                      ParsedReading &reading)
+{
+    static char payload[SHELLY_PAYLOAD_SIZE];
+    memcpy(payload, response, length);
+    if (!jsonScanNumber(payload, length, powerKey, reading.power))
+        return false;
+    if (!jsonScanNumber(payload, length, voltageKey, reading.voltage))
+        reading.voltage = NAN;
+    if (!jsonScanNumber(payload, length, pfKey, reading.powerFactor))
+        reading.powerFactor = NAN;
+    bool isValid = true;
+    jsonScanBool(payload, length, "is_valid", isValid);
+    reading.valid = isValid && jsonScanFind(payload, length, "errors") == nullptr;
+    return true;
+}
+
+static void compareParsers(const char *label, const char *response, const char *powerKey, const char *voltageKey, const char *pfKey)
+{
+    size_t length = strlen(response);
+    ParsedReading legacy = {}, scanned = {};
+    char name[64];
+
+    snprintf(name, sizeof(name), "%s String/indexOf", label);
+    BenchResult before = bench(name, 200000, [&](size_t i)
+                               { legacyParse(response, length, powerKey, voltageKey, pfKey, legacy); });
+    snprintf(name, sizeof(name), "%s jsonScan", label);
+    BenchResult after = bench(name, 200000, [&](size_t i)
+                              { scanParse(response, length, powerKey, voltageKey, pfKey, scanned); });
+
+    // Mêmes valeurs, sans allocation
+    TEST_ASSERT_EQUAL_FLOAT(legacy.power, scanned.power);
+    TEST_ASSERT_EQUAL_FLOAT(legacy.voltage, scanned.voltage);
+    TEST_ASSERT_EQUAL_FLOAT(legacy.powerFactor, scanned.powerFactor);
+    TEST_ASSERT_EQUAL(legacy.valid, scanned.valid);
+    TEST_ASSERT_GREATER_THAN(0, before.allocationsPerOp);
+    TEST_ASSERT_EQUAL_FLOAT(0, after.allocationsPerOp);
+}
+
+void bench_shelly_gen1_response()
+{
+    compareParsers("Gen1 /emeter", GEN1_RESPONSE, "power", "voltage", "pf");
+}
+
+void bench_shelly_pro3em_response()
+{
+    compareParsers("Pro3EM EM.GetStatus", PRO3EM_RESPONSE, "total_act_power", "a_voltage", "a_pf");
+}
+
+void bench_timezone_lookup()
+{
+    // Parcours linéaire de la table : appelé une fois au démarrage, mesuré pour référence
+    bench("getPosixTimezone", 100000, [](size_t i)
+          { sink = getPosixTimezone(i % 2 ? "Pacific/Auckland" : "Unknown/Zone")[0]; });
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(bench_regulator_update);
+    RUN_TEST(bench_period_schedule);
+    RUN_TEST(bench_history);
+    RUN_TEST(bench_shelly_notification);
+    RUN_TEST(bench_shelly_gen1_response);
+    RUN_TEST(bench_shelly_pro3em_response);
+    RUN_TEST(bench_timezone_lookup);
+    return UNITY_END();
+}
@@ -0,0 +1,106 @@
+#include <unity.h>
+#include "configBlob.h"
+
+void setUp() {}
+
+void tearDown() {}
+
+// Section de test : un entier, une chaîne, un flottant
+static ConfigBlobWriter writeSection()
+{
+    ConfigBlobWriter writer;
+    writer.putI32(1883);
+    writer.putString("maison/routeur");
+    writer.putFloat(-30.5f);
+    return writer;
+}
+
+void test_round_trip()
+{
+    ConfigBlobWriter writer = writeSection();
+    writer.putBool(true);
+    writer.putU8(7);
+    const std::vector<uint8_t> &data = writer.getData();
+
+    ConfigBlobReader reader(data.data(), data.size());
+    TEST_ASSERT_EQUAL_INT(1883, reader.getI32(0));
+    TEST_ASSERT_EQUAL_STRING("maison/routeur", reader.getString("").c_str());
+    TEST_ASSERT_EQUAL_FLOAT(-30.5f, reader.getFloat(0));
+    TEST_ASSERT_TRUE(reader.getBool(false));
+    TEST_ASSERT_EQUAL_UINT32(7, reader.getU8(0));
+    TEST_ASSERT_TRUE(reader.isValid());
+}
+
+void test_older_section_loads_defaults()
+{
+    // Section écrite par un schéma plus ancien, sans les champs ajoutés depuis à la fin
+    ConfigBlobWriter writer = writeSection();
+    const std::vector<uint8_t> &data = writer.getData();
+
+    ConfigBlobReader reader(data.data(), data.size());
+    TEST_ASSERT_EQUAL_INT(1883, reader.getI32(0));
+    TEST_ASSERT_EQUAL_STRING("maison/routeur", reader.getString("").c_str());
+    TEST_ASSERT_EQUAL_FLOAT(-30.5f, reader.getFloat(0));
+    TEST_ASSERT_TRUE(reader.getBool(true));
+    TEST_ASSERT_EQUAL_INT(30000, reader.getI32(30000));
+    TEST_ASSERT_EQUAL_STRING("phase", reader.getString("phase").c_str());
+    TEST_ASSERT_TRUE(reader.isValid());
+}
+
+void test_truncated_number_fails()
+{
+    ConfigBlobWriter writer = writeSection();
+    const std::vector<uint8_t> &data = writer.getData();
+
+    // Flottant final coupé après 2 octets
+    ConfigBlobReader reader(data.data(), data.size() - 2);
+    reader.getI32(0);
+    reader.getString("");
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, reader.getFloat(1.0f));
+    TEST_ASSERT_FALSE(reader.isValid());
+}
+
+void test_truncated_string_fails()
+{
+    ConfigBlobWriter writer = writeSection();
+    const std::vector<uint8_t> &data = writer.getData();
+
+    // Chaîne coupée : longueur annoncée au-delà de la fin de la section
+    ConfigBlobReader reader(data.data(), sizeof(int32_t) + sizeof(uint16_t) + 3);
+    TEST_ASSERT_EQUAL_INT(1883, reader.getI32(0));
+    TEST_ASSERT_EQUAL_STRING("défaut", reader.getString("défaut").c_str());
+    TEST_ASSERT_FALSE(reader.isValid());
+    // Les champs suivants prennent leur valeur par défaut
+    TEST_ASSERT_EQUAL_FLOAT(2.0f, reader.getFloat(2.0f));
+}
+
+void test_empty_section_loads_defaults()
+{
+    ConfigBlobReader reader(nullptr, 0);
+    TEST_ASSERT_EQUAL_INT(502, reader.getI32(502));
+    TEST_ASSERT_EQUAL_STRING("shelly", reader.getString("shelly").c_str());
+    TEST_ASSERT_TRUE(reader.isValid());
+}
+
+void test_crc_detects_corruption()
+{
+    ConfigBlobWriter writer = writeSection();
+    std::vector<uint8_t> data = writer.getData();
+    uint32_t crc = configCrc32(data.data(), data.size());
+    data[5] ^= 0x01;
+    TEST_ASSERT_NOT_EQUAL(crc, configCrc32(data.data(), data.size()));
+    // Valeur de contrôle du CRC-32 standard
+    TEST_ASSERT_EQUAL_UINT32(0xCBF43926, configCrc32((const uint8_t *)"123456789", 9));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip);
+    RUN_TEST(test_older_section_loads_defaults);
+    RUN_TEST(test_truncated_number_fails);
+    RUN_TEST(test_truncated_string_fails);
+    RUN_TEST(test_empty_section_loads_defaults);
+    RUN_TEST(test_crc_detects_corruption);
+    return UNITY_END();
+}
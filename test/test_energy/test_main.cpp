@@ -0,0 +1,68 @@
+#include <unity.h>
+#include "energyManager.h"
+
+// 15/03/2024 12:00:00 UTC
+static const time_t MARCH_15 = 1710504000;
+static const time_t DAY = 24 * 3600;
+
+void setUp()
+{
+    setenv("TZ", "UTC0", 1);
+    tzset();
+}
+
+void tearDown() {}
+
+// Soutirage de 3600 W pendant une seconde (1 Wh) à l'instant `now`, après un écart ignoré depuis la mesure précédente
+static void importOneWattHour(EnergyManager &energy, time_t now)
+{
+    stubAdvanceMicros(60 * 1000000ULL);
+    stubSetTime(now);
+    energy.addGridSample(3600);
+    stubAdvanceMicros(1000000);
+    energy.addGridSample(3600);
+}
+
+void test_month_change_keeps_previous_month()
+{
+    EnergyManager energy;
+    importOneWattHour(energy, MARCH_15);
+    importOneWattHour(energy, MARCH_15 + 20 * DAY); // 04/04
+
+    EnergyTotals totals = energy.getTotals();
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, (float)totals.lastMonth.imported);
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, (float)totals.thisMonth.imported);
+}
+
+void test_month_change_after_long_outage_clears_last_month()
+{
+    EnergyManager energy;
+    importOneWattHour(energy, MARCH_15);
+    importOneWattHour(energy, MARCH_15 + 61 * DAY); // 15/05 : avril non compté
+
+    EnergyTotals totals = energy.getTotals();
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, (float)totals.lastMonth.imported);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, (float)totals.yesterday.imported);
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, (float)totals.thisMonth.imported);
+    TEST_ASSERT_EQUAL_FLOAT(2.0f, (float)totals.total.imported);
+}
+
+void test_month_change_across_new_year()
+{
+    EnergyManager energy;
+    importOneWattHour(energy, MARCH_15 - 75 * DAY); // 31/12/2023
+    importOneWattHour(energy, MARCH_15 - 74 * DAY); // 01/01/2024
+
+    EnergyTotals totals = energy.getTotals();
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, (float)totals.lastMonth.imported);
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, (float)totals.yesterday.imported);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_month_change_keeps_previous_month);
+    RUN_TEST(test_month_change_after_long_outage_clears_last_month);
+    RUN_TEST(test_month_change_across_new_year);
+    return UNITY_END();
+}
@@ -0,0 +1,347 @@
+#include <unity.h>
+#include <LittleFS.h>
+#include "historyFormat.h"
+#include "historyManager.h"
+#include "historyStore.h"
+#include "historyTiers.h"
+
+// 14/11/2023 00:00:00 UTC
+static const time_t DAY_START = 1699920000;
+
+void setUp()
+{
+    LittleFS.format();
+    HistoryStore::suspendWrites(false);
+    fs::stubNextWriteLimit = -1;
+}
+
+void tearDown() {}
+
+void test_ram_buckets()
+{
+    HistoryManager history(120, 60);
+    for (int i = 0; i < 10; i++)
+    {
+        history.add(DataPoint{DAY_START + i * 60, (float)i});
+    }
+    TEST_ASSERT_EQUAL(DAY_START, history.oldest());
+
+    // Intervalles de 5 minutes : 0-4 puis 5-9
+    time_t cursor = DAY_START;
+    HistoryBucket bucket;
+    TEST_ASSERT_TRUE(history.nextBucket(cursor, DAY_START, HISTORY_TIME_MAX, 300, bucket));
+    TEST_ASSERT_EQUAL(DAY_START, bucket.start);
+    TEST_ASSERT_EQUAL_UINT32(5, bucket.count);
+    TEST_ASSERT_EQUAL_FLOAT(0, bucket.min);
+    TEST_ASSERT_EQUAL_FLOAT(4, bucket.max);
+    TEST_ASSERT_EQUAL_FLOAT(2, bucket.avg);
+    TEST_ASSERT_TRUE(history.nextBucket(cursor, DAY_START, HISTORY_TIME_MAX, 300, bucket));
+    TEST_ASSERT_EQUAL_FLOAT(7, bucket.avg);
+    TEST_ASSERT_FALSE(history.nextBucket(cursor, DAY_START, HISTORY_TIME_MAX, 300, bucket));
+}
+
+void test_ram_bucket_stops_at_end_of_range()
+{
+    HistoryManager history(120, 60);
+    for (int i = 0; i < 10; i++)
+    {
+        history.add(DataPoint{DAY_START + i * 60, 100});
+    }
+    time_t cursor = DAY_START;
+    HistoryBucket bucket;
+    TEST_ASSERT_TRUE(history.nextBucket(cursor, DAY_START, DAY_START + 180, 3600, bucket));
+    TEST_ASSERT_EQUAL_UINT32(3, bucket.count);
+    // 3 points d'une minute à 100 W : 5 Wh
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 5.0f, bucket.energy);
+    TEST_ASSERT_FALSE(history.nextBucket(cursor, DAY_START, DAY_START + 180, 3600, bucket));
+}
+
+void test_ring_overwrites_oldest_points()
+{
+    HistoryManager history(8, 60);
+    for (int i = 0; i < 20; i++)
+    {
+        history.add(DataPoint{DAY_START + i * 60, (float)i});
+    }
+    TEST_ASSERT_GREATER_OR_EQUAL(DAY_START + 12 * 60, history.oldest());
+    size_t count = history.forEach([](const DataPoint &point) {});
+    TEST_ASSERT_LESS_OR_EQUAL(8, count);
+}
+
+void test_store_flush_and_read_back()
+{
+    HistoryStore store("power", 60, 14);
+    TEST_ASSERT_TRUE(store.begin());
+    for (int i = 0; i < 30; i++)
+    {
+        store.append(DataPoint{DAY_START + i * 60, (float)(i % 3)});
+    }
+    TEST_ASSERT_TRUE(store.flush());
+    TEST_ASSERT_EQUAL(DAY_START, store.oldest());
+    TEST_ASSERT_EQUAL(DAY_START + 29 * 60, store.newest());
+
+    time_t cursor = DAY_START;
+    HistoryBucket bucket;
+    TEST_ASSERT_TRUE(store.nextBucket(cursor, DAY_START, HISTORY_TIME_MAX, 3600, bucket));
+    TEST_ASSERT_EQUAL_UINT32(30, bucket.count);
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, bucket.avg);
+    TEST_ASSERT_EQUAL_FLOAT(2.0f, bucket.max);
+}
+
+void test_store_reopens_segment_after_append()
+{
+    HistoryStore store("power", 60, 14);
+    store.begin();
+    store.append(DataPoint{DAY_START, 1});
+    store.flush();
+
+    // Première lecture : le segment reste ouvert en cache
+    time_t cursor = DAY_START;
+    HistoryBucket bucket;
+    TEST_ASSERT_TRUE(store.nextBucket(cursor, DAY_START, HISTORY_TIME_MAX, 0, bucket));
+    TEST_ASSERT_FALSE(store.nextBucket(cursor, DAY_START, HISTORY_TIME_MAX, 0, bucket));
+
+    // Les points ajoutés depuis doivent être lus, pas ceux de la taille du fichier à l'ouverture
+    store.append(DataPoint{DAY_START + 60, 2});
+    store.flush();
+    TEST_ASSERT_TRUE(store.nextBucket(cursor, DAY_START, HISTORY_TIME_MAX, 0, bucket));
+    TEST_ASSERT_EQUAL(DAY_START + 60, bucket.start);
+    TEST_ASSERT_EQUAL_FLOAT(2.0f, bucket.avg);
+}
+
+void test_store_survives_restart()
+{
+    {
+        HistoryStore store("power", 60, 14);
+        store.begin();
+        store.append(DataPoint{DAY_START, 1});
+        store.append(DataPoint{DAY_START + 86400, 2});
+        store.flush();
+    }
+    HistoryStore store("power", 60, 14);
+    TEST_ASSERT_TRUE(store.begin());
+    TEST_ASSERT_EQUAL(DAY_START, store.oldest());
+    TEST_ASSERT_EQUAL(DAY_START + 86400, store.newest());
+}
+
+void test_ignores_points_before_time_sync()
+{
+    HistoryStore store("power", 60, 14);
+    store.begin();
+    store.append(DataPoint{120, 1});
+    store.flush();
+    TEST_ASSERT_EQUAL(0, store.oldest());
+}
+
+void test_suspended_writes_stay_pending()
+{
+    HistoryStore store("power", 60, 14);
+    store.begin();
+    HistoryStore::suspendWrites(true);
+    store.append(DataPoint{DAY_START, 1});
+    TEST_ASSERT_FALSE(store.flush());
+    TEST_ASSERT_EQUAL(0, store.newest());
+
+    HistoryStore::suspendWrites(false);
+    TEST_ASSERT_TRUE(store.flush());
+    TEST_ASSERT_EQUAL(DAY_START, store.newest());
+}
+
+void test_backup_and_restore()
+{
+    {
+        HistoryStore store("power", 60, 14);
+        store.begin();
+        for (int day = 0; day < 3; day++)
+        {
+            store.append(DataPoint{DAY_START + day * 86400, (float)day});
+        }
+        store.flush();
+    }
+
+    std::vector<HistoryBackupFile> files;
+    // Budget de deux segments : le plus ancien est abandonné
+    size_t size = HistoryStore::backup(files, 2 * sizeof(HistoryRecord));
+    TEST_ASSERT_EQUAL(2 * sizeof(HistoryRecord), size);
+    TEST_ASSERT_EQUAL(2, files.size());
+
+    // Réécriture de la partition
+    LittleFS.format();
+    TEST_ASSERT_TRUE(HistoryStore::restoreBackup(files));
+
+    // L'index n'a pas été copié : il est reconstruit à partir des segments
+    HistoryStore store("power", 60, 14);
+    TEST_ASSERT_TRUE(store.begin());
+    TEST_ASSERT_EQUAL(DAY_START + 86400, store.oldest());
+    TEST_ASSERT_EQUAL(DAY_START + 2 * 86400, store.newest());
+}
+
+void test_store_short_write_keeps_records_aligned()
+{
+    HistoryStore store("power", 60, 14);
+    store.begin();
+    store.append(DataPoint{DAY_START, 1});
+    TEST_ASSERT_TRUE(store.flush());
+
+    // Partition pleine au milieu du lot : un enregistrement et demi écrits
+    fs::stubNextWriteLimit = sizeof(HistoryRecord) * 3 / 2;
+    store.append(DataPoint{DAY_START + 60, 2});
+    store.append(DataPoint{DAY_START + 120, 3});
+    TEST_ASSERT_FALSE(store.flush());
+
+    // Les ajouts suivants restent alignés sur les enregistrements
+    store.append(DataPoint{DAY_START + 180, 4});
+    TEST_ASSERT_TRUE(store.flush());
+
+    const float expected[] = {1, 2, 4};
+    time_t cursor = DAY_START;
+    HistoryBucket bucket;
+    for (float value : expected)
+    {
+        TEST_ASSERT_TRUE(store.nextBucket(cursor, DAY_START, HISTORY_TIME_MAX, 0, bucket));
+        TEST_ASSERT_EQUAL_FLOAT(value, bucket.avg);
+    }
+    TEST_ASSERT_FALSE(store.nextBucket(cursor, DAY_START, HISTORY_TIME_MAX, 0, bucket));
+    TEST_ASSERT_EQUAL(DAY_START + 180, store.newest());
+}
+
+void test_store_drops_empty_segment_after_failed_write()
+{
+    HistoryStore store("power", 60, 14);
+    store.begin();
+    store.append(DataPoint{DAY_START, 1});
+    TEST_ASSERT_TRUE(store.flush());
+
+    // Aucun octet écrit dans le segment du lendemain : il n'est pas conservé
+    fs::stubNextWriteLimit = 0;
+    store.append(DataPoint{DAY_START + 86400, 2});
+    TEST_ASSERT_FALSE(store.flush());
+    TEST_ASSERT_EQUAL(DAY_START, store.newest());
+
+    store.append(DataPoint{DAY_START + 86400 + 60, 3});
+    TEST_ASSERT_TRUE(store.flush());
+    time_t cursor = DAY_START + 86400;
+    HistoryBucket bucket;
+    TEST_ASSERT_TRUE(store.nextBucket(cursor, DAY_START, HISTORY_TIME_MAX, 0, bucket));
+    TEST_ASSERT_EQUAL(DAY_START + 86400 + 60, bucket.start);
+    TEST_ASSERT_EQUAL_FLOAT(3.0f, bucket.avg);
+}
+
+void test_store_skips_unreadable_segment()
+{
+    HistoryStore store("power", 60, 14);
+    store.begin();
+    for (int day = 0; day < 3; day++)
+    {
+        store.append(DataPoint{DAY_START + day * 86400, (float)day});
+    }
+    TEST_ASSERT_TRUE(store.flush());
+
+    // Segment du milieu perdu : la lecture continue sur le suivant
+    LittleFS.remove("/history/power/" + String((uint32_t)((DAY_START + 86400) / 86400)) + ".bin");
+
+    time_t cursor = DAY_START;
+    HistoryBucket bucket;
+    TEST_ASSERT_TRUE(store.nextBucket(cursor, DAY_START, HISTORY_TIME_MAX, 3600, bucket));
+    TEST_ASSERT_EQUAL(DAY_START, bucket.start);
+    TEST_ASSERT_TRUE(store.nextBucket(cursor, DAY_START, HISTORY_TIME_MAX, 3600, bucket));
+    TEST_ASSERT_EQUAL(DAY_START + 2 * 86400, bucket.start);
+    TEST_ASSERT_EQUAL_FLOAT(2.0f, bucket.avg);
+    TEST_ASSERT_FALSE(store.nextBucket(cursor, DAY_START, HISTORY_TIME_MAX, 3600, bucket));
+}
+
+// Série sans tampon à la seconde (grandeur lentement échantillonnée), instance statique (registre des séries)
+static HistoryTiers sparseHistory("sparse", 100, HistoryCapacity{0, 30, 8, 4});
+
+void test_tiers_capacity_per_series()
+{
+    TEST_ASSERT_TRUE(sparseHistory.tier(HISTORY_TIER_SECOND) == nullptr);
+    TEST_ASSERT_TRUE(sparseHistory.tier(HISTORY_TIER_MINUTE) != nullptr);
+    TEST_ASSERT_EQUAL_UINT16(100, sparseHistory.getBinaryScale());
+
+    sparseHistory.begin();
+    stubSetTime(DAY_START);
+    DataPoint minute;
+    bool closed = false;
+    for (int i = 0; i <= 60; i++)
+    {
+        closed = sparseHistory.addSample(20, minute) || closed;
+        stubAdvanceMicros(1000000);
+    }
+    // La minute est close et conservée, sans tampon à la seconde
+    TEST_ASSERT_TRUE(closed);
+    TEST_ASSERT_EQUAL(DAY_START, minute.timestamp);
+    TEST_ASSERT_EQUAL_FLOAT(20, minute.value);
+    TEST_ASSERT_EQUAL(DAY_START, sparseHistory.tier(HISTORY_TIER_MINUTE)->oldest());
+}
+
+static int16_t readInt16(const uint8_t *in)
+{
+    return (int16_t)(in[0] | (in[1] << 8));
+}
+
+void test_binary_round_trip_power_bucket()
+{
+    // Puissance réseau : échelle 1 (watts entiers), au-delà des ±327 W représentables en centièmes
+    const uint16_t scale = 1;
+    uint8_t out[HISTORY_BIN_HEADER_SIZE + HISTORY_BIN_RECORD_MAX_SIZE];
+    size_t n = encodeHistoryHeader(out, 900, scale);
+    TEST_ASSERT_EQUAL(HISTORY_BIN_HEADER_SIZE, n);
+    HistoryBucket bucket = {DAY_START, -1500, 2000, 1234.4f, 308.6f, 900};
+    n += encodeHistoryBucket(out + n, bucket, 0, 900, scale);
+
+    // En-tête
+    TEST_ASSERT_EQUAL('R', out[0]);
+    TEST_ASSERT_EQUAL('H', out[1]);
+    TEST_ASSERT_EQUAL(HISTORY_BIN_BUCKET, out[3]);
+    uint16_t readScale = out[4] | (out[5] << 8);
+    TEST_ASSERT_EQUAL_UINT16(scale, readScale);
+    TEST_ASSERT_EQUAL_UINT32(900, out[6] | (out[7] << 8) | (out[8] << 16) | ((uint32_t)out[9] << 24));
+
+    // Horodatage (varint) puis moyenne, min, max, nombre de points
+    size_t pos = HISTORY_BIN_HEADER_SIZE;
+    uint32_t start = 0;
+    for (int shift = 0;; shift += 7)
+    {
+        uint8_t byte = out[pos++];
+        start |= (uint32_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+            break;
+    }
+    TEST_ASSERT_EQUAL_UINT32(DAY_START, start);
+    TEST_ASSERT_EQUAL_FLOAT(1234, (float)readInt16(out + pos) / readScale);
+    TEST_ASSERT_EQUAL_FLOAT(-1500, (float)readInt16(out + pos + 2) / readScale);
+    TEST_ASSERT_EQUAL_FLOAT(2000, (float)readInt16(out + pos + 4) / readScale);
+    TEST_ASSERT_EQUAL_UINT16(900, (uint16_t)readInt16(out + pos + 6));
+    TEST_ASSERT_EQUAL(pos + 8, n);
+}
+
+void test_binary_fixed_point_limits()
+{
+    // Valeur non définie : INT16_MIN, valeurs hors limites bornées sans se confondre avec elle
+    TEST_ASSERT_EQUAL_INT16(INT16_MIN, historyToFixedPoint(NAN, 100));
+    TEST_ASSERT_EQUAL_INT16(INT16_MAX, historyToFixedPoint(2000, 100));
+    TEST_ASSERT_EQUAL_INT16(INT16_MIN + 1, historyToFixedPoint(-2000, 100));
+    TEST_ASSERT_EQUAL_INT16(4523, historyToFixedPoint(45.23f, 100));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_ram_buckets);
+    RUN_TEST(test_ram_bucket_stops_at_end_of_range);
+    RUN_TEST(test_ring_overwrites_oldest_points);
+    RUN_TEST(test_store_flush_and_read_back);
+    RUN_TEST(test_store_reopens_segment_after_append);
+    RUN_TEST(test_store_survives_restart);
+    RUN_TEST(test_ignores_points_before_time_sync);
+    RUN_TEST(test_suspended_writes_stay_pending);
+    RUN_TEST(test_backup_and_restore);
+    RUN_TEST(test_store_short_write_keeps_records_aligned);
+    RUN_TEST(test_store_drops_empty_segment_after_failed_write);
+    RUN_TEST(test_store_skips_unreadable_segment);
+    RUN_TEST(test_tiers_capacity_per_series);
+    RUN_TEST(test_binary_round_trip_power_bucket);
+    RUN_TEST(test_binary_fixed_point_limits);
+    return UNITY_END();
+}
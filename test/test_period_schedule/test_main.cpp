@@ -0,0 +1,201 @@
+#include <unity.h>
+#include "periodSchedule.h"
+
+static PeriodSchedule schedule;
+
+static Period period(int start, int end, PeriodMode mode)
+{
+    return Period{start, false, false, end, false, false, mode};
+}
+
+// Période ancrée : start / end ignorés au profit du lever ou du coucher du soleil
+static Period anchored(bool startSunrise, bool startSunset, bool endSunrise, bool endSunset, PeriodMode mode)
+{
+    return Period{0, startSunrise, startSunset, 0, endSunrise, endSunset, mode};
+}
+
+void setUp()
+{
+    schedule = PeriodSchedule();
+}
+
+void tearDown() {}
+
+void test_empty_schedule_is_off()
+{
+    schedule.compile({}, 420, 1200);
+    for (int minute = 0; minute < MINUTES_PER_DAY; minute++)
+    {
+        TEST_ASSERT_EQUAL_UINT8(PERIOD_OFF, schedule.getMode(minute));
+    }
+}
+
+void test_period_bounds()
+{
+    // 10:00 - 16:00 : début inclus, fin exclue
+    schedule.compile({period(600, 960, PERIOD_AUTO)}, -1, -1);
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_OFF, schedule.getMode(599));
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_AUTO, schedule.getMode(600));
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_AUTO, schedule.getMode(959));
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_OFF, schedule.getMode(960));
+}
+
+void test_out_of_range_minute_is_off()
+{
+    schedule.compile({period(0, MINUTES_PER_DAY, PERIOD_ON)}, -1, -1);
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_ON, schedule.getMode(0));
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_ON, schedule.getMode(MINUTES_PER_DAY - 1));
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_OFF, schedule.getMode(-1));
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_OFF, schedule.getMode(MINUTES_PER_DAY));
+}
+
+void test_recompile_clears_previous_table()
+{
+    schedule.compile({period(600, 960, PERIOD_AUTO)}, -1, -1);
+    schedule.compile({period(100, 200, PERIOD_ON)}, 400, 1100);
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_OFF, schedule.getMode(700));
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_ON, schedule.getMode(150));
+    TEST_ASSERT_EQUAL_INT(400, schedule.getSunrise());
+    TEST_ASSERT_EQUAL_INT(1100, schedule.getSunset());
+}
+
+void test_period_crossing_midnight()
+{
+    // 22:00 - 06:00
+    schedule.compile({period(1320, 360, PERIOD_ON)}, -1, -1);
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_OFF, schedule.getMode(1319));
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_ON, schedule.getMode(1320));
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_ON, schedule.getMode(MINUTES_PER_DAY - 1));
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_ON, schedule.getMode(0));
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_ON, schedule.getMode(359));
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_OFF, schedule.getMode(360));
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_OFF, schedule.getMode(720));
+}
+
+void test_period_ending_at_midnight()
+{
+    // 20:00 - 00:00 : fin à minuit, rien le matin
+    schedule.compile({period(1200, 0, PERIOD_AUTO)}, -1, -1);
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_AUTO, schedule.getMode(1200));
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_AUTO, schedule.getMode(MINUTES_PER_DAY - 1));
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_OFF, schedule.getMode(0));
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_OFF, schedule.getMode(1199));
+}
+
+void test_empty_period_is_ignored()
+{
+    schedule.compile({period(600, 600, PERIOD_ON)}, -1, -1);
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_OFF, schedule.getMode(600));
+}
+
+void test_sunrise_to_sunset()
+{
+    // Lever 07:12, coucher 19:48 : les heures start / end de la période ne comptent pas
+    schedule.compile({anchored(true, false, false, true, PERIOD_AUTO)}, 432, 1188);
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_OFF, schedule.getMode(431));
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_AUTO, schedule.getMode(432));
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_AUTO, schedule.getMode(1187));
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_OFF, schedule.getMode(1188));
+}
+
+void test_anchor_mixed_with_fixed_time()
+{
+    // Du coucher du soleil à 23:00, puis de 05:00 au lever du soleil
+    Period evening = period(0, 1380, PERIOD_ON);
+    evening.startSunset = true;
+    Period morning = period(300, 0, PERIOD_ON);
+    morning.endSunrise = true;
+    schedule.compile({evening, morning}, 420, 1200);
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_ON, schedule.getMode(1200));
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_ON, schedule.getMode(1379));
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_OFF, schedule.getMode(1380));
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_OFF, schedule.getMode(299));
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_ON, schedule.getMode(300));
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_ON, schedule.getMode(419));
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_OFF, schedule.getMode(420));
+}
+
+void test_sunset_to_sunrise_crosses_midnight()
+{
+    schedule.compile({anchored(false, true, true, false, PERIOD_ON)}, 420, 1200);
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_ON, schedule.getMode(1200));
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_ON, schedule.getMode(0));
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_ON, schedule.getMode(419));
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_OFF, schedule.getMode(420));
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_OFF, schedule.getMode(1199));
+}
+
+void test_anchors_follow_recompile()
+{
+    std::vector<Period> periods = {anchored(true, false, false, true, PERIOD_AUTO)};
+    schedule.compile(periods, 480, 1080);
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_OFF, schedule.getMode(450));
+    // Jours plus longs : la table est recompilée avec les nouvelles heures
+    schedule.compile(periods, 420, 1200);
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_AUTO, schedule.getMode(450));
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_AUTO, schedule.getMode(1100));
+}
+
+void test_unknown_ephemeris_skips_anchored_periods()
+{
+    // Heure non synchronisée ou nuit polaire : lever / coucher inconnus (< 0)
+    std::vector<Period> periods = {anchored(true, false, false, true, PERIOD_AUTO), period(1320, 360, PERIOD_ON)};
+    schedule.compile(periods, -1, -1);
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_OFF, schedule.getMode(720));
+    // Les périodes à heure fixe restent actives
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_ON, schedule.getMode(0));
+
+    // Seul le coucher est inconnu : une période qui n'utilise que le lever reste valide
+    Period morning = period(0, 600, PERIOD_AUTO);
+    morning.startSunrise = true;
+    schedule.compile({anchored(false, true, true, false, PERIOD_ON), morning}, 420, -1);
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_OFF, schedule.getMode(0));
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_AUTO, schedule.getMode(420));
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_OFF, schedule.getMode(600));
+}
+
+void test_on_overrides_auto()
+{
+    // "on" de 12:00 à 14:00 au milieu d'une période "auto", déclarée avant ou après
+    std::vector<Period> periods = {period(720, 840, PERIOD_ON), period(480, 1080, PERIOD_AUTO)};
+    for (int order = 0; order < 2; order++)
+    {
+        schedule.compile(periods, -1, -1);
+        TEST_ASSERT_EQUAL_UINT8(PERIOD_AUTO, schedule.getMode(719));
+        TEST_ASSERT_EQUAL_UINT8(PERIOD_ON, schedule.getMode(720));
+        TEST_ASSERT_EQUAL_UINT8(PERIOD_ON, schedule.getMode(839));
+        TEST_ASSERT_EQUAL_UINT8(PERIOD_AUTO, schedule.getMode(840));
+        std::swap(periods[0], periods[1]);
+    }
+}
+
+void test_on_overrides_auto_across_midnight()
+{
+    // "auto" toute la journée (du lever au coucher), "on" la nuit débordant sur l'"auto" du matin
+    schedule.compile({anchored(true, false, false, true, PERIOD_AUTO), period(1320, 480, PERIOD_ON)}, 420, 1200);
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_ON, schedule.getMode(420));
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_ON, schedule.getMode(479));
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_AUTO, schedule.getMode(480));
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_OFF, schedule.getMode(1250));
+    TEST_ASSERT_EQUAL_UINT8(PERIOD_ON, schedule.getMode(1320));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_schedule_is_off);
+    RUN_TEST(test_period_bounds);
+    RUN_TEST(test_out_of_range_minute_is_off);
+    RUN_TEST(test_recompile_clears_previous_table);
+    RUN_TEST(test_period_crossing_midnight);
+    RUN_TEST(test_period_ending_at_midnight);
+    RUN_TEST(test_empty_period_is_ignored);
+    RUN_TEST(test_sunrise_to_sunset);
+    RUN_TEST(test_anchor_mixed_with_fixed_time);
+    RUN_TEST(test_sunset_to_sunrise_crosses_midnight);
+    RUN_TEST(test_anchors_follow_recompile);
+    RUN_TEST(test_unknown_ephemeris_skips_anchored_periods);
+    RUN_TEST(test_on_overrides_auto);
+    RUN_TEST(test_on_overrides_auto_across_midnight);
+    return UNITY_END();
+}
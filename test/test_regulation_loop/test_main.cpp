@@ -0,0 +1,176 @@
+#include <unity.h>
+#include <vector>
+#include "solarManager.h"
+
+/**
+ * Simulation en boucle fermée de la régulation (SolarManager::updateRegulation) pour plusieurs jeux de gains.
+ * Installation simulée : chauffe-eau résistif de 2000 W commandé par angle de phase (puissance réellement
+ * délivrée d'après le retard d'amorçage quantifié), maison et production photovoltaïque en échelons.
+ * Le compteur mesure la puissance moyenne de l'intervalle précédent : une période de retard.
+ * Pour chaque configuration, la simulation affiche :
+ * - le temps d'établissement : instant à partir duquel la puissance réseau reste à ±2 % de la puissance
+ *   nominale autour de la consigne ;
+ * - le dépassement : excès de la puissance routée au-delà de sa valeur finale, en % de l'échelon ;
+ * - l'énergie soutirée au-delà de la consigne après l'échelon (achetée au réseau).
+ */
+
+static const float HEATER_POWER = 2000;
+static const float SETTLING_BAND = HEATER_POWER * 0.02f;
+
+struct GainSet
+{
+    const char *name;
+    RegulationConfig config;
+    float maxPeriod; // Période de mesure (s) au-delà de laquelle la boucle n'est plus stable
+};
+
+// Réglage par défaut (ConfigManager) et variantes
+static const GainSet GAIN_SETS[] = {
+    {"défaut (kp 0.2, ki 0.5, 25 %/s)", {-30, 0.2f, 0.5f, 0, 25}, 1.0f},
+    {"sans limite de pente", {-30, 0.2f, 0.5f, 0, 0}, 1.0f},
+    {"lent (kp 0.1, ki 0.2)", {-30, 0.1f, 0.2f, 0, 25}, 1.0f},
+    // Oscille avec une mesure par seconde : réservé aux compteurs qui poussent leurs mesures
+    {"rapide (kp 0.5, ki 1.0)", {-30, 0.5f, 1.0f, 0, 0}, 0.2f},
+    {"PID (kd 0.05)", {-30, 0.2f, 0.5f, 0.05f, 25}, 1.0f},
+};
+
+struct StepResult
+{
+    float settlingTime; // s, < 0 si la puissance réseau ne s'établit pas dans la durée simulée
+    float overshoot;    // % de l'échelon de puissance routée
+    float importEnergy; // Wh soutirés au-delà de la consigne
+    float finalHeater;  // Puissance routée en fin de simulation (W)
+};
+
+// Puissance délivrée par le chauffe-eau pour le retard d'amorçage courant
+static float heaterPower(SolarManager &manager)
+{
+    uint32_t delay = manager.getFiringDelay();
+    if (delay >= MAINS_HALF_PERIOD_US)
+        return 0;
+    return HEATER_POWER * (float)phaseAnglePowerFraction(PHASE_ANGLE_PI * delay / MAINS_HALF_PERIOD_US);
+}
+
+/**
+ * Échelon de la puissance disponible (production - consommation de la maison) à t = 0,
+ * à partir d'un régime établi à `initialPercentage` % de la puissance nominale.
+ * @param surplusBefore, surplusAfter Surplus (W) avant et après l'échelon
+ * @param period Période des mesures (s)
+ */
+static StepResult simulateStep(const RegulationConfig &config, float initialPercentage, float surplusBefore, float surplusAfter, float period,
+                               float duration)
+{
+    SolarManager manager(4, 5);
+    manager.configureRegulation(config);
+    manager.setPower(initialPercentage);
+
+    float initialHeater = heaterPower(manager);
+    float expectedHeater = surplusAfter + config.setpoint;
+    if (expectedHeater < 0)
+        expectedHeater = 0;
+    if (expectedHeater > HEATER_POWER)
+        expectedHeater = HEATER_POWER;
+    float stepSize = fabsf(expectedHeater - initialHeater);
+
+    // Mesure de l'intervalle précédant l'échelon
+    float measured = -surplusBefore + initialHeater;
+    StepResult result = {-1, 0, 0, 0};
+    float lastOutside = 0;
+    int steps = (int)(duration / period);
+    for (int k = 0; k < steps; k++)
+    {
+        stubAdvanceMicros((uint64_t)(period * 1000000));
+        manager.updateRegulation(measured, (int)HEATER_POWER);
+
+        // Puissance de l'intervalle qui commence, mesurée à la fin de l'intervalle
+        float heater = heaterPower(manager);
+        float grid = -surplusAfter + heater;
+        measured = grid;
+
+        float t = (k + 1) * period;
+        if (fabsf(grid - config.setpoint) > SETTLING_BAND)
+            lastOutside = t;
+        float excess = expectedHeater > initialHeater ? heater - expectedHeater : expectedHeater - heater;
+        if (stepSize > 0 && excess / stepSize * 100 > result.overshoot)
+            result.overshoot = excess / stepSize * 100;
+        if (grid > config.setpoint)
+            result.importEnergy += (grid - config.setpoint) * period / 3600;
+        result.finalHeater = heater;
+    }
+    if (lastOutside < duration - 5 * period)
+        result.settlingTime = lastOutside;
+    return result;
+}
+
+static void report(const char *scenario, const char *name, const StepResult &result)
+{
+    char settling[16];
+    if (result.settlingTime < 0)
+        snprintf(settling, sizeof(settling), "non établi");
+    else
+        snprintf(settling, sizeof(settling), "%5.1f s", result.settlingTime);
+    char line[160];
+    snprintf(line, sizeof(line), "%-22s %-34s établissement %-10s  dépassement %5.1f %%  soutirage %5.2f Wh", scenario, name, settling,
+             result.overshoot, result.importEnergy);
+    TEST_MESSAGE(line);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+/**
+ * Simule un échelon pour chaque jeu de gains ; la boucle doit s'établir sur la valeur attendue
+ * tant que la période de mesure ne dépasse pas la limite du jeu de gains.
+ */
+static void runScenario(const char *scenario, float initialPercentage, float surplusBefore, float surplusAfter, float period)
+{
+    float expectedHeater = surplusAfter - 30 > 0 ? surplusAfter - 30 : 0;
+    for (const GainSet &set : GAIN_SETS)
+    {
+        StepResult result = simulateStep(set.config, initialPercentage, surplusBefore, surplusAfter, period, 120);
+        report(scenario, set.name, result);
+        if (period <= set.maxPeriod)
+        {
+            TEST_ASSERT_TRUE_MESSAGE(result.settlingTime >= 0, set.name);
+            TEST_ASSERT_FLOAT_WITHIN_MESSAGE(SETTLING_BAND, expectedHeater, result.finalHeater, set.name);
+        }
+    }
+}
+
+// Éclaircie : le surplus passe de 0 à 1000 W, mesures toutes les secondes (interrogation REST)
+void test_surplus_step_polled()
+{
+    runScenario("surplus +1000 W, 1 s", 0, 0, 1000, 1.0f);
+
+    // Réglage par défaut : établi en moins de 15 s, sans dépassement notable
+    StepResult defaults = simulateStep(GAIN_SETS[0].config, 0, 0, 1000, 1.0f, 120);
+    TEST_ASSERT_LESS_OR_EQUAL(15.0f, defaults.settlingTime);
+    TEST_ASSERT_LESS_OR_EQUAL(10.0f, defaults.overshoot);
+}
+
+// Mise en route d'une bouilloire pendant le routage : le surplus passe de 1500 à 0 W
+void test_load_step_polled()
+{
+    runScenario("charge +1500 W, 1 s", 73.5f, 1500, 0, 1.0f);
+
+    // Réglage par défaut : le soutirage dû au chauffe-eau disparaît en moins de 10 s
+    StepResult defaults = simulateStep(GAIN_SETS[0].config, 73.5f, 1500, 0, 1.0f, 120);
+    TEST_ASSERT_LESS_OR_EQUAL(10.0f, defaults.settlingTime);
+}
+
+// Mêmes échelons avec des mesures poussées toutes les 200 ms (notifications Shelly Gen2)
+void test_steps_pushed()
+{
+    runScenario("surplus +1000 W, 0.2 s", 0, 0, 1000, 0.2f);
+    runScenario("charge +1500 W, 0.2 s", 73.5f, 1500, 0, 0.2f);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_surplus_step_polled);
+    RUN_TEST(test_load_step_polled);
+    RUN_TEST(test_steps_pushed);
+    return UNITY_END();
+}
@@ -0,0 +1,133 @@
+#include <unity.h>
+#include "regulator.h"
+
+// Chauffe-eau de 2000 W : 20 W d'écart = 1 % de commande
+static const float HEATER_POWER = 2000;
+
+static Regulator regulator;
+
+void setUp()
+{
+    regulator = Regulator();
+}
+
+void tearDown() {}
+
+void test_proportional_only()
+{
+    regulator.configure(RegulationConfig{0, 1.0f, 0, 0, 0});
+    // 500 W injectés : 25 % de la puissance nominale restent à router
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 25.0f, regulator.update(-500, HEATER_POWER, 1.0f));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 25.0f, regulator.getTerms().error);
+}
+
+void test_output_saturates()
+{
+    regulator.configure(RegulationConfig{0, 1.0f, 0, 0, 0});
+    TEST_ASSERT_EQUAL_FLOAT(100.0f, regulator.update(-5000, HEATER_POWER, 1.0f));
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, regulator.update(3000, HEATER_POWER, 1.0f));
+}
+
+void test_rate_limit()
+{
+    // La pente est limitée à 25 %/s quel que soit l'écart
+    regulator.configure(RegulationConfig{0, 1.0f, 0.5f, 0, 25});
+    TEST_ASSERT_EQUAL_FLOAT(25.0f, regulator.update(-2000, HEATER_POWER, 1.0f));
+    TEST_ASSERT_EQUAL_FLOAT(37.5f, regulator.update(-2000, HEATER_POWER, 0.5f));
+}
+
+void test_integral_converges_to_setpoint()
+{
+    // Maison et chauffe-eau en régime établi : la puissance réseau dépend directement de la commande
+    regulator.configure(RegulationConfig{-30, 0.2f, 0.5f, 0, 0});
+    float surplus = 1200;
+    float output = 0;
+    for (int i = 0; i < 200; i++)
+    {
+        float grid = -surplus + output * HEATER_POWER / 100;
+        output = regulator.update(grid, HEATER_POWER, 1.0f);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, (surplus - 30) * 100 / HEATER_POWER, output);
+}
+
+void test_anti_windup()
+{
+    regulator.configure(RegulationConfig{0, 0.2f, 0.5f, 0, 0});
+    // Long surplus supérieur à la puissance du chauffe-eau : la commande reste saturée à 100 %
+    for (int i = 0; i < 100; i++)
+    {
+        regulator.update(-3000, HEATER_POWER, 1.0f);
+    }
+    TEST_ASSERT_EQUAL_FLOAT(100.0f, regulator.getOutput());
+    // Le surplus disparaît : la commande doit baisser immédiatement, sans attendre la décharge de l'intégrale
+    float output = regulator.update(400, HEATER_POWER, 1.0f);
+    TEST_ASSERT_LESS_THAN(100.0f, output);
+    TEST_ASSERT_LESS_OR_EQUAL(100.0f, regulator.getTerms().integral);
+}
+
+void test_reset_is_bumpless()
+{
+    regulator.configure(RegulationConfig{0, 0.2f, 0.5f, 0, 0});
+    regulator.reset(40);
+    // Aucun écart : la commande reprend là où elle a été laissée
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 40.0f, regulator.update(0, HEATER_POWER, 1.0f));
+}
+
+void test_derivative_on_measurement()
+{
+    regulator.configure(RegulationConfig{0, 0, 0, 1.0f, 0});
+    regulator.reset(50);
+    regulator.update(0, HEATER_POWER, 1.0f);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, regulator.getTerms().derivative);
+    // Hausse de 200 W de la puissance réseau en 1 s : -10 % de dérivée
+    regulator.update(200, HEATER_POWER, 1.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, -10.0f, regulator.getTerms().derivative);
+}
+
+void test_invalid_inputs_keep_output()
+{
+    regulator.configure(RegulationConfig{0, 1.0f, 0, 0, 0});
+    regulator.reset(30);
+    TEST_ASSERT_EQUAL_FLOAT(30.0f, regulator.update(-1000, 0, 1.0f));
+    TEST_ASSERT_EQUAL_FLOAT(30.0f, regulator.update(-1000, HEATER_POWER, 0));
+}
+
+void test_unsigned_meter_ramps_up_until_import()
+{
+    // Consigne négative et compteur sans mesure de l'injection (0 W pendant l'injection)
+    regulator.configure(RegulationConfig{-30, 0.2f, 0.5f, 0, 25});
+    float surplus = 1200;
+    float output = 0;
+    for (int i = 0; i < 300; i++)
+    {
+        float grid = -surplus + output * HEATER_POWER / 100;
+        output = regulator.update(grid > 0 ? grid : 0, HEATER_POWER, 1.0f, false);
+    }
+    // La commande monte jusqu'à un léger soutirage (UNSIGNED_METER_SETPOINT)
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, (surplus + UNSIGNED_METER_SETPOINT) * 100 / HEATER_POWER, output);
+
+    // Le même compteur avec la consigne négative ne route rien
+    regulator = Regulator();
+    regulator.configure(RegulationConfig{-30, 0.2f, 0.5f, 0, 25});
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, regulator.update(0, HEATER_POWER, 1.0f));
+
+    // Consigne positive configurée : conservée
+    regulator = Regulator();
+    regulator.configure(RegulationConfig{20, 1.0f, 0, 0, 0});
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 1.0f, regulator.update(0, HEATER_POWER, 1.0f, false));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_proportional_only);
+    RUN_TEST(test_output_saturates);
+    RUN_TEST(test_rate_limit);
+    RUN_TEST(test_integral_converges_to_setpoint);
+    RUN_TEST(test_anti_windup);
+    RUN_TEST(test_reset_is_bumpless);
+    RUN_TEST(test_derivative_on_measurement);
+    RUN_TEST(test_invalid_inputs_keep_output);
+    RUN_TEST(test_unsigned_meter_ramps_up_until_import);
+    return UNITY_END();
+}
@@ -0,0 +1,157 @@
+#include <unity.h>
+#include <atomic>
+#include <thread>
+#include "seqlockRing.h"
+
+/**
+ * Essai de charge du tampon SeqlockRing : un écrivain et un lecteur sur deux threads.
+ * Chaque élément est cohérent par construction (tous les champs dérivent de son index) :
+ * une lecture acceptée alors que l'écrivain modifiait la case serait détectée comme "déchirée".
+ * Le petit tampon force l'écrivain à rattraper le lecteur en permanence, et les éléments de 256 octets
+ * allongent la copie pour qu'une préemption pendant la lecture soit fréquente, même sur un seul cœur.
+ */
+
+struct Sample
+{
+    uint32_t index;
+    uint32_t payload[62];
+    uint32_t check;
+};
+
+static Sample makeSample(uint32_t index)
+{
+    Sample sample;
+    sample.index = index;
+    uint32_t check = index;
+    for (size_t i = 0; i < 62; i++)
+    {
+        sample.payload[i] = index * 2654435761u + i;
+        check ^= sample.payload[i];
+    }
+    sample.check = check;
+    return sample;
+}
+
+static bool isConsistent(const Sample &sample)
+{
+    uint32_t check = sample.index;
+    for (size_t i = 0; i < 62; i++)
+    {
+        if (sample.payload[i] != sample.index * 2654435761u + i)
+            return false;
+        check ^= sample.payload[i];
+    }
+    return check == sample.check;
+}
+
+static const uint32_t PUSH_COUNT = 2000000;
+static const size_t CAPACITY = 16;
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_concurrent_read_never_returns_torn_sample()
+{
+    SeqlockRing<Sample> ring(CAPACITY);
+    std::atomic<bool> done(false);
+
+    std::thread writer([&]()
+                       {
+                           for (uint32_t i = 0; i < PUSH_COUNT; i++)
+                               ring.push(makeSample(i));
+                           done.store(true);
+                       });
+
+    uint32_t accepted = 0, rejected = 0, torn = 0, misplaced = 0;
+    Sample sample;
+    while (!done.load())
+    {
+        uint32_t last = ring.end();
+        for (uint32_t i = ring.begin(); i < last; i++)
+        {
+            if (!ring.read(i, sample))
+            {
+                rejected++;
+                continue;
+            }
+            accepted++;
+            if (!isConsistent(sample))
+                torn++;
+            if (sample.index != i)
+                misplaced++;
+        }
+    }
+    writer.join();
+
+    char line[128];
+    snprintf(line, sizeof(line), "%u lectures acceptées, %u rejetées (case réécrite)", accepted, rejected);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_EQUAL_UINT32(0, torn);
+    TEST_ASSERT_EQUAL_UINT32(0, misplaced);
+    TEST_ASSERT_GREATER_THAN(0, accepted);
+}
+
+void test_concurrent_for_each_is_ordered()
+{
+    SeqlockRing<Sample> ring(CAPACITY);
+    std::atomic<bool> done(false);
+
+    std::thread writer([&]()
+                       {
+                           for (uint32_t i = 0; i < PUSH_COUNT; i++)
+                               ring.push(makeSample(i));
+                           done.store(true);
+                       });
+
+    uint32_t torn = 0, unordered = 0, overflow = 0;
+    while (!done.load())
+    {
+        bool first = true;
+        uint32_t previous = 0;
+        size_t visited = ring.forEach([&](const Sample &sample)
+                                      {
+                                          if (!isConsistent(sample))
+                                              torn++;
+                                          if (!first && sample.index <= previous)
+                                              unordered++;
+                                          previous = sample.index;
+                                          first = false;
+                                      });
+        // Un parcours ne visite jamais plus d'éléments que le tampon n'en contient
+        if (visited > CAPACITY)
+            overflow++;
+    }
+    writer.join();
+
+    TEST_ASSERT_EQUAL_UINT32(0, torn);
+    TEST_ASSERT_EQUAL_UINT32(0, unordered);
+    TEST_ASSERT_EQUAL_UINT32(0, overflow);
+}
+
+void test_final_content_after_writer_stops()
+{
+    SeqlockRing<Sample> ring(CAPACITY);
+    std::thread writer([&]()
+                       {
+                           for (uint32_t i = 0; i < 1000; i++)
+                               ring.push(makeSample(i));
+                       });
+    writer.join();
+
+    TEST_ASSERT_EQUAL_UINT32(1000 - CAPACITY, ring.begin());
+    TEST_ASSERT_EQUAL_UINT32(1000, ring.end());
+    uint32_t expected = 1000 - CAPACITY;
+    size_t visited = ring.forEach([&](const Sample &sample)
+                                  { TEST_ASSERT_EQUAL_UINT32(expected++, sample.index); });
+    TEST_ASSERT_EQUAL(CAPACITY, visited);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_concurrent_read_never_returns_torn_sample);
+    RUN_TEST(test_concurrent_for_each_is_ordered);
+    RUN_TEST(test_final_content_after_writer_stops);
+    return UNITY_END();
+}
@@ -0,0 +1,305 @@
+#include <unity.h>
+#include <string>
+#include "shellyEm.h"
+
+static bool notify(ShellyEm &meter, const std::string &frame)
+{
+    return meter.handleNotification((const uint8_t *)frame.data(), frame.size());
+}
+
+// Accès à l'interrogation REST, exécutée sinon par la tâche du compteur
+class PolledShellyEm : public ShellyEm
+{
+public:
+    using ShellyEm::poll;
+    using ShellyEm::ShellyEm;
+};
+
+// Serveur simulé : dernière URL demandée
+static String requestedUrl;
+
+static void serve(int code, const std::string &body, uint32_t latencyMs = 20, bool chunked = false, size_t truncate = 0)
+{
+    stubHttpHandler = [=](const String &url)
+    {
+        requestedUrl = url;
+        return StubHttpResponse{code, body, latencyMs, chunked, truncate};
+    };
+}
+
+void setUp()
+{
+    stubHttpHandler = nullptr;
+    requestedUrl = "";
+}
+
+void tearDown() {}
+
+void test_parse_shelly_model()
+{
+    TEST_ASSERT_EQUAL(SHELLY_PRO_EM, parseShellyModel("proem"));
+    TEST_ASSERT_EQUAL(SHELLY_PRO_3EM, parseShellyModel("pro3em"));
+    TEST_ASSERT_EQUAL(SHELLY_EM, parseShellyModel("em"));
+    TEST_ASSERT_EQUAL(SHELLY_EM, parseShellyModel(""));
+}
+
+void test_pro_em_notify_status()
+{
+    // Channel "1" de l'interface : composant em1:0
+    ShellyEm meter("192.168.1.10", "1", SHELLY_PRO_EM);
+    TEST_ASSERT_TRUE(notify(meter, R"({"src":"shellyproem50","dst":"router","method":"NotifyStatus","params":{"ts":1700000000.12,)"
+                                   R"("em1:0":{"id":0,"act_power":-523.4,"voltage":231.2,"pf":-0.97}}})"));
+    MeterSample sample;
+    TEST_ASSERT_TRUE(meter.receive(sample, 0));
+    TEST_ASSERT_EQUAL(METER_GOOD, sample.quality);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, -523.4f, sample.power);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 231.2f, sample.voltage);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, -0.97f, sample.powerFactor);
+    TEST_ASSERT_EQUAL_UINT32(1, meter.getStats().notifications);
+}
+
+void test_pro_3em_total_power()
+{
+    ShellyEm meter("192.168.1.10", "1", SHELLY_PRO_3EM);
+    TEST_ASSERT_TRUE(notify(meter, R"({"method":"NotifyStatus","params":{"em:0":{"id":0,"a_act_power":-400.0,"b_act_power":10.0,)"
+                                   R"("c_act_power":5.0,"total_act_power":-385.0,"a_voltage":229.9,"a_pf":-0.9}}})"));
+    MeterSample sample;
+    TEST_ASSERT_TRUE(meter.receive(sample, 0));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, -385.0f, sample.power);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 229.9f, sample.voltage);
+}
+
+void test_missing_optional_values_are_nan()
+{
+    ShellyEm meter("192.168.1.10", "1", SHELLY_PRO_EM);
+    TEST_ASSERT_TRUE(notify(meter, R"({"method":"NotifyStatus","params":{"em1:0":{"act_power":120.5}}})"));
+    MeterSample sample;
+    TEST_ASSERT_TRUE(meter.receive(sample, 0));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 120.5f, sample.power);
+    TEST_ASSERT_FLOAT_IS_NAN(sample.voltage);
+    TEST_ASSERT_FLOAT_IS_NAN(sample.powerFactor);
+}
+
+void test_meter_errors_invalidate_sample()
+{
+    ShellyEm meter("192.168.1.10", "1", SHELLY_PRO_EM);
+    TEST_ASSERT_TRUE(notify(meter, R"({"method":"NotifyStatus","params":{"em1:0":{"act_power":0,"errors":["out_of_range:act_power"]}}})"));
+    MeterSample sample;
+    TEST_ASSERT_TRUE(meter.receive(sample, 0));
+    TEST_ASSERT_EQUAL(METER_INVALID, sample.quality);
+}
+
+void test_gen1_ignores_notifications()
+{
+    ShellyEm meter("192.168.1.10", "1", SHELLY_EM);
+    TEST_ASSERT_FALSE(notify(meter, R"({"method":"NotifyStatus","params":{"em1:0":{"act_power":120.5}}})"));
+    MeterSample sample;
+    TEST_ASSERT_FALSE(meter.receive(sample, 0));
+}
+
+void test_full_status_selects_configured_channel()
+{
+    // Channel "2" de l'interface : composant em1:1, placé après em1:0 dans la trame
+    ShellyEm meter("192.168.1.10", "2", SHELLY_PRO_EM);
+    TEST_ASSERT_TRUE(notify(meter, R"({"src":"shellyproem50","method":"NotifyFullStatus","params":{"ts":1700000000.5,)"
+                                   R"("em1:0":{"id":0,"act_power":-300.0,"voltage":230.0,"pf":-0.9},)"
+                                   R"("em1:1":{"id":1,"act_power":75.5,"voltage":230.0,"pf":0.5},"sys":{"uptime":1234}}})"));
+    MeterSample sample;
+    TEST_ASSERT_TRUE(meter.receive(sample, 0));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 75.5f, sample.power);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.5f, sample.powerFactor);
+}
+
+void test_partial_status_without_power_is_ignored()
+{
+    // Seule la tension du channel configuré a changé : la puissance d'un autre channel ne doit pas être prise
+    ShellyEm meter("192.168.1.10", "1", SHELLY_PRO_EM);
+    TEST_ASSERT_FALSE(notify(meter, R"({"method":"NotifyStatus","params":{"em1:0":{"voltage":229.4},"em1:1":{"act_power":999.0}}})"));
+    MeterSample sample;
+    TEST_ASSERT_FALSE(meter.receive(sample, 0));
+    TEST_ASSERT_EQUAL_UINT32(0, meter.getStats().notifications);
+}
+
+void test_notification_for_other_component_is_ignored()
+{
+    ShellyEm meter("192.168.1.10", "1", SHELLY_PRO_EM);
+    TEST_ASSERT_FALSE(notify(meter, R"({"method":"NotifyStatus","params":{"em1:1":{"act_power":12.0}}})"));
+    TEST_ASSERT_FALSE(notify(meter, R"({"method":"NotifyStatus","params":{"sys":{"available_updates":{}}}})"));
+}
+
+void test_other_methods_are_ignored()
+{
+    ShellyEm meter("192.168.1.10", "1", SHELLY_PRO_EM);
+    TEST_ASSERT_FALSE(notify(meter, R"({"method":"NotifyEvent","params":{"em1:0":{"act_power":12.0}}})"));
+    TEST_ASSERT_FALSE(notify(meter, R"({"method":"NotifyStatusX","params":{"em1:0":{"act_power":12.0}}})"));
+    TEST_ASSERT_FALSE(notify(meter, R"({"id":1,"result":{"em1:0":{"act_power":12.0}}})"));
+}
+
+void test_truncated_frames_are_rejected()
+{
+    ShellyEm meter("192.168.1.10", "1", SHELLY_PRO_EM);
+    const std::string frame = R"({"method":"NotifyStatus","params":{"em1:0":{"id":0,"act_power":-523.4,"voltage":231.2}}})";
+    // Trame coupée à chaque position : jamais de mesure publiée à partir d'un objet incomplet
+    size_t objectEnd = frame.find('}') + 1;
+    for (size_t length = 0; length < objectEnd; length++)
+    {
+        TEST_ASSERT_FALSE_MESSAGE(meter.handleNotification((const uint8_t *)frame.data(), length), frame.substr(0, length).c_str());
+    }
+    MeterSample sample;
+    TEST_ASSERT_FALSE(meter.receive(sample, 0));
+    TEST_ASSERT_TRUE(meter.handleNotification((const uint8_t *)frame.data(), objectEnd));
+}
+
+void test_frame_length_is_respected()
+{
+    // Tampon du WebSocket non terminé par '\0' : les octets au-delà de `len` ne sont pas lus
+    ShellyEm meter("192.168.1.10", "1", SHELLY_PRO_EM);
+    const std::string buffer = R"({"method":"NotifyStatus","params":{"em1:0":{"voltage":230.0}}})"
+                               R"({"em1:0":{"act_power":50.0}})";
+    size_t len = buffer.find("}}}") + 3;
+    TEST_ASSERT_FALSE(meter.handleNotification((const uint8_t *)buffer.data(), len));
+}
+
+void test_malformed_frames_are_rejected()
+{
+    ShellyEm meter("192.168.1.10", "1", SHELLY_PRO_EM);
+    TEST_ASSERT_FALSE(notify(meter, ""));
+    TEST_ASSERT_FALSE(notify(meter, "not json at all"));
+    TEST_ASSERT_FALSE(notify(meter, "{}"));
+    TEST_ASSERT_FALSE(notify(meter, R"({"method":"NotifyStatus"})"));
+    TEST_ASSERT_FALSE(notify(meter, R"({"method":"NotifyStatus","params":{"em1:0":"offline"}})"));
+    TEST_ASSERT_FALSE(notify(meter, R"({"method":"NotifyStatus","params":{"em1:0":{"act_power":"n/a"}}})"));
+    TEST_ASSERT_FALSE(notify(meter, R"({"method":"NotifyStatus","params":{"em1:0":{"act_power":}}})"));
+    MeterSample sample;
+    TEST_ASSERT_FALSE(meter.receive(sample, 0));
+}
+
+void test_component_name_in_string_values()
+{
+    ShellyEm meter("192.168.1.10", "1", SHELLY_PRO_EM);
+    // Nom du composant présent comme valeur, accolades dans une chaîne de l'objet
+    TEST_ASSERT_TRUE(notify(meter, R"({"method":"NotifyStatus","params":{"target":"em1:0","em1:0":{"name":"cuisine {est}","act_power":42.0}}})"));
+    MeterSample sample;
+    TEST_ASSERT_TRUE(meter.receive(sample, 0));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 42.0f, sample.power);
+}
+
+void test_rest_gen1_response()
+{
+    serve(200, R"({"power":-512.37,"pf":-0.96,"current":2.31,"voltage":231.05,"is_valid":true,"total":123456.7})");
+    PolledShellyEm meter("192.168.1.10", "1", SHELLY_EM);
+    ShellyReading reading;
+    TEST_ASSERT_TRUE(meter.poll(reading));
+    TEST_ASSERT_EQUAL_STRING("http://192.168.1.10/emeter/0", requestedUrl.c_str());
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, -512.37f, reading.power);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 231.05f, reading.voltage);
+    TEST_ASSERT_TRUE(reading.valid);
+
+    serve(200, R"({"power":0,"pf":0,"voltage":0,"is_valid":false})");
+    TEST_ASSERT_TRUE(meter.poll(reading));
+    TEST_ASSERT_FALSE(reading.valid);
+}
+
+void test_rest_gen2_urls()
+{
+    serve(200, R"({"id":0,"act_power":10.0})");
+    PolledShellyEm proEm("192.168.1.10", "2", SHELLY_PRO_EM);
+    ShellyReading reading;
+    TEST_ASSERT_TRUE(proEm.poll(reading));
+    TEST_ASSERT_EQUAL_STRING("http://192.168.1.10/rpc/EM1.GetStatus?id=1", requestedUrl.c_str());
+
+    serve(200, R"({"id":0,"a_act_power":5.0,"total_act_power":-20.5})");
+    PolledShellyEm pro3em("192.168.1.11", "1", SHELLY_PRO_3EM);
+    TEST_ASSERT_TRUE(pro3em.poll(reading));
+    TEST_ASSERT_EQUAL_STRING("http://192.168.1.11/rpc/EM.GetStatus?id=0", requestedUrl.c_str());
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, -20.5f, reading.power);
+}
+
+void test_rest_errors()
+{
+    PolledShellyEm meter("192.168.1.10", "1", SHELLY_EM);
+    ShellyReading reading;
+
+    serve(500, "Internal error");
+    TEST_ASSERT_FALSE(meter.poll(reading));
+    TEST_ASSERT_EQUAL(500, meter.getStats().lastError);
+
+    // Serveur injoignable, refus après le délai de connexion : compté comme délai dépassé
+    serve(HTTPC_ERROR_CONNECTION_REFUSED, "", 1000);
+    TEST_ASSERT_FALSE(meter.poll(reading));
+    serve(HTTPC_ERROR_READ_TIMEOUT, "", 1500);
+    TEST_ASSERT_FALSE(meter.poll(reading));
+
+    MeterStats stats = meter.getStats();
+    TEST_ASSERT_EQUAL_UINT32(3, stats.requests);
+    TEST_ASSERT_EQUAL_UINT32(3, stats.errors);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.timeouts);
+}
+
+void test_rest_truncated_response_is_rejected()
+{
+    // Connexion coupée au milieu de la puissance : "-51" ne doit pas être lu comme une mesure
+    const std::string body = R"({"power":-512.37,"pf":-0.96,"voltage":231.05,"is_valid":true})";
+    serve(200, body, 20, false, body.find("2.37"));
+    PolledShellyEm meter("192.168.1.10", "1", SHELLY_EM);
+    ShellyReading reading;
+    TEST_ASSERT_FALSE(meter.poll(reading));
+    TEST_ASSERT_EQUAL_UINT32(1, meter.getStats().errors);
+}
+
+void test_rest_chunked_response()
+{
+    // Longueur non annoncée : réponse lue jusqu'à la fermeture de la connexion
+    serve(200, R"({"power":100.5,"voltage":230.0,"is_valid":true})", 20, true);
+    PolledShellyEm meter("192.168.1.10", "1", SHELLY_EM);
+    ShellyReading reading;
+    TEST_ASSERT_TRUE(meter.poll(reading));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 100.5f, reading.power);
+}
+
+void test_rest_connection_is_reused()
+{
+    serve(200, R"({"power":1.0,"is_valid":true})", 35);
+    PolledShellyEm meter("192.168.1.10", "1", SHELLY_EM);
+    ShellyReading reading;
+    for (int i = 0; i < 5; i++)
+    {
+        TEST_ASSERT_TRUE(meter.poll(reading));
+    }
+    MeterStats stats = meter.getStats();
+    TEST_ASSERT_EQUAL_UINT32(1, stats.reconnections);
+    TEST_ASSERT_EQUAL_UINT32(35, stats.lastLatencyMs);
+
+    // Après une erreur, la connexion est rouverte
+    serve(500, "");
+    meter.poll(reading);
+    serve(200, R"({"power":1.0,"is_valid":true})");
+    meter.poll(reading);
+    TEST_ASSERT_EQUAL_UINT32(2, meter.getStats().reconnections);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_parse_shelly_model);
+    RUN_TEST(test_pro_em_notify_status);
+    RUN_TEST(test_pro_3em_total_power);
+    RUN_TEST(test_missing_optional_values_are_nan);
+    RUN_TEST(test_meter_errors_invalidate_sample);
+    RUN_TEST(test_gen1_ignores_notifications);
+    RUN_TEST(test_full_status_selects_configured_channel);
+    RUN_TEST(test_partial_status_without_power_is_ignored);
+    RUN_TEST(test_notification_for_other_component_is_ignored);
+    RUN_TEST(test_other_methods_are_ignored);
+    RUN_TEST(test_truncated_frames_are_rejected);
+    RUN_TEST(test_frame_length_is_respected);
+    RUN_TEST(test_malformed_frames_are_rejected);
+    RUN_TEST(test_component_name_in_string_values);
+    RUN_TEST(test_rest_gen1_response);
+    RUN_TEST(test_rest_gen2_urls);
+    RUN_TEST(test_rest_errors);
+    RUN_TEST(test_rest_truncated_response_is_rejected);
+    RUN_TEST(test_rest_chunked_response);
+    RUN_TEST(test_rest_connection_is_reused);
+    return UNITY_END();
+}
@@ -0,0 +1,493 @@
+#include "simulator.h"
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <Preferences.h>
+#include <hal/timer_ll.h>
+#include "phaseAngle.h"
+#include "timezone.h"
+
+// Broches de la carte (main.cpp)
+static const uint8_t PIN_TRIAC = 22;
+static const uint8_t PIN_ZERO_CROSS = 23;
+// Instant du démarrage du firmware sur l'horloge virtuelle : le premier passage à zéro n'est pas pris pour un rebond
+static const uint64_t BOOT_MICROS = 1000000;
+// Rebond du détecteur de passage à zéro après le front
+static const uint64_t BOUNCE_DELAY_US = 400;
+// Durée d'une requête REST restée sans réponse (RESPONSE_TIMEOUT de shellyEm.cpp)
+static const uint32_t SHELLY_TIMEOUT_MS = 1500;
+static const float WATER_HEAT_CAPACITY = 4186; // J/(kg.K)
+static const uint64_t NEVER = UINT64_MAX;
+
+SimulationConfig defaultSimulation()
+{
+    SimulationConfig simulation;
+    simulation.date = 20260621;
+    simulation.startTime = 0;
+    simulation.duration = 24 * 3600;
+
+    PlantConfig &plant = simulation.plant;
+    plant.heaterPower = 2000;
+    plant.tankLitres = 200;
+    plant.initialTemperature = 45;
+    plant.ambientTemperature = 18;
+    plant.tankLoss = 2;
+    plant.pvPeakPower = 3000;
+    plant.cloudiness = 0;
+    plant.cloudSeed = 1;
+    plant.houseBase = 250;
+    plant.loads = {
+        {7 * 3600 + 15 * 60, 180, 2000},  // Bouilloire
+        {7 * 3600 + 20 * 60, 120, 900},   // Grille-pain
+        {10 * 3600 + 30 * 60, 1800, 2000}, // Lave-linge : chauffage...
+        {11 * 3600, 3600, 300},            // ... puis lavage et essorage
+        {12 * 3600, 2700, 2500},           // Four
+        {14 * 3600, 1200, 1800},           // Lave-vaisselle
+        {19 * 3600, 1800, 2000},           // Plaques de cuisson
+    };
+
+    Config &config = simulation.config;
+    config = Config{};
+    config.shellyEm.ip = "192.168.1.50";
+    config.shellyEm.channel = "1";
+    config.shellyEm.model = "proem";
+    config.shellyEm.pollPeriod = 1000;
+    config.meter.source = "shelly";
+    config.boiler.mode = BOILER_AUTO;
+    config.boiler.temperature = 60;
+    // Régulation du lever au coucher du soleil
+    config.boiler.periods = {{0, true, false, 0, false, true, PERIOD_AUTO}};
+    config.boiler.triacOpening = 50;
+    config.boiler.heaterPower = 2000;
+    config.boiler.outputMode = "phase";
+    config.boiler.sensorResolution = 12;
+    config.boiler.sensorInterval = 30000;
+    config.solar.latitude = 48.8566f;
+    config.solar.longitude = 2.3522f;
+    config.solar.timeZone = "Europe/Paris";
+    config.regulation = {-30, 0.2f, 0.5f, 0, 25};
+    config.version = 1;
+
+    simulation.transport = SIM_METER_POLL;
+    simulation.meterLatencyMs = 30;
+    simulation.meterJitterMs = 40;
+    simulation.pushPeriodMs = 200;
+    simulation.outageStart = 0;
+    simulation.outageDuration = 0;
+    simulation.bouncePeriod = 0;
+    return simulation;
+}
+
+namespace
+{
+
+// Un déroulement de la simulation : objets du firmware, tâches et modèle de l'installation
+class Simulation
+{
+public:
+    explicit Simulation(const SimulationConfig &simulation);
+    SimulationReport run();
+
+private:
+    static void regulationTask(void *parameter);
+    static void communicationTask(void *parameter);
+
+    void zeroCross();
+    void closeHalfCycle(uint64_t now);
+    void updateEnvironment(uint64_t now);
+    float readMeter();
+    bool outage() const;
+    StubHttpResponse serveRest(const String &url);
+    void pushNotification();
+    uint32_t meterLatency();
+    void collectTrace();
+
+    const SimulationConfig &simulation;
+    const PlantConfig &plant;
+    std::shared_ptr<const Config> config;
+    SimulationReport report;
+
+    // Objets du firmware
+    SolarManager solarManager;
+    SolarEphemeris solarEphemeris;
+    PeriodSchedule schedule;
+    ControlStateMachine controlState;
+    EnergyManager energyManager;
+    RegulationTrace regulationTrace;
+    LatencyHistogram controlLoopHistogram;
+    ControlLoop controlLoop;
+    ShellyEm meter;
+
+    // Secteur et triac
+    uint64_t start;
+    uint64_t end;
+    uint64_t halfCycleStart;
+    uint64_t nextZeroCross;
+    uint64_t nextBounce;
+    uint64_t firedAt; // Amorçage du triac dans l'alternance en cours, NEVER si bloqué
+    uint32_t halfCycles;
+
+    // Installation
+    SolarEphemeris sky;         // Position du soleil pour la production
+    std::vector<float> clouds;  // Transmission des nuages, par seconde
+    uint64_t environmentSecond; // Seconde de la production / consommation en cours
+    float pvPower;
+    float housePower;
+    double temperature;
+    double meterEnergy; // Énergie réseau depuis la dernière lecture du compteur (J)
+    double meterTime;   // Durée correspondante (s)
+    float lastReading;
+
+    // Compteur Gen2 poussé
+    uint64_t nextPush;
+    uint64_t pendingFrameAt;
+    char pendingFrame[256];
+    size_t pendingFrameLength;
+
+    // Latences de bout en bout
+    uint32_t latencySeed;
+    std::deque<std::pair<uint64_t, uint64_t>> readings; // Mesures envoyées : instant de publication, instant de la mesure
+    uint32_t traceSeen;
+    std::vector<uint64_t> pendingMeasures; // Instants des mesures dont la commande attend le passage à zéro
+    double endToEndSum;
+    uint32_t endToEndCount;
+};
+
+Simulation::Simulation(const SimulationConfig &simulation)
+    : simulation(simulation), plant(simulation.plant), config(std::make_shared<Config>(simulation.config)), report(),
+      solarManager(PIN_TRIAC, PIN_ZERO_CROSS),
+      controlLoop(solarManager, solarEphemeris, schedule, controlState, energyManager, regulationTrace, controlLoopHistogram),
+      meter(simulation.config.shellyEm.ip.c_str(), simulation.config.shellyEm.channel.c_str(), parseShellyModel(simulation.config.shellyEm.model),
+            simulation.config.shellyEm.pollPeriod),
+      start(0), end(0), halfCycleStart(0), nextZeroCross(0), nextBounce(NEVER), firedAt(NEVER), halfCycles(0), environmentSecond(NEVER), pvPower(0),
+      housePower(0), temperature(simulation.plant.initialTemperature), meterEnergy(0), meterTime(0), lastReading(0), nextPush(NEVER),
+      pendingFrameAt(NEVER), pendingFrameLength(0), latencySeed(simulation.plant.cloudSeed), traceSeen(0), endToEndSum(0), endToEndCount(0)
+{
+}
+
+// Tâche de régulation : la boucle de signalProcessingTask (main.cpp)
+void Simulation::regulationTask(void *parameter)
+{
+    Simulation *self = static_cast<Simulation *>(parameter);
+    self->controlLoop.begin(*self->config);
+    for (;;)
+    {
+        MeterSample sample;
+        bool hasSample = self->controlLoop.wait(&self->meter, sample);
+        self->controlLoop.run(hasSample ? &sample : nullptr, *self->config);
+    }
+}
+
+// Partie de communicationTask (main.cpp) qui alimente la régulation et le comptage de l'énergie
+void Simulation::communicationTask(void *parameter)
+{
+    Simulation *self = static_cast<Simulation *>(parameter);
+    uint32_t sensorInterval = self->config->boiler.sensorInterval;
+    unsigned long lastSensorRead = 0;
+    for (;;)
+    {
+        unsigned long now = millis();
+        if (lastSensorRead == 0 || now - lastSensorRead >= sensorInterval)
+        {
+            // Résolution de la sonde DS18B20 en 12 bits
+            lastTemperature = roundf(self->temperature * 16) / 16;
+            lastSensorRead = now;
+        }
+        self->energyManager.addRoutedSample(triacOpeningPercentage, self->config->boiler.heaterPower);
+        vTaskDelay(pdMS_TO_TICKS(1000));
+    }
+}
+
+bool Simulation::outage() const
+{
+    uint64_t outageStart = start + (uint64_t)simulation.outageStart * 1000000;
+    return simulation.outageDuration != 0 && stubMicros >= outageStart && stubMicros < outageStart + (uint64_t)simulation.outageDuration * 1000000;
+}
+
+// Production et consommation, mises à jour chaque seconde
+void Simulation::updateEnvironment(uint64_t now)
+{
+    uint64_t second = (now - start) / 1000000;
+    if (second == environmentSecond)
+        return;
+    environmentSecond = second;
+
+    float elevation = sky.getElevation(stubTime(nullptr));
+    float cloud = second < clouds.size() ? clouds[second] : 1;
+    pvPower = elevation > 0 ? plant.pvPeakPower * sinf(elevation * (float)M_PI / 180) * cloud : 0;
+
+    uint32_t daySecond = (uint32_t)((simulation.startTime + second) % 86400);
+    housePower = plant.houseBase;
+    for (const HouseLoad &load : plant.loads)
+    {
+        if (daySecond >= load.start && daySecond < load.start + load.duration)
+            housePower += load.power;
+    }
+}
+
+// Bilan de l'alternance qui se termine : puissance délivrée d'après l'instant réel de l'amorçage
+void Simulation::closeHalfCycle(uint64_t now)
+{
+    updateEnvironment(halfCycleStart);
+    double dt = (now - halfCycleStart) / 1e6;
+    double heater = 0;
+    if (firedAt != NEVER)
+    {
+        double alpha = PHASE_ANGLE_PI * (double)(firedAt - halfCycleStart) / MAINS_HALF_PERIOD_US;
+        heater = plant.heaterPower * phaseAnglePowerFraction(alpha < PHASE_ANGLE_PI ? alpha : PHASE_ANGLE_PI);
+    }
+    double grid = housePower + heater - pvPower;
+
+    report.pvEnergy += pvPower * dt / 3600;
+    report.houseEnergy += housePower * dt / 3600;
+    report.heaterEnergy += heater * dt / 3600;
+    if (grid > 0)
+        report.importEnergy += grid * dt / 3600;
+    else
+        report.exportEnergy += -grid * dt / 3600;
+    if (controlState.getState() == CONTROL_AUTO)
+    {
+        if (grid < 0 && heater < 0.99 * plant.heaterPower)
+            report.autoExportEnergy += -grid * dt / 3600;
+        if (grid > 0 && heater > 0)
+            report.autoImportEnergy += std::min(grid, heater) * dt / 3600;
+    }
+    report.polarityImbalance += (halfCycles % 2 == 0 ? heater : -heater) * dt / 3600;
+    // Arrêt attendu au premier passage de la régulation après METER_STALE_PERIOD sans mesure valide
+    if (outage() && now - (start + (uint64_t)simulation.outageStart * 1000000) > (METER_STALE_PERIOD + 2 * REGULATION_IDLE_PERIOD) * 1000)
+        report.outageHeaterEnergy += heater * dt / 3600;
+
+    meterEnergy += grid * dt;
+    meterTime += dt;
+
+    double mass = plant.tankLitres;
+    temperature += (heater - plant.tankLoss * (temperature - plant.ambientTemperature)) * dt / (mass * WATER_HEAT_CAPACITY);
+}
+
+void Simulation::zeroCross()
+{
+    uint64_t now = nextZeroCross;
+    closeHalfCycle(now);
+
+    // Commandes en attente : appliquées à partir de ce passage à zéro
+    for (uint64_t measuredAt : pendingMeasures)
+    {
+        double latency = (now - measuredAt) / 1000.0;
+        endToEndSum += latency;
+        endToEndCount++;
+        report.maxEndToEndMs = std::max(report.maxEndToEndMs, latency);
+    }
+    pendingMeasures.clear();
+
+    report.zeroCrossEdges++;
+    stubPinIsr[PIN_ZERO_CROSS]();
+    halfCycleStart = now;
+    firedAt = NEVER;
+    halfCycles++;
+    if (simulation.bouncePeriod != 0 && halfCycles % simulation.bouncePeriod == 0)
+        nextBounce = now + BOUNCE_DELAY_US;
+    nextZeroCross = now + MAINS_HALF_PERIOD_US;
+}
+
+// Puissance moyenne depuis la lecture précédente (le Shelly intègre l'énergie entre deux lectures)
+float Simulation::readMeter()
+{
+    if (meterTime > 0)
+        lastReading = (float)(meterEnergy / meterTime);
+    meterEnergy = 0;
+    meterTime = 0;
+    return lastReading;
+}
+
+// Délai de la mesure suivante (réseau et traitement du compteur)
+uint32_t Simulation::meterLatency()
+{
+    latencySeed = latencySeed * 1664525 + 1013904223;
+    return simulation.meterLatencyMs + (simulation.meterJitterMs == 0 ? 0 : (latencySeed >> 8) % (simulation.meterJitterMs + 1));
+}
+
+// Shelly Pro EM simulé : EM1.GetStatus
+StubHttpResponse Simulation::serveRest(const String &url)
+{
+    if (outage())
+        return StubHttpResponse{HTTPC_ERROR_READ_TIMEOUT, "", SHELLY_TIMEOUT_MS, false, 0};
+    uint32_t latency = meterLatency();
+    if (url != "http://" + String(simulation.config.shellyEm.ip.c_str()) + "/rpc/EM1.GetStatus?id=0")
+        return StubHttpResponse{404, "", latency, false, 0};
+
+    float power = readMeter();
+    readings.push_back({stubMicros + (uint64_t)latency * 1000, stubMicros});
+    char body[192];
+    snprintf(body, sizeof(body), "{\"id\":0,\"current\":%.3f,\"voltage\":230.0,\"act_power\":%.1f,\"aprt_power\":%.1f,\"pf\":%.2f,\"freq\":50.0}",
+             fabsf(power) / 230, power, fabsf(power), power < 0 ? -0.98 : 0.98);
+    return StubHttpResponse{HTTP_CODE_OK, body, latency, false, 0};
+}
+
+// Notification NotifyStatus du Shelly Pro EM, livrée après le délai réseau
+void Simulation::pushNotification()
+{
+    float power = readMeter();
+    double ts = (double)stubTime(nullptr) + (stubMicros % 1000000) / 1e6;
+    int length = snprintf(pendingFrame, sizeof(pendingFrame),
+                          "{\"src\":\"shellyproem50-sim\",\"dst\":\"router\",\"method\":\"NotifyStatus\",\"params\":{\"ts\":%.2f,"
+                          "\"em1:0\":{\"id\":0,\"act_power\":%.1f,\"voltage\":230.0,\"pf\":%.2f}}}",
+                          ts, power, power < 0 ? -0.98 : 0.98);
+    pendingFrameLength = (size_t)length;
+    pendingFrameAt = stubMicros + (uint64_t)meterLatency() * 1000;
+    readings.push_back({pendingFrameAt, stubMicros});
+}
+
+// Nouveaux pas de régulation : instant de la mesure correspondante, retrouvé par son instant de publication
+void Simulation::collectTrace()
+{
+    const SeqlockRing<TraceRecord> &ring = regulationTrace.getRing();
+    uint32_t traceEnd = ring.end();
+    for (; traceSeen < traceEnd; traceSeen++)
+    {
+        TraceRecord record;
+        if (!ring.read(traceSeen, record))
+            continue;
+        report.regulationPasses++;
+        uint64_t publishedAt = stubMicros - record.latencyUs;
+        while (!readings.empty() && readings.front().first < publishedAt)
+            readings.pop_front();
+        if (!readings.empty() && readings.front().first == publishedAt && record.state == CONTROL_AUTO)
+            pendingMeasures.push_back(readings.front().second);
+    }
+}
+
+SimulationReport Simulation::run()
+{
+    auto hostStart = std::chrono::steady_clock::now();
+
+    // Heure locale de début
+    setenv("TZ", getPosixTimezone(simulation.config.solar.timeZone.c_str()), 1);
+    tzset();
+    struct tm local = {};
+    local.tm_year = simulation.date / 10000 - 1900;
+    local.tm_mon = simulation.date / 100 % 100 - 1;
+    local.tm_mday = simulation.date % 100;
+    local.tm_hour = simulation.startTime / 3600;
+    local.tm_min = simulation.startTime / 60 % 60;
+    local.tm_sec = simulation.startTime % 60;
+    local.tm_isdst = -1;
+    stubSetTime(mktime(&local));
+    start = stubMicros;
+    end = start + (uint64_t)simulation.duration * 1000000;
+
+    sky.update(simulation.config.solar.latitude, simulation.config.solar.longitude, simulation.config.solar.timeZone);
+    // Nuages : passages de 1 à 6 minutes, transmission de 20 à 70 %
+    clouds.assign(simulation.duration + 1, 1.0f);
+    uint32_t seed = plant.cloudSeed;
+    auto random = [&seed]() {
+        seed = seed * 1664525 + 1013904223;
+        return (seed >> 8) / 16777216.0f;
+    };
+    for (uint32_t minute = 0; minute * 60 < simulation.duration; minute++)
+    {
+        if (random() >= plant.cloudiness)
+            continue;
+        uint32_t duration = 60 + (uint32_t)(random() * 300);
+        float transmission = 0.2f + random() * 0.5f;
+        for (uint32_t s = minute * 60; s < minute * 60 + duration && s < clouds.size(); s++)
+            clouds[s] = std::min(clouds[s], transmission);
+    }
+
+    // Démarrage du firmware (setup() de main.cpp)
+    energyManager.begin();
+    solarManager.begin();
+    stubHttpHandler = [this](const String &url) { return serveRest(url); };
+    stubSchedulerStart();
+    meter.begin(0, 2);
+    xTaskCreatePinnedToCore(regulationTask, "SignalProcessingTask", 10000, this, 3, nullptr, 0);
+    xTaskCreatePinnedToCore(communicationTask, "CommunicationTask", 10000, this, 2, nullptr, 1);
+
+    halfCycleStart = start;
+    nextZeroCross = start + MAINS_HALF_PERIOD_US;
+    if (simulation.transport == SIM_METER_PUSH)
+        nextPush = start + (uint64_t)simulation.pushPeriodMs * 1000;
+    stubRunReadyTasks();
+
+    for (;;)
+    {
+        uint64_t timerAt = stubTimerAlarmAt(&TIMERG0, TIMER_0);
+        uint64_t next = std::min({nextZeroCross, nextBounce, timerAt, nextPush, pendingFrameAt, stubNextTaskWake()});
+        if (next >= end)
+            break;
+        stubMicros = next;
+
+        if (timerAt == next)
+        {
+            stubTimerFire(&stubTimers[0]);
+            if (firedAt == NEVER && stubPinLevel[PIN_TRIAC] == HIGH)
+                firedAt = next;
+        }
+        if (nextZeroCross == next)
+            zeroCross();
+        if (nextBounce == next)
+        {
+            report.zeroCrossEdges++;
+            report.bounceEdges++;
+            stubPinIsr[PIN_ZERO_CROSS]();
+            nextBounce = NEVER;
+        }
+        if (nextPush == next)
+        {
+            if (!outage())
+                pushNotification();
+            nextPush += (uint64_t)simulation.pushPeriodMs * 1000;
+        }
+        if (pendingFrameAt == next)
+        {
+            meter.handleNotification((const uint8_t *)pendingFrame, pendingFrameLength);
+            pendingFrameAt = NEVER;
+        }
+
+        ControlState before = controlState.getState();
+        stubRunReadyTasks();
+        collectTrace();
+        if (controlState.getState() == CONTROL_METER_LOST && before != CONTROL_METER_LOST)
+            report.meterLostSeen = true;
+    }
+    stubMicros = end;
+    closeHalfCycle(end);
+
+    for (const StubTask *task : stubScheduledTasks)
+        report.tasksWakeups += task->runs;
+    stubSchedulerStop();
+    stubHttpHandler = nullptr;
+
+    report.firmware = energyManager.getTotals();
+    report.finalTemperature = (float)temperature;
+    report.finalState = controlState.getState();
+    report.stateTransitions = controlState.getTransitionCount();
+    report.maxRegulationLatencyUs = maxRegulationLatencyUs;
+    report.meanEndToEndMs = endToEndCount > 0 ? endToEndSum / endToEndCount : 0;
+    report.isr = solarManager.getIsrStats();
+    report.meter = meter.getStats();
+    report.hostSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - hostStart).count();
+    return report;
+}
+
+} // namespace
+
+SimulationReport simulate(const SimulationConfig &simulation)
+{
+    // Démarrage à froid : horloge, périphériques, NVS et valeurs partagées de la régulation
+    stubMicros = BOOT_MICROS;
+    stubEpochOffset = 0;
+    memset(stubPinLevel, 0, sizeof(stubPinLevel));
+    memset(stubPinIsr, 0, sizeof(stubPinIsr));
+    memset(&TIMERG0, 0, sizeof(TIMERG0));
+    stubPreferencesReset();
+    lastTemperature = 0;
+    triacOpeningPercentage = 0;
+    lastPower = 0;
+    temperatureReached = false;
+    regulationLatencyUs = 0;
+    maxRegulationLatencyUs = 0;
+
+    std::unique_ptr<Simulation> run(new Simulation(simulation));
+    return run->run();
+}
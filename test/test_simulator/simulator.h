@@ -0,0 +1,116 @@
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include <string>
+#include <vector>
+#include "controlLoop.h"
+#include "shellyEm.h"
+
+/**
+ * Simulateur du routeur sur la machine hôte.
+ * Le code du firmware est exécuté tel quel : SolarManager (interruptions de passage à zéro et du timer),
+ * ControlLoop (tâche de régulation), ShellyEm (tâche d'interrogation REST et notifications Gen2),
+ * EnergyManager, ControlStateMachine, RegulationTrace. Les tâches sont exécutées par l'ordonnanceur
+ * coopératif des substituts FreeRTOS (test/stubs/freertos/task.h), sur l'horloge virtuelle.
+ *
+ * Le simulateur fait avancer l'horloge d'un événement au suivant :
+ * - passage à zéro du secteur 50 Hz (et rebonds éventuels du détecteur) : interruption attachée par SolarManager ;
+ * - alarme du timer matériel : interruption du timer (amorçage, fin d'impulsion) ;
+ * - notification du Shelly Gen2 (mode poussé), livrée après le délai réseau ;
+ * - réveil d'une tâche (attente écoulée ou mesure reçue).
+ * La puissance du chauffe-eau est calculée à chaque alternance d'après l'instant réel de l'amorçage du triac
+ * (la sortie reste conductrice jusqu'au passage à zéro suivant). L'installation (production photovoltaïque,
+ * consommation de la maison, ballon d'eau chaude) est intégrée à chaque alternance.
+ *
+ * Non simulés : WiFi, serveur web, MQTT, LED, sonde OneWire (la température du ballon est lue directement),
+ * durée d'exécution du code (une tâche s'exécute en un temps virtuel nul).
+ */
+
+// Charge ponctuelle de la maison
+struct HouseLoad
+{
+    uint32_t start;    // Début (s depuis minuit, heure locale)
+    uint32_t duration; // Durée (s)
+    float power;       // Puissance (W)
+};
+
+// Installation simulée
+struct PlantConfig
+{
+    float heaterPower;        // Puissance réelle de la résistance (W)
+    float tankLitres;         // Volume du ballon (l)
+    float initialTemperature; // Température initiale de l'eau (°C)
+    float ambientTemperature; // Température du local (°C)
+    float tankLoss;           // Pertes du ballon (W/K)
+    float pvPeakPower;        // Production, soleil au zénith et ciel clair (W)
+    float cloudiness;         // Probabilité par minute du passage d'un nuage (0 : ciel clair)
+    uint32_t cloudSeed;       // Graine du tirage des nuages
+    float houseBase;          // Consommation de fond de la maison (W)
+    std::vector<HouseLoad> loads;
+};
+
+// Transport des mesures du Shelly Pro EM
+enum SimMeterTransport
+{
+    SIM_METER_POLL, // Interrogation REST par la tâche du compteur (EM1.GetStatus)
+    SIM_METER_PUSH  // Notifications NotifyStatus poussées sur le WebSocket sortant
+};
+
+struct SimulationConfig
+{
+    uint32_t date;      // Jour du début (AAAAMMJJ, heure locale du fuseau de la configuration)
+    uint32_t startTime; // Heure du début (s depuis minuit)
+    uint32_t duration;  // Durée simulée (s)
+    PlantConfig plant;
+    Config config;      // Configuration du routeur
+    SimMeterTransport transport;
+    uint32_t meterLatencyMs; // Durée d'une requête REST, ou délai d'acheminement d'une notification...
+    uint32_t meterJitterMs;  // ... augmenté d'un tirage entre 0 et cette valeur
+    uint32_t pushPeriodMs;   // Période des notifications
+    uint32_t outageStart;    // Compteur injoignable à partir de cet instant (s depuis le début)...
+    uint32_t outageDuration; // ... pendant cette durée (s), 0 : jamais
+    uint32_t bouncePeriod;   // Un rebond du détecteur de passage à zéro toutes les N alternances, 0 : aucun
+};
+
+struct SimulationReport
+{
+    // Énergies de l'installation simulée (Wh)
+    double pvEnergy;
+    double houseEnergy;
+    double heaterEnergy;
+    double importEnergy;
+    double exportEnergy;
+    double autoExportEnergy;   // Injection pendant la régulation (état CONTROL_AUTO), triac non saturé
+    double autoImportEnergy;   // Soutirage pendant la régulation, triac ouvert (retard de la régulation)
+    double polarityImbalance;  // Énergie routée sur les alternances positives - négatives (composante continue)
+    double outageHeaterEnergy; // Énergie routée pendant la panne du compteur, au-delà de METER_STALE_PERIOD
+    // Compteurs du firmware (EnergyManager)
+    EnergyTotals firmware;
+    float finalTemperature;
+    ControlState finalState;
+    uint32_t stateTransitions;
+    bool meterLostSeen; // État CONTROL_METER_LOST atteint
+
+    // Latences
+    uint32_t regulationPasses;       // Pas de régulation tracés
+    uint32_t maxRegulationLatencyUs; // Mesure reçue -> commande (maxRegulationLatencyUs du firmware)
+    double meanEndToEndMs;           // Mesure du compteur -> passage à zéro qui applique la commande (mode automatique)
+    double maxEndToEndMs;
+
+    // Interruptions
+    uint32_t zeroCrossEdges; // Fronts du détecteur (rebonds compris)
+    uint32_t bounceEdges;
+    TriacIsrStats isr;
+    MeterStats meter;
+
+    uint32_t tasksWakeups;   // Réveils des tâches
+    double hostSeconds;      // Durée réelle de la simulation
+};
+
+// Journée du 21 juin à Paris : 3 kWc, ballon de 200 l à 45 °C (consigne 60 °C), Shelly Pro EM interrogé toutes les secondes
+SimulationConfig defaultSimulation();
+
+// Exécute la simulation (l'horloge virtuelle et les valeurs partagées de la régulation sont réinitialisées)
+SimulationReport simulate(const SimulationConfig &simulation);
+
+#endif // SIMULATOR_H
@@ -0,0 +1,180 @@
+#include <unity.h>
+#include "simulator.h"
+
+/**
+ * Scénarios du simulateur (pio test -e native_sim) : journées complètes ou épisodes de quelques heures,
+ * exécutés en quelques secondes. Chaque scénario affiche son rapport (énergies, latences, interruptions)
+ * et vérifie le comportement de bout en bout du firmware.
+ * Pour profiler le firmware : pio test -e native_sim --without-testing, puis perf / valgrind sur
+ * .pio/build/native_sim/program.
+ */
+
+static void report(const char *scenario, const SimulationReport &report)
+{
+    char line[200];
+    snprintf(line, sizeof(line), "[SIM %s] PV %.0f Wh, maison %.0f Wh, routé %.0f Wh (compté %.0f Wh), soutiré %.0f Wh (dû au routage %.0f Wh), injecté %.0f Wh (en régulation %.0f Wh)",
+             scenario, report.pvEnergy, report.houseEnergy, report.heaterEnergy, report.firmware.total.routed, report.importEnergy, report.autoImportEnergy,
+             report.exportEnergy, report.autoExportEnergy);
+    TEST_MESSAGE(line);
+    snprintf(line, sizeof(line), "[SIM %s] ballon %.1f °C, état final %s, %u transitions, %u pas de régulation, %u notifications, %u requêtes (%u erreurs)",
+             scenario, report.finalTemperature, controlStateName(report.finalState), (unsigned)report.stateTransitions, (unsigned)report.regulationPasses,
+             (unsigned)report.meter.notifications, (unsigned)report.meter.requests, (unsigned)report.meter.errors);
+    TEST_MESSAGE(line);
+    snprintf(line, sizeof(line), "[SIM %s] latence mesure -> commande max %u µs, mesure -> alternance moyenne %.1f ms, max %.1f ms", scenario,
+             (unsigned)report.maxRegulationLatencyUs, report.meanEndToEndMs, report.maxEndToEndMs);
+    TEST_MESSAGE(line);
+    snprintf(line, sizeof(line), "[SIM %s] %u fronts (%u rebonds), %u passages à zéro, %u rejetés, %u alarmes du timer, %u réveils de tâches, %.2f s réelles",
+             scenario, (unsigned)report.zeroCrossEdges, (unsigned)report.bounceEdges, (unsigned)report.isr.zeroCrossCount,
+             (unsigned)report.isr.debouncedCount, (unsigned)report.isr.timerCount, (unsigned)report.tasksWakeups, report.hostSeconds);
+    TEST_MESSAGE(line);
+}
+
+// Bilan de l'installation : la production et le soutirage couvrent la maison, le chauffe-eau et l'injection
+static void assertEnergyBalance(const SimulationReport &result)
+{
+    double sources = result.pvEnergy + result.importEnergy;
+    double uses = result.houseEnergy + result.heaterEnergy + result.exportEnergy;
+    TEST_ASSERT_FLOAT_WITHIN(sources * 1e-4, sources, uses);
+}
+
+// Compteur du firmware : énergie routée estimée d'après la commande du triac (table d'angle de phase)
+static void assertRoutedCounter(const SimulationReport &result)
+{
+    TEST_ASSERT_FLOAT_WITHIN(result.heaterEnergy * 0.02 + 1, result.heaterEnergy, result.firmware.total.routed);
+}
+
+/**
+ * Compteurs du firmware : énergie réseau intégrée d'après les mesures du compteur.
+ * Les mesures sont des moyennes sur la période d'interrogation : soutirage et injection alternés à l'intérieur
+ * d'une période (trains d'ondes) se compensent, la comparaison n'a de sens qu'en angle de phase.
+ */
+static void assertGridCounters(const SimulationReport &result)
+{
+    TEST_ASSERT_FLOAT_WITHIN(result.importEnergy * 0.03 + 5, result.importEnergy, result.firmware.total.imported);
+    TEST_ASSERT_FLOAT_WITHIN(result.exportEnergy * 0.03 + 5, result.exportEnergy, result.firmware.total.exported);
+}
+
+// Chaque front du détecteur est traité par l'interruption, les rebonds sont rejetés
+static void assertZeroCross(const SimulationReport &result)
+{
+    TEST_ASSERT_EQUAL_UINT32(result.zeroCrossEdges - result.bounceEdges, result.isr.zeroCrossCount);
+    TEST_ASSERT_EQUAL_UINT32(result.bounceEdges, result.isr.debouncedCount);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+/**
+ * Journée ensoleillée, Shelly Pro EM interrogé toutes les secondes : routage du lever du soleil jusqu'à la
+ * consigne de température, puis arrêt jusqu'au lendemain.
+ */
+void test_sunny_day_polled()
+{
+    SimulationConfig simulation = defaultSimulation();
+    SimulationReport result = simulate(simulation);
+    report("soleil, REST 1 s", result);
+
+    assertEnergyBalance(result);
+    assertRoutedCounter(result);
+    assertGridCounters(result);
+    assertZeroCross(result);
+    // Consigne atteinte dans la journée
+    TEST_ASSERT_EQUAL(CONTROL_TEMPERATURE_REACHED, result.finalState);
+    TEST_ASSERT_TRUE(result.finalTemperature > 55);
+    // Surplus routé : peu d'injection pendant la régulation, peu de soutirage dû au chauffe-eau
+    TEST_ASSERT_TRUE(result.autoExportEnergy < result.heaterEnergy * 0.05);
+    TEST_ASSERT_TRUE(result.autoImportEnergy < result.heaterEnergy * 0.05);
+    // Toutes les mesures sont traitées, dans l'alternance qui suit leur réception
+    TEST_ASSERT_EQUAL_UINT32(result.meter.requests, result.regulationPasses);
+    TEST_ASSERT_EQUAL_UINT32(0, result.meter.errors);
+    TEST_ASSERT_TRUE(result.meanEndToEndMs > simulation.meterLatencyMs);
+    TEST_ASSERT_TRUE(result.maxEndToEndMs <= simulation.meterLatencyMs + simulation.meterJitterMs + MAINS_HALF_PERIOD_US / 1000.0);
+}
+
+/**
+ * Passages nuageux (10:00-16:00), mesures interrogées toutes les secondes puis poussées toutes les 200 ms
+ * par le Shelly Gen2 : les notifications suivent mieux les variations de la production.
+ */
+void test_cloudy_polled_vs_pushed()
+{
+    SimulationConfig simulation = defaultSimulation();
+    simulation.startTime = 10 * 3600;
+    simulation.duration = 6 * 3600;
+    simulation.plant.cloudiness = 0.15f;
+    simulation.plant.cloudSeed = 7;
+    simulation.plant.initialTemperature = 35;
+    simulation.config.boiler.temperature = 65;
+
+    SimulationReport polled = simulate(simulation);
+    report("nuages, REST 1 s", polled);
+    simulation.transport = SIM_METER_PUSH;
+    SimulationReport pushed = simulate(simulation);
+    report("nuages, Gen2 200 ms", pushed);
+
+    assertEnergyBalance(polled);
+    assertEnergyBalance(pushed);
+    assertRoutedCounter(pushed);
+    assertGridCounters(pushed);
+    TEST_ASSERT_EQUAL(CONTROL_AUTO, pushed.finalState);
+    // Mesures poussées : pas d'interrogation tant que les notifications arrivent
+    TEST_ASSERT_TRUE(pushed.meter.notifications >= simulation.duration * 4);
+    TEST_ASSERT_TRUE(pushed.meter.requests <= 1);
+    TEST_ASSERT_TRUE(pushed.autoExportEnergy + pushed.autoImportEnergy < polled.autoExportEnergy + polled.autoImportEnergy);
+}
+
+/**
+ * Shelly injoignable pendant 10 minutes en pleine production : le triac est coupé après METER_STALE_PERIOD
+ * (pas de routage à l'aveugle), puis la régulation reprend au retour des mesures.
+ */
+void test_meter_outage()
+{
+    SimulationConfig simulation = defaultSimulation();
+    simulation.startTime = 11 * 3600;
+    simulation.duration = 2 * 3600;
+    simulation.plant.initialTemperature = 35;
+    simulation.outageStart = 3600;
+    simulation.outageDuration = 600;
+
+    SimulationReport result = simulate(simulation);
+    report("compteur injoignable", result);
+
+    assertEnergyBalance(result);
+    TEST_ASSERT_TRUE(result.meterLostSeen);
+    TEST_ASSERT_EQUAL_FLOAT(0, result.outageHeaterEnergy);
+    TEST_ASSERT_TRUE(result.meter.timeouts > 0);
+    TEST_ASSERT_EQUAL(CONTROL_AUTO, result.finalState);
+}
+
+/**
+ * Commande en trains d'ondes, détecteur de passage à zéro qui rebondit une alternance sur sept :
+ * les rebonds sont rejetés et les périodes conduites restent complètes (pas de composante continue).
+ */
+void test_burst_with_bouncing_zero_cross()
+{
+    SimulationConfig simulation = defaultSimulation();
+    simulation.startTime = 11 * 3600;
+    simulation.duration = 2 * 3600;
+    simulation.plant.initialTemperature = 35;
+    simulation.config.boiler.outputMode = "burst";
+    simulation.bouncePeriod = 7;
+
+    SimulationReport result = simulate(simulation);
+    report("trains d'ondes, rebonds", result);
+
+    assertEnergyBalance(result);
+    assertRoutedCounter(result);
+    assertZeroCross(result);
+    TEST_ASSERT_TRUE(result.bounceEdges > 0);
+    TEST_ASSERT_FLOAT_WITHIN(result.heaterEnergy * 0.001, 0, result.polarityImbalance);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_sunny_day_polled);
+    RUN_TEST(test_cloudy_polled_vs_pushed);
+    RUN_TEST(test_meter_outage);
+    RUN_TEST(test_burst_with_bouncing_zero_cross);
+    return UNITY_END();
+}
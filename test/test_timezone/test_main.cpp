@@ -0,0 +1,32 @@
+#include <unity.h>
+#include "timezone.h"
+
+static const char *PARIS = "CET-1CEST,M3.5.0,M10.5.0/3";
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_known_timezones()
+{
+    TEST_ASSERT_EQUAL_STRING(PARIS, getPosixTimezone("Europe/Paris"));
+    TEST_ASSERT_EQUAL_STRING("EST5EDT,M3.2.0,M11.1.0", getPosixTimezone("America/New_York"));
+    TEST_ASSERT_EQUAL_STRING("NZST-12NZDT,M9.5.0,M4.1.0/3", getPosixTimezone("Pacific/Auckland"));
+    TEST_ASSERT_EQUAL_STRING("GMT0", getPosixTimezone("Africa/Abidjan"));
+}
+
+void test_unknown_timezone_falls_back_to_paris()
+{
+    TEST_ASSERT_EQUAL_STRING(PARIS, getPosixTimezone("Mars/Olympus_Mons"));
+    TEST_ASSERT_EQUAL_STRING(PARIS, getPosixTimezone(""));
+    // La recherche est exacte : la casse compte
+    TEST_ASSERT_EQUAL_STRING(PARIS, getPosixTimezone("america/new_york"));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_known_timezones);
+    RUN_TEST(test_unknown_timezone_falls_back_to_paris);
+    return UNITY_END();
+}
@@ -1,5 +1,5 @@
 import { Loader } from "lucide-react";
-import { boilerConfig, period } from "../context/configurationContext";
+import { boilerConfig, period, regulationConfig } from "../context/configurationContext";
 import { useRef, useEffect, useState } from "preact/hooks";
 import { FormEvent } from "react";
 import { Period } from "./period";
@@ -18,12 +18,28 @@ type PeriodType = period & {
 
 let nextId = 0;
 
+const defaultRegulation: regulationConfig = { setpoint: -30, kp: 0.2, ki: 0.5, kd: 0, maxRate: 25 };
+
+// Champs des réglages avancés de la régulation
+const regulationFields: { key: keyof regulationConfig; label: string; step: string }[] = [
+  { key: 'setpoint', label: 'Consigne de puissance réseau (W, positive pour un compteur sans mesure de l\'injection)', step: '1' },
+  { key: 'kp', label: 'Gain proportionnel (Kp)', step: '0.01' },
+  { key: 'ki', label: 'Gain intégral (Ki, 1/s)', step: '0.01' },
+  { key: 'kd', label: 'Gain dérivé (Kd, s)', step: '0.01' },
+  { key: 'maxRate', label: 'Variation maximale (% par seconde)', step: '1' },
+];
+
 export const BoilerForm = ({ onSubmit, boilerSettings, loading, sunRiseMinutes,sunSetMinutes }: boilerFormProps) => {
   
   const temperatureRef = useRef<HTMLInputElement>(null);
+  const heaterPowerRef = useRef<HTMLInputElement>(null);
   const [periods, setPeriods] = useState<PeriodType[]>([]);
   const [currentMode, setCurrentMode] = useState(boilerSettings?.mode?.toLowerCase() || 'auto');
   const [triacOpening, setTriacOpening] = useState(boilerSettings?.triacOpening || 50);
+  const [outputMode, setOutputMode] = useState<'phase' | 'burst'>(boilerSettings?.outputMode || 'phase');
+  const [sensorResolution, setSensorResolution] = useState(boilerSettings?.sensorResolution || 12);
+  const sensorIntervalRef = useRef<HTMLInputElement>(null);
+  const [regulation, setRegulation] = useState<regulationConfig>(boilerSettings?.regulation || defaultRegulation);
 
   const handleModeChange = (e: Event) => {
     setCurrentMode((e.target as HTMLInputElement).value);
@@ -35,29 +51,38 @@ export const BoilerForm = ({ onSubmit, boilerSettings, loading, sunRiseMinutes,s
     if (boilerSettings) {
       setCurrentMode(boilerSettings.mode.toLowerCase() || 'auto');
       setTriacOpening(boilerSettings.triacOpening || 50);
+      setOutputMode(boilerSettings.outputMode || 'phase');
+      setSensorResolution(boilerSettings.sensorResolution || 12);
+      if (sensorIntervalRef.current) {
+        sensorIntervalRef.current.value = ((boilerSettings.sensorInterval || 30000) / 1000).toString();
+      }
+      setRegulation(boilerSettings.regulation || defaultRegulation);
       if (temperatureRef.current) {
         temperatureRef.current.value = boilerSettings.temperature?.toString() || '50';
       }
+      if (heaterPowerRef.current) {
+        heaterPowerRef.current.value = boilerSettings.heaterPower?.toString() || '2000';
+      }
       if (boilerSettings.periods && boilerSettings.periods.length > 0) {
         initialPeriods = boilerSettings.periods.map((p) => ({ ...p, id: nextId++ }));
       }
     }
     if (initialPeriods.length === 0) {
       // Initialize with a default period if none exist
-      initialPeriods = [{ id: nextId++, start: sunRiseMinutes, end: sunSetMinutes, mode: 'auto' }];
+      initialPeriods = [{ id: nextId++, start: sunRiseMinutes, startSunrise: true, end: sunSetMinutes, endSunset: true, mode: 'auto' }];
     }
 
     setPeriods(initialPeriods);
   }, [boilerSettings]);
 
   // Fonction pour mettre à jour une période
-  const handlePeriodChange = (id: number, newValues: { start: number; end: number; mode: 'auto' | 'on' }) => {
+  const handlePeriodChange = (id: number, newValues: period) => {
     setPeriods(periods.map(p => p.id === id ? { ...p, ...newValues } : p));
   };
 
   // Fonction pour ajouter une nouvelle période
   const addPeriod = () => {
-    setPeriods([...periods, { id: nextId++, start: sunRiseMinutes, end: sunSetMinutes, mode: 'auto' }]);
+    setPeriods([...periods, { id: nextId++, start: sunRiseMinutes, startSunrise: true, end: sunSetMinutes, endSunset: true, mode: 'auto' }]);
   };
 
   // Fonction pour supprimer une période
@@ -76,7 +101,12 @@ export const BoilerForm = ({ onSubmit, boilerSettings, loading, sunRiseMinutes,s
       mode: currentMode,
       temperature: parseFloat(temperatureRef.current?.value || "50"),
       periods: periods.map(({ start, end, mode, startSunrise, startSunset, endSunrise, endSunset }) => ({ start, end, mode, startSunrise, startSunset, endSunrise, endSunset })),
-      triacOpening: currentMode === 'manual' ? triacOpening : undefined
+      triacOpening: currentMode === 'manual' ? triacOpening : undefined,
+      heaterPower: parseInt(heaterPowerRef.current?.value || "2000"),
+      outputMode,
+      sensorResolution,
+      sensorInterval: Math.round(parseFloat(sensorIntervalRef.current?.value || "30") * 1000),
+      regulation
     };
     onSubmit(newSettings);
   }
@@ -95,6 +125,62 @@ export const BoilerForm = ({ onSubmit, boilerSettings, loading, sunRiseMinutes,s
           required
         />
       </div>
+      <div>
+        <label htmlFor="heaterPower" className="block text-sm font-medium text-gray-700">Puissance de la résistance du chauffe-eau (W)</label>
+        <input
+          id="heaterPower"
+          name="heaterPower"
+          type="number"
+          min="100"
+          max="10000"
+          ref={heaterPowerRef}
+          className="mt-1 block w-full rounded-md border-gray-300 shadow-sm focus:border-indigo-500 focus:ring-indigo-500 text-lg px-4 py-3"
+          placeholder="2000 W"
+          required
+        />
+      </div>
+      <div>
+        <label htmlFor="outputMode" className="block text-sm font-medium text-gray-700">Commande du triac</label>
+        <select
+          id="outputMode"
+          name="outputMode"
+          value={outputMode}
+          onChange={(e) => setOutputMode((e.target as HTMLSelectElement).value as 'phase' | 'burst')}
+          className="mt-1 block w-full rounded-md border-gray-300 shadow-sm focus:border-indigo-500 focus:ring-indigo-500 text-lg px-4 py-3"
+        >
+          <option value="phase">Angle de phase (réglage fin à chaque alternance)</option>
+          <option value="burst">Train d'ondes (périodes complètes, moins de perturbations)</option>
+        </select>
+      </div>
+      <div>
+        <label htmlFor="sensorResolution" className="block text-sm font-medium text-gray-700">Résolution de la sonde de température</label>
+        <select
+          id="sensorResolution"
+          name="sensorResolution"
+          value={sensorResolution}
+          onChange={(e) => setSensorResolution(parseInt((e.target as HTMLSelectElement).value))}
+          className="mt-1 block w-full rounded-md border-gray-300 shadow-sm focus:border-indigo-500 focus:ring-indigo-500 text-lg px-4 py-3"
+        >
+          <option value="9">9 bits (0,5 °C, conversion 94 ms)</option>
+          <option value="10">10 bits (0,25 °C, conversion 188 ms)</option>
+          <option value="11">11 bits (0,125 °C, conversion 375 ms)</option>
+          <option value="12">12 bits (0,0625 °C, conversion 750 ms)</option>
+        </select>
+      </div>
+      <div>
+        <label htmlFor="sensorInterval" className="block text-sm font-medium text-gray-700">Période de lecture de la température (s)</label>
+        <input
+          id="sensorInterval"
+          name="sensorInterval"
+          type="number"
+          min="1"
+          max="3600"
+          ref={sensorIntervalRef}
+          className="mt-1 block w-full rounded-md border-gray-300 shadow-sm focus:border-indigo-500 focus:ring-indigo-500 text-lg px-4 py-3"
+          placeholder="30 s"
+          required
+        />
+      </div>
       {/* // Mode */}
       <div>
         <span className="block text-sm font-medium text-gray-700 mb-4">Mode de fonctionnement</span>
@@ -147,7 +233,7 @@ export const BoilerForm = ({ onSubmit, boilerSettings, loading, sunRiseMinutes,s
       {currentMode === 'manual' && (
         <div>
           <label htmlFor="triacOpening" className="block text-sm font-medium text-gray-700 mb-2">
-            Pourcentage d'ouverture du triac : {triacOpening}%
+            Puissance du chauffe-eau : {triacOpening}%
           </label>
           <input
             id="triacOpening"
@@ -176,6 +262,10 @@ export const BoilerForm = ({ onSubmit, boilerSettings, loading, sunRiseMinutes,s
                 key={period.id}
                 periodStart={period.start}
                 periodEnd={period.end}
+                startSunrise={period.startSunrise}
+                startSunset={period.startSunset}
+                endSunrise={period.endSunrise}
+                endSunset={period.endSunset}
                 sunRise={sunRiseMinutes} // This should probably come from props/context
                 sunSet={sunSetMinutes} // This should probably come from props/context
                 canDelete={periods.length > 1}
@@ -194,6 +284,24 @@ export const BoilerForm = ({ onSubmit, boilerSettings, loading, sunRiseMinutes,s
               + Période
             </button>
           </div>
+          <details>
+            <summary className="text-sm font-medium text-gray-700 cursor-pointer">Réglages avancés de la régulation</summary>
+            <div className="mt-4 grid grid-cols-1 gap-4 sm:grid-cols-2">
+              {regulationFields.map(({ key, label, step }) => (
+                <div key={key}>
+                  <label htmlFor={`regulation-${key}`} className="block text-sm font-medium text-gray-700">{label}</label>
+                  <input
+                    id={`regulation-${key}`}
+                    type="number"
+                    step={step}
+                    value={regulation[key]}
+                    onChange={(e) => setRegulation({ ...regulation, [key]: parseFloat((e.target as HTMLInputElement).value) || 0 })}
+                    className="mt-1 block w-full rounded-md border-gray-300 shadow-sm focus:border-indigo-500 focus:ring-indigo-500 px-4 py-2"
+                  />
+                </div>
+              ))}
+            </div>
+          </details>
         </>
       )}
 
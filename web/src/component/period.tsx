@@ -7,6 +7,10 @@ interface periodProps {
  canDelete: boolean;
  periodStart: number;
  periodEnd: number;
+ startSunrise?: boolean; // Début ancré au lever du soleil
+ startSunset?: boolean;  // Début ancré au coucher du soleil
+ endSunrise?: boolean;   // Fin ancrée au lever du soleil
+ endSunset?: boolean;    // Fin ancrée au coucher du soleil
  sunRise: number;
  sunSet: number;
  mode: 'auto' | 'on';
@@ -19,21 +23,24 @@ interface periodProps {
 * @param param0
 * @returns
 */
-export const Period = ({ periodStart, periodEnd, sunRise, sunSet, onDelete, canDelete, onChange, mode }: periodProps) => {
+export const Period = ({ periodStart, periodEnd, startSunrise, startSunset, endSunrise, endSunset, sunRise, sunSet, onDelete, canDelete, onChange, mode }: periodProps) => {
+
+ // Ancrages transmis par l'ESP32 : une borne ancrée suit le lever / coucher du soleil de chaque jour
+ const anchors = { startSunrise, startSunset, endSunrise, endSunset };
 
  const FormatStart = (start: number): string => {
-  if (start == sunRise) {
+  if (startSunrise) {
    return "Du lever du soleil";
-  } else if (start == sunSet) {
+  } else if (startSunset) {
    return "Du coucher du soleil";
   }
   return `De ${formatMinuteToTime(start)}`;
  };
 
  const FormatEnd = (end: number): string => {
-  if (end == sunRise) {
+  if (endSunrise) {
    return "au lever du soleil";
-  } else if (end == sunSet) {
+  } else if (endSunset) {
    return "au coucher du soleil";
   } else {
    return "à " + formatMinuteToTime(end);
@@ -63,14 +70,14 @@ export const Period = ({ periodStart, periodEnd, sunRise, sunSet, onDelete, canD
       <button
        type="button"
        className={`relative rounded-full py-1 px-4 text-sm font-medium transition-colors whitespace-nowrap ${mode === 'auto' ? 'bg-white text-gray-900' : 'text-gray-500'}`}
-       onClick={() => onChange({ start: periodStart, end: periodEnd, mode: 'auto' })}
+       onClick={() => onChange({ start: periodStart, end: periodEnd, mode: 'auto', ...anchors })}
       >
        Auto
       </button>
       <button
        type="button"
        className={`relative rounded-full py-1 px-4 text-sm font-medium transition-colors whitespace-nowrap ${mode === 'on' ? 'bg-white text-gray-900' : 'text-gray-500'}`}
-       onClick={() => onChange({ start: periodStart, end: periodEnd, mode: 'on' })}
+       onClick={() => onChange({ start: periodStart, end: periodEnd, mode: 'on', ...anchors })}
       >
        On
       </button>
@@ -1,26 +1,40 @@
-import { useEffect, useRef } from "preact/hooks";
-import { boilerConfig, shellyEmConfig, solarConfig } from "../context/configurationContext";
+import { useEffect, useRef, useState } from "preact/hooks";
+import { boilerConfig, meterConfig, shellyEmConfig, solarConfig } from "../context/configurationContext";
 import { Loader } from "lucide-react";
 import { timeZones } from "../helper/timezone";
 
 
 
+// Valeurs par défaut (identiques à celles du firmware)
+const defaultMeter: meterConfig = {
+  source: 'shelly',
+  linky: { standard: false, rxPin: 16 },
+  modbus: { transport: 'rtu', device: 'sdm120', address: 1, host: '', port: 502, baudRate: 9600, rxPin: 16, txPin: 17, dePin: -1, pollPeriod: 1000 },
+  mqtt: { topic: '', key: '' },
+};
+
 interface solarFormProps {
-  onSubmit: ( shellyEmSettings? : shellyEmConfig, solarSettings?: solarConfig  ) => Promise<any>;
+  onSubmit: ( shellyEmSettings? : shellyEmConfig, solarSettings?: solarConfig, meterSettings?: meterConfig ) => Promise<any>;
   loading?: boolean;
   boilerSettings?: boilerConfig;
   shellyEmSettings? : shellyEmConfig;
   solarSettings? : solarConfig;
+  meterSettings? : meterConfig;
 }
 
 
 /**
  * Simple form for updating the ShellyEM IP address.
  */
-function SolarForm({ onSubmit, loading,  shellyEmSettings, solarSettings }: solarFormProps) {
+function SolarForm({ onSubmit, loading,  shellyEmSettings, solarSettings, meterSettings }: solarFormProps) {
+  const [meter, setMeter] = useState<meterConfig>(meterSettings || defaultMeter);
+  const updateMeter = (changes: Partial<meterConfig>) => setMeter({ ...meter, ...changes });
+  const updateModbus = (changes: Partial<meterConfig['modbus']>) => setMeter({ ...meter, modbus: { ...meter.modbus, ...changes } });
   const ipRef = useRef<HTMLInputElement>(null);
   const channel1Ref = useRef<HTMLInputElement>(null);
   const channel2Ref = useRef<HTMLInputElement>(null);    
+  const pollPeriodRef = useRef<HTMLInputElement>(null);
+  const modelRef = useRef<HTMLSelectElement>(null);
   const latitudeRef = useRef<HTMLInputElement>(null);
   const longitudeRef = useRef<HTMLInputElement>(null);
   const timezoneRef = useRef<HTMLSelectElement>(null);
@@ -32,66 +46,206 @@ function SolarForm({ onSubmit, loading,  shellyEmSettings, solarSettings }: sola
       if (ipRef.current) ipRef.current.value = shellyEmSettings.ip || '';
       if (channel1Ref.current) channel1Ref.current.checked = shellyEmSettings.channel === '1';
       if (channel2Ref.current) channel2Ref.current.checked = shellyEmSettings.channel === '2';      
+      if (modelRef.current) modelRef.current.value = shellyEmSettings.model || 'em';
+      if (pollPeriodRef.current) pollPeriodRef.current.value = (shellyEmSettings.pollPeriod ?? 1000).toString();
       if (latitudeRef.current) latitudeRef.current.value = solarSettings.latitude?.toString() || '';
       if (longitudeRef.current) longitudeRef.current.value = solarSettings.longitude?.toString() || '';
       if (timezoneRef.current) timezoneRef.current.value = solarSettings.timeZone || 'Europe/Paris';
     }
   }, [ shellyEmSettings, solarSettings]);
 
+  useEffect(() => {
+    if (meterSettings) setMeter(meterSettings);
+  }, [meterSettings]);
+
   // Handles the form submission for Solar settings.
   const handleSubmit = (e: Event) => {
     e.preventDefault();
     const  dataShelly : shellyEmConfig = {
       ip : ipRef.current?.value || '',
       channel : channel1Ref.current?.checked ? '1' : '2',
+      model : (modelRef.current?.value || 'em') as shellyEmConfig['model'],
+      pollPeriod : Math.max(200, parseInt(pollPeriodRef.current?.value || '1000')),
     }    
     const dataSolar : solarConfig = {
         latitude: parseFloat(latitudeRef.current?.value || '0'),
         longitude: parseFloat(longitudeRef.current?.value || '0'),
         timeZone: timezoneRef.current?.value || 'Europe/Paris',        
     }
-    onSubmit( dataShelly, dataSolar);
+    onSubmit( dataShelly, dataSolar, meter);
   };
 
   return (
     <form onSubmit={handleSubmit} className="space-y-6">
       <div>
-        <label htmlFor="shellyIp" className="block text-sm font-medium text-gray-700">Adresse IP du module ShellyEM</label>
-        <input
-          id="shellyIp"
-          name="shellyIp"
-          type="text"
-          ref={ipRef}
+        <label htmlFor="meterSource" className="block text-sm font-medium text-gray-700">Mesure de la puissance réseau</label>
+        <select
+          id="meterSource"
+          name="meterSource"
+          value={meter.source}
+          onChange={(e) => updateMeter({ source: (e.target as HTMLSelectElement).value as meterConfig['source'] })}
           className="mt-1 block w-full rounded-md border-gray-300 shadow-sm focus:border-indigo-500 focus:ring-indigo-500 text-lg px-4 py-3"
-          placeholder="192.168.1.100"
-          required
-        />
+        >
+          <option value="shelly">Shelly EM / Pro EM</option>
+          <option value="linky">Linky (TIC)</option>
+          <option value="modbus">Compteur Modbus (SDM120, SDM630, PZEM)</option>
+          <option value="mqtt">Topic MQTT</option>
+        </select>
       </div>
-      <div>
-        <span className="block text-sm font-medium text-gray-700 mb-1">Channel du module Shelly</span>
-        <label className="inline-flex items-center mr-4">
+      {meter.source === 'linky' && (
+        <div className="space-y-4">
+          <div>
+            <span className="block text-sm font-medium text-gray-700 mb-1">Mode de la TIC</span>
+            <label className="inline-flex items-center mr-4">
+              <input type="radio" name="ticMode" checked={!meter.linky.standard} onChange={() => updateMeter({ linky: { ...meter.linky, standard: false } })} className="form-radio text-indigo-600" />
+              <span className="ml-2">Historique (1200 bauds)</span>
+            </label>
+            <label className="inline-flex items-center">
+              <input type="radio" name="ticMode" checked={meter.linky.standard} onChange={() => updateMeter({ linky: { ...meter.linky, standard: true } })} className="form-radio text-indigo-600" />
+              <span className="ml-2">Standard (9600 bauds)</span>
+            </label>
+            <p className="mt-1 text-sm text-gray-500">
+              Sans SINSTI (mode historique ou compteur consommateur), l'injection n'est pas mesurée : la régulation vise un léger soutirage (consigne positive, 50 W si la consigne réglée est négative ou nulle).
+            </p>
+          </div>
+          <div>
+            <label htmlFor="ticRxPin" className="block text-sm font-medium text-gray-700">Broche de réception de la TIC</label>
+            <input id="ticRxPin" type="number" value={meter.linky.rxPin} onInput={(e) => updateMeter({ linky: { ...meter.linky, rxPin: parseInt((e.target as HTMLInputElement).value) } })} className="mt-1 block w-full rounded-md border-gray-300 shadow-sm focus:border-indigo-500 focus:ring-indigo-500 text-lg px-4 py-3" />
+          </div>
+        </div>
+      )}
+      {meter.source === 'modbus' && (
+        <div className="space-y-4">
+          <div>
+            <label htmlFor="modbusDevice" className="block text-sm font-medium text-gray-700">Compteur</label>
+            <select id="modbusDevice" value={meter.modbus.device} onChange={(e) => updateModbus({ device: (e.target as HTMLSelectElement).value as meterConfig['modbus']['device'] })} className="mt-1 block w-full rounded-md border-gray-300 shadow-sm focus:border-indigo-500 focus:ring-indigo-500 text-lg px-4 py-3">
+              <option value="sdm120">Eastron SDM120</option>
+              <option value="sdm630">Eastron SDM630</option>
+              <option value="pzem">PZEM-004T v3 (sans sens du transit)</option>
+            </select>
+            {meter.modbus.device === 'pzem' && (
+              <p className="mt-1 text-sm text-gray-500">
+                L'injection n'est pas mesurée : la régulation vise un léger soutirage (consigne positive, 50 W si la consigne réglée est négative ou nulle).
+              </p>
+            )}
+          </div>
+          <div>
+            <label htmlFor="modbusTransport" className="block text-sm font-medium text-gray-700">Liaison</label>
+            <select id="modbusTransport" value={meter.modbus.transport} onChange={(e) => updateModbus({ transport: (e.target as HTMLSelectElement).value as meterConfig['modbus']['transport'] })} className="mt-1 block w-full rounded-md border-gray-300 shadow-sm focus:border-indigo-500 focus:ring-indigo-500 text-lg px-4 py-3">
+              <option value="rtu">RTU (RS485)</option>
+              <option value="tcp">TCP</option>
+            </select>
+          </div>
+          <div>
+            <label htmlFor="modbusAddress" className="block text-sm font-medium text-gray-700">Adresse Modbus</label>
+            <input id="modbusAddress" type="number" min="1" max="247" value={meter.modbus.address} onInput={(e) => updateModbus({ address: parseInt((e.target as HTMLInputElement).value) })} className="mt-1 block w-full rounded-md border-gray-300 shadow-sm focus:border-indigo-500 focus:ring-indigo-500 text-lg px-4 py-3" />
+          </div>
+          {meter.modbus.transport === 'tcp' ? (
+            <div>
+              <label htmlFor="modbusHost" className="block text-sm font-medium text-gray-700">Adresse IP et port</label>
+              <div className="flex gap-2">
+                <input id="modbusHost" type="text" placeholder="192.168.1.50" value={meter.modbus.host} onInput={(e) => updateModbus({ host: (e.target as HTMLInputElement).value })} className="mt-1 block w-full rounded-md border-gray-300 shadow-sm focus:border-indigo-500 focus:ring-indigo-500 text-lg px-4 py-3" required />
+                <input id="modbusPort" type="number" value={meter.modbus.port} onInput={(e) => updateModbus({ port: parseInt((e.target as HTMLInputElement).value) })} className="mt-1 block w-full rounded-md border-gray-300 shadow-sm focus:border-indigo-500 focus:ring-indigo-500 text-lg px-4 py-3" />
+              </div>
+            </div>
+          ) : (
+            <div>
+              <label className="block text-sm font-medium text-gray-700">Vitesse, broches RX / TX / DE (-1 : direction automatique)</label>
+              <div className="flex gap-2">
+                <input type="number" value={meter.modbus.baudRate} onInput={(e) => updateModbus({ baudRate: parseInt((e.target as HTMLInputElement).value) })} className="mt-1 block w-full rounded-md border-gray-300 shadow-sm focus:border-indigo-500 focus:ring-indigo-500 text-lg px-4 py-3" />
+                <input type="number" value={meter.modbus.rxPin} onInput={(e) => updateModbus({ rxPin: parseInt((e.target as HTMLInputElement).value) })} className="mt-1 block w-full rounded-md border-gray-300 shadow-sm focus:border-indigo-500 focus:ring-indigo-500 text-lg px-4 py-3" />
+                <input type="number" value={meter.modbus.txPin} onInput={(e) => updateModbus({ txPin: parseInt((e.target as HTMLInputElement).value) })} className="mt-1 block w-full rounded-md border-gray-300 shadow-sm focus:border-indigo-500 focus:ring-indigo-500 text-lg px-4 py-3" />
+                <input type="number" value={meter.modbus.dePin} onInput={(e) => updateModbus({ dePin: parseInt((e.target as HTMLInputElement).value) })} className="mt-1 block w-full rounded-md border-gray-300 shadow-sm focus:border-indigo-500 focus:ring-indigo-500 text-lg px-4 py-3" />
+              </div>
+            </div>
+          )}
+          <div>
+            <label htmlFor="modbusPollPeriod" className="block text-sm font-medium text-gray-700">Période de lecture (ms)</label>
+            <input id="modbusPollPeriod" type="number" min="200" step="100" value={meter.modbus.pollPeriod} onInput={(e) => updateModbus({ pollPeriod: parseInt((e.target as HTMLInputElement).value) })} className="mt-1 block w-full rounded-md border-gray-300 shadow-sm focus:border-indigo-500 focus:ring-indigo-500 text-lg px-4 py-3" />
+          </div>
+        </div>
+      )}
+      {meter.source === 'mqtt' && (
+        <div className="space-y-4">
+          <div>
+            <label htmlFor="mqttMeterTopic" className="block text-sm font-medium text-gray-700">Topic de la puissance réseau (W, négative en injection)</label>
+            <input id="mqttMeterTopic" type="text" placeholder="tele/compteur/SENSOR" value={meter.mqtt.topic} onInput={(e) => updateMeter({ mqtt: { ...meter.mqtt, topic: (e.target as HTMLInputElement).value } })} className="mt-1 block w-full rounded-md border-gray-300 shadow-sm focus:border-indigo-500 focus:ring-indigo-500 text-lg px-4 py-3" required />
+          </div>
+          <div>
+            <label htmlFor="mqttMeterKey" className="block text-sm font-medium text-gray-700">Clé JSON (vide si le message contient la valeur seule)</label>
+            <input id="mqttMeterKey" type="text" placeholder="ENERGY.Power" value={meter.mqtt.key} onInput={(e) => updateMeter({ mqtt: { ...meter.mqtt, key: (e.target as HTMLInputElement).value } })} className="mt-1 block w-full rounded-md border-gray-300 shadow-sm focus:border-indigo-500 focus:ring-indigo-500 text-lg px-4 py-3" />
+          </div>
+        </div>
+      )}
+      <div className={meter.source === 'shelly' ? 'space-y-6' : 'hidden'}>
+        <div>
+          <label htmlFor="shellyIp" className="block text-sm font-medium text-gray-700">Adresse IP du module ShellyEM</label>
           <input
-            type="radio"
-            name="shellyChannel"
-            value="1"
-            ref={channel1Ref}
-            className="form-radio text-indigo-600"
-            defaultChecked={shellyEmSettings?.channel === '1'}
+            id="shellyIp"
+            name="shellyIp"
+            type="text"
+            ref={ipRef}
+            className="mt-1 block w-full rounded-md border-gray-300 shadow-sm focus:border-indigo-500 focus:ring-indigo-500 text-lg px-4 py-3"
+            placeholder="192.168.1.100"
+            required={meter.source === 'shelly'}
           />
-          <span className="ml-2">Channel 1</span>
-        </label>
-        <label className="inline-flex items-center">
+        </div>
+        <div>
+          <span className="block text-sm font-medium text-gray-700 mb-1">Channel du module Shelly</span>
+          <label className="inline-flex items-center mr-4">
+            <input
+              type="radio"
+              name="shellyChannel"
+              value="1"
+              ref={channel1Ref}
+              className="form-radio text-indigo-600"
+              defaultChecked={shellyEmSettings?.channel === '1'}
+            />
+            <span className="ml-2">Channel 1</span>
+          </label>
+          <label className="inline-flex items-center">
+            <input
+              type="radio"
+              name="shellyChannel"
+              value="2"
+              ref={channel2Ref}
+              className="form-radio text-indigo-600"
+              defaultChecked={shellyEmSettings?.channel=== '2'}
+            />
+            <span className="ml-2">Channel 2</span>
+          </label>
+        </div>            
+        <div>
+          <label htmlFor="shellyModel" className="block text-sm font-medium text-gray-700">Modèle du compteur Shelly</label>
+          <select
+            id="shellyModel"
+            name="shellyModel"
+            ref={modelRef}
+            className="mt-1 block w-full rounded-md border-gray-300 shadow-sm focus:border-indigo-500 focus:ring-indigo-500 text-lg px-4 py-3"
+          >
+            <option value="em">Shelly EM (Gen1)</option>
+            <option value="proem">Shelly Pro EM (Gen2)</option>
+            <option value="pro3em">Shelly Pro 3EM (Gen2, somme des 3 phases)</option>
+          </select>
+          <p className="mt-1 text-sm text-gray-500">
+            Gen2 : activer le WebSocket sortant du Shelly vers ws://&lt;adresse du routeur&gt;/shelly pour recevoir les mesures dès qu'elles changent.
+          </p>
+        </div>
+        <div>
+          <label htmlFor="pollPeriod" className="block text-sm font-medium text-gray-700">Période de lecture du ShellyEM (ms)</label>
           <input
-            type="radio"
-            name="shellyChannel"
-            value="2"
-            ref={channel2Ref}
-            className="form-radio text-indigo-600"
-            defaultChecked={shellyEmSettings?.channel=== '2'}
+            id="pollPeriod"
+            name="pollPeriod"
+            type="number"
+            min="200"
+            step="100"
+            ref={pollPeriodRef}
+            className="mt-1 block w-full rounded-md border-gray-300 shadow-sm focus:border-indigo-500 focus:ring-indigo-500 text-lg px-4 py-3"
+            placeholder="1000"
+            required={meter.source === 'shelly'}
           />
-          <span className="ml-2">Channel 2</span>
-        </label>
-      </div>            
+        </div>
+      </div>
       <div>
         <label htmlFor="latitude" className="block text-sm font-medium text-gray-700">Latitude</label>
         <input
@@ -27,6 +27,35 @@ export type mqttConfig= {
 export type shellyEmConfig ={
     ip: string;
     channel: string;
+    pollPeriod: number; // Période d'interrogation (ms), 200 minimum
+    model: 'em' | 'proem' | 'pro3em'; // Shelly EM (Gen1), Pro EM ou Pro 3EM (Gen2)
+}
+
+/**
+ *  Source de la mesure de puissance réseau
+ */
+export type meterConfig = {
+    source: 'shelly' | 'linky' | 'modbus' | 'mqtt';
+    linky: {
+        standard: boolean; // TIC en mode standard (9600 bauds), sinon historique (1200 bauds)
+        rxPin: number;
+    };
+    modbus: {
+        transport: 'rtu' | 'tcp';
+        device: 'sdm120' | 'sdm630' | 'pzem';
+        address: number; // Adresse de l'esclave Modbus
+        host: string; // Adresse IP (TCP)
+        port: number;
+        baudRate: number;
+        rxPin: number;
+        txPin: number;
+        dePin: number; // -1 si le transceiver RS485 gère seul la direction
+        pollPeriod: number; // Période d'interrogation (ms), 200 minimum
+    };
+    mqtt: {
+        topic: string; // Topic complet de la puissance
+        key: string; // Chemin de la puissance dans le JSON (ex: ENERGY.Power), vide si valeur seule
+    };
 }
 
 /**
@@ -36,7 +65,23 @@ export type boilerConfig= {
     mode: string; // Auto, On ou Off  Auto = Routeur solaire , On = Marche forcée
     temperature?: number; // Températue cible du chauffe eau
     periods?: period[]; // List of heating periods
-    triacOpening?: number; // Pourcentage d'ouverture du triac en mode manuel (0-100)
+    triacOpening?: number; // Puissance commandée en mode manuel (% de la puissance nominale, 0-100)
+    heaterPower?: number; // Puissance nominale de la résistance du chauffe-eau (W)
+    outputMode?: 'phase' | 'burst'; // Commande du triac : angle de phase ou train d'ondes
+    sensorResolution?: number; // Résolution de la sonde de température (bits, 9-12)
+    sensorInterval?: number; // Période de lecture de la sonde de température (ms)
+    regulation?: regulationConfig; // Paramètres du régulateur de puissance routée
+}
+
+/**
+ *  Paramètres du régulateur PID de la puissance routée
+ */
+export type regulationConfig = {
+    setpoint: number; // Puissance réseau visée (W), négative pour garder une légère injection
+    kp: number; // Gain proportionnel
+    ki: number; // Gain intégral (1/s)
+    kd: number; // Gain dérivé (s)
+    maxRate: number; // Variation maximale de la commande (% par seconde)
 }
 
 
@@ -66,6 +111,7 @@ export type config ={
     wifi: wifiConfig;
     mqtt: mqttConfig;
     shellyEm: shellyEmConfig;
+    meter: meterConfig;
     boiler: boilerConfig;
     solar: solarConfig;
 }
@@ -1,5 +1,11 @@
 import { useState, useEffect, useRef } from 'preact/hooks';
 
+// Point d'historique
+export interface HistoryPoint {
+    time: number;
+    value: number;
+}
+
 // Structure des données reçues via WebSocket
 interface WebSocketData {
     temperature?: number;
@@ -7,12 +13,60 @@ interface WebSocketData {
     sunset?: string;
     triacOpeningPercentage?: number;
     temperatureReached?: boolean;
+    routedPower?: number; // Puissance routée vers le chauffe-eau (W)
+    routedEnergyToday?: number; // Énergie routée depuis minuit (Wh)
     currentFirmwareVersion?: string;
     newFirmwareVersion?: string;
-    temperatureHistory?: { time: number, value: number }[];
-    triacHistory?: { time: number, value: number }[];
+    temperatureHistory?: HistoryPoint[];
+    triacHistory?: HistoryPoint[];
 }
 
+// Messages émis par l'ESP32 (voir WebServerManager::broadcastData / broadcastHistoryPoint / sendHistory)
+// Les points d'historique sont transmis sous forme de tableaux [time, value]
+type RawPoint = [number, number];
+
+type LiveMessage = {
+    type: 'live';
+    seq: number;
+    temperature: number;
+    triacOpeningPercentage: number;
+    temperatureReached: boolean;
+    routedPower: number;
+    routedEnergyToday: number;
+    currentFirmwareVersion: string;
+    lastFirmwareVersion?: string;
+};
+
+type HistoryMessage = {
+    type: 'history';
+    seq: number;
+    temperatureHistory: RawPoint[];
+    triacHistory: RawPoint[];
+};
+
+type AppendMessage = {
+    type: 'append';
+    seq: number;
+    temperature: RawPoint;
+    triac: RawPoint;
+};
+
+type Esp32Message = LiveMessage | HistoryMessage | AppendMessage;
+
+// Durée de l'historique conservé côté client (24 heures)
+const HISTORY_DURATION = 24 * 3600;
+
+const toPoint = ([time, value]: RawPoint): HistoryPoint => ({ time, value });
+
+// Ajoute un point et supprime ceux qui sortent de la fenêtre de 24 heures
+const appendPoint = (history: HistoryPoint[] | undefined, point: HistoryPoint): HistoryPoint[] => {
+    const next = [...(history || []), point];
+    const minTime = point.time - HISTORY_DURATION;
+    let first = 0;
+    while (first < next.length && next[first].time < minTime) first++;
+    return first > 0 ? next.slice(first) : next;
+};
+
 // Énumération pour le statut de la connexion
 export enum ConnectionStatus {
     Connecting = 'Connecting',
@@ -23,12 +77,16 @@ export enum ConnectionStatus {
 
 /**
  * Hook pour gérer la connexion WebSocket avec l'ESP32.
+ * L'historique est reçu une fois à la connexion puis complété point par point.
+ * En cas de trou dans les numéros de séquence, une resynchronisation est demandée.
  * @returns Un objet contenant les dernières données reçues et le statut de la connexion.
  */
 export function useEsp32WebSocket() {
     const [data, setData] = useState<WebSocketData>({ temperature: undefined, triacOpeningPercentage: undefined, temperatureReached: false, currentFirmwareVersion: undefined, newFirmwareVersion: undefined });
     const [status, setStatus] = useState<ConnectionStatus>(ConnectionStatus.Closed);
     const ws = useRef<WebSocket | null>(null);
+    // Dernier numéro de séquence d'historique reçu (null tant que l'historique complet n'est pas reçu)
+    const lastSeq = useRef<number | null>(null);
 
     useEffect(() => {
         // Ne s'exécute que côté client
@@ -36,10 +94,65 @@ export function useEsp32WebSocket() {
             return;
         }
 
+        const resync = () => {
+            lastSeq.current = null;
+            if (ws.current?.readyState === WebSocket.OPEN) {
+                ws.current.send(JSON.stringify({ type: 'resync' }));
+            }
+        };
+
+        const handleMessage = (message: Esp32Message) => {
+            switch (message.type) {
+                case 'history':
+                    lastSeq.current = message.seq;
+                    setData(d => ({
+                        ...d,
+                        temperatureHistory: message.temperatureHistory.map(toPoint),
+                        triacHistory: message.triacHistory.map(toPoint),
+                    }));
+                    break;
+
+                case 'append':
+                    if (lastSeq.current === null) {
+                        // Historique complet pas encore reçu : il contiendra ce point
+                        break;
+                    }
+                    if (message.seq !== lastSeq.current + 1) {
+                        resync();
+                        break;
+                    }
+                    lastSeq.current = message.seq;
+                    setData(d => ({
+                        ...d,
+                        temperatureHistory: appendPoint(d.temperatureHistory, toPoint(message.temperature)),
+                        triacHistory: appendPoint(d.triacHistory, toPoint(message.triac)),
+                    }));
+                    break;
+
+                case 'live':
+                    if (lastSeq.current !== null && message.seq !== lastSeq.current) {
+                        // Un point d'historique a été manqué
+                        resync();
+                    }
+                    setData(d => ({
+                        ...d,
+                        temperature: message.temperature,
+                        triacOpeningPercentage: message.triacOpeningPercentage,
+                        temperatureReached: message.temperatureReached,
+                        routedPower: message.routedPower,
+                        routedEnergyToday: message.routedEnergyToday,
+                        currentFirmwareVersion: message.currentFirmwareVersion,
+                        newFirmwareVersion: message.lastFirmwareVersion ?? d.newFirmwareVersion,
+                    }));
+                    break;
+            }
+        };
+
         const connect = () => {
             // Construit l'URL WebSocket à partir de l'hôte actuel
             const url = `ws://${window.location.host}/ws`;
             ws.current = new WebSocket(url);
+            lastSeq.current = null;
             setStatus(ConnectionStatus.Connecting);
 
             ws.current.onopen = () => {
@@ -49,9 +162,9 @@ export function useEsp32WebSocket() {
 
             ws.current.onmessage = (event) => {
                 try {
-                    const message = JSON.parse(event.data);
+                    const message = JSON.parse(event.data) as Esp32Message;
                     // Met à jour l'état avec les nouvelles données
-                    setData(message);
+                    handleMessage(message);
                 } catch (error) {
                     console.error('Failed to parse WebSocket message:', error);
                 }
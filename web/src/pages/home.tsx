@@ -1,7 +1,7 @@
 import { pagePros } from '../app';
 import { Card } from '../component/card';
 import HistoryChart from '../component/historyChart';
-import { Thermometer, Zap,Sun } from 'lucide-react';
+import { Thermometer, Zap,Sun, Flame } from 'lucide-react';
 import { useConfig } from '../context/configurationContext';
 import { useEsp32WebSocket } from '../hooks/useEsp32WebSocket';
 import { formatMinuteToTime } from '../helper/time';
@@ -76,6 +76,13 @@ export default function HomePage(props: pagePros) {
             ) : null}
           </Card>
 
+          {/* Energy routed to the boiler */}
+          <Card
+            value={data.routedEnergyToday !== undefined ? `${(data.routedEnergyToday / 1000).toFixed(2)} kWh` : "..."}
+            label={data.routedPower !== undefined ? `Énergie routée aujourd'hui (${data.routedPower} W)` : "Énergie routée aujourd'hui"}
+            Icon={Flame}
+          />
+
           <Card
             value={config?.solar.sunRiseMinutes !== undefined && config.solar.sunSetMinutes !== undefined ? `${formatMinuteToTime( config.solar.sunRiseMinutes)} - ${formatMinuteToTime(config.solar.sunSetMinutes)}` : "..."}
             label="Lever / Coucher"